@@ -3,6 +3,12 @@
 
 #include <QDebug>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "threadpool.h"
+
 namespace Gomo {
 
 namespace Geometry2D {
@@ -10,6 +16,400 @@ namespace Geometry2D {
 
 static double INVALID_COORDINATE_VALUE = -999999.00;
 
+// below this count of (angle, hull vertex) pairs the angle sweep runs on the calling thread
+static const size_t MIN_PARALLEL_SWEEP_WORK = 1<<16;
+
+
+namespace {
+
+    // an edge of the polygon on the design plane, from its lowest to its highest end
+    struct RegionEdge
+    {
+        double ylow, yhigh;
+        double xlow, xhigh;
+    };
+
+    inline bool EdgeHigherThan(const RegionEdge & a, const RegionEdge & b)
+    {
+        return a.yhigh > b.yhigh;
+    }
+
+    inline double EdgeXAt(const RegionEdge & edge, double y)
+    {
+        if(edge.yhigh==edge.ylow)
+        {
+            return edge.xlow;
+        }
+        return edge.xlow + (edge.xhigh-edge.xlow)*(y-edge.ylow)/(edge.yhigh-edge.ylow);
+    }
+
+    // the intervals of the line y inside the polygon, by the even-odd rule of the active edges
+    void LineIntervalsInRegion(const std::vector<RegionEdge> & active,
+                               double y,
+                               std::vector<double> & crossings,
+                               std::vector<StripInterval> & intervals)
+    {
+        crossings.clear();
+        std::vector<RegionEdge>::const_iterator it = active.begin();
+        for( ; it!=active.end(); it++ )
+        {
+            if(it->ylow <= y && y < it->yhigh)
+            {
+                crossings.push_back(EdgeXAt(*it,y));
+            }
+        }
+        std::sort(crossings.begin(),crossings.end());
+        for(size_t i=0; i+1<crossings.size(); i+=2 )
+        {
+            intervals.push_back(StripInterval(crossings[i],crossings[i+1]));
+        }
+    }
+}
+
+void ClipStripsToPolygon(const Point2DArray & polygon,
+                         const std::vector<double> & strips_y,
+                         double band_half_height,
+                         std::vector< std::vector<StripInterval> > & strips_intervals)
+{
+    strips_intervals.assign(strips_y.size(),std::vector<StripInterval>());
+
+    size_t count_points = polygon.size();
+    if(count_points<2)
+    {
+        return;
+    }
+
+    // edge table, sorted by the highest end as the strips go down
+    std::vector<RegionEdge> edges;
+    edges.reserve(count_points);
+    for(size_t i=0; i<count_points; i++ )
+    {
+        const Point2D & a = polygon[i];
+        const Point2D & b = polygon[(i+1)%count_points];
+
+        RegionEdge edge;
+        if(a.Y <= b.Y)
+        {
+            edge.ylow = a.Y; edge.xlow = a.X;
+            edge.yhigh= b.Y; edge.xhigh= b.X;
+        }
+        else
+        {
+            edge.ylow = b.Y; edge.xlow = b.X;
+            edge.yhigh= a.Y; edge.xhigh= a.X;
+        }
+        edges.push_back(edge);
+    }
+    std::sort(edges.begin(),edges.end(),EdgeHigherThan);
+
+    std::vector<RegionEdge> active;
+    std::vector<double> crossings;
+    std::vector<StripInterval> intervals;
+    size_t next_edge = 0;
+
+    for(size_t s=0; s<strips_y.size(); s++ )
+    {
+        double band_top    = strips_y[s] + band_half_height;
+        double band_bottom = strips_y[s] - band_half_height;
+
+        // active edge table: the edges reaching the band, minus the ones left above it
+        while(next_edge<edges.size() && edges[next_edge].yhigh >= band_bottom)
+        {
+            active.push_back(edges[next_edge]);
+            next_edge++;
+        }
+        size_t count_active = 0;
+        for(size_t i=0; i<active.size(); i++ )
+        {
+            if(active[i].ylow <= band_top)
+            {
+                active[count_active++] = active[i];
+            }
+        }
+        active.resize(count_active);
+
+        // the x extent of the region within the band: the edges clipped to the band,
+        // and the parts of the two band lines inside the region
+        intervals.clear();
+        std::vector<RegionEdge>::const_iterator it = active.begin();
+        for( ; it!=active.end(); it++ )
+        {
+            double x_a = EdgeXAt(*it,std::max(it->ylow,band_bottom));
+            double x_b = EdgeXAt(*it,std::min(it->yhigh,band_top));
+            intervals.push_back(StripInterval(std::min(x_a,x_b),std::max(x_a,x_b)));
+        }
+        LineIntervalsInRegion(active,band_top,crossings,intervals);
+        LineIntervalsInRegion(active,band_bottom,crossings,intervals);
+
+        if(intervals.empty())
+        {
+            continue;
+        }
+
+        // merge the overlapping intervals
+        std::sort(intervals.begin(),intervals.end());
+        std::vector<StripInterval> & merged = strips_intervals[s];
+        merged.push_back(intervals[0]);
+        for(size_t i=1; i<intervals.size(); i++ )
+        {
+            if(intervals[i].first <= merged.back().second)
+            {
+                merged.back().second = std::max(merged.back().second,intervals[i].second);
+            }
+            else
+            {
+                merged.push_back(intervals[i]);
+            }
+        }
+    }
+}
+
+RouteCostModel::RouteCostModel()
+    :baseline_length(0.0),
+    redundant_baselines(0),
+    guidance_distance(0.0),
+    cross_strip_distance(0.0),
+    has_airport(false),
+    clip_strips(false)
+{
+}
+
+int RouteCostModel::CountStrips(double mbr_height, double cross_strip_distance)
+{
+    // a single strip in the middle if the region is narrower than the strip distance
+    if(cross_strip_distance <= 0.0 || cross_strip_distance > mbr_height*1.2)
+    {
+        return 1;
+    }
+
+    // the first strip on the top, the next ones until the bottom is within half a strip distance
+    return 1 + (int)std::max(0.0, ceil(mbr_height/cross_strip_distance - 0.5));
+}
+
+void RouteCostModel::StripLines(double minY, double maxY, double cross_strip_distance, bool isSingleStrip,
+                                std::vector<double> & strips_y, double & band_half_height)
+{
+    // the same strip lines as the unclipped design, each strip covers the band between its neighbours
+    strips_y.clear();
+    if(isSingleStrip)
+    {
+        strips_y.push_back((minY+maxY)/2.0);
+        band_half_height = fabs(maxY-minY);
+        return;
+    }
+
+    band_half_height = cross_strip_distance/2.0;
+    double current_strip_y = maxY;
+    strips_y.push_back(current_strip_y);
+    while (current_strip_y > (minY + cross_strip_distance/2))
+    {
+        current_strip_y -= cross_strip_distance;
+        strips_y.push_back(current_strip_y);
+    }
+}
+
+double RouteCostModel::StripCourseLength(double mbr_width) const
+{
+    if(baseline_length <= 0.0)
+    {
+        return mbr_width + 2.0*guidance_distance;
+    }
+
+    // the exposures cover the width, then the redundant baselines, the entrance/exit and the guidance
+    double count_exposures = ceil(mbr_width/baseline_length) + 1.0;
+
+    return 2.0*guidance_distance
+            + baseline_length*(redundant_baselines+1)
+            + count_exposures*baseline_length
+            + ((redundant_baselines!=0) ? baseline_length : 0.0);
+}
+
+double RouteCostModel::Cost(double minX, double maxX, double minY, double maxY, double ux, double uy) const
+{
+    double height = maxY - minY;
+
+    int count_strips = CountStrips(height, cross_strip_distance);
+    double strip_length = StripCourseLength(maxX - minX);
+
+    // a half circle turn from a strip to the next one
+    double cost = count_strips*strip_length + (count_strips-1)*cross_strip_distance*_PI_/2.0;
+
+    if(has_airport)
+    {
+        // the design plane before the flip: first strip on the top, from the left
+        double x_start = minX - baseline_length*(redundant_baselines+1) - guidance_distance;
+        double x_end   = x_start + strip_length;
+
+        bool isSingleStrip = cross_strip_distance <= 0.0 || cross_strip_distance > height*1.2;
+        double y_first = isSingleStrip ? (minY+maxY)/2.0 : maxY;
+        double y_last  = y_first - (count_strips-1)*cross_strip_distance;
+
+        double exit_x  = (count_strips%2==1) ? x_end : x_start;
+
+        AddAirportLegs(x_start, exit_x, y_first, y_last, minX, maxX, minY, maxY, ux, uy, cost);
+    }
+
+    return cost;
+}
+
+void RouteCostModel::ClippedStripCourse(double x_first, double x_last, double grid_origin_x,
+                                        double & x_start, double & x_end) const
+{
+    if(baseline_length <= 0.0)
+    {
+        x_start = x_first - guidance_distance;
+        x_end   = x_last  + guidance_distance;
+        return;
+    }
+
+    // as PolygonAreaFlightRouteDesign::CreateClippedStrip: the first and last exposures,
+    // then the entrance/exit a baseline further and the guidance
+    double first_k = floor((x_first - grid_origin_x)/baseline_length) - redundant_baselines;
+    double last_k  = ceil ((x_last  - grid_origin_x)/baseline_length) + redundant_baselines;
+
+    x_start = grid_origin_x + (first_k-1.0)*baseline_length - guidance_distance;
+    x_end   = grid_origin_x + (last_k +1.0)*baseline_length + guidance_distance;
+}
+
+double RouteCostModel::ClippedCost(const Point2DArray & polygon,
+                                   double minX, double maxX, double minY, double maxY, double ux, double uy,
+                                   ClippedCostBuffers & buffers) const
+{
+    // the polygon in the design plane of the orientation, x along the strips
+    Point2DArray & rotated = buffers.rotated;
+    rotated.resize(polygon.size());
+    for(size_t i=0; i<polygon.size(); i++ )
+    {
+        rotated[i].X = polygon[i].X*ux + polygon[i].Y*uy;
+        rotated[i].Y = polygon[i].Y*ux - polygon[i].X*uy;
+    }
+
+    bool isSingleStrip = cross_strip_distance <= 0.0 || cross_strip_distance > (maxY-minY)*1.2;
+
+    std::vector<double> & strips_y = buffers.strips_y;
+    double band_half_height = 0.0;
+    StripLines(minY, maxY, cross_strip_distance, isSingleStrip, strips_y, band_half_height);
+
+    // a clipped strip flies over the gaps between its intervals, so only the x extent of the polygon
+    // within each band matters: the ones of its edges clipped to the band, as ClipStripsToPolygon
+    // keeps the edges with ylow <= band_top and yhigh >= band_bottom
+    size_t count_lines = strips_y.size();
+    std::vector<double> & band_minX = buffers.band_minX;
+    std::vector<double> & band_maxX = buffers.band_maxX;
+    band_minX.assign(count_lines, std::numeric_limits<double>::max());
+    band_maxX.assign(count_lines, -std::numeric_limits<double>::max());
+    double y_top = strips_y[0];
+    size_t count_points = rotated.size();
+    for(size_t i=0; i<count_points && count_points>=2; i++ )
+    {
+        const Point2D & a = rotated[i];
+        const Point2D & b = rotated[(i+1)%count_points];
+
+        RegionEdge edge;
+        if(a.Y <= b.Y)
+        {
+            edge.ylow = a.Y; edge.xlow = a.X;
+            edge.yhigh= b.Y; edge.xhigh= b.X;
+        }
+        else
+        {
+            edge.ylow = b.Y; edge.xlow = b.X;
+            edge.yhigh= a.Y; edge.xhigh= a.X;
+        }
+
+        // the bands the edge may reach, one more on each side for the rounding of the strip lines
+        long first_line = 0, last_line = (long)count_lines-1;
+        if(count_lines>1)
+        {
+            first_line = std::max(first_line, (long)floor((y_top - band_half_height - edge.yhigh)/cross_strip_distance) - 1);
+            last_line  = std::min(last_line,  (long)ceil ((y_top + band_half_height - edge.ylow )/cross_strip_distance) + 1);
+        }
+
+        for(long s=first_line; s<=last_line; s++ )
+        {
+            double band_top    = strips_y[s] + band_half_height;
+            double band_bottom = strips_y[s] - band_half_height;
+            if(edge.ylow > band_top || edge.yhigh < band_bottom)
+            {
+                continue;
+            }
+
+            double x_a = EdgeXAt(edge,std::max(edge.ylow,band_bottom));
+            double x_b = EdgeXAt(edge,std::min(edge.yhigh,band_top));
+            band_minX[s] = std::min(band_minX[s], std::min(x_a,x_b));
+            band_maxX[s] = std::max(band_maxX[s], std::max(x_a,x_b));
+        }
+    }
+
+    // the strips outside of the polygon are dropped, the others keep on alternating the direction
+    double cost = 0.0;
+    int count_strips = 0;
+    double entry_x = 0.0, exit_x = 0.0, y_first = 0.0, y_last = 0.0;
+    for(size_t i=0; i<count_lines; i++ )
+    {
+        if(band_minX[i] > band_maxX[i])
+        {
+            continue;
+        }
+
+        double x_start, x_end;
+        ClippedStripCourse(band_minX[i], band_maxX[i], minX, x_start, x_end);
+        cost += x_end - x_start;
+
+        if(count_strips == 0)
+        {
+            entry_x = x_start;
+            y_first = strips_y[i];
+        }
+        exit_x = (count_strips%2==0) ? x_end : x_start;
+        y_last = strips_y[i];
+
+        count_strips++;
+    }
+
+    if(count_strips == 0)
+    {
+        return std::numeric_limits<double>::max();
+    }
+
+    // a half circle turn from a strip to the next one
+    cost += (count_strips-1)*cross_strip_distance*_PI_/2.0;
+
+    if(has_airport)
+    {
+        AddAirportLegs(entry_x, exit_x, y_first, y_last, minX, maxX, minY, maxY, ux, uy, cost);
+    }
+
+    return cost;
+}
+
+void RouteCostModel::AddAirportLegs(double entry_x, double exit_x, double y_first, double y_last,
+                                    double minX, double maxX, double minY, double maxY, double ux, double uy,
+                                    double & cost) const
+{
+    double center_x = (minX+maxX)/2.0;
+    double center_y = (minY+maxY)/2.0;
+
+    double airport_x = airport.X*ux + airport.Y*uy;
+    double airport_y = airport.Y*ux - airport.X*uy;
+
+    // the flip puts the first strip at the corner of the airport
+    if(airport_x > center_x)
+    {
+        entry_x = 2.0*center_x - entry_x;
+        exit_x  = 2.0*center_x - exit_x;
+    }
+    if(airport_y < center_y)
+    {
+        y_first = 2.0*center_y - y_first;
+        y_last  = 2.0*center_y - y_last;
+    }
+
+    cost += sqrt((entry_x-airport_x)*(entry_x-airport_x) + (y_first-airport_y)*(y_first-airport_y));
+    cost += sqrt((exit_x -airport_x)*(exit_x -airport_x) + (y_last -airport_y)*(y_last -airport_y));
+}
+
+
 PolygonOrientation2D::PolygonOrientation2D( const Point2DArray pts)
 {
     m_polygon_pts= pts;
@@ -23,6 +423,11 @@ PolygonOrientation2D::PolygonOrientation2D( const Point2DArray pts)
 
     m_extended_baseline = 200.0;// 200 meters as default
 
+    m_objective = OBJECTIVE_MBR_AREA;
+    m_cross_strip_distance = 0.0;
+
+    m_sweep_resolution = 0.0;
+
 }
 
 
@@ -32,6 +437,105 @@ PolygonOrientation2D::~PolygonOrientation2D()
 }
 
 
+namespace {
+
+    inline double Cross(const Point2D & o, const Point2D & a, const Point2D & b)
+    {
+        return (a.X-o.X)*(b.Y-o.Y) - (a.Y-o.Y)*(b.X-o.X);
+    }
+
+    inline bool LessXY(const Point2D & a, const Point2D & b)
+    {
+        return a.X < b.X || (a.X == b.X && a.Y < b.Y);
+    }
+
+    inline double Dot(const Point2D & p, double ux, double uy)
+    {
+        return p.X*ux + p.Y*uy;
+    }
+}
+
+void PolygonOrientation2D::ConvexHull(const Point2DArray & pts, Point2DArray & hull)
+{
+    hull.clear();
+
+    Point2DArray sorted(pts);
+    std::sort(sorted.begin(), sorted.end(), LessXY);
+
+    size_t numPoints = sorted.size();
+    if(numPoints < 3)
+    {
+        hull = sorted;
+        return;
+    }
+
+    hull.resize(2*numPoints);
+    size_t k = 0;
+
+    // lower hull
+    for(size_t i=0; i<numPoints; i++)
+    {
+        while(k >= 2 && Cross(hull[k-2], hull[k-1], sorted[i]) <= 0.0)
+        {
+            k--;
+        }
+        hull[k++] = sorted[i];
+    }
+
+    // upper hull
+    for(size_t i=numPoints-1, lower=k+1; i>0; i--)
+    {
+        while(k >= lower && Cross(hull[k-2], hull[k-1], sorted[i-1]) <= 0.0)
+        {
+            k--;
+        }
+        hull[k++] = sorted[i-1];
+    }
+
+    // the last point is the first one
+    hull.resize(k-1);
+}
+
+double PolygonOrientation2D::StripAngle(double angle)
+{
+    while(angle > _PI_/2.0)
+    {
+        angle -= _PI_;
+    }
+    while(angle <= -_PI_/2.0)
+    {
+        angle += _PI_;
+    }
+    return angle;
+}
+
+double PolygonOrientation2D::Objective(double minX, double maxX, double minY, double maxY, double ux, double uy,
+                                       RouteCostModel::ClippedCostBuffers & buffers) const
+{
+    double width  = maxX - minX;
+    double height = maxY - minY;
+
+    if(m_objective == OBJECTIVE_ROUTE_COST)
+    {
+        if(m_cost_model.clip_strips)
+        {
+            return m_cost_model.ClippedCost(m_polygon_centralized, minX, maxX, minY, maxY, ux, uy, buffers);
+        }
+        return m_cost_model.Cost(minX, maxX, minY, maxY, ux, uy);
+    }
+
+    double strip_length = width + m_extended_baseline;
+
+    if(m_objective == OBJECTIVE_FLIGHT_LENGTH && m_cross_strip_distance > 0.0)
+    {
+        return RouteCostModel::CountStrips(height, m_cross_strip_distance)*strip_length;
+    }
+
+    return strip_length*height;
+}
+
+// rotating calipers: for each edge of the hull the MBR with a side on that edge,
+// the three other sides of the MBR only move forward along the hull, O(h) after the O(n log n) hull
 bool PolygonOrientation2D::GetOrientation_ConvexHull(OptimalOrientationInfo& info)
 {
     info.__model= CONVEXHULL;
@@ -39,67 +543,220 @@ bool PolygonOrientation2D::GetOrientation_ConvexHull(OptimalOrientationInfo& inf
 
     //first get convexhull
     Point2DArray polyon_convexhull;
+    ConvexHull(m_polygon_centralized, polyon_convexhull);
+
+    size_t numPoints=polyon_convexhull.size();
+    if(numPoints < 3)
+    {
+        return false;
+    }
+
+    const Point2DArray & hull = polyon_convexhull;
+
+    size_t idx_right = 1;   // max along the edge
+    size_t idx_top   = 1;   // max across the edge, the hull is on the left of the edges
+    size_t idx_left  = 1;   // min along the edge
 
-    ni::niIntArray convexHullIds;
-    if (ni::geometry::
-            niGeomMath2d::CalcConvexHull(
-                               m_polygon_centralized,
-                               convexHullIds))
+    bool found = false;
+    double best_objective = 0.0;
+    RouteCostModel::ClippedCostBuffers buffers;
+
+    for(size_t i=0; i<numPoints; i++)
     {
-        ni::niIntArray::iterator it_vec = convexHullIds.begin();
+        const Point2D & pt_start = hull[i];
+        const Point2D & pt_end   = hull[(i+1)%numPoints];
+
+        double dx = pt_end.X - pt_start.X;
+        double dy = pt_end.Y - pt_start.Y;
+        double length = sqrt(dx*dx + dy*dy);
+        if(length <= 0.0)
+        {
+            continue;
+        }
 
-        for( ; it_vec!= convexHullIds.end(); it_vec++ )
+        // along the edge: (ux,uy), across the edge: (-uy,ux)
+        double ux = dx/length;
+        double uy = dy/length;
+
+        if(i == 0)
+        {
+            idx_right = 1;
+        }
+        while(Dot(hull[(idx_right+1)%numPoints], ux, uy) > Dot(hull[idx_right], ux, uy))
+        {
+            idx_right = (idx_right+1)%numPoints;
+        }
+
+        if(i == 0)
+        {
+            idx_top = idx_right;
+        }
+        while(Dot(hull[(idx_top+1)%numPoints], -uy, ux) > Dot(hull[idx_top], -uy, ux))
         {
-            polyon_convexhull.push_back(m_polygon_centralized[*it_vec]);
+            idx_top = (idx_top+1)%numPoints;
         }
 
+        if(i == 0)
+        {
+            idx_left = idx_top;
+        }
+        while(Dot(hull[(idx_left+1)%numPoints], ux, uy) < Dot(hull[idx_left], ux, uy))
+        {
+            idx_left = (idx_left+1)%numPoints;
+        }
+
+        double minX = Dot(hull[idx_left], ux, uy);
+        double maxX = Dot(hull[idx_right], ux, uy);
+        double minY = Dot(pt_start, -uy, ux);
+        double maxY = Dot(hull[idx_top], -uy, ux);
+
+        double width  = maxX - minX;
+        double height = maxY - minY;
+
+        // the strips are flown along the edge or against it, as the design angle says
+        double angle = StripAngle(LineOrientation(pt_start, pt_end));
+        double objective;
+        if(cos(angle)*ux + sin(angle)*uy >= 0.0)
+        {
+            objective = Objective(minX, maxX, minY, maxY, ux, uy, buffers);
+        }
+        else
+        {
+            objective = Objective(-maxX, -minX, -maxY, -minY, -ux, -uy, buffers);
+        }
+
+        // the later edge wins a tie, as the former std::map keyed by area did
+        if(!found || objective <= best_objective)
+        {
+            found = true;
+            best_objective = objective;
+            info.__angle = angle;
+            info.__rotated_mbr_area = (width + m_extended_baseline)*height;
+            info.__objective = objective;
+        }
     }
-    else
+
+    return found;
+}
+
+namespace {
+
+    struct SweepResult
+    {
+        bool   found;
+        double angle;
+        double rotated_mbr_area;
+        double objective;
+    };
+}
+
+// the angles [0,PI) every m_sweep_resolution, scored as the design flies them in (-PI/2,PI/2];
+// the angle ranges run in parallel, each with its own buffers for ClippedCost;
+// only the hull vertices matter for the MBR, kept as separated x[] and y[] so the inner loop vectorizes
+bool PolygonOrientation2D::GetOrientation_AngleSweep(OptimalOrientationInfo& info)
+{
+    info.__model = ANGLE_SWEEP;
+    info.__angle = 0;
+
+    if(m_sweep_resolution <= 0.0)
     {
         return false;
     }
 
+    Point2DArray hull;
+    ConvexHull(m_polygon_centralized, hull);
 
-    //use this map to find the optimal roation angle that make the smallest mbr area after roation
-    std::map<double /* mbr area after rotation*/, double /*angle*/> mbr_angle;
+    size_t numPoints = hull.size();
+    if(numPoints < 3)
+    {
+        return false;
+    }
 
-    int numPoints=polyon_convexhull.size();
-    double angle_by_edge;
+    std::vector<double> hull_x(numPoints), hull_y(numPoints);
+    for(size_t i=0; i<numPoints; i++)
+    {
+        hull_x[i] = hull[i].X;
+        hull_y[i] = hull[i].Y;
+    }
+    const double * hx = &hull_x[0];
+    const double * hy = &hull_y[0];
+
+    size_t count_angles = (size_t)ceil(_PI_/m_sweep_resolution);
+    double angle_step = _PI_/count_angles;
 
-    if(numPoints > 2)
+    auto sweep = [this, hx, hy, numPoints, angle_step](size_t first_angle, size_t last_angle, SweepResult & result)
     {
-        Point2DArray::iterator it_vertex = polyon_convexhull.begin();
+        result.found = false;
+        RouteCostModel::ClippedCostBuffers buffers;
 
-        for( ; (it_vertex+1)!= polyon_convexhull.end(); it_vertex++ )
+        for(size_t k=first_angle; k<last_angle; k++)
         {
-            //calculate the angle of each edge one by one
-            angle_by_edge = LineOrientation( *it_vertex,*(it_vertex+1));
+            double angle = StripAngle(k*angle_step);
+            double ux = cos(angle);
+            double uy = sin(angle);
 
-            double rotated_mbr_area=-1;
+            double minX = std::numeric_limits<double>::max(), maxX = -minX;
+            double minY = minX, maxY = -minX;
 
-            if( PolygonRoationExperiment(angle_by_edge,rotated_mbr_area))
+            for(size_t i=0; i<numPoints; i++)
             {
-                mbr_angle[rotated_mbr_area] = angle_by_edge;
+                double x = hx[i]*ux + hy[i]*uy;
+                double y = hy[i]*ux - hx[i]*uy;
+                minX = (x < minX) ? x : minX;
+                maxX = (x > maxX) ? x : maxX;
+                minY = (y < minY) ? y : minY;
+                maxY = (y > maxY) ? y : maxY;
             }
-            else
+
+            double objective = Objective(minX, maxX, minY, maxY, ux, uy, buffers);
+            if(!result.found || objective < result.objective)
             {
-                false;
+                result.found = true;
+                result.angle = angle;
+                result.rotated_mbr_area = (maxX - minX + m_extended_baseline)*(maxY - minY);
+                result.objective = objective;
             }
-
         }
+    };
 
+    size_t count_ranges = 1;
+    if(count_angles*numPoints >= MIN_PARALLEL_SWEEP_WORK)
+    {
+        count_ranges = std::min<size_t>(count_angles, 4*WorkStealingThreadPool::CurrentThreadCount());
+    }
+
+    std::vector<SweepResult> results(count_ranges);
+    if(count_ranges == 1)
+    {
+        sweep(0, count_angles, results[0]);
     }
     else
     {
-        return false;
+        TaskGroup sweep_group;
+        for(size_t r=0; r<count_ranges; r++)
+        {
+            size_t first_angle = count_angles*r/count_ranges;
+            size_t last_angle  = count_angles*(r+1)/count_ranges;
+            SweepResult * result = &results[r];
+            sweep_group.Run([&sweep, first_angle, last_angle, result]{ sweep(first_angle, last_angle, *result); });
+        }
+        sweep_group.Wait();
     }
 
+    // the first of the equal minima, whatever the count of ranges
+    bool found = false;
+    for(size_t r=0; r<count_ranges; r++)
+    {
+        if(results[r].found && (!found || results[r].objective < info.__objective))
+        {
+            found = true;
+            info.__angle = results[r].angle;
+            info.__rotated_mbr_area = results[r].rotated_mbr_area;
+            info.__objective = results[r].objective;
+        }
+    }
 
-    // take the first element , ie the smallest mbr area after rotation
-    info.__angle = mbr_angle.begin()->second;
-    info.__rotated_mbr_area = mbr_angle.begin()->first;
-
-    return true;
+    return found;
 }
 
 bool PolygonOrientation2D::GetOrientation_Skeleton(OptimalOrientationInfo& info)
@@ -108,7 +765,7 @@ bool PolygonOrientation2D::GetOrientation_Skeleton(OptimalOrientationInfo& info)
 
 
     info.__angle = 0;
-    PolygonRoationExperiment(info.__angle,info.__rotated_mbr_area);
+    PolygonRoationExperiment(info.__angle,info.__rotated_mbr_area,info.__objective);
 
     return true;
 
@@ -163,8 +820,8 @@ bool PolygonOrientation2D::GetOrientation_LineApprox(OptimalOrientationInfo& inf
         }
     }
 
-    info.__angle = angle;
-    PolygonRoationExperiment(info.__angle,info.__rotated_mbr_area);
+    info.__angle = StripAngle(angle);
+    PolygonRoationExperiment(info.__angle,info.__rotated_mbr_area,info.__objective);
 
     return true;
 
@@ -172,25 +829,35 @@ bool PolygonOrientation2D::GetOrientation_LineApprox(OptimalOrientationInfo& inf
 }
 
 bool PolygonOrientation2D::PolygonRoationExperiment(const double & angle,
-                              double& mbr_area_after_rotation)
+                              double& mbr_area_after_rotation,
+                              double& objective)
 {
-    //reverse the angle, then apply the rotation
-    double reverse_angle = angle * (-1);
+    //reverse the angle, then apply the rotation: the extents along and across the angle
+    double ux = cos(angle);
+    double uy = sin(angle);
 
-    Point2DArray rotated_vetices;
-
-    std::vector<Point2D>::iterator itVetex = m_polygon_centralized.begin();
-    for( ; itVetex!=m_polygon_centralized.end();itVetex++)
+    if(m_polygon_centralized.empty())
     {
-        Point2D newp= Rotate2D(*itVetex,reverse_angle);
-        rotated_vetices.push_back(newp);
+        return false;
     }
 
-    Point2D lt,rb;
+    double minX = Dot(m_polygon_centralized[0], ux, uy), maxX = minX;
+    double minY = Dot(m_polygon_centralized[0], -uy, ux), maxY = minY;
 
-    MBR2D(rotated_vetices,lt,rb);
+    std::vector<Point2D>::const_iterator itVetex = m_polygon_centralized.begin()+1;
+    for( ; itVetex!=m_polygon_centralized.end();itVetex++)
+    {
+        double x = Dot(*itVetex, ux, uy);
+        double y = Dot(*itVetex, -uy, ux);
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+    }
 
-    mbr_area_after_rotation = (fabs(lt.X-rb.X)+m_extended_baseline)*fabs(lt.Y-rb.Y);
+    RouteCostModel::ClippedCostBuffers buffers;
+    mbr_area_after_rotation = (fabs(maxX-minX)+m_extended_baseline)*fabs(maxY-minY);
+    objective = Objective(minX, maxX, minY, maxY, ux, uy, buffers);
 
     return true;
 
@@ -266,7 +933,8 @@ bool PolygonOrientation2D::GetOptimalOrientation(double & optimal_angle)
     OptimalOrientationInfo orien_info;
     if(GetOrientation_LineApprox(orien_info)==true)
     {
-        double diff_area = fabs(m_orignal_area - orien_info.__rotated_mbr_area  );
+        double diff_area = (m_objective == OBJECTIVE_MBR_AREA) ?
+                    fabs(m_orignal_area - orien_info.__rotated_mbr_area  ) : orien_info.__objective;
 
         m_model_orienation.insert(std::make_pair(diff_area,orien_info));
 
@@ -279,7 +947,21 @@ bool PolygonOrientation2D::GetOptimalOrientation(double & optimal_angle)
 
     if(GetOrientation_ConvexHull(orien_info)==true)
     {
-        double diff_area = fabs(m_orignal_area - orien_info.__rotated_mbr_area  );
+        double diff_area = (m_objective == OBJECTIVE_MBR_AREA) ?
+                    fabs(m_orignal_area - orien_info.__rotated_mbr_area  ) : orien_info.__objective;
+
+        m_model_orienation.insert(std::make_pair(diff_area,orien_info));
+
+        streamdebug.str("");
+        streamdebug<<"diff_area="<<diff_area<<std::endl;
+        orien_info.Output(streamdebug);
+        qDebug(streamdebug.str().c_str());
+    }
+
+    if(m_sweep_resolution > 0.0 && GetOrientation_AngleSweep(orien_info)==true)
+    {
+        double diff_area = (m_objective == OBJECTIVE_MBR_AREA) ?
+                    fabs(m_orignal_area - orien_info.__rotated_mbr_area  ) : orien_info.__objective;
 
         m_model_orienation.insert(std::make_pair(diff_area,orien_info));
 
@@ -293,11 +975,8 @@ bool PolygonOrientation2D::GetOptimalOrientation(double & optimal_angle)
     m_orientation_angle = m_model_orienation.begin()->second.__angle;
 
 
-    // make sure the angle be smaller than 90 degree
-    if( m_orientation_angle> _PI_ / 2.0 )
-    {
-        m_orientation_angle -= _PI_ ;
-    }
+    // make sure the angle be smaller than 90 degree, the candidates are already scored in that range
+    m_orientation_angle = StripAngle(m_orientation_angle);
 
     optimal_angle = m_orientation_angle;    
     streamdebug.str("");
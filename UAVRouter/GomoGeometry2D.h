@@ -180,20 +180,102 @@ namespace Geometry2D {
         return true;
     }
 
+    typedef std::pair<double,double> StripInterval;
+
+    // the x intervals of the polygon within the band [y-band_half_height, y+band_half_height] of each strip,
+    // strips_y in descending order; one sweep of a sorted edge table over all the strips
+    void ClipStripsToPolygon(const Point2DArray & polygon,
+                             const std::vector<double> & strips_y,
+                             double band_half_height,
+                             std::vector< std::vector<StripInterval> > & strips_intervals);
+
+    // the flight of a region along an orientation, as PolygonAreaFlightRouteDesign::DesignInTransformedCoords
+    // lays the strips on the MBR of the rotated region and FlipOrthoPlaneOrientation puts the first
+    // strip at the corner of the airport; all the lengths in meters on the gauss plane
+    struct RouteCostModel
+    {
+        // the work arrays of ClippedCost, one per thread so the angles are scored without allocating
+        struct ClippedCostBuffers
+        {
+            Point2DArray        rotated;
+            std::vector<double> strips_y;
+            std::vector<double> band_minX;
+            std::vector<double> band_maxX;
+        };
+
+        double       baseline_length;
+        unsigned int redundant_baselines;
+        double       guidance_distance;
+        double       cross_strip_distance;
+
+        bool         has_airport;       // count the legs from and back to the airport
+        Point2D      airport;           // in the coordinates of the polygon to orientate
+
+        bool         clip_strips;       // FlightParameter::ClipStripsToRegion, see ClippedCost
+
+    public:
+        RouteCostModel();
+
+        // the strips from the top of the MBR down to its bottom
+        static int CountStrips(double mbr_height, double cross_strip_distance);
+
+        // the lines of the strips from the top of the MBR down to its bottom, and the half height
+        // of the band each one covers, as PolygonAreaFlightRouteDesign::DesignClippedStrips lays them
+        static void StripLines(double minY, double maxY, double cross_strip_distance, bool isSingleStrip,
+                               std::vector<double> & strips_y, double & band_half_height);
+
+        // from the guidance start to the guidance end of a strip
+        double StripCourseLength(double mbr_width) const;
+
+        // the guidance start and end of a clipped strip: the exposures of the grid
+        // x=grid_origin_x+k*baseline_length covering [x_first,x_last], with the redundant baselines
+        void ClippedStripCourse(double x_first, double x_last, double grid_origin_x,
+                                double & x_start, double & x_end) const;
+
+        // strips, the turns between them, and the legs to and from the airport;
+        // (ux,uy) the strip direction, [minX,maxX]x[minY,maxY] the MBR along (ux,uy) and (-uy,ux)
+        double Cost(double minX, double maxX, double minY, double maxY, double ux, double uy) const;
+
+        // Cost with each strip clipped to the polygon as DesignClippedStrips does it, the strips
+        // missing the polygon dropped; polygon in the coordinates of airport
+        double ClippedCost(const Point2DArray & polygon,
+                           double minX, double maxX, double minY, double maxY, double ux, double uy,
+                           ClippedCostBuffers & buffers) const;
+
+    protected:
+        // add the legs from the airport to the entry of the first strip and back from the exit of the last one,
+        // in the design plane before FlipOrthoPlaneOrientation puts the first strip at the corner of the airport
+        void AddAirportLegs(double entry_x, double exit_x, double y_first, double y_last,
+                            double minX, double maxX, double minY, double maxY, double ux, double uy,
+                            double & cost) const;
+    };
+
     class PolygonOrientation2D
     {
+    public:
+        // what the optimal orientation minimizes
+        enum enmOrientationObjective
+        {
+            OBJECTIVE_MBR_AREA=0,       // (MBR width + extended baseline) * MBR height
+            OBJECTIVE_FLIGHT_LENGTH=1,  // count of strips * (MBR width + extended baseline)
+            OBJECTIVE_ROUTE_COST=2      // RouteCostModel::Cost, or ClippedCost with clip_strips
+        };
+
+    protected:
         // candidate methodologies
         enum enmOrientationModel
         {
             LINE_APPROXIMATION=0,
             CONVEXHULL=1,
-            SKELETON=2
+            SKELETON=2,
+            ANGLE_SWEEP=3
         };
 
         struct OptimalOrientationInfo
         {
             double __angle;
             double __rotated_mbr_area;
+            double __objective;
             enmOrientationModel __model;
 
         public:
@@ -204,9 +286,11 @@ namespace Geometry2D {
                 model_string[LINE_APPROXIMATION]=GETVARIABLESTR(LINE_APPROXIMATION);
                 model_string[CONVEXHULL]=GETVARIABLESTR(CONVEXHULL);
                 model_string[SKELETON]=GETVARIABLESTR(SKELETON);
+                model_string[ANGLE_SWEEP]=GETVARIABLESTR(ANGLE_SWEEP);
 
                 out_stream<<"Orientation Angle (in rad): "<<__angle<<"\n";
                 out_stream<<"MBR Area after roation(m2):"<< __rotated_mbr_area <<"\n";
+                out_stream<<"Objective:"<< __objective <<"\n";
                 out_stream<<"OrientationModel:"<<model_string[__model]<<"\n";
             };
         };
@@ -223,14 +307,48 @@ namespace Geometry2D {
             m_extended_baseline = baseline;
         };
 
+        // OBJECTIVE_FLIGHT_LENGTH needs the distance of the strips, default OBJECTIVE_MBR_AREA
+        void SetObjective(enmOrientationObjective objective, double cross_strip_distance=0.0)
+        {
+            m_objective = objective;
+            m_cross_strip_distance = cross_strip_distance;
+        };
+
+        // minimize RouteCostModel::Cost
+        void SetRouteCostModel(const RouteCostModel & cost_model)
+        {
+            m_objective = OBJECTIVE_ROUTE_COST;
+            m_cost_model = cost_model;
+            m_cross_strip_distance = cost_model.cross_strip_distance;
+        };
+
+        // also try the angles of (-PI/2,PI/2] every resolution (rad) in parallel, 0 (default) to disable
+        void SetAngleSweep(double resolution)
+        {
+            m_sweep_resolution = resolution;
+        };
+
     protected:
         bool Centralization();
+
+        // convex hull in anticlockwise order, without collinear or repeated points (monotone chain)
+        static void ConvexHull(const Point2DArray & pts, Point2DArray & hull);
+
+        // the angle the design turns the polygon by, in (-PI/2,PI/2]: angle and angle+PI give the same strips
+        // flown from the opposite sides of the MBR, so a candidate is scored at the angle it is flown at
+        static double StripAngle(double angle);
+
+        // the objective of the MBR [minX,maxX]x[minY,maxY] along (ux,uy) and (-uy,ux), the strips along (ux,uy)
+        double Objective(double minX, double maxX, double minY, double maxY, double ux, double uy,
+                         RouteCostModel::ClippedCostBuffers & buffers) const;
         bool GetOrientation_ConvexHull(OptimalOrientationInfo& info);
         bool GetOrientation_Skeleton(OptimalOrientationInfo& info);
         bool GetOrientation_LineApprox( OptimalOrientationInfo& info);
+        bool GetOrientation_AngleSweep( OptimalOrientationInfo& info);
 
         bool PolygonRoationExperiment(const double & angle,
-                                      double& mbr_area);
+                                      double& mbr_area,
+                                      double& objective);
 
     protected:
         Point2D m_center;
@@ -245,6 +363,12 @@ namespace Geometry2D {
 
         double m_extended_baseline;
 
+        enmOrientationObjective m_objective;
+        double m_cross_strip_distance;
+        RouteCostModel m_cost_model;
+
+        double m_sweep_resolution;
+
     };
 
 
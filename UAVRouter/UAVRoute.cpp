@@ -1,5 +1,6 @@
 
 #include "UAVRoute.h"
+#include <cstring>
 
 
 
@@ -8,202 +9,249 @@ namespace Gomo {
 
 namespace FlightRoute {
 
-    ///
-    /**
-     *@param word_obj
-     *
-     *@return the entrypted word_obj
-     */
-    WORD16  UAVROUTE_DATA_FRAME::encryptWORD( const WORD16& word_obj)
-    {
-        // this lookup table indicate the original bit index for each bit of the encrypted word
-        int bit_encrypt_index[16]={1,3,5,7,9,11,13,15,
-                                   0,2,4,6,8,10,12,14};
+    namespace {
 
-        int bitsOfWord=sizeof(WORD16)*8;
+        // the bits 0,2,4,...,14 of x packed into the bits 0..7, as PEXT(x,0x5555) without BMI2
+        inline unsigned int CompressEvenBits(unsigned int x)
+        {
+            x &= 0x5555;
+            x = (x | (x >> 1)) & 0x3333;
+            x = (x | (x >> 2)) & 0x0F0F;
+            x = (x | (x >> 4)) & 0x00FF;
+            return x;
+        }
 
-        WORD16 * bitmasks= new WORD16[bitsOfWord];
+        inline WORD16 EncryptWordBits(unsigned int word)
+        {
+            return (WORD16)(CompressEvenBits(word >> 1) | (CompressEvenBits(word) << 8));
+        }
 
-        for(int i=0; i<bitsOfWord;i++)
+        // the bits 0..7 of x to the bits 0,2,4,...,14, the inverse of CompressEvenBits
+        inline unsigned int SpreadEvenBits(unsigned int x)
         {
-            WORD16 one=1;
-            bitmasks[i]=one << i;
+            x &= 0x00FF;
+            x = (x | (x << 4)) & 0x0F0F;
+            x = (x | (x << 2)) & 0x3333;
+            x = (x | (x << 1)) & 0x5555;
+            return x;
         }
 
-        WORD16 * srcBitsInWord= new WORD16[bitsOfWord];
-        for(int i=0; i<bitsOfWord;i++)
+        inline WORD16 DecryptWordBits(unsigned int word)
         {
-            srcBitsInWord[i]= bitmasks[i] & word_obj;
+            return (WORD16)((SpreadEvenBits(word) << 1) | SpreadEvenBits(word >> 8));
         }
 
-        // here use bit_encrypt_index to find the original bit index(src_bit_index)
-        //  and its value in WORD:srcBitsInWord[src_bit_index],
-        //  then use right bit shift and left shift to get the encrypted value of this bit
-        WORD16 * destBitsInWord= new WORD16[bitsOfWord];
-        for(int i=0; i<bitsOfWord;i++)
+        // 8 bytes as a little endian number and back, whatever the byte order of the cpu
+        inline ULong64 LoadBytes64(const BYTE8 * bytes, int length)
         {
-            int src_bit_index=bit_encrypt_index[i];
-            destBitsInWord[i]=(srcBitsInWord[src_bit_index] >> src_bit_index) <<i;
+            ULong64 value = 0;
+            for(int i=0; i<length; i++ )
+            {
+                value |= (ULong64)bytes[i] << (8*i);
+            }
+            return value;
         }
 
-        delete [] srcBitsInWord;
-        srcBitsInWord=NULL;
+        inline void StoreBytes64(BYTE8 * bytes, int length, ULong64 value)
+        {
+            for(int i=0; i<length; i++ )
+            {
+                bytes[i] = (BYTE8)(value >> (8*i));
+            }
+        }
+
+        const ULong64 EVERY_BYTE = 0x0101010101010101ULL;
 
-        // use bitwise OR to combine the value of all the bits value in WORD
-        WORD16 dest=destBitsInWord[0];
-        for(int i=1;i<bitsOfWord;i++)
+        // the 6 bytes of ULong64Pack back to the number
+        inline ULong64 ULong64Unpack(const BYTE8 * pSource, int nBytes)
         {
-            dest= dest | destBitsInWord[i];
+            ULong64 value = 0;
+            for(int i=0; i<nBytes; i++)
+            {
+                value = (value << 8) | pSource[i];
+            }
+            return value;
         }
 
-        delete [] bitmasks;
-        bitmasks=NULL;
-        delete [] destBitsInWord;
-        destBitsInWord=NULL;
+        // the float nearest to value which encode packs to encoded, or the nearest one if none does:
+        // the statistic is packed from floats through doubles, so the nearest float may be a few ulp off
+        template<typename Encode>
+        float FloatPackedAs(double value, ULong64 encoded, Encode encode)
+        {
+            float nearest = (float)value;
+            float above = nearest, below = nearest;
+
+            for(int step=0; step<4; step++)
+            {
+                if(encode(above)==encoded)
+                {
+                    return above;
+                }
+                if(encode(below)==encoded)
+                {
+                    return below;
+                }
+                above = nextafterf(above, HUGE_VALF);
+                below = nextafterf(below, -HUGE_VALF);
+            }
 
-        return dest;
+            return nearest;
+        }
     }
 
+    ///
+    /**
+     *@param word_obj
+     *
+     *@return the entrypted word_obj: the bit i of the result is the bit bit_encrypt_index[i] of word_obj,
+     *        bit_encrypt_index={1,3,5,7,9,11,13,15, 0,2,4,6,8,10,12,14}
+     */
+    WORD16  UAVROUTE_DATA_FRAME::encryptWORD( const WORD16& word_obj)
+    {
+        return EncryptWordBits(word_obj);
+    }
 
+
+    // bytes[i] = 0xEA ^ bytes[0] ^ ... ^ bytes[i]
     void UAVROUTE_DATA_FRAME::SequentialXor(BYTE8* bytes,int length)
     {
-        //ostringstream streamdebug;
+        // prefix xor of 8 bytes at a time, carrying the last byte to the next 8
+        ULong64 carry = 0xEA * EVERY_BYTE;
 
-//        if(length<3)
-//        {
-//            throw "SequentialXor length<3";
-//        }
+        for(int i=0; i<length; i+=8 )
+        {
+            int count = (length-i < 8) ? length-i : 8;
 
-        bytes[0]= 0XEA ^ bytes[0];
+            ULong64 value = LoadBytes64(bytes+i,count);
+            value ^= value << 8;
+            value ^= value << 16;
+            value ^= value << 32;
+            value ^= carry;
+            StoreBytes64(bytes+i,count,value);
 
-        for(int i=1;i<=length-1;i++)
-        {
-            bytes[i]= bytes[i-1] ^ bytes[i];
+            carry = (ULong64)bytes[i+count-1] * EVERY_BYTE;
         }
-
     }
 
-    void UAVROUTE_DATA_FRAME::OutputBinary(std::ostream & out_stream, bool encrypt)
+    void UAVROUTE_DATA_FRAME::EncodeFrame(BYTE8 * output, bool encrypt)
     {
+        //check sum of the frame
+        checksum = checksum_data_XOR();
+
+        WORD16 header = frameHeader;
+        memcpy(output, &header, sizeof(header));
+
+        BYTE8 * data_for_encrypt = output+sizeof(header);
+        memcpy(data_for_encrypt, data, FRAME_DATA_LENGTH_IN_BYTE8-1);
+        data_for_encrypt[FRAME_DATA_LENGTH_IN_BYTE8-1] = checksum;
+
         if(encrypt==true)
         {
+            //process1, change the seq of bits in each WORD16 element
+            for(int i=0; i<FRAME_DATA_LENGTH_IN_BYTE8/2; i++ )
+            {
+                WORD16 word;
+                memcpy(&word, data_for_encrypt+2*i, 2);
+                word = EncryptWordBits(word);
+                memcpy(data_for_encrypt+2*i, &word, 2);
+            }
 
-            OutputBinaryV2(out_stream, true);
+            //process2,sequential Xor in bytes
+            SequentialXor(data_for_encrypt,FRAME_DATA_LENGTH_IN_BYTE8);
         }
-        else
-        {
-//            ostringstream streamdebug;
-//            streamdebug.str("");
-//            streamdebug<< "start OutputBinary here! "<<std::endl;
-//            qDebug(streamdebug.str().c_str());
-
-            //check sum of the frame
-            checksum = checksum_data_XOR();
-
-            size_t size_frame= sizeof(frameHeader)+FRAME_DATA_LENGTH_IN_BYTE8;
+    }
 
-            char * data_output= new char[size_frame];
+    WORD16  UAVROUTE_DATA_FRAME::decryptWORD( const WORD16& word_obj)
+    {
+        return DecryptWordBits(word_obj);
+    }
 
-            memcpy_s(data_output,
-                     sizeof(frameHeader),
-                     &frameHeader,
-                     sizeof(frameHeader));
-            memcpy_s(data_output+sizeof(frameHeader),
-                     FRAME_DATA_LENGTH_IN_BYTE8-1,
-                     data,
-                     FRAME_DATA_LENGTH_IN_BYTE8-1);
+    // bytes[i] = bytes[i] ^ bytes[i-1], bytes[-1] = 0xEA
+    void UAVROUTE_DATA_FRAME::InverseSequentialXor(BYTE8* bytes,int length)
+    {
+        ULong64 carry = 0xEA;
 
-            memcpy_s(data_output+sizeof(frameHeader)+FRAME_DATA_LENGTH_IN_BYTE8-1,
-                     sizeof(checksum),
-                     &checksum,
-                     1);
+        for(int i=0; i<length; i+=8 )
+        {
+            int count = (length-i < 8) ? length-i : 8;
 
+            ULong64 value = LoadBytes64(bytes+i,count);
+            ULong64 last = bytes[i+count-1];
 
-            out_stream.write(data_output,size_frame);
+            value ^= (value << 8) ^ carry;
+            StoreBytes64(bytes+i,count,value);
 
-            delete [] data_output;
-            data_output= NULL;
+            carry = last;
         }
-
-
     }
 
-    /// this is for output the frame as encrypted binary format
-    /**
-     *  @date 2013.11.09
-     *
-     */
-    void UAVROUTE_DATA_FRAME::OutputBinaryV2(std::ostream & out_stream, bool encrypt)
+    void UAVROUTE_DATA_FRAME::DecodeFrame(const BYTE8 * input, bool encrypt)
     {
-        BYTE8   data_for_encrypt[FRAME_DATA_LENGTH_IN_BYTE8];
-
-        //check sum of the frame
-        checksum = checksum_data_XOR();
-
-        //copy data[], checksum to data_for_encrypt[]
-        memcpy_s(data_for_encrypt,
-                     FRAME_DATA_LENGTH_IN_BYTE8-1,
-                     data,
-                     FRAME_DATA_LENGTH_IN_BYTE8-1);
+        WORD16 header = frameHeader;
+        if(memcmp(input, &header, sizeof(header))!=0)
+        {
+            throw "wrong frame header, UAVROUTE_DATA_FRAME::DecodeFrame";
+        }
 
-        memcpy_s(data_for_encrypt+FRAME_DATA_LENGTH_IN_BYTE8-1,
-                     sizeof(checksum),
-                     &checksum,
-                     1);
+        BYTE8 data_decrypted[FRAME_DATA_LENGTH_IN_BYTE8];
+        memcpy(data_decrypted, input+sizeof(header), FRAME_DATA_LENGTH_IN_BYTE8);
 
-        // encrypt 'data_for_encrypt[]' here
-        if ( encrypt==true)
+        if(encrypt==true)
         {
-//            ostringstream streamdebug;
-//            streamdebug.str("");
-//            streamdebug<< "encrypt 'data_for_encrypt[]' here! "<<std::endl;
-//            qDebug(streamdebug.str().c_str());
+            InverseSequentialXor(data_decrypted,FRAME_DATA_LENGTH_IN_BYTE8);
 
-            //process1, change the seq of bits in each WORD16 element
-            WORD16* frame_data_word= (WORD16*)data_for_encrypt;
-            for(int i=0; i<FRAME_DATA_LENGTH_IN_BYTE8/2;i++)
+            for(int i=0; i<FRAME_DATA_LENGTH_IN_BYTE8/2; i++ )
             {
-                WORD16 curWord=frame_data_word[i];
-                WORD16 encWorkd= encryptWORD(curWord);
-                frame_data_word[i]=encWorkd;
+                WORD16 word;
+                memcpy(&word, data_decrypted+2*i, 2);
+                word = DecryptWordBits(word);
+                memcpy(data_decrypted+2*i, &word, 2);
             }
-//            streamdebug.str("");
-//            streamdebug<< "memcpy_s(data_for_encrypt"<<std::endl;
-//            qDebug(streamdebug.str().c_str());
-
-            memcpy_s(data_for_encrypt,
-                         FRAME_DATA_LENGTH_IN_BYTE8,
-                         frame_data_word,
-                         FRAME_DATA_LENGTH_IN_BYTE8);
+        }
 
-//            streamdebug.str("");
-//            streamdebug<< "BEFORE SequentialXor"<<std::endl;
-//            qDebug(streamdebug.str().c_str());
+        memcpy(data, data_decrypted, FRAME_DATA_LENGTH_IN_BYTE8-1);
+        checksum = data_decrypted[FRAME_DATA_LENGTH_IN_BYTE8-1];
 
-            //process2,sequential Xor in bytes
-            SequentialXor(data_for_encrypt,FRAME_DATA_LENGTH_IN_BYTE8);
+        if(checksum != checksum_data_XOR())
+        {
+            throw "wrong checksum, UAVROUTE_DATA_FRAME::DecodeFrame";
+        }
+    }
 
+    void UAVROUTE_DATA_FRAME::EncodeFrames(UAVROUTE_DATA_FRAME * frames, size_t count, BYTE8 * output, bool encrypt)
+    {
+        for(size_t i=0; i<count; i++ )
+        {
+            frames[i].EncodeFrame(output+i*FRAME_SIZE_IN_BYTE8, encrypt);
         }
+    }
 
-        size_t size_frame= sizeof(frameHeader)+FRAME_DATA_LENGTH_IN_BYTE8;
-        char * data_output= new char[size_frame];
+    void UAVROUTE_DATA_FRAME::OutputBinary(std::ostream & out_stream, bool encrypt)
+    {
+        if(encrypt==true)
+        {
+            OutputBinaryV2(out_stream, true);
+        }
+        else
+        {
+            BYTE8 data_output[FRAME_SIZE_IN_BYTE8];
+            EncodeFrame(data_output, false);
+            out_stream.write((const char *)data_output,FRAME_SIZE_IN_BYTE8);
+        }
+    }
 
-        //copy frameHeader,data_for_encrypt[] to data_output[]
-        memcpy_s(data_output,
-                 sizeof(frameHeader),
-                 &frameHeader,
-                 sizeof(frameHeader));
-        memcpy_s(data_output+sizeof(frameHeader),
-                 FRAME_DATA_LENGTH_IN_BYTE8,
-                 data_for_encrypt,
-                 FRAME_DATA_LENGTH_IN_BYTE8);
+    /// this is for output the frame as encrypted binary format
+    /**
+     *  @date 2013.11.09
+     *
+     */
+    void UAVROUTE_DATA_FRAME::OutputBinaryV2(std::ostream & out_stream, bool encrypt)
+    {
+        BYTE8 data_output[FRAME_SIZE_IN_BYTE8];
+        EncodeFrame(data_output, encrypt);
 
         // output data_output[] to file
-        out_stream.write(data_output,size_frame);
-
-        delete [] data_output;
-        data_output= NULL;
-
+        out_stream.write((const char *)data_output,FRAME_SIZE_IN_BYTE8);
     }
 
     void UAVROUTE_HEADER::OutputBinary(std::ostream & out_stream) const
@@ -213,11 +261,21 @@ namespace FlightRoute {
 //        streamdebug<< "UAVROUTE_HEADER::OutputBinary here! "<<std::endl;
 //        qDebug(streamdebug.str().c_str());
 
+        UAVRouteDataFrame frame_header_region;
+        UAVRouteDataFrame frame_header_airport;
+
+        ToFrames(frame_header_region,frame_header_airport);
+
+        frame_header_region.OutputBinary(out_stream);
+        frame_header_airport.OutputBinary(out_stream);
+    }
+
+    void UAVROUTE_HEADER::ToFrames(UAVRouteDataFrame & frame_header_region,
+                                   UAVRouteDataFrame & frame_header_airport) const
+    {
         //------------
         //first frame
         //------------
-        UAVRouteDataFrame frame_header_region;
-
         frame_header_region.data[0]=0x0A;
 
         UINT4 reserved = 0x0000;
@@ -235,12 +293,9 @@ namespace FlightRoute {
         UINT4 max_lon= CoordinatePack(max_longitude);
         memcpy_s(frame_header_region.data+17,4,&max_lon,4);
 
-        frame_header_region.OutputBinary(out_stream);
-
         //------------
         //second frame
         //------------
-        UAVRouteDataFrame frame_header_airport;
         frame_header_airport.data[0]=0x0B;
 
         //airport name
@@ -264,9 +319,50 @@ namespace FlightRoute {
 //        streamdebug.str("");
 //        streamdebug<< "airport_name="<<airport_name<<std::endl;
 //        qDebug(streamdebug.str().c_str());
+    }
 
-        frame_header_airport.OutputBinary(out_stream);
+    void UAVROUTE_HEADER::FromFrames(const UAVRouteDataFrame & frame_header_region,
+                                     const UAVRouteDataFrame & frame_header_airport)
+    {
+        if(frame_header_region.data[0]!=0x0A || frame_header_airport.data[0]!=0x0B)
+        {
+            throw "not the frames of a header, UAVROUTE_HEADER::FromFrames";
+        }
+
+        UINT4 packed;
+
+        //------------
+        //first frame
+        //------------
+        memcpy_s(&packed,4,frame_header_region.data+5,4);
+        min_latitude = CoordinateUnpack(packed);
+        memcpy_s(&packed,4,frame_header_region.data+9,4);
+        max_latitude = CoordinateUnpack(packed);
+        memcpy_s(&packed,4,frame_header_region.data+13,4);
+        min_longitude = CoordinateUnpack(packed);
+        memcpy_s(&packed,4,frame_header_region.data+17,4);
+        max_longitude = CoordinateUnpack(packed);
 
+        //------------
+        //second frame
+        //------------
+        //airport name, aligned to the right and filled by 0x00
+        const char * airport_name_array = (const char *)frame_header_airport.data+1;
+        int first = 0;
+        while(first<10 && airport_name_array[first]==0x00)
+        {
+            first++;
+        }
+        airport_name.assign(airport_name_array+first,10-first);
+
+        memcpy_s(&packed,4,frame_header_airport.data+11,4);
+        airport_latitude = CoordinateUnpack(packed);
+        memcpy_s(&packed,4,frame_header_airport.data+15,4);
+        airport_longitude = CoordinateUnpack(packed);
+
+        WORD16 height_2;
+        memcpy_s(&height_2,2,frame_header_airport.data+19,2);
+        airport_height = HeightUnpack(height_2);
     }
 
     Point2D UAVROUTE_FLIGHT_POINT::ToGomoPoint2D()const
@@ -311,115 +407,170 @@ namespace FlightRoute {
 
     void UAVROUTE_FLIGHT_POINT::Output(std::ostream & out_stream,bool encrypt) const
     {
-        ostringstream stream_pointid;
-        stream_pointid.str("");
+        TextLineFormatter line;
+        Output(line,encrypt);
+        line.WriteTo(out_stream);
+    }
+
+    namespace {
 
-        out_stream<<setiosflags(ios::fixed)<<setiosflags(ios::showpoint);
-        out_stream.precision(COORDINATE_DEGREE_PRECISION);
+        // the strip id and the point id of a line, return the point class
+        int AppendPointId(const UAVROUTE_FLIGHT_POINT & pt, TextLineFormatter & line)
+        {
+            // output strip id
+            unsigned int strip_id= pt.__strip_id;
+            line.AppendInteger(strip_id,2);
+            line.Append("-");
 
+            const char * pt_flag_A_B;
 
-        // output strip id
-        unsigned int strip_id= __strip_id;
-        ios state(nullptr);
-        state.copyfmt(out_stream); // save current formatting
-        out_stream << std::setw(2)
-             << std::setfill('0')
-             << strip_id<<"-";          // the actual value we wanted to print out
-        out_stream.copyfmt(state); // restore previous formatting
+            if( pt.__flight_point_type & FLIGTH_POINT_TYPE_A_POINT_MASK )
+            {
+                pt_flag_A_B = "0A";
+            }
+            else if(pt.__flight_point_type & FLIGTH_POINT_TYPE_B_POINT_MASK)
+            {
+                pt_flag_A_B = "0B";
+            }
+            else
+            {
+                pt_flag_A_B="";
+            }
 
-        std::string pt_flag_A_B;
+            int pt_class = 0;
 
-        if( __flight_point_type & FLIGTH_POINT_TYPE_A_POINT_MASK )
-        {
-            pt_flag_A_B = "0A";
+             // output point id
+            if( pt.__flight_point_type == FLIGTH_POINT_TYPE_EXPOSURE)
+            {
+                line.AppendInteger(pt.__id_in_strip,3);
+                pt_class= FLIGTH_POINT_TYPE_EXPOSURE;
+            }
+            else if ( pt.__flight_point_type & FLIGTH_POINT_TYPE_GUIDE)
+            {
+                line.Append(pt_flag_A_B);
+                line.AppendInteger(FLIGTH_POINT_TYPE_GUIDE);
+                pt_class= FLIGTH_POINT_TYPE_GUIDE;
+            }
+            else if ( pt.__flight_point_type & FLIGTH_POINT_TYPE_ETRANCE_EXIT)
+            {
+                line.Append(pt_flag_A_B);
+                line.AppendInteger(FLIGTH_POINT_TYPE_ETRANCE_EXIT);
+                pt_class= FLIGTH_POINT_TYPE_ETRANCE_EXIT;
+            }
+
+            return pt_class;
         }
-        else if(__flight_point_type & FLIGTH_POINT_TYPE_B_POINT_MASK)
+
+        void AppendHeightAndClass(const UAVROUTE_FLIGHT_POINT & pt, int pt_class, TextLineFormatter & line)
         {
-            pt_flag_A_B = "0B";
+            int height_int = pt.__height +0.5;
+
+            //output the height and pt_class
+            line.Append(SPACE);
+            line.AppendInteger(height_int,4);
+
+            //point class
+            line.Append(SPACE);
+            line.AppendInteger(pt_class);
+            line.Append("\n");
         }
-        else
+    }
+
+    void UAVROUTE_FLIGHT_POINT::Output(TextLineFormatter & line,bool encrypt) const
+    {
+        if(encrypt==true)
         {
-            pt_flag_A_B="";
+            char encrypted_coordinate[16];
+            CoordinateOutput::EncryptCoordinate(__latitude,__longitude,EncryptionKey(),encrypted_coordinate);
+
+            OutputEncrypted(line,encrypted_coordinate);
+            return;
         }
 
-        int pt_class;
+        int pt_class = AppendPointId(*this,line);
+
+        line.Append(SPACE);
+        line.AppendFixed(__latitude,COORDINATE_DEGREE_PRECISION);
+        line.Append(SPACE);
+        line.AppendFixed(__longitude,COORDINATE_DEGREE_PRECISION,COORDINATE_DEGREE_PRECISION+4);
+
+        AppendHeightAndClass(*this,pt_class,line);
+    }
+
+    void UAVROUTE_FLIGHT_POINT::OutputEncrypted(TextLineFormatter & line,const char * encrypted_coordinate) const
+    {
+        int pt_class = AppendPointId(*this,line);
+
+        line.Append(SPACE);
+        line.Append(encrypted_coordinate,16);
+
+        AppendHeightAndClass(*this,pt_class,line);
+    }
+
+    // CoordinateOutput::PointIdKey of the point id as written (the last two chars),
+    // but the id of an exposure without the leading zeros
+    unsigned char UAVROUTE_FLIGHT_POINT::EncryptionKey() const
+    {
+        char point_id[2];
 
-         // output point id
         if( __flight_point_type == FLIGTH_POINT_TYPE_EXPOSURE)
         {
-            state.copyfmt(out_stream); // save current formatting
-            out_stream << std::setw(3)
-                 << std::setfill('0')
-                 << __id_in_strip;     // the actual value we wanted to print out
-            out_stream.copyfmt(state); // restore previous formatting
-
-            //out_stream<<__id_in_strip;
-            pt_class= FLIGTH_POINT_TYPE_EXPOSURE;
+            if(__id_in_strip<10)
+            {
+                point_id[0] = '0'+__id_in_strip;
+                return CoordinateOutput::PointIdKey(point_id,1);
+            }
 
-            stream_pointid<<__id_in_strip;// for encrypt
+            point_id[0] = '0'+(__id_in_strip/10)%10;
+            point_id[1] = '0'+__id_in_strip%10;
+            return CoordinateOutput::PointIdKey(point_id,2);
         }
-        else if ( __flight_point_type & FLIGTH_POINT_TYPE_GUIDE)
-        {
-            out_stream<<pt_flag_A_B<<FLIGTH_POINT_TYPE_GUIDE ;
-            pt_class= FLIGTH_POINT_TYPE_GUIDE;
 
-            stream_pointid <<pt_flag_A_B<<FLIGTH_POINT_TYPE_GUIDE ; // for encrypt
+        int pt_class = 0;
+        if ( __flight_point_type & FLIGTH_POINT_TYPE_GUIDE)
+        {
+            pt_class = FLIGTH_POINT_TYPE_GUIDE;
         }
         else if ( __flight_point_type & FLIGTH_POINT_TYPE_ETRANCE_EXIT)
         {
-            out_stream<<pt_flag_A_B<<FLIGTH_POINT_TYPE_ETRANCE_EXIT ;
-            pt_class= FLIGTH_POINT_TYPE_ETRANCE_EXIT;
-
-            stream_pointid <<pt_flag_A_B<<FLIGTH_POINT_TYPE_ETRANCE_EXIT ; // for encrypt
+            pt_class = FLIGTH_POINT_TYPE_ETRANCE_EXIT;
+        }
+        else
+        {
+            return 0;
         }
 
-        int height_int = __height +0.5;
-
-        out_stream.precision(COORDINATE_DEGREE_PRECISION);
+        point_id[1] = '0'+pt_class;
 
-        if(encrypt==false)
+        if( __flight_point_type & FLIGTH_POINT_TYPE_A_POINT_MASK )
         {
-            out_stream<<SPACE<<__latitude<<SPACE;
-
-            //output the height and pt_class
-            state.copyfmt(out_stream); // save current formatting
-            out_stream << std::setw(COORDINATE_DEGREE_PRECISION+4)
-                      << std::setfill('0')
-                      <<__longitude;
-            out_stream.copyfmt(state); // restore previous formatting
+            point_id[0] = 'A';
+        }
+        else if(__flight_point_type & FLIGTH_POINT_TYPE_B_POINT_MASK)
+        {
+            point_id[0] = 'B';
         }
         else
         {
-            CoordinateOutput coordoutput;
-
-            coordoutput.SetPointIdForEncryptionStep3A(stream_pointid.str());
-            coordoutput.SetAsDouble(__latitude,__longitude);
-
-            out_stream<<SPACE<<coordoutput.GetAsEncryptString();
+            return CoordinateOutput::PointIdKey(point_id+1,1);
         }
 
-
-        //output the height and pt_class
-        state.copyfmt(out_stream); // save current formatting
-        out_stream <<SPACE
-                  << std::setw(4)
-                  << std::setfill('0')
-                  <<height_int;
-        out_stream.copyfmt(state); // restore previous formatting
-
-        //point class
-        out_stream <<SPACE<<pt_class<<"\n";
-
-
+        return CoordinateOutput::PointIdKey(point_id,2);
     }
 
 
 
     void UAVROUTE_FLIGHT_POINT::OutputBinary(std::ostream & out_stream) const
     {
-
         UAVRouteDataFrame frame_point;
 
+        ToFrame(frame_point);
+
+        frame_point.OutputBinary(out_stream);
+    }
+
+    void UAVROUTE_FLIGHT_POINT::ToFrame(UAVRouteDataFrame & frame_point) const
+    {
         WORD16 point_id_16;
         BYTE8  pt_class;
 
@@ -480,16 +631,76 @@ namespace FlightRoute {
         memcpy_s(frame_point.data+18,2,&h_pack,2);
 
         memcpy_s(frame_point.data+20,1,&pt_class,1);
+    }
 
-        frame_point.OutputBinary(out_stream);
 
+    void UAVROUTE_FLIGHT_POINT::FromFrame(const UAVRouteDataFrame & frame_point)
+    {
+        WORD16 point_id_16;
+        memcpy_s(&point_id_16,2,frame_point.data,2);
+
+        BYTE8 pt_class = frame_point.data[20];
+
+        __id_in_strip = 0;
+
+        // the point class first: the id of an exposure may look like the one of a guide point
+        if(pt_class==FLIGTH_POINT_TYPE_EXPOSURE)
+        {
+            WORD16 id_litte_pack = SHORT_little_endian_TO_big_endian(point_id_16);
+            if((id_litte_pack & 0xF000)!=0x1000)
+            {
+                throw "unknown point id, UAVROUTE_FLIGHT_POINT::FromFrame";
+            }
+
+            __id_in_strip = id_litte_pack & 0x0FFF;
+            __flight_point_type = FLIGTH_POINT_TYPE_EXPOSURE;
+        }
+        else if(point_id_16==0xA11F && pt_class==FLIGTH_POINT_TYPE_GUIDE)
+        {
+            __flight_point_type = (enumFlightPointType)(FLIGTH_POINT_TYPE_GUIDE|FLIGTH_POINT_TYPE_A_POINT_MASK);
+        }
+        else if(point_id_16==0xA21F && pt_class==FLIGTH_POINT_TYPE_ETRANCE_EXIT)
+        {
+            __flight_point_type = (enumFlightPointType)(FLIGTH_POINT_TYPE_ETRANCE_EXIT|FLIGTH_POINT_TYPE_A_POINT_MASK);
+        }
+        else if(point_id_16==0xB11F && pt_class==FLIGTH_POINT_TYPE_GUIDE)
+        {
+            __flight_point_type = (enumFlightPointType)(FLIGTH_POINT_TYPE_GUIDE|FLIGTH_POINT_TYPE_B_POINT_MASK);
+        }
+        else if(point_id_16==0xB21F && pt_class==FLIGTH_POINT_TYPE_ETRANCE_EXIT)
+        {
+            __flight_point_type = (enumFlightPointType)(FLIGTH_POINT_TYPE_ETRANCE_EXIT|FLIGTH_POINT_TYPE_B_POINT_MASK);
+        }
+        else
+        {
+            throw "unknown point id, UAVROUTE_FLIGHT_POINT::FromFrame";
+        }
+
+        __strip_id = frame_point.data[9];
+
+        UINT4 lat_pack, lon_pack;
+        WORD16 h_pack;
+        memcpy_s(&lat_pack,4,frame_point.data+10,4);
+        memcpy_s(&lon_pack,4,frame_point.data+14,4);
+        memcpy_s(&h_pack,2,frame_point.data+18,2);
+
+        __latitude  = CoordinateUnpack(lat_pack);
+        __longitude = CoordinateUnpack(lon_pack);
+        __height    = HeightUnpack(h_pack);
     }
 
 
     void UAVFLIGHT_STATISTIC_INFO::OutputBinary(std::ostream & out_stream) const
     {
-
         UAVRouteDataFrame frame_statis;
+
+        ToFrame(frame_statis);
+
+        frame_statis.OutputBinary(out_stream);
+    }
+
+    void UAVFLIGHT_STATISTIC_INFO::ToFrame(UAVRouteDataFrame & frame_statis) const
+    {
         frame_statis.data[0]=0x20;
 
         BYTE8 reserved =0;
@@ -516,9 +727,38 @@ namespace FlightRoute {
         memcpy_s(frame_statis.data+14,2,&count_expos,2);
         memcpy_s(frame_statis.data+16,1,&count_strip,1);
         memcpy_s(frame_statis.data+17,4,&sum_lengh,4);
+    }
 
-        frame_statis.OutputBinary(out_stream);
+    void UAVFLIGHT_STATISTIC_INFO::FromFrame(const UAVRouteDataFrame & frame_statis)
+    {
+        if(frame_statis.data[0]!=0x20)
+        {
+            throw "not a statistic frame, UAVFLIGHT_STATISTIC_INFO::FromFrame";
+        }
 
+        ULong64 mbr_area = ULong64Unpack(frame_statis.data+2,6);
+        ULong64 area_region = ULong64Unpack(frame_statis.data+8,6);
+
+        WORD16 count_expos;
+        memcpy_s(&count_expos,2,frame_statis.data+14,2);
+
+        UINT4 sum_lengh;
+        memcpy_s(&sum_lengh,4,frame_statis.data+17,4);
+        UINT4 sum_lengh_value = sum_lengh;
+#ifdef LITTLE_ENDIAN_TO_BIG_ON
+        sum_lengh_value = INT_little_endian_TO_big_endian(sum_lengh);
+#endif
+
+        // the floats packed to the same numbers by ToFrame
+        __MBR_Area = FloatPackedAs(mbr_area/1e3, mbr_area,
+                                   [](float area){ return (ULong64)(area*1e3); });
+        __flight_region_area = FloatPackedAs(area_region/1e3, area_region,
+                                             [](float area){ return (ULong64)(area*1e3); });
+        __photo_flight_course_chainage = FloatPackedAs(sum_lengh_value/1e3, sum_lengh,
+                                                       [](float chainage){ return (ULong64)DoublePackUnsigned(chainage*1e3); });
+
+        __count_exposures = count_expos;
+        __count_strips = frame_statis.data[16];
     }
 
 
@@ -45,6 +45,7 @@ using namespace Gomo::Geometry2D;
 #include "ogrsf_frmts.h"
 
 #include"coordinateoutput.h"
+#include "textlineformatter.h"
 
 
 
@@ -195,6 +196,34 @@ namespace FlightRoute {
 
     };
 
+    // the value packed by "+0.5 and a cast" to rounded, the center of the values rounded to it:
+    // the cast truncates toward zero, so the negative values round to one more than half up
+    inline double UnpackRounded(long long rounded)
+    {
+        return rounded<0 ? rounded-1.0 : (double)rounded;
+    };
+
+    // the inverse of CoordinatePack
+    inline double CoordinateUnpack(UINT4 packed)
+    {
+#ifdef LITTLE_ENDIAN_TO_BIG_ON
+        packed = INT_little_endian_TO_big_endian(packed);
+#endif
+        return packed/1e5;
+    };
+
+    // the inverse of HeightPack
+    inline double HeightUnpack(WORD16 packed)
+    {
+#ifdef LITTLE_ENDIAN_TO_BIG_ON
+        packed = SHORT_little_endian_TO_big_endian(packed);
+#endif
+        short height_short;
+        memcpy_s(&height_short,2,&packed,2);
+
+        return UnpackRounded(height_short);
+    };
+
 
 
     typedef struct UAVROUTE_DATA_FRAME
@@ -224,9 +253,27 @@ namespace FlightRoute {
 
         void OutputBinaryV2(std::ostream & out_stream, bool encrypt=true);
 
-        WORD16 encryptWORD( const WORD16& word_obj);
-        void SequentialXor(BYTE8* source,int length);      
-       
+        // the size of a frame in the file: frameHeader, data[], checksum
+        static const size_t FRAME_SIZE_IN_BYTE8 = sizeof(WORD16)+FRAME_DATA_LENGTH_IN_BYTE8;
+
+        // the frame as it is written to the file into output[FRAME_SIZE_IN_BYTE8],
+        // data[] and checksum encrypted if encrypt; checksum is updated
+        void EncodeFrame(BYTE8 * output, bool encrypt=true);
+
+        // EncodeFrame of count frames into output[count*FRAME_SIZE_IN_BYTE8], no allocation
+        static void EncodeFrames(UAVROUTE_DATA_FRAME * frames, size_t count, BYTE8 * output, bool encrypt=true);
+
+        // odd bits of word_obj to the low byte, even bits to the high byte
+        static WORD16 encryptWORD( const WORD16& word_obj);
+        static void SequentialXor(BYTE8* source,int length);
+
+        // the inverse of EncodeFrame: input[FRAME_SIZE_IN_BYTE8] to data[] and checksum,
+        // throw if the frame header or the checksum is wrong
+        void DecodeFrame(const BYTE8 * input, bool encrypt=true);
+
+        // the inverses of encryptWORD and SequentialXor
+        static WORD16 decryptWORD( const WORD16& word_obj);
+        static void InverseSequentialXor(BYTE8* source,int length);
 
 
     } UAVRouteDataFrame;
@@ -244,9 +291,17 @@ namespace FlightRoute {
         double airport_height;               //in " meter. "
 
         inline void Output(std::ostream & out_stream,bool encrypt=false) const
+        {
+            TextLineFormatter lines;
+            Output(lines,encrypt);
+            lines.WriteTo(out_stream);
+        };
+
+        inline void Output(TextLineFormatter & lines,bool encrypt=false) const
         {
             //BEGIN FLAG
-            out_stream<<"BEGIN"<<"\n";
+            lines.Append("BEGIN");
+            lines.Append("\n");
             int intAirportHeight=airport_height;
 
             std::string airport_upper(airport_name);
@@ -254,48 +309,27 @@ namespace FlightRoute {
 
             if(encrypt==false)
             {
-                out_stream<<setiosflags(ios::fixed)<<setiosflags(ios::showpoint);
-                out_stream.precision(COORDINATE_DEGREE_PRECISION);
-
                 //first line
-                out_stream<<min_latitude
-                          <<SPACE<<max_latitude
-                          <<SPACE;
-
-                ios state(nullptr);
-                //output the height and pt_class
-                state.copyfmt(out_stream); // save current formatting
-                out_stream << std::setw(COORDINATE_DEGREE_PRECISION+4)
-                          << std::setfill('0')
-                          <<min_longitude
-                          <<SPACE
-                          << std::setw(COORDINATE_DEGREE_PRECISION+4)
-                          << std::setfill('0')
-                          <<max_longitude<<"\n";
-                out_stream.copyfmt(state); // restore previous formatting
-
+                lines.AppendFixed(min_latitude,COORDINATE_DEGREE_PRECISION);
+                lines.Append(SPACE);
+                lines.AppendFixed(max_latitude,COORDINATE_DEGREE_PRECISION);
+                lines.Append(SPACE);
+                lines.AppendFixed(min_longitude,COORDINATE_DEGREE_PRECISION,COORDINATE_DEGREE_PRECISION+4);
+                lines.Append(SPACE);
+                lines.AppendFixed(max_longitude,COORDINATE_DEGREE_PRECISION,COORDINATE_DEGREE_PRECISION+4);
+                lines.Append("\n");
 
                 //second line
-                out_stream<<airport_upper
-                          <<SPACE<<airport_latitude
-                          <<SPACE;
-
-                //output the height and pt_class
-                state.copyfmt(out_stream); // save current formatting
-                out_stream << std::setw(COORDINATE_DEGREE_PRECISION+4)
-                          << std::setfill('0')
-                          <<airport_longitude;
-                out_stream.copyfmt(state); // restore previous formatting
-
+                lines.Append(airport_upper);
+                lines.Append(SPACE);
+                lines.AppendFixed(airport_latitude,COORDINATE_DEGREE_PRECISION);
+                lines.Append(SPACE);
+                lines.AppendFixed(airport_longitude,COORDINATE_DEGREE_PRECISION,COORDINATE_DEGREE_PRECISION+4);
 
                 //output the height
-                state.copyfmt(out_stream); // save current formatting
-                out_stream <<SPACE
-                          << std::setw(4)
-                          << std::setfill('0')
-                          <<intAirportHeight
-                          <<"\n";
-                out_stream.copyfmt(state); // restore previous formatting
+                lines.Append(SPACE);
+                lines.AppendInteger(intAirportHeight,4);
+                lines.Append("\n");
             }
             else
             {
@@ -319,6 +353,11 @@ namespace FlightRoute {
 
         void OutputBinary(std::ostream & out_stream) const;
 
+        // the two frames written by OutputBinary, before encoding
+        void ToFrames(UAVROUTE_DATA_FRAME & frame_region, UAVROUTE_DATA_FRAME & frame_airport) const;
+        // the inverse of ToFrames, throw if they are not the frames of a header
+        void FromFrames(const UAVROUTE_DATA_FRAME & frame_region, const UAVROUTE_DATA_FRAME & frame_airport);
+
     }UAVRouteHEADER;
 
     typedef enum FLIGTH_POINT_TYPE
@@ -354,11 +393,24 @@ namespace FlightRoute {
             };
 
         void Output(std::ostream & out_stream,bool encrypt=false) const;
+        // the same line appended to line
+        void Output(TextLineFormatter & line,bool encrypt=false) const;
+        // the encrypted line with the 16 chars of the coordinates already encrypted (CoordinateOutput::EncryptCoordinates)
+        void OutputEncrypted(TextLineFormatter & line,const char * encrypted_coordinate) const;
+
+        // the point id key of the coordinate encryption (CoordinateOutput::PointIdKey)
+        unsigned char EncryptionKey() const;
 
        // void OutputTextEncrypted(std::ostream & out_stream) const;
 
         void OutputBinary(std::ostream & out_stream) const;
 
+        // the frame written by OutputBinary, before encoding
+        void ToFrame(UAVROUTE_DATA_FRAME & frame) const;
+        // the inverse of ToFrame, throw if the point id is unknown;
+        // the id of an exposure is the 12 bits written, 0 for the other points
+        void FromFrame(const UAVROUTE_DATA_FRAME & frame);
+
         void ToOGRFeature( OGRLayer *poLayer,OGRFeature ** ppOFeature) const;
         OGRPoint ToOGRPoint() const;
 
@@ -399,6 +451,10 @@ namespace FlightRoute {
 
         void OutputBinary(std::ostream & out_stream) const;
 
+        // the frame written by OutputBinary, before encoding
+        void ToFrame(UAVROUTE_DATA_FRAME & frame) const;
+        // the inverse of ToFrame, throw if it is not a statistic frame
+        void FromFrame(const UAVROUTE_DATA_FRAME & frame);
 
     }UAVFlightStatisticInfo;
 
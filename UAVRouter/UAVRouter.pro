@@ -11,6 +11,8 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 TARGET = UAVRouter
 TEMPLATE = app
 
+CONFIG += c++11 simd
+
 RC_ICONS = guangmu_128.ico
 
 INCLUDEPATH = .
@@ -38,6 +40,18 @@ SOURCES += main.cpp\
     child_tv.cpp \
     uicontroller.cpp \
     GomoGemetry2D.cpp \
+    ogrdriverregistration.cpp \
+    threadpool.cpp \
+    regionorderplanner.cpp \
+    gaussprojector.cpp \
+    transversemercator.cpp \
+    regiondecomposer.cpp \
+    textlineformatter.cpp \
+    uavroutesink.cpp \
+    routecolumnfile.cpp \
+    uavroutecolumns.cpp \
+    uavroutedecoder.cpp \
+    routefileverifier.cpp \
     ./niGeom/source/niPolygon2d.cpp \
     ./niGeom/source/niPolygon2dFn.cpp \
     ./niGeom/source/niGeomMath2d.cpp \
@@ -61,8 +75,23 @@ HEADERS  += mainwindow.h \
     flightparameterinput.h \
     child_tv.h \
     uicontroller.h \
+    ogrdriverregistration.h \
+    threadpool.h \
+    regionorderplanner.h \
+    gaussprojector.h \
+    transversemercator.h \
+    regiondecomposer.h \
+    textlineformatter.h \
+    uavroutesink.h \
+    routecolumnfile.h \
+    uavroutecolumns.h \
+    uavroutedecoder.h \
+    routefileverifier.h \
     copyrightdialog.h
 
+# the AVX2 kernel of the projection, only called if the cpu supports it
+AVX2_SOURCES += transversemercator_avx2.cpp
+
 FORMS    += mainwindow.ui \
     child_tv.ui \
     copyrightdialog.ui
@@ -0,0 +1,210 @@
+#include "batchdesignengine.h"
+
+#include "designtaskfactory.h"
+#include "gomologging.h"
+#include "designjobscheduler.h"
+
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include <memory>
+#include <exception>
+#include <iomanip>
+#include <algorithm>
+#include <sstream>
+using std::ostringstream;
+
+
+DesignJobResult::DesignJobResult()
+    :succeeded(false),
+    load_ms(0.0),
+    design_ms(0.0),
+    output_ms(0.0),
+    count_flight_points(0)
+{
+}
+
+
+BatchDesignEngine::BatchDesignEngine(size_t count_threads)
+    :m_count_threads(count_threads)
+{
+}
+
+
+DesignJobResult BatchDesignEngine::RunJob(const DesignJob & job)
+{
+    DesignJobResult result;
+    result.name = job.name;
+
+    QElapsedTimer timer;
+
+    try
+    {
+        timer.start();
+
+        FlightParameter parameter;
+        job.FillFlightParameter(parameter);
+
+        std::auto_ptr<FlightRouteDesign> route_desinger(DesignTaskFactory::CreateFlightRouteDeigner(parameter));
+
+        std::vector<std::string> output_files = job.GetOutputFiles();
+        for(size_t i=0; i<output_files.size(); i++)
+        {
+            route_desinger->AddOutPutFileName(output_files[i]);
+        }
+
+        result.load_ms = timer.nsecsElapsed()/1.0e6;
+        timer.restart();
+
+        if(job.stream_output)
+        {
+            // the design and the output interleaved, all counted as design
+            result.count_flight_points = route_desinger->StreamRouteDesign();
+
+            result.design_ms = timer.nsecsElapsed()/1.0e6;
+        }
+        else
+        {
+            route_desinger->PerformRouteDesign();
+
+            result.design_ms = timer.nsecsElapsed()/1.0e6;
+            timer.restart();
+
+            route_desinger->OutputRouteFile();
+
+            result.output_ms = timer.nsecsElapsed()/1.0e6;
+
+            result.count_flight_points = route_desinger->GetRouteDesign().__flight_point.size();
+        }
+        result.succeeded = true;
+    }
+    catch(const char * error)
+    {
+        result.error = error;
+    }
+    catch(const std::string & error)
+    {
+        result.error = error;
+    }
+    catch(const std::exception & e)
+    {
+        result.error = e.what();
+    }
+    catch(...)
+    {
+        result.error = "unknown error";
+    }
+
+    ostringstream streamlog;
+    streamlog<< "BatchDesignEngine::RunJob: "<<result.name
+             <<(result.succeeded ? " done, " : " failed, ")
+             <<result.TotalMilliseconds()<<" ms";
+    if(!result.succeeded)
+    {
+        streamlog<<", "<<result.error;
+    }
+    GomoLogging::GetInstancePtr()->logging(streamlog.str());
+
+    return result;
+}
+
+
+std::vector<DesignJobResult> BatchDesignEngine::RunJobs(const std::vector<DesignJob> & jobs)
+{
+    if(m_count_threads == 1)
+    {
+        // the task groups within the designs run in place too
+        WorkStealingThreadPool::PoolScope serial_scope(NULL);
+
+        std::vector<DesignJobResult> results;
+        results.reserve(jobs.size());
+
+        for(size_t i=0; i<jobs.size(); i++)
+        {
+            results.push_back(RunJob(jobs[i]));
+        }
+
+        return results;
+    }
+
+    // the calling thread runs jobs while it waits for them, so the pool has one thread less;
+    // the task groups within the designs use the pool of their job
+    std::auto_ptr<WorkStealingThreadPool> own_pool;
+    if(m_count_threads != 0)
+    {
+        own_pool.reset(new WorkStealingThreadPool(m_count_threads-1));
+    }
+
+    DesignJobScheduler scheduler(own_pool.get() ? *own_pool : WorkStealingThreadPool::GlobalInstance());
+
+    for(size_t i=0; i<jobs.size(); i++)
+    {
+        scheduler.Submit(jobs[i]);
+    }
+
+    return scheduler.WaitAll();
+}
+
+
+void BatchDesignEngine::ReportResults(const std::vector<DesignJobResult> & results, std::ostream & out_stream)
+{
+    size_t count_failed = 0;
+    double total_ms = 0.0;
+
+    out_stream<<std::setiosflags(std::ios::fixed)<<std::setiosflags(std::ios::showpoint);
+    out_stream.precision(1);
+
+    for(size_t i=0; i<results.size(); i++)
+    {
+        const DesignJobResult & r = results[i];
+
+        out_stream<<(r.succeeded ? "[ OK ] " : "[FAIL] ")<<r.name
+                  <<" load: "<<r.load_ms<<" ms"
+                  <<", design: "<<r.design_ms<<" ms"
+                  <<", output: "<<r.output_ms<<" ms"
+                  <<", total: "<<r.TotalMilliseconds()<<" ms";
+
+        if(r.succeeded)
+        {
+            out_stream<<", points: "<<r.count_flight_points;
+        }
+        else
+        {
+            out_stream<<", error: "<<r.error;
+            count_failed++;
+        }
+        out_stream<<"\n";
+
+        total_ms += r.TotalMilliseconds();
+    }
+
+    out_stream<<"Jobs: "<<results.size()
+              <<", failed: "<<count_failed
+              <<", total: "<<total_ms<<" ms\n";
+}
+
+
+void BatchDesignEngine::ReportResultsCSV(const std::vector<DesignJobResult> & results, std::ostream & out_stream)
+{
+    out_stream<<std::setiosflags(std::ios::fixed)<<std::setiosflags(std::ios::showpoint);
+    out_stream.precision(3);
+
+    out_stream<<"job,status,load_ms,design_ms,output_ms,total_ms,flight_points,error\n";
+
+    for(size_t i=0; i<results.size(); i++)
+    {
+        const DesignJobResult & r = results[i];
+
+        std::string error(r.error);
+        std::replace(error.begin(), error.end(), ',', ';');
+
+        out_stream<<r.name<<","
+                  <<(r.succeeded ? "ok" : "failed")<<","
+                  <<r.load_ms<<","
+                  <<r.design_ms<<","
+                  <<r.output_ms<<","
+                  <<r.TotalMilliseconds()<<","
+                  <<r.count_flight_points<<","
+                  <<error<<"\n";
+    }
+}
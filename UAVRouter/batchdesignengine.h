@@ -0,0 +1,58 @@
+#ifndef BATCHDESIGNENGINE_H
+#define BATCHDESIGNENGINE_H
+
+/// BatchDesignEngine: run route designs without any QApplication/MainWindow
+/// each job goes through the same path as MainWindow::on_cmdDesignStart_clicked,
+/// ie. DesignTaskFactory -> PerformRouteDesign -> OutputRouteFile (or StreamRouteDesign if DesignJob::stream_output),
+/// a failed job is reported in its result and does not stop the batch;
+/// with more than one thread the jobs go through a DesignJobScheduler
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "designjob.h"
+
+struct DesignJobResult
+{
+public:
+    DesignJobResult();
+
+    std::string name;
+    bool succeeded;
+    std::string error;
+
+    // timing of each stage, in milliseconds
+    double load_ms;     // reading the regions
+    double design_ms;   // PerformRouteDesign, or StreamRouteDesign with the output
+    double output_ms;   // OutputRouteFile
+
+    size_t count_flight_points;
+
+    inline double TotalMilliseconds() const {
+        return load_ms + design_ms + output_ms; };
+};
+
+
+class BatchDesignEngine
+{
+public:
+    // count_threads=0: one thread per core, 1: all the jobs in the calling thread
+    explicit BatchDesignEngine(size_t count_threads=0);
+
+public:
+    // thread safe, never throws
+    static DesignJobResult RunJob(const DesignJob & job);
+
+    std::vector<DesignJobResult> RunJobs(const std::vector<DesignJob> & jobs);
+
+    // one line per job, then the summary
+    static void ReportResults(const std::vector<DesignJobResult> & results, std::ostream & out_stream);
+    // comma separated, one line per job
+    static void ReportResultsCSV(const std::vector<DesignJobResult> & results, std::ostream & out_stream);
+
+protected:
+    size_t m_count_threads;
+};
+
+#endif // BATCHDESIGNENGINE_H
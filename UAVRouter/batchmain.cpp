@@ -0,0 +1,846 @@
+/// UAVRouterBatch: command line route designer
+///
+///     UAVRouterBatch <manifest.ini> [--threads n] [--report report.csv] [--projection native|gdal]
+///     UAVRouterBatch --check-projection
+///     UAVRouterBatch --check-text-format
+///     UAVRouterBatch --check-encryption
+///     UAVRouterBatch --verify <directory> [--threads n]
+///
+/// runs every job of the manifest (see designjob.h) without any QApplication,
+/// on n threads (default: one per core),
+/// prints the timing of each job and returns the count of failed jobs (0 if all done)
+///
+/// --check-projection compares the native gauss projection with the GDAL one,
+/// prints the differences and the points per second of both, returns 0 if they agree
+///
+/// --check-text-format compares the numbers of TextLineFormatter with the ones of an ostream
+/// (std::fixed, setprecision, setw, setfill), on rounding ties, negatives, large and random values,
+/// then a fixed route written as .ght and .gst by UAVRouteOutputer with the same files written by
+/// a copy of the former ostream writer, prints the differences, returns 0 if the text is the same
+///
+/// --check-encryption compares CoordinateOutput::EncryptCoordinates and PointIdKey with
+/// GetAsEncryptString on random coordinates and point ids, including the ones out of range which throw,
+/// prints the differences, returns 0 if they agree
+///
+/// --verify decodes every .bht, .ght and .gst file of the directory (and its sub directories),
+/// encodes it again and compares the bytes, returns the count of files which differ
+
+#include "designjob.h"
+#include "batchdesignengine.h"
+#include "gaussprojector.h"
+#include "routefileverifier.h"
+#include "textlineformatter.h"
+#include "coordinateoutput.h"
+#include "uavrouteoutputer.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <random>
+#include <climits>
+
+#include <QElapsedTimer>
+
+
+static void PrintUsage()
+{
+    std::cerr<<"Usage: UAVRouterBatch <manifest.ini> [--threads n] [--report report.csv] [--projection native|gdal]"<<std::endl;
+    std::cerr<<"       UAVRouterBatch --check-projection"<<std::endl;
+    std::cerr<<"       UAVRouterBatch --check-text-format"<<std::endl;
+    std::cerr<<"       UAVRouterBatch --check-encryption"<<std::endl;
+    std::cerr<<"       UAVRouterBatch --verify <directory> [--threads n]"<<std::endl;
+}
+
+
+// project the points by the backend, return the points per second of forward + inverse
+static double ProjectByBackend(GaussProjector::Backend backend, double central_meridian,
+                               std::vector<double> & x, std::vector<double> & y,
+                               std::vector<double> & x_inverse, std::vector<double> & y_inverse)
+{
+    GaussProjector projector(central_meridian, false, backend);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    projector.Forward((int)x.size(), &x[0], &y[0]);
+
+    x_inverse = x;
+    y_inverse = y;
+    projector.Inverse((int)x_inverse.size(), &x_inverse[0], &y_inverse[0]);
+
+    double seconds = timer.nsecsElapsed()/1.0e9;
+    return seconds>0.0 ? x.size()/seconds : 0.0;
+}
+
+// the native projection against the GDAL one, within 3 degree of the central meridian
+static int CheckProjection()
+{
+    const double central_meridian = 117.0;
+    const double tolerance = 0.001;     // m
+    const double meters_per_degree = 111319.49;
+
+    std::vector<double> lon, lat;
+    for(double dlat=-80.0; dlat<=80.0; dlat+=0.05 )
+    {
+        for(double dlon=-3.0; dlon<=3.0; dlon+=0.05 )
+        {
+            lon.push_back(central_meridian+dlon);
+            lat.push_back(dlat);
+        }
+    }
+
+    std::vector<double> x_native = lon, y_native = lat, lon_native, lat_native;
+    std::vector<double> x_gdal   = lon, y_gdal   = lat, lon_gdal,   lat_gdal;
+
+    double speed_native = ProjectByBackend(GaussProjector::BACKEND_NATIVE, central_meridian,
+                                           x_native, y_native, lon_native, lat_native);
+    double speed_gdal   = ProjectByBackend(GaussProjector::BACKEND_GDAL, central_meridian,
+                                           x_gdal, y_gdal, lon_gdal, lat_gdal);
+
+    double max_forward = 0.0, max_inverse = 0.0, max_round_trip = 0.0;
+    for(size_t i=0; i<lon.size(); i++ )
+    {
+        double forward = std::max(fabs(x_native[i]-x_gdal[i]), fabs(y_native[i]-y_gdal[i]));
+        double inverse = std::max(fabs(lon_native[i]-lon_gdal[i]), fabs(lat_native[i]-lat_gdal[i]))*meters_per_degree;
+        double round_trip = std::max(fabs(lon_native[i]-lon[i]), fabs(lat_native[i]-lat[i]))*meters_per_degree;
+
+        max_forward = std::max(max_forward, forward);
+        max_inverse = std::max(max_inverse, inverse);
+        max_round_trip = std::max(max_round_trip, round_trip);
+    }
+
+    std::cout<<"Points: "<<lon.size()<<", AVX2: "<<(TransverseMercator::HasAVX2() ? "yes" : "no")<<std::endl;
+    std::cout<<"Native - GDAL, forward:    "<<max_forward<<" m"<<std::endl;
+    std::cout<<"Native - GDAL, inverse:    "<<max_inverse<<" m"<<std::endl;
+    std::cout<<"Native round trip:         "<<max_round_trip<<" m"<<std::endl;
+    std::cout<<"Native points/second:      "<<speed_native<<std::endl;
+    std::cout<<"GDAL points/second:        "<<speed_gdal<<std::endl;
+
+    bool agree = max_forward<tolerance && max_inverse<tolerance && max_round_trip<tolerance;
+    std::cout<<(agree ? "Projection check passed" : "Projection check FAILED")<<std::endl;
+
+    return agree ? 0 : 1;
+}
+
+// the fixed number of TextLineFormatter against the ostream, print the first differences
+static bool CompareFixed(double value, int precision, int width, char fill,
+                         TextLineFormatter & line, std::ostringstream & stream, int & count_differences)
+{
+    line.Clear();
+    line.AppendFixed(value, precision, width, fill);
+
+    stream.str("");
+    stream<<std::fixed<<std::setprecision(precision)<<std::setw(width)<<std::setfill(fill)<<value;
+
+    std::string expected = stream.str();
+    if(expected.size()==line.Size() && 0==memcmp(expected.data(), line.Data(), line.Size()))
+    {
+        return true;
+    }
+
+    if(count_differences++ < 10)
+    {
+        std::cout<<std::setprecision(17)<<std::scientific<<value<<" precision "<<precision<<" width "<<width
+                 <<": \""<<std::string(line.Data(), line.Size())<<"\" expected \""<<expected<<"\""<<std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout<<std::setprecision(6);
+    }
+    return false;
+}
+
+// the integer of TextLineFormatter against the ostream, print the first differences
+static bool CompareInteger(long long value, int width, char fill,
+                           TextLineFormatter & line, std::ostringstream & stream, int & count_differences)
+{
+    line.Clear();
+    line.AppendInteger(value, width, fill);
+
+    stream.str("");
+    stream<<std::setw(width)<<std::setfill(fill)<<value;
+
+    std::string expected = stream.str();
+    if(expected.size()==line.Size() && 0==memcmp(expected.data(), line.Data(), line.Size()))
+    {
+        return true;
+    }
+
+    if(count_differences++ < 10)
+    {
+        std::cout<<value<<" width "<<width
+                 <<": \""<<std::string(line.Data(), line.Size())<<"\" expected \""<<expected<<"\""<<std::endl;
+    }
+    return false;
+}
+
+// the former ostream writer of the header, kept as the reference of UAVROUTE_HEADER::Output
+static void ReferenceHeaderText(const UAVRouteHEADER & header, std::ostream & out_stream, bool encrypt)
+{
+    //BEGIN FLAG
+    out_stream<<"BEGIN"<<"\n";
+    int intAirportHeight=header.airport_height;
+
+    std::string airport_upper(header.airport_name);
+    std::transform(header.airport_name.begin(), header.airport_name.end(), airport_upper.begin(), toupper);
+
+    if(encrypt==false)
+    {
+        out_stream<<std::setiosflags(ios::fixed)<<std::setiosflags(ios::showpoint);
+        out_stream.precision(COORDINATE_DEGREE_PRECISION);
+
+        //first line
+        out_stream<<header.min_latitude
+                  <<SPACE<<header.max_latitude
+                  <<SPACE;
+
+        ios state(nullptr);
+        state.copyfmt(out_stream); // save current formatting
+        out_stream << std::setw(COORDINATE_DEGREE_PRECISION+4)
+                  << std::setfill('0')
+                  <<header.min_longitude
+                  <<SPACE
+                  << std::setw(COORDINATE_DEGREE_PRECISION+4)
+                  << std::setfill('0')
+                  <<header.max_longitude<<"\n";
+        out_stream.copyfmt(state); // restore previous formatting
+
+        //second line
+        out_stream<<airport_upper
+                  <<SPACE<<header.airport_latitude
+                  <<SPACE;
+
+        state.copyfmt(out_stream); // save current formatting
+        out_stream << std::setw(COORDINATE_DEGREE_PRECISION+4)
+                  << std::setfill('0')
+                  <<header.airport_longitude;
+        out_stream.copyfmt(state); // restore previous formatting
+
+        //output the height
+        state.copyfmt(out_stream); // save current formatting
+        out_stream <<SPACE
+                  << std::setw(4)
+                  << std::setfill('0')
+                  <<intAirportHeight
+                  <<"\n";
+        out_stream.copyfmt(state); // restore previous formatting
+    }
+}
+
+// the former ostream writer of a flight point, kept as the reference of UAVROUTE_FLIGHT_POINT::Output
+static void ReferencePointText(const UAVFlightPoint & point, std::ostream & out_stream, bool encrypt)
+{
+    using Gomo::FlightRoute::CoordinateOutput;
+
+    ostringstream stream_pointid;
+    stream_pointid.str("");
+
+    out_stream<<std::setiosflags(ios::fixed)<<std::setiosflags(ios::showpoint);
+    out_stream.precision(COORDINATE_DEGREE_PRECISION);
+
+    // output strip id
+    unsigned int strip_id= point.__strip_id;
+    ios state(nullptr);
+    state.copyfmt(out_stream); // save current formatting
+    out_stream << std::setw(2)
+         << std::setfill('0')
+         << strip_id<<"-";
+    out_stream.copyfmt(state); // restore previous formatting
+
+    std::string pt_flag_A_B;
+
+    if( point.__flight_point_type & FLIGTH_POINT_TYPE_A_POINT_MASK )
+    {
+        pt_flag_A_B = "0A";
+    }
+    else if(point.__flight_point_type & FLIGTH_POINT_TYPE_B_POINT_MASK)
+    {
+        pt_flag_A_B = "0B";
+    }
+    else
+    {
+        pt_flag_A_B="";
+    }
+
+    int pt_class;
+
+    // output point id
+    if( point.__flight_point_type == FLIGTH_POINT_TYPE_EXPOSURE)
+    {
+        state.copyfmt(out_stream); // save current formatting
+        out_stream << std::setw(3)
+             << std::setfill('0')
+             << point.__id_in_strip;
+        out_stream.copyfmt(state); // restore previous formatting
+
+        pt_class= FLIGTH_POINT_TYPE_EXPOSURE;
+
+        stream_pointid<<point.__id_in_strip;// for encrypt
+    }
+    else if ( point.__flight_point_type & FLIGTH_POINT_TYPE_GUIDE)
+    {
+        out_stream<<pt_flag_A_B<<FLIGTH_POINT_TYPE_GUIDE ;
+        pt_class= FLIGTH_POINT_TYPE_GUIDE;
+
+        stream_pointid <<pt_flag_A_B<<FLIGTH_POINT_TYPE_GUIDE ; // for encrypt
+    }
+    else if ( point.__flight_point_type & FLIGTH_POINT_TYPE_ETRANCE_EXIT)
+    {
+        out_stream<<pt_flag_A_B<<FLIGTH_POINT_TYPE_ETRANCE_EXIT ;
+        pt_class= FLIGTH_POINT_TYPE_ETRANCE_EXIT;
+
+        stream_pointid <<pt_flag_A_B<<FLIGTH_POINT_TYPE_ETRANCE_EXIT ; // for encrypt
+    }
+
+    int height_int = point.__height +0.5;
+
+    out_stream.precision(COORDINATE_DEGREE_PRECISION);
+
+    if(encrypt==false)
+    {
+        out_stream<<SPACE<<point.__latitude<<SPACE;
+
+        state.copyfmt(out_stream); // save current formatting
+        out_stream << std::setw(COORDINATE_DEGREE_PRECISION+4)
+                  << std::setfill('0')
+                  <<point.__longitude;
+        out_stream.copyfmt(state); // restore previous formatting
+    }
+    else
+    {
+        CoordinateOutput coordoutput;
+
+        coordoutput.SetPointIdForEncryptionStep3A(stream_pointid.str());
+        coordoutput.SetAsDouble(point.__latitude,point.__longitude);
+
+        out_stream<<SPACE<<coordoutput.GetAsEncryptString();
+    }
+
+    //output the height and pt_class
+    state.copyfmt(out_stream); // save current formatting
+    out_stream <<SPACE
+              << std::setw(4)
+              << std::setfill('0')
+              <<height_int;
+    out_stream.copyfmt(state); // restore previous formatting
+
+    //point class
+    out_stream <<SPACE<<pt_class<<"\n";
+}
+
+// the former ostream writer of the statistic, kept as the reference of UAVFLIGHT_STATISTIC_INFO::Output
+static void ReferenceStatisticText(const UAVFlightStatisticInfo & statistic, std::ostream & out_stream)
+{
+    unsigned int count_strips= statistic.__count_strips;
+
+    out_stream<<std::setiosflags(ios::fixed)<<std::setiosflags(ios::showpoint);
+    out_stream.precision(2);
+
+    out_stream<<"MBR Area(m2):"<< statistic.__MBR_Area<<"\n";
+    out_stream<<"Flight Region Polygon Area(m2):"<< statistic.__flight_region_area <<"\n";
+    out_stream<<"Exposure Points Count:"<< statistic.__count_exposures<<"\n";
+    out_stream<<"Strips Count:"<< count_strips<<"\n";
+    out_stream<<"Flight Course Length(m):"<< statistic.__photo_flight_course_chainage<<"\n";
+}
+
+// a route with the paddings of the ids and heights, the A/B flags, negative and tied coordinates,
+// more points than one encryption batch; the coordinates stay in the range of the .gst encryption
+static void FixedRouteDesign(UAVRouteDesign & route_design)
+{
+    route_design.__header.min_latitude = 34.123455;
+    route_design.__header.max_latitude = 34.9999951;
+    route_design.__header.min_longitude = -3.5;
+    route_design.__header.max_longitude = 113.000005;
+    route_design.__header.airport_name = "ZhengZhou";
+    route_design.__header.airport_latitude = 34.5;
+    route_design.__header.airport_longitude = 9.87654321;
+    route_design.__header.airport_height = 87.9;
+
+    const unsigned char strip_ids[] = { 1, 9, 10, 99, 123 };
+    const int count_strip_ids = sizeof(strip_ids)/sizeof(strip_ids[0]);
+    const unsigned int point_types[] = {
+        FLIGTH_POINT_TYPE_GUIDE | FLIGTH_POINT_TYPE_A_POINT_MASK,
+        FLIGTH_POINT_TYPE_ETRANCE_EXIT | FLIGTH_POINT_TYPE_A_POINT_MASK,
+        FLIGTH_POINT_TYPE_EXPOSURE,
+        FLIGTH_POINT_TYPE_ETRANCE_EXIT | FLIGTH_POINT_TYPE_B_POINT_MASK,
+        FLIGTH_POINT_TYPE_GUIDE | FLIGTH_POINT_TYPE_B_POINT_MASK,
+        FLIGTH_POINT_TYPE_GUIDE,
+        FLIGTH_POINT_TYPE_ETRANCE_EXIT
+    };
+    const double heights[] = { 0.0, 0.49, 0.5, 7.5, 99.5, 999.4, 9999.5, 12345.6, -0.4, -3.7 };
+    const int count_heights = sizeof(heights)/sizeof(heights[0]);
+    const unsigned int ids_in_strip[] = { 0, 7, 99, 100, 999, 1000, 12345 };
+    const int count_ids = sizeof(ids_in_strip)/sizeof(ids_in_strip[0]);
+
+    std::mt19937_64 random(20141101);
+    std::uniform_real_distribution<double> latitudes(-89.0, 89.0);
+    std::uniform_real_distribution<double> longitudes(-99.0, 179.0);
+    std::uniform_int_distribution<long long> ties(-9000000LL, 9000000LL);
+
+    route_design.__flight_point.clear();
+    for(int i=0; i<600; i++ )
+    {
+        UAVFlightPoint point;
+        point.__strip_id = strip_ids[(i/40)%count_strip_ids];
+        point.__flight_point_type = (enumFlightPointType)point_types[i%7];
+        point.__id_in_strip = i%5==2 ? ids_in_strip[(i/5)%count_ids] : i;
+        point.__height = i%3==0 ? heights[(i/3)%count_heights] : 100.0+i*0.37;
+
+        // a random coordinate, or a tie of the 5 decimals
+        if(i%4==0)
+        {
+            point.__latitude = (ties(random)+0.5)/1e5;
+            point.__longitude = (ties(random)+0.5)/1e5;
+        }
+        else
+        {
+            point.__latitude = latitudes(random);
+            point.__longitude = longitudes(random);
+        }
+        route_design.__flight_point.push_back(point);
+    }
+
+    route_design.__flight_statistic.__MBR_Area = 123456.789f;
+    route_design.__flight_statistic.__flight_region_area = 0.005f;
+    route_design.__flight_statistic.__count_exposures = 600;
+    route_design.__flight_statistic.__count_strips = 5;
+    route_design.__flight_statistic.__photo_flight_course_chainage = 98765.4321f;
+}
+
+// the fixed route as a .ght (or .gst) file by UAVRouteOutputer and by the former ostream writer,
+// byte for byte; print the first line which differs, return 1 if the files differ
+static int CheckRouteText(bool encrypt)
+{
+    UAVRouteDesign route_design;
+    FixedRouteDesign(route_design);
+
+    std::ostringstream encoded;
+    UAVRouteOutputer::EncodeRouteDesignAsText(route_design, encoded, encrypt);
+
+    std::ostringstream reference;
+    ReferenceHeaderText(route_design.__header, reference, encrypt);
+    for(size_t i=0; i<route_design.__flight_point.size(); i++ )
+    {
+        ReferencePointText(route_design.__flight_point[i], reference, encrypt);
+    }
+    reference<<"END"<<"\n";
+    ReferenceStatisticText(route_design.__flight_statistic, reference);
+
+    std::string text = encoded.str();
+    std::string expected = reference.str();
+
+    std::cout<<(encrypt ? ".gst" : ".ght")<<" route: "<<expected.size()<<" bytes";
+    if(text == expected)
+    {
+        std::cout<<", same"<<std::endl;
+        return 0;
+    }
+
+    // the first line which differs
+    size_t position = 0;
+    while(position < text.size() && position < expected.size() && text[position]==expected[position])
+    {
+        position++;
+    }
+    size_t line_begin = position==0 ? std::string::npos : expected.rfind('\n', position-1);
+    line_begin = line_begin==std::string::npos ? 0 : line_begin+1;
+    int line_number = 1 + (int)std::count(expected.begin(), expected.begin()+line_begin, '\n');
+
+    std::cout<<", "<<text.size()<<" written, first difference in line "<<line_number<<": \""
+             <<text.substr(line_begin, text.find('\n', line_begin)-line_begin)<<"\" expected \""
+             <<expected.substr(line_begin, expected.find('\n', line_begin)-line_begin)<<"\""<<std::endl;
+    return 1;
+}
+
+// TextLineFormatter against the ostream path of the route files, byte for byte
+static int CheckTextFormat()
+{
+    const int max_precision = 10;   // 10 is above the fast path of TextLineFormatter
+    const int widths[] = { 0, 2, 4, 9, 12, 20 };
+    const int count_widths = sizeof(widths)/sizeof(widths[0]);
+    const int count_random = 200000;
+
+    // rounding ties, negatives, denormals and values above the fast path
+    const double edge_values[] = {
+        0.0, -0.0, 0.5, 1.5, 2.5, -0.5, -1.5, -2.5, 0.125, 0.375, -0.125, 1.005, 2.675, 1.0e-5, 5.0e-6, 5.0e-9, -5.0e-6,
+        0.000005, 116.123456785, 39.999995, 179.999995, -179.999995, 180.0, -180.0, 89.999999995, -89.999999995,
+        1.0e-320, -1.0e-320, 4.9e-324, 999999999.4999999, 999999999.5, 1.0e9, -1.0e9, 1.0e9+0.5, -1.0e9-0.5,
+        4503599627370495.5, 9007199254740993.0, 1.0e15, -1.0e15, 1.0e20, -1.0e20, 1.0e300, 1.7976931348623157e308
+    };
+    const int count_edges = sizeof(edge_values)/sizeof(edge_values[0]);
+
+    TextLineFormatter line;
+    std::ostringstream stream;
+    std::mt19937_64 random(20141027);
+    int count_checked = 0, count_differences = 0;
+
+    for(int i=0; i<count_edges; i++ )
+    {
+        for(int precision=0; precision<=max_precision; precision++ )
+        {
+            for(int w=0; w<count_widths; w++ )
+            {
+                CompareFixed(edge_values[i], precision, widths[w], '0', line, stream, count_differences);
+                CompareFixed(edge_values[i], precision, widths[w], ' ', line, stream, count_differences);
+                count_checked += 2;
+            }
+        }
+    }
+
+    std::uniform_real_distribution<double> degrees(-180.0, 180.0);
+    std::uniform_real_distribution<double> exponents(-12.0, 18.0);
+    std::uniform_int_distribution<long long> digits(-2000000000LL, 2000000000LL);
+    std::uniform_int_distribution<int> precisions(0, max_precision);
+    std::uniform_int_distribution<int> width_ids(0, count_widths-1);
+
+    for(int i=0; i<count_random; i++ )
+    {
+        int precision = precisions(random);
+        int width = widths[width_ids(random)];
+
+        // a coordinate, a value of any magnitude, and a decimal tie with its neighbours
+        double coordinate = degrees(random);
+        double magnitude = pow(10.0, exponents(random)) * (random()&1 ? -1.0 : 1.0);
+        double tie = (digits(random)+0.5)/pow(10.0, precision);
+
+        CompareFixed(coordinate, precision, width, '0', line, stream, count_differences);
+        CompareFixed(magnitude, precision, width, '0', line, stream, count_differences);
+        CompareFixed(tie, precision, width, '0', line, stream, count_differences);
+        CompareFixed(nextafter(tie, HUGE_VAL), precision, width, '0', line, stream, count_differences);
+        CompareFixed(nextafter(tie, -HUGE_VAL), precision, width, '0', line, stream, count_differences);
+        count_checked += 5;
+    }
+
+    const long long edge_integers[] = { 0, 1, -1, 9, -9, 10, -10, 999, -999, 1000, 12345, -12345, LLONG_MAX, LLONG_MIN };
+    const int count_edge_integers = sizeof(edge_integers)/sizeof(edge_integers[0]);
+    for(int i=0; i<count_edge_integers; i++ )
+    {
+        for(int w=0; w<count_widths; w++ )
+        {
+            CompareInteger(edge_integers[i], widths[w], '0', line, stream, count_differences);
+            count_checked++;
+        }
+    }
+    std::uniform_int_distribution<long long> integers(-100000, 100000);
+    for(int i=0; i<count_random; i++ )
+    {
+        CompareInteger(integers(random), widths[width_ids(random)], '0', line, stream, count_differences);
+        count_checked++;
+    }
+
+    std::cout<<"Numbers: "<<count_checked<<", differences: "<<count_differences<<std::endl;
+
+    int count_route_differences = CheckRouteText(false) + CheckRouteText(true);
+
+    bool agree = 0==count_differences && 0==count_route_differences;
+    std::cout<<(agree ? "Text format check passed" : "Text format check FAILED")<<std::endl;
+
+    return agree ? 0 : 1;
+}
+
+// the string path of CoordinateOutput for one point: the 16 chars, or false if it throws
+static bool EncryptByString(double lat, double lon, const std::string & point_id, std::string & encrypted)
+{
+    Gomo::FlightRoute::CoordinateOutput output;
+    output.SetAsDouble(lat, lon);
+    output.SetPointIdForEncryptionStep3A(point_id);
+    try
+    {
+        encrypted = output.GetAsEncryptString();
+    }
+    catch(const char *)
+    {
+        return false;
+    }
+    return true;
+}
+
+// the batch encryption of the .gst file against GetAsEncryptString, point by point
+static int CheckEncryption()
+{
+    using Gomo::FlightRoute::CoordinateOutput;
+
+    const int count_batches = 2000;
+    const size_t batch_size = 256;
+
+    std::mt19937_64 random(20140427);
+    std::uniform_real_distribution<double> latitudes(-90.0, 90.0);
+    std::uniform_real_distribution<double> longitudes(-99.99999, 180.0);
+    std::uniform_real_distribution<double> out_of_range(-3000.0, 3000.0);
+    std::uniform_int_distribution<long long> lat_ties(-9000000LL, 9000000LL);
+    std::uniform_int_distribution<long long> lon_ties(-9999999LL, 18000000LL);
+    std::uniform_int_distribution<int> id_lengths(1, 6);
+    std::uniform_int_distribution<int> kinds(0, 9);
+    const char * id_chars = "0123456789ABCDEF-_";
+
+    // around the limits of the 8 chars, 8 digits or the sign and 7 digits
+    const double limits[] = { 999.99999, 999.999994, 999.999995, 1000.0, -99.99999, -100.0, -100.000005, -100.00001 };
+    const int count_limits = sizeof(limits)/sizeof(limits[0]);
+
+    std::vector<double> lat(batch_size), lon(batch_size);
+    std::vector<unsigned char> keys(batch_size);
+    std::vector<std::string> point_ids(batch_size);
+    std::vector<char> encrypted(16*batch_size);
+    std::vector<std::string> expected(batch_size);
+    std::vector<bool> expected_valid(batch_size);
+
+    int count_checked = 0, count_throwing = 0, count_differences = 0, count_whole_batches = 0;
+
+    for(int b=0; b<count_batches; b++ )
+    {
+        // one batch in 8 with a few points out of the 8 chars of a coordinate
+        bool with_out_of_range = 7==b%8;
+        bool batch_valid = true;
+
+        for(size_t i=0; i<batch_size; i++ )
+        {
+            // mostly coordinates and some .5e-5 ties, the negative ones have room for 7 digits
+            int kind = kinds(random);
+            if(kind<7)
+            {
+                lat[i] = latitudes(random);
+                lon[i] = longitudes(random);
+            }
+            else if(kind<9 || !with_out_of_range)
+            {
+                lat[i] = (lat_ties(random)+0.5)/1e5;
+                lon[i] = (lon_ties(random)+0.5)/1e5;
+            }
+            else
+            {
+                lat[i] = out_of_range(random);
+                lon[i] = random()&1 ? limits[random()%count_limits] : out_of_range(random);
+            }
+
+            int length = id_lengths(random);
+            point_ids[i].resize(length);
+            for(int c=0; c<length; c++ )
+            {
+                point_ids[i][c] = id_chars[random()%18];
+            }
+            keys[i] = CoordinateOutput::PointIdKey(point_ids[i].data(), point_ids[i].size());
+
+            expected_valid[i] = EncryptByString(lat[i], lon[i], point_ids[i], expected[i]);
+            batch_valid = batch_valid && expected_valid[i];
+        }
+
+        // the batch as the .gst writer calls it, or one point after the other if one throws
+        if(batch_valid)
+        {
+            count_whole_batches++;
+            CoordinateOutput::EncryptCoordinates(&lat[0], &lon[0], &keys[0], batch_size, &encrypted[0]);
+        }
+        else
+        {
+            bool batch_throws = false;
+            try
+            {
+                CoordinateOutput::EncryptCoordinates(&lat[0], &lon[0], &keys[0], batch_size, &encrypted[0]);
+            }
+            catch(const char *)
+            {
+                batch_throws = true;
+            }
+            if(!batch_throws && count_differences++ < 10)
+            {
+                std::cout<<"batch "<<b<<" does not throw"<<std::endl;
+            }
+        }
+
+        for(size_t i=0; i<batch_size; i++ )
+        {
+            count_checked++;
+
+            bool valid = true;
+            if(!batch_valid)
+            {
+                try
+                {
+                    CoordinateOutput::EncryptCoordinate(lat[i], lon[i], keys[i], &encrypted[16*i]);
+                }
+                catch(const char *)
+                {
+                    valid = false;
+                }
+            }
+
+            if(!expected_valid[i])
+            {
+                count_throwing++;
+            }
+
+            if(valid!=expected_valid[i])
+            {
+                if(count_differences++ < 10)
+                {
+                    std::cout<<std::setprecision(17)<<lat[i]<<" "<<lon[i]<<": throws "<<(valid ? "no" : "yes")
+                             <<" expected "<<(expected_valid[i] ? "no" : "yes")<<std::endl;
+                }
+                continue;
+            }
+
+            if(valid && 0!=memcmp(expected[i].data(), &encrypted[16*i], 16))
+            {
+                if(count_differences++ < 10)
+                {
+                    std::cout<<std::setprecision(17)<<lat[i]<<" "<<lon[i]<<" "<<point_ids[i]<<": "
+                             <<std::string(&encrypted[16*i], 16)<<" expected "<<expected[i]<<std::endl;
+                }
+            }
+        }
+    }
+    std::cout<<std::setprecision(6);
+
+    std::cout<<"Points: "<<count_checked<<", out of range: "<<count_throwing
+             <<", batches without one: "<<count_whole_batches<<"/"<<count_batches
+             <<", differences: "<<count_differences<<std::endl;
+
+    bool agree = 0==count_differences;
+    std::cout<<(agree ? "Encryption check passed" : "Encryption check FAILED")<<std::endl;
+
+    return agree ? 0 : 1;
+}
+
+
+int main(int argc, char *argv[])
+{
+    std::string manifest_file;
+    std::string report_file;
+    std::string verify_directory;
+    int count_threads = 0;
+
+    for(int i=1; i<argc; i++)
+    {
+        if(0 == strcmp(argv[i], "--threads") && i+1 < argc)
+        {
+            count_threads = atoi(argv[++i]);
+            if(count_threads < 0)
+            {
+                PrintUsage();
+                return -1;
+            }
+        }
+        else if(0 == strcmp(argv[i], "--report") && i+1 < argc)
+        {
+            report_file = argv[++i];
+        }
+        else if(0 == strcmp(argv[i], "--projection") && i+1 < argc)
+        {
+            ++i;
+            if(0 == strcmp(argv[i], "native"))
+            {
+                GaussProjector::SetDefaultBackend(GaussProjector::BACKEND_NATIVE);
+            }
+            else if(0 == strcmp(argv[i], "gdal"))
+            {
+                GaussProjector::SetDefaultBackend(GaussProjector::BACKEND_GDAL);
+            }
+            else
+            {
+                PrintUsage();
+                return -1;
+            }
+        }
+        else if(0 == strcmp(argv[i], "--check-projection"))
+        {
+            return CheckProjection();
+        }
+        else if(0 == strcmp(argv[i], "--check-text-format"))
+        {
+            return CheckTextFormat();
+        }
+        else if(0 == strcmp(argv[i], "--check-encryption"))
+        {
+            return CheckEncryption();
+        }
+        else if(0 == strcmp(argv[i], "--verify") && i+1 < argc)
+        {
+            verify_directory = argv[++i];
+        }
+        else if(manifest_file.empty() && argv[i][0] != '-')
+        {
+            manifest_file = argv[i];
+        }
+        else
+        {
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    if(!verify_directory.empty())
+    {
+        std::vector<std::string> files = RouteFileVerifier::FindRouteFiles(verify_directory);
+        std::cout<<"Route files in "<<verify_directory<<": "<<files.size()<<std::endl;
+
+        RouteFileVerifier verifier(count_threads);
+        std::vector<RouteFileCheck> checks = verifier.VerifyFiles(files);
+
+        RouteFileVerifier::ReportChecks(checks, std::cout);
+
+        int count_failed = 0;
+        for(size_t i=0; i<checks.size(); i++)
+        {
+            if(!checks[i].passed)
+            {
+                count_failed++;
+            }
+        }
+
+        return count_failed;
+    }
+
+    if(manifest_file.empty())
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    std::vector<DesignJob> jobs;
+    try
+    {
+        DesignJobManifest::Load(manifest_file, jobs);
+    }
+    catch(const char * error)
+    {
+        std::cerr<<manifest_file<<": "<<error<<std::endl;
+        return -1;
+    }
+
+    std::cout<<"Jobs in manifest: "<<jobs.size()<<std::endl;
+
+    BatchDesignEngine engine(count_threads);
+    std::vector<DesignJobResult> results = engine.RunJobs(jobs);
+
+    // the projectors cached by the jobs are no longer needed
+    GaussProjectorCache::Clear();
+
+    BatchDesignEngine::ReportResults(results, std::cout);
+
+    if(!report_file.empty())
+    {
+        std::ofstream report(report_file.c_str());
+        if(!report)
+        {
+            std::cerr<<"Can not write the report file: "<<report_file<<std::endl;
+            return -1;
+        }
+        BatchDesignEngine::ReportResultsCSV(results, report);
+    }
+
+    int count_failed = 0;
+    for(size_t i=0; i<results.size(); i++)
+    {
+        if(!results[i].succeeded)
+        {
+            count_failed++;
+        }
+    }
+
+    return count_failed;
+}
@@ -1,4 +1,5 @@
 #include "cogrgeometryfilereader.h"
+#include "ogrdriverregistration.h"
 #include <QDebug>
 #include <sstream>
 using std::ostringstream;
@@ -69,7 +70,7 @@ COGRGeometryFileReader::GetFirstOGRPolygonFromFile(std::string ogrfile)
 std::auto_ptr<OGRGeometry>
 COGRGeometryFileReader::GetFirstOGRGeometryFromFile(std::string ogrfile)
 {
-    OGRRegisterAll();
+    OGRDriverRegistration::RegisterAllOnce();
 
     OGRDataSource       *poDS;
 
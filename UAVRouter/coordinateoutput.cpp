@@ -3,11 +3,130 @@
 #include <iomanip>
 using std::ios;
 
+#include <cstring>
+
 
 namespace Gomo {
 
 namespace FlightRoute {
 
+namespace {
+
+    // the packed decimal (2 digits) of 0~99 and the 2 hex chars of a byte
+    struct EncryptionTables
+    {
+        unsigned char bcd_pairs[100];
+        char hex_pairs[256*2];
+        unsigned char hex_values[256];  // 0xFF but for the chars of hex_pairs
+
+        EncryptionTables()
+        {
+            memset(hex_values, 0xFF, sizeof(hex_values));
+
+            for(int i=0;i<100;i++)
+            {
+                bcd_pairs[i] = (unsigned char)( ((i/10)<<4) | (i%10) );
+            }
+
+            const char * hex_digits = "0123456789ABCDEF";
+            for(int i=0;i<256;i++)
+            {
+                hex_pairs[2*i]   = hex_digits[i>>4];
+                hex_pairs[2*i+1] = hex_digits[i&0x0F];
+            }
+            for(int i=0;i<16;i++)
+            {
+                hex_values[(unsigned char)hex_digits[i]] = (unsigned char)i;
+            }
+        }
+    };
+
+    const EncryptionTables ENCRYPTION_TABLES;
+
+    const uint64_t BYTES_0XEA = 0xEAEAEAEAEAEAEAEAULL;
+    const uint64_t BYTES_0X01 = 0x0101010101010101ULL;
+
+    // the 8 chars of ConvertSingleCoordinateToString as 8 nibbles (Step2), the first char the highest:
+    // the chars are the digits filled by '0' before the sign, the first one F for a negative value,
+    // and the '-' packs as its lowest 4 bits (D)
+    uint32_t PackCoordinate(double coord)
+    {
+        double lat_long_in_degree = coord*1e5;
+
+        long tolong = lat_long_in_degree+0.5;//for round
+
+        unsigned long magnitude = tolong<0 ? 0UL-(unsigned long)tolong : (unsigned long)tolong;
+
+        if(magnitude >= (tolong<0 ? 10000000UL : 100000000UL))
+        {
+            throw "step1.length()!=16";
+        }
+
+        unsigned long high4 = magnitude/10000;
+        unsigned long low4  = magnitude%10000;
+
+        uint32_t packed = ((uint32_t)ENCRYPTION_TABLES.bcd_pairs[high4/100]<<24)
+                        | ((uint32_t)ENCRYPTION_TABLES.bcd_pairs[high4%100]<<16)
+                        | ((uint32_t)ENCRYPTION_TABLES.bcd_pairs[low4/100]<<8)
+                        |  (uint32_t)ENCRYPTION_TABLES.bcd_pairs[low4%100];
+
+        if(tolong<0)
+        {
+            int count_digits = 1;
+            for(unsigned long rest=magnitude/10; rest!=0; rest/=10)
+            {
+                count_digits++;
+            }
+
+            // the sign just before the digits, then F over the first char
+            packed |= (uint32_t)0xD << (4*count_digits);
+            packed  = (packed & 0x0FFFFFFF) | 0xF0000000;
+        }
+
+        return packed;
+    }
+
+    // the inverse of PackCoordinate: the 8 nibbles of the digits, or F, the zeros, D and the digits
+    // of a negative value (F over the sign if there are 7 digits)
+    double UnpackCoordinate(uint32_t packed)
+    {
+        int nibble = 7;
+        bool negative = (packed>>28)==0xF;
+
+        if(negative)
+        {
+            nibble--;
+            while(nibble>0 && ((packed>>(4*nibble)) & 0xF)==0)
+            {
+                nibble--;
+            }
+            if(((packed>>(4*nibble)) & 0xF)==0xD)
+            {
+                nibble--;
+            }
+        }
+
+        long tolong = 0;
+        for( ; nibble>=0; nibble--)
+        {
+            unsigned int digit = (packed>>(4*nibble)) & 0xF;
+            if(digit>9)
+            {
+                throw "not an encrypted coordinate, CoordinateOutput::DecryptCoordinate";
+            }
+            tolong = tolong*10 + digit;
+        }
+
+        // the center of the values rounded to tolong by "+0.5 and a cast", which truncates a negative one toward zero
+        if(negative)
+        {
+            return (-tolong-1)/1e5;
+        }
+        return tolong/1e5;
+    }
+
+}
+
 CoordinateOutput::CoordinateOutput()
 {
     m_coordinate_lat=m_coordinate_lon=0;
@@ -215,6 +334,90 @@ std::string CoordinateOutput::GetAsEncryptString()
 
 }
 
+unsigned char CoordinateOutput::PointIdKey(const char * point_id, size_t length)
+{
+    if(length==0)
+    {
+        return 0;
+    }
+
+    unsigned char binary_values[2]={0,0};
+    size_t first = length>=2 ? length-2 : 0;
+    for(size_t i=first; i<length; i++)
+    {
+        unsigned char cha = point_id[i];
+        if (cha>='0' && cha<='9' )
+        {
+            cha -= '0';
+        }
+        else if(cha>='A' && cha<='F')
+        {
+            cha = cha - 'A' + 0xA;
+        }
+
+        binary_values[1-(length-1-i)] = cha;
+    }
+
+    unsigned char prelast = binary_values[0];
+    unsigned char last    = binary_values[1];
+
+    return ( (prelast<<4) & 0xF0 ) | (last & 0x0F);
+}
+
+// Step1 to Step4 on one 64 bits word: the 16 nibbles of the chars, the first byte the highest,
+// the xor chain of Step3 as a prefix xor from the highest byte
+void CoordinateOutput::EncryptCoordinate(double lat, double lon, unsigned char point_id_key, char * encrypted)
+{
+    uint64_t packed = ((uint64_t)PackCoordinate(lat)<<32) | PackCoordinate(lon);
+
+    packed ^= BYTES_0XEA;
+
+    packed ^= packed>>8;
+    packed ^= packed>>16;
+    packed ^= packed>>32;
+
+    packed ^= point_id_key*BYTES_0X01;
+
+    for(int i=0 ; i<8 ; i++)
+    {
+        unsigned int byte = (unsigned int)(packed>>(56-8*i)) & 0xFF;
+        memcpy(encrypted+2*i, ENCRYPTION_TABLES.hex_pairs+2*byte, 2);
+    }
+}
+
+void CoordinateOutput::EncryptCoordinates(const double * lat, const double * lon, const unsigned char * point_id_keys,
+                                          size_t count, char * encrypted)
+{
+    for(size_t i=0; i<count; i++)
+    {
+        EncryptCoordinate(lat[i], lon[i], point_id_keys[i], encrypted+16*i);
+    }
+}
+
+// EncryptCoordinate backward: the xor chain undone by one xor with the word shifted by a byte
+void CoordinateOutput::DecryptCoordinate(const char * encrypted, unsigned char point_id_key, double & lat, double & lon)
+{
+    uint64_t packed = 0;
+    for(int i=0 ; i<16 ; i++)
+    {
+        unsigned char value = ENCRYPTION_TABLES.hex_values[(unsigned char)encrypted[i]];
+        if(value==0xFF)
+        {
+            throw "not an encrypted coordinate, CoordinateOutput::DecryptCoordinate";
+        }
+        packed = (packed<<4) | value;
+    }
+
+    packed ^= point_id_key*BYTES_0X01;
+
+    packed ^= packed>>8;
+
+    packed ^= BYTES_0XEA;
+
+    lat = UnpackCoordinate((uint32_t)(packed>>32));
+    lon = UnpackCoordinate((uint32_t)packed);
+}
+
 //std::string CoordinateOutput::GetHeaderEncryptString()
 //{
 //    std::string step1=Step1_to16Chars(m_coordinate_lat,m_coordinate_lon);
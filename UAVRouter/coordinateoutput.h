@@ -18,6 +18,7 @@ using std::ostringstream;
 #include <string>
 using std::string;
 
+#include <cstddef>
 #include <cstdint>
 
 namespace Gomo {
@@ -36,6 +37,19 @@ namespace FlightRoute {
         std::string GetAsEncryptString();    // packed coordinates string for normal flight point
         //std::string GetHeaderEncryptString();// packed coordinates string for file header
 
+        // the same steps without the strings: the key of SetPointIdForEncryptionStep3A,
+        // and the 16 chars of GetAsEncryptString written to encrypted (not terminated)
+        static unsigned char PointIdKey(const char * point_id, size_t length);
+        static void EncryptCoordinate(double lat, double lon, unsigned char point_id_key, char * encrypted);
+
+        // EncryptCoordinate of count coordinates, 16 chars each one after the other in encrypted
+        static void EncryptCoordinates(const double * lat, const double * lon, const unsigned char * point_id_keys,
+                                       size_t count, char * encrypted);
+
+        // the inverse of EncryptCoordinate: the 16 chars of encrypted back to lat and lon,
+        // throw if they are not two encrypted coordinates
+        static void DecryptCoordinate(const char * encrypted, unsigned char point_id_key, double & lat, double & lon);
+
     protected:
         double m_coordinate_lat,m_coordinate_lon;
 
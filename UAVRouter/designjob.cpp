@@ -0,0 +1,307 @@
+#include "designjob.h"
+
+#include "cogrgeometryfilereader.h"
+
+#include <QSettings>
+#include <QStringList>
+#include <QFileInfo>
+#include <QDebug>
+
+#include <sstream>
+using std::ostringstream;
+
+
+DesignJob::DesignJob()
+{
+    // the same defaults as UIController::LoadDefaultDesignParameters2UI
+    CameraInfo.x0 = 0;
+    CameraInfo.y0 = 0;
+    CameraInfo.f = 55;
+    CameraInfo.width = 7760;
+    CameraInfo.height = 10328;
+    CameraInfo.pixelsize = 5.2/1000.0; //um => mm
+
+    AverageElevation = 0.0;
+    FightHeight = 1000.0;
+    GuidanceEntrancePointsDistance = 100.0;
+    overlap = 0.7;
+    overlap_crossStrip = 0.3;
+    RedudantBaselines = 0;
+
+    airport_longitude = 0.0;
+    airport_latitude = 0.0;
+    airport_altitude = 0.0;
+
+    optimize_region_order = false;
+    orientation_by_flight_length = false;
+    orientation_sweep = 0.0;
+    clip_strips = false;
+    decompose_regions = false;
+
+    output_formats.push_back("ght");
+    output_formats.push_back("kml");
+    stream_output = false;
+}
+
+
+void DesignJob::FillFlightParameter(FlightParameter & parameter) const
+{
+    parameter.CameraInfo = CameraInfo;
+
+    parameter.AverageElevation = AverageElevation;
+    parameter.FightHeight = FightHeight;
+    parameter.GuidanceEntrancePointsDistance = GuidanceEntrancePointsDistance;
+    parameter.overlap = overlap;
+    parameter.overlap_crossStrip = overlap_crossStrip;
+    parameter.RedudantBaselines = RedudantBaselines;
+    parameter.OptimizeRegionOrder = optimize_region_order;
+    parameter.OrientationByFlightLength = orientation_by_flight_length;
+    parameter.OrientationSweepResolution = orientation_sweep;
+    parameter.ClipStripsToRegion = clip_strips;
+    parameter.DecomposeRegions = decompose_regions;
+
+    OGRPoint airportLoc(airport_longitude, airport_latitude, airport_altitude);
+    parameter.airport.SetLocation(airportLoc);
+    if(!airport_name.empty())
+    {
+        parameter.airport.SetName(airport_name);
+    }
+
+    if(region_files.empty())
+    {
+        throw "No flight region in DesignJob::FillFlightParameter";
+    }
+
+    // same as MainWindow::fillInFlightParamRegionFiles
+    parameter.ClearFlightRegions();
+    if(1 == region_files.size())
+    {
+        parameter.FightRegion = COGRGeometryFileReader::GetFirstOGRGeometryFromFile(region_files[0]);
+        if(parameter.FightRegion.get() == NULL)
+        {
+            throw "Can not read the flight region file in DesignJob::FillFlightParameter";
+        }
+    }
+    else
+    {
+        for(size_t i=0; i<region_files.size(); i++)
+        {
+            std::auto_ptr<OGRGeometry> region = COGRGeometryFileReader::GetFirstOGRGeometryFromFile(region_files[i]);
+            if(region.get() == NULL)
+            {
+                throw "Can not read the flight region file in DesignJob::FillFlightParameter";
+            }
+
+            parameter.AddFlightRegionGeometry(region);
+        }
+    }
+}
+
+
+std::vector<std::string> DesignJob::GetOutputFiles() const
+{
+    std::vector<std::string> files;
+
+    for(size_t i=0; i<output_formats.size(); i++)
+    {
+        files.push_back(output_basename + "." + output_formats[i]);
+    }
+
+    return files;
+}
+
+
+namespace {
+
+    QString ResolvePath(const QString & base_dir, const QString & path)
+    {
+        QFileInfo fi(path);
+        if(fi.isRelative())
+        {
+            return base_dir + "/" + path;
+        }
+        return path;
+    }
+
+    // the value of a job key, or the default value of the manifest (keys outside of any group)
+    QVariant JobValue(const QSettings & settings, const QString & job, const QString & key)
+    {
+        QString job_key = job + "/" + key;
+        if(settings.contains(job_key))
+        {
+            return settings.value(job_key);
+        }
+        return settings.value(key);
+    }
+
+    double JobDouble(const QSettings & settings, const QString & job, const QString & key, double default_value)
+    {
+        QVariant value = JobValue(settings, job, key);
+        if(!value.isValid())
+        {
+            return default_value;
+        }
+
+        bool ok = false;
+        double d = value.toDouble(&ok);
+        if(!ok)
+        {
+            throw "Invalid number in the job manifest, DesignJobManifest::Load";
+        }
+        return d;
+    }
+
+    QStringList JobList(const QSettings & settings, const QString & job, const QString & key)
+    {
+        QStringList trimmed;
+
+        QVariant value = JobValue(settings, job, key);
+        if(!value.isValid())
+        {
+            return trimmed;
+        }
+
+        QStringList items = value.toStringList();
+        for(QStringList::const_iterator it=items.begin(); it!=items.end(); ++it)
+        {
+            QString item = (*it).trimmed();
+            if(!item.isEmpty())
+            {
+                trimmed.append(item);
+            }
+        }
+        return trimmed;
+    }
+}
+
+
+size_t DesignJobManifest::Load(const std::string & manifest_file, std::vector<DesignJob> & jobs)
+{
+    QString manifest_path = QString::fromLocal8Bit(manifest_file.c_str());
+    if(!QFileInfo(manifest_path).exists())
+    {
+        throw "The job manifest does not exist, DesignJobManifest::Load";
+    }
+
+    QSettings settings(manifest_path, QSettings::IniFormat);
+    if(settings.status() != QSettings::NoError)
+    {
+        throw "Can not parse the job manifest, DesignJobManifest::Load";
+    }
+
+    QString base_dir = QFileInfo(manifest_path).absolutePath();
+
+    size_t count_jobs = 0;
+
+    QStringList groups = settings.childGroups();
+    for(QStringList::const_iterator it_grp=groups.begin(); it_grp!=groups.end(); ++it_grp)
+    {
+        const QString & group = *it_grp;
+
+        DesignJob job;
+        job.name = group.toStdString();
+
+        job.CameraInfo.f = JobDouble(settings, group, "focus", job.CameraInfo.f);
+        job.CameraInfo.width = (long)JobDouble(settings, group, "cam_width", job.CameraInfo.width);
+        job.CameraInfo.height = (long)JobDouble(settings, group, "cam_height", job.CameraInfo.height);
+        job.CameraInfo.pixelsize = JobDouble(settings, group, "pixelsize", job.CameraInfo.pixelsize*1000.0)/1000.0; //um => mm
+
+        job.AverageElevation = JobDouble(settings, group, "datum_height", job.AverageElevation);
+        job.FightHeight = JobDouble(settings, group, "flight_height", job.FightHeight);
+        job.GuidanceEntrancePointsDistance = JobDouble(settings, group, "guidance_distance", job.GuidanceEntrancePointsDistance);
+        job.overlap = JobDouble(settings, group, "overlap", job.overlap*100.0)/100.0;
+        job.overlap_crossStrip = JobDouble(settings, group, "overlap_side", job.overlap_crossStrip*100.0)/100.0;
+        job.RedudantBaselines = (unsigned int)JobDouble(settings, group, "redundant_baselines", job.RedudantBaselines);
+
+        // airport=longitude, latitude[, altitude]
+        QStringList airport = JobList(settings, group, "airport");
+        if(airport.size() >= 2)
+        {
+            QStringList::const_iterator it = airport.begin();
+            bool ok_lon = false, ok_lat = false, ok_alt = true;
+            job.airport_longitude = (*it++).toDouble(&ok_lon);
+            job.airport_latitude = (*it++).toDouble(&ok_lat);
+            if(it != airport.end())
+            {
+                job.airport_altitude = (*it).toDouble(&ok_alt);
+            }
+            if(!ok_lon || !ok_lat || !ok_alt)
+            {
+                throw "Invalid airport in the job manifest, DesignJobManifest::Load";
+            }
+        }
+        else if(!airport.isEmpty())
+        {
+            throw "Invalid airport in the job manifest, DesignJobManifest::Load";
+        }
+        job.airport_name = JobValue(settings, group, "airport_name").toString().toStdString();
+
+        QStringList regions = JobList(settings, group, "regions");
+        for(QStringList::const_iterator it=regions.begin(); it!=regions.end(); ++it)
+        {
+            job.region_files.push_back(ResolvePath(base_dir, *it).toStdString());
+        }
+
+        QVariant optimize_order = JobValue(settings, group, "optimize_region_order");
+        if(optimize_order.isValid())
+        {
+            job.optimize_region_order = optimize_order.toBool();
+        }
+
+        QVariant orientation_by_length = JobValue(settings, group, "orientation_by_flight_length");
+        if(orientation_by_length.isValid())
+        {
+            job.orientation_by_flight_length = orientation_by_length.toBool();
+        }
+
+        job.orientation_sweep = JobDouble(settings, group, "orientation_sweep", job.orientation_sweep);
+        if(job.orientation_sweep < 0.0)
+        {
+            throw "Invalid orientation_sweep in the job manifest, DesignJobManifest::Load";
+        }
+
+        QVariant clip_strips = JobValue(settings, group, "clip_strips");
+        if(clip_strips.isValid())
+        {
+            job.clip_strips = clip_strips.toBool();
+        }
+
+        QVariant decompose_regions = JobValue(settings, group, "decompose_regions");
+        if(decompose_regions.isValid())
+        {
+            job.decompose_regions = decompose_regions.toBool();
+        }
+
+        QString output = JobValue(settings, group, "output").toString();
+        if(output.isEmpty())
+        {
+            output = group;
+        }
+        job.output_basename = ResolvePath(base_dir, output).toStdString();
+
+        QStringList formats = JobList(settings, group, "formats");
+        if(!formats.isEmpty())
+        {
+            job.output_formats.clear();
+            for(QStringList::const_iterator it=formats.begin(); it!=formats.end(); ++it)
+            {
+                job.output_formats.push_back((*it).toLower().toStdString());
+            }
+        }
+
+        QVariant stream_output = JobValue(settings, group, "stream_output");
+        if(stream_output.isValid())
+        {
+            job.stream_output = stream_output.toBool();
+        }
+
+        ostringstream streamdebug;
+        streamdebug<< "DesignJobManifest::Load: "<<job.name<<", regions: "<<job.region_files.size();
+        qDebug(streamdebug.str().c_str());
+
+        jobs.push_back(job);
+        count_jobs++;
+    }
+
+    return count_jobs;
+}
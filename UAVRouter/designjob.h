@@ -0,0 +1,84 @@
+#ifndef DESIGNJOB_H
+#define DESIGNJOB_H
+
+/// DesignJob: one headless route design task
+/// plain copyable description of a design (regions, camera, flight, airport and outputs),
+/// the FlightParameter owning the OGR geometries is only built when the job is run,
+/// so a batch of thousands of jobs does not keep thousands of regions in memory
+///
+/// DesignJobManifest: reads the jobs from an INI manifest, e.g.
+///
+///     ; keys outside of any group are the defaults of all jobs
+///     focus=55
+///     overlap=70
+///     formats=ght, kml, bht
+///
+///     [block_0001]
+///     regions=regions/block_0001.kml
+///     airport=104.05, 30.65, 500
+///     output=output/block_0001
+///     optimize_region_order=true
+///     orientation_by_flight_length=true
+///     orientation_sweep=0.5
+///     clip_strips=true
+///     decompose_regions=true
+///     stream_output=true
+///
+/// the units are the same as the ones of the MainWindow: focus in mm, pixelsize in um,
+/// overlaps in percent; relative paths are relative to the manifest file
+
+
+#include <string>
+#include <vector>
+
+#include "flightparameter.h"
+
+using namespace Gomo::FlightRoute;
+
+struct DesignJob
+{
+public:
+    DesignJob();
+
+    std::string name;
+
+    DigitalCameraInfo CameraInfo;           // pixelsize in mm, as FlightParameter
+
+    double AverageElevation;                // m
+    double FightHeight;                     // m
+    double GuidanceEntrancePointsDistance;  // m
+    double overlap;                         // (0,1)
+    double overlap_crossStrip;              // (0,1)
+    unsigned int RedudantBaselines;
+
+    double airport_longitude;
+    double airport_latitude;
+    double airport_altitude;
+    std::string airport_name;
+
+    std::vector<std::string> region_files;  // one region per file, designed in the given order
+    bool optimize_region_order;             // unless set, see FlightParameter::OptimizeRegionOrder
+    bool orientation_by_flight_length;      // unless set, see FlightParameter::OrientationByFlightLength
+    double orientation_sweep;               // degree, see FlightParameter::OrientationSweepResolution
+    bool clip_strips;                       // unless set, see FlightParameter::ClipStripsToRegion
+    bool decompose_regions;                 // unless set, see FlightParameter::DecomposeRegions
+    std::string output_basename;            // output path without suffix
+    std::vector<std::string> output_formats;// suffixes known by FlightRouteDesign::OutputRouteFile
+    bool stream_output;                     // write the outputs strip by strip, see FlightRouteDesign::StreamRouteDesign
+
+public:
+    // load the regions and fill all the design parameters, throw if any region can not be read
+    void FillFlightParameter(FlightParameter & parameter) const;
+
+    std::vector<std::string> GetOutputFiles() const;
+};
+
+
+class DesignJobManifest
+{
+public:
+    // append the jobs of the manifest to jobs, return the count of jobs read
+    static size_t Load(const std::string & manifest_file, std::vector<DesignJob> & jobs);
+};
+
+#endif // DESIGNJOB_H
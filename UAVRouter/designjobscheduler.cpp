@@ -0,0 +1,80 @@
+#include "designjobscheduler.h"
+
+
+DesignJobScheduler::DesignJobScheduler(WorkStealingThreadPool & pool)
+    :m_pool(pool),
+    m_group(pool)
+{
+}
+
+
+DesignJobScheduler::~DesignJobScheduler()
+{
+    // the tasks refer to the members, they must be finished before anything is destroyed
+    try
+    {
+        m_group.Wait();
+    }
+    catch(...)
+    {
+    }
+}
+
+
+void DesignJobScheduler::SetJobFinishedCallback(JobFinishedCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_callback_mutex);
+    m_job_finished = callback;
+}
+
+
+size_t DesignJobScheduler::Submit(const DesignJob & job)
+{
+    size_t index;
+    {
+        std::lock_guard<std::mutex> lock(m_jobs_mutex);
+        index = m_jobs.size();
+        m_jobs.push_back(job);
+        m_results.push_back(DesignJobResult());
+        m_results.back().name = job.name;
+    }
+
+    m_group.Run([this, index]{ RunJob(index); });
+
+    return index;
+}
+
+
+void DesignJobScheduler::RunJob(size_t index)
+{
+    const DesignJob * job;
+    {
+        std::lock_guard<std::mutex> lock(m_jobs_mutex);
+        job = &m_jobs[index];
+    }
+
+    // RunJob never throws, every error goes into the result of the job
+    DesignJobResult result = BatchDesignEngine::RunJob(*job);
+
+    DesignJobResult * stored;
+    {
+        std::lock_guard<std::mutex> lock(m_jobs_mutex);
+        stored = &m_results[index];
+    }
+    *stored = result;
+
+    std::lock_guard<std::mutex> lock(m_callback_mutex);
+    if(m_job_finished)
+    {
+        m_job_finished(result);
+    }
+}
+
+
+std::vector<DesignJobResult> DesignJobScheduler::WaitAll()
+{
+    m_group.Wait();
+
+    std::lock_guard<std::mutex> lock(m_jobs_mutex);
+    return std::vector<DesignJobResult>(m_results.begin(), m_results.end());
+}
@@ -0,0 +1,52 @@
+#ifndef DESIGNJOBSCHEDULER_H
+#define DESIGNJOBSCHEDULER_H
+
+/// DesignJobScheduler: runs design jobs concurrently on a WorkStealingThreadPool
+/// the jobs are independent (each one builds its own FlightParameter and FlightRouteDesign),
+/// Submit blocks while the pool queues are full, so a huge manifest is fed in at the pace
+/// of the workers; results are kept in submission order
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <functional>
+
+#include "designjob.h"
+#include "batchdesignengine.h"
+#include "threadpool.h"
+
+
+class DesignJobScheduler
+{
+public:
+    typedef std::function<void(const DesignJobResult &)> JobFinishedCallback;
+
+    explicit DesignJobScheduler(WorkStealingThreadPool & pool = WorkStealingThreadPool::GlobalInstance());
+    ~DesignJobScheduler();
+
+    // called from the worker threads when a job is finished, calls are serialized
+    void SetJobFinishedCallback(JobFinishedCallback callback);
+
+    // queue one job, return its index in the results
+    size_t Submit(const DesignJob & job);
+
+    // wait for all the submitted jobs, the results are in submission order
+    std::vector<DesignJobResult> WaitAll();
+
+protected:
+    void RunJob(size_t index);
+
+protected:
+    WorkStealingThreadPool & m_pool;
+    TaskGroup m_group;
+
+    // deques keep the element addresses when growing while the workers write the results
+    std::deque<DesignJob> m_jobs;
+    std::deque<DesignJobResult> m_results;
+    std::mutex m_jobs_mutex;
+
+    JobFinishedCallback m_job_finished;
+    std::mutex m_callback_mutex;
+};
+
+#endif // DESIGNJOBSCHEDULER_H
@@ -16,7 +16,8 @@ FlightRouteDesign *
 
     FlightRouteDesign * flightdes=NULL;
 
-    if(parameter.GetRegionCount()>1)
+    // the cells of a decomposed region are designed as the regions of a multi-region design
+    if(parameter.GetRegionCount()>1 || parameter.DecomposeRegions)
     {
         return new MultiRegionDesigner(parameter);
     }
@@ -8,6 +8,11 @@ namespace Gomo {
     FlightParameter::FlightParameter()
     {
 		FightRegion = std::auto_ptr<OGRGeometry>(NULL);
+        OptimizeRegionOrder = false;
+        OrientationByFlightLength = false;
+        OrientationSweepResolution = 0.0;
+        ClipStripsToRegion = false;
+        DecomposeRegions = false;
         multiFlightRegionGeometries.clear();
     }
 
@@ -23,6 +28,11 @@ namespace Gomo {
              overlap_crossStrip = rs.overlap_crossStrip;
              RedudantBaselines  = rs.RedudantBaselines;             
              airport            = rs.airport;
+             OptimizeRegionOrder = rs.OptimizeRegionOrder;
+             OrientationByFlightLength = rs.OrientationByFlightLength;
+             OrientationSweepResolution = rs.OrientationSweepResolution;
+             ClipStripsToRegion = rs.ClipStripsToRegion;
+             DecomposeRegions = rs.DecomposeRegions;
 
 			 if( rs.FightRegion.get()==NULL)
 			 {
@@ -88,6 +88,12 @@ namespace Gomo {
 
             Airport airport;                        // 机场中心,in WGS84
 
+            bool OptimizeRegionOrder;               // 多摄区: 重排摄区顺序及进入角点以缩短转场, default false
+            bool OrientationByFlightLength;         // 航线方向: 最小化航线总长(航线数*航线长)而非外接矩形面积, default false
+            double OrientationSweepResolution;      // 航线方向: 按此间隔(度)遍历方向, 最小化含转弯及进出场的总航程, 0 不遍历(default)
+            bool ClipStripsToRegion;                // 航线按摄区裁剪: 每条航线只保留覆盖摄区的曝光点(及冗余基线), 而非外接矩形全宽, default false
+            bool DecomposeRegions;                  // 摄区分解: 凹多边形或带洞摄区分解为单调子区, 各子区独立定向后串联, default false
+
         protected:
             std::vector< std::auto_ptr<OGRGeometry> > multiFlightRegionGeometries;// 多摄区, 面状或者线状
 
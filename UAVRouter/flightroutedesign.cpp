@@ -16,7 +16,7 @@ FlightRouteDesign::FlightRouteDesign()
 {
     m_FightRegion_Gauss = std::auto_ptr<OGRGeometry>(NULL);//add this for the auto destructor, otherwise the m_FightRegion_Gauss would free the random memory
 
-    InitialSpatialReference();
+    m_major_meridian = 0.0;
 }
 
 
@@ -28,16 +28,10 @@ FlightRouteDesign::FlightRouteDesign(const FlightParameter & parameter)
 
     ScaleCamera2Ground();
 
-    InitialSpatialReference();
+    m_major_meridian = 0.0;
 
 }
 
-void FlightRouteDesign::InitialSpatialReference()
-{
-    m_ProjTM.SetProjCS("Local Guass-Krugger on WGS84");
-    m_ProjTM.SetWellKnownGeogCS( "WGS84" );
-}
-
 void FlightRouteDesign::ScaleCamera2Ground()
 {
     qDebug("FlightRouteDesign::ScaleCamera2Ground()");
@@ -71,13 +65,47 @@ void FlightRouteDesign::PerformRouteDesign()
 
 }
 
+void FlightRouteDesign::PrepareRouteDesign()
+{
+}
+
+UAVFlightPoint FlightRouteDesign::ChainRouteDesign(const Airport & airport)
+{
+    m_parameter.airport = airport;
+
+    PerformRouteDesign();
+
+    return GetLastFlightPoint();
+}
+
+void FlightRouteDesign::FinishRouteDesign()
+{
+}
+
+void FlightRouteDesign::GetEntryExitCandidates(std::vector<RouteEntryExit> & candidates)
+{
+    candidates.clear();
+}
+
+void FlightRouteDesign::SetEntryExitCandidate(int index)
+{
+}
+
 void FlightRouteDesign::GaussProjection()
 {
-    ostringstream streamdebug;
     qDebug("FlightRouteDesign::GaussProjection()");
 
+    GaussProjectionOfRegion();
+
+    GaussProjectionOfAirport();
+}
+
+void FlightRouteDesign::GaussProjectionOfRegion()
+{
+    ostringstream streamdebug;
+    qDebug("FlightRouteDesign::GaussProjectionOfRegion()");
+
     m_FightRegion_Gauss=std::auto_ptr<OGRGeometry>( m_parameter.FightRegion.get()->clone() );
-    m_AirportLoc_Gauss =m_parameter.airport.GetLocation();
 
     //Get centroid to create projection parameter
     OGRPoint region_ceneter;
@@ -88,85 +116,98 @@ void FlightRouteDesign::GaussProjection()
     streamdebug<< "centermeridian of the region: "<<centermeridian;
     qDebug(streamdebug.str().c_str());
 
-    double x_airport=m_AirportLoc_Gauss.getX();
-    double y_airport=m_AirportLoc_Gauss.getY();
+    //the projection of the region centroid, reused from the former designs if any
+    m_projector = GaussProjectorCache::Acquire(centermeridian,centerlat);
+    m_major_meridian = m_projector->GetCentralMeridian();
+
+    //Guass projection of flight region polygon or polyline
+    char * geom_before_proj_wkt="";
+    m_FightRegion_Gauss.get()->exportToWkt(&geom_before_proj_wkt);
     streamdebug.str("");
-    streamdebug<<"airport lat,long:("<<x_airport<<","<<y_airport<<")";
+    streamdebug<<"flight region geometry before gauss projection:"<<geom_before_proj_wkt<<std::endl;
     qDebug(streamdebug.str().c_str());
+    m_projector->ForwardGeometry(m_FightRegion_Gauss.get());
+}
 
-    //define spatial reference and transform
-    OGRSpatialReference    *poLatLong;
-    OGRCoordinateTransformation *poTransform;
-    m_ProjTM.SetTM( 0, centermeridian, 0.9996,
-           500000.0, (centerlat >= 0.0) ? 0.0 : 10000000.0 );
-    poLatLong = m_ProjTM.CloneGeogCS();
+// m_projector must be acquired by GaussProjectionOfRegion
+void FlightRouteDesign::GaussProjectionOfAirport()
+{
+    ostringstream streamdebug;
+    qDebug("FlightRouteDesign::GaussProjectionOfAirport()");
 
-    poTransform = OGRCreateCoordinateTransformation( poLatLong,&m_ProjTM);
+    double x_airport=m_parameter.airport.getX();
+    double y_airport=m_parameter.airport.getY();
+    double z_airport=m_parameter.airport.getZ();
+    streamdebug.str("");
+    streamdebug<<"airport lat,long:("<<x_airport<<","<<y_airport<<")";
+    qDebug(streamdebug.str().c_str());
 
     //Guass projection of airport
-    m_AirportLoc_Gauss.transform(poTransform);
+    m_projector->Forward(1,&x_airport,&y_airport,&z_airport);
+    m_AirportLoc_Gauss = OGRPoint(x_airport,y_airport,z_airport);
+
     streamdebug.str("");
     streamdebug<<"airport after project:("<<m_AirportLoc_Gauss.getX()<<","<<m_AirportLoc_Gauss.getY();
     qDebug(streamdebug.str().c_str());
+}
 
-    //Guass projection of flight region polygon or polyline
-    char * geom_before_proj_wkt="";
-    m_FightRegion_Gauss.get()->exportToWkt(&geom_before_proj_wkt);
-    streamdebug.str("");
-    streamdebug<<"flight region geometry before gauss projection:"<<geom_before_proj_wkt<<std::endl;
-    qDebug(streamdebug.str().c_str());
-    m_FightRegion_Gauss.get()->transformTo(&m_ProjTM);
+// a single point from gauss projection to WGS84, the same as in InverseGaussProjection
+UAVFlightPoint FlightRouteDesign::InverseGaussProjectionOfPoint(const UAVFlightPoint & pt_gauss)
+{
+    UAVFlightPoint flight_pt_wgs84;
+    flight_pt_wgs84.__strip_id         = pt_gauss.__strip_id;
+    flight_pt_wgs84.__id_in_strip      = pt_gauss.__id_in_strip;
+    flight_pt_wgs84.__flight_point_type= pt_gauss.__flight_point_type;
+
+    double x = pt_gauss.__longitude;
+    double y = pt_gauss.__latitude;
+    double z = m_parameter.FightHeight;
+    m_projector->Inverse(1,&x,&y,&z);
 
+    flight_pt_wgs84.__longitude = x;
+    flight_pt_wgs84.__latitude  = y;
+    flight_pt_wgs84.__height    = m_parameter.FightHeight;
 
+    return flight_pt_wgs84;
+}
+
+void FlightRouteDesign::FillRouteHeader(UAVRouteHEADER & header) const
+{
+    OGREnvelope env;
+    dynamic_cast<OGRPolygon*>(m_parameter.FightRegion.get())->getEnvelope(&env);
+    header.max_latitude  =env.MaxY;
+    header.min_latitude  =env.MinY;
+    header.min_longitude =env.MinX;
+    header.max_longitude =env.MaxX;
+
+    header.airport_height = m_parameter.airport.getZ();
+    header.airport_longitude = m_parameter.airport.getX();
+    header.airport_latitude = m_parameter.airport.getY();
+    header.airport_name = m_parameter.airport.GetName();
 }
 
 // form m_route_design_CaussProj to m_route_design_WGS84
 void FlightRouteDesign::InverseGaussProjection()
 {
 
-    //define spatial reference and transform
-    OGRSpatialReference    *poLatLong;
-    OGRCoordinateTransformation *poTransform;
-
-    poLatLong = m_ProjTM.CloneGeogCS();
-    poTransform = OGRCreateCoordinateTransformation( &m_ProjTM,poLatLong);
-
     //---------------------------------------------------------------
-    //Main section: flight strips:
+    //Main section: flight strips, inverse projected in one batch on the columns
     //----------------------------------------------------------------
-    std::vector< UAVFlightPoint >::iterator it= m_route_design_CaussProj.__flight_point.begin();
-
-    for( ; it!= m_route_design_CaussProj.__flight_point.end() ; it++ )
+    if(!m_route_columns_gauss.Empty())
     {
-        UAVFlightPoint flight_pt_wgs84;
-        flight_pt_wgs84.__strip_id         = (*it).__strip_id;
-        flight_pt_wgs84.__id_in_strip      = (*it).__id_in_strip;
-        flight_pt_wgs84.__flight_point_type= (*it).__flight_point_type;
-
-        OGRPoint pt((*it).__longitude,(*it).__latitude,m_parameter.FightHeight );
-        pt.transform(poTransform);
+        UAVRouteColumns columns_wgs84 = m_route_columns_gauss;
+        columns_wgs84.FillZ(m_parameter.FightHeight);
 
-        flight_pt_wgs84.__longitude = pt.getX();
-        flight_pt_wgs84.__latitude  = pt.getY();
-        flight_pt_wgs84.__height    = m_parameter.FightHeight;
+        m_projector->Inverse((int)columns_wgs84.Size(),
+                             columns_wgs84.GetX(),columns_wgs84.GetY(),columns_wgs84.GetZ());
 
-        m_route_design_WGS84.__flight_point.push_back(flight_pt_wgs84);
+        columns_wgs84.GetPoints(m_route_design_WGS84.__flight_point);
     }
 
     //------------------------------------------------------------------------
     // Header
     //------------------------------------------------------------------------
-    OGREnvelope env;
-    dynamic_cast<OGRPolygon*>(m_parameter.FightRegion.get())->getEnvelope(&env);
-    m_route_design_WGS84.__header.max_latitude  =env.MaxY;
-    m_route_design_WGS84.__header.min_latitude  =env.MinY;
-    m_route_design_WGS84.__header.min_longitude =env.MinX;
-    m_route_design_WGS84.__header.max_longitude =env.MaxX;
-
-    m_route_design_WGS84.__header.airport_height = m_parameter.airport.getZ();
-    m_route_design_WGS84.__header.airport_longitude = m_parameter.airport.getX();
-    m_route_design_WGS84.__header.airport_latitude = m_parameter.airport.getY();
-    m_route_design_WGS84.__header.airport_name = m_parameter.airport.GetName();
+    FillRouteHeader(m_route_design_WGS84.__header);
 
     //------------------------------------------------------------------------
     // Statistic
@@ -182,54 +223,41 @@ void FlightRouteDesign::InverseGaussProjection()
 
 
 
+// all the files in one pass over the route, each file written by its own thread
 void FlightRouteDesign::OutputRouteFile()
 {
-    QString suf_ght("ght");
-    QString suf_bht("bht");
-    QString suf_kml("kml");
-    QString suf_gst("gst");
+    FanOutRouteSink fan_out;
+    CreateOutputSinks(fan_out);
 
-    std::vector<std::string>::iterator it=m_output_files.begin();
-
-    for( ; it!=m_output_files.end();it++)
+    if(fan_out.GetSinkCount()>0)
     {
-        QString output((*it).c_str());
+        UAVRouteSink::WriteRouteDesign(m_route_design_WGS84,fan_out);
+    }
+}
 
-        QFileInfo fi(output);
-        QString suffix=fi.suffix();
 
-        if (suffix.compare(suf_ght, Qt::CaseInsensitive) ==0)
-        {
-            qDebug("suf_ght");
-            qDebug((*it).c_str());
+size_t FlightRouteDesign::StreamRouteDesign()
+{
+    qDebug("FlightRouteDesign::StreamRouteDesign()");
 
-            UAVRouteOutputer::OutputRouteDesignFileAsText(m_route_design_WGS84,*it);
-        }
+    PerformRouteDesign();
 
-        if (suffix.compare(suf_bht, Qt::CaseInsensitive) ==0)
-        {
-            qDebug("suf_bht");
-            qDebug((*it).c_str());
-            UAVRouteOutputer::OutputRouteDesignFileAsBinary(m_route_design_WGS84,*it);
-        }
+    OutputRouteFile();
 
-        if (suffix.compare(suf_kml, Qt::CaseInsensitive) ==0)
-        {
-            qDebug("suf_kml");
-            qDebug((*it).c_str());
-            UAVRouteOutputer::OutputRouteDesignFileAsKML(m_route_design_WGS84,*it);
-        }
+    return m_route_design_WGS84.__flight_point.size();
+}
 
-        if (suffix.compare(suf_gst, Qt::CaseInsensitive) ==0)
+void FlightRouteDesign::CreateOutputSinks(FanOutRouteSink & fan_out) const
+{
+    for(size_t i=0; i<m_output_files.size(); i++)
+    {
+        UAVRouteSink * sink = UAVRouteSink::CreateFileSink(m_output_files[i]);
+        if(sink!=NULL)
         {
-            qDebug("suf_gst");
-            qDebug((*it).c_str());
-            UAVRouteOutputer::OutputRouteDesignFileAsTextEncrypted(m_route_design_WGS84,*it);
+            qDebug(m_output_files[i].c_str());
+            fan_out.AddSink(sink);
         }
-
-
     }
-
 }
 
 
@@ -14,6 +14,18 @@ using namespace Gomo::Geometry2D;
 using namespace Gomo::FlightRoute;
 
 #include "uavrouteoutputer.h"
+#include "uavroutesink.h"
+#include "uavroutecolumns.h"
+#include "gaussprojector.h"
+
+#include <memory>
+
+// one way to fly a designed region, in WGS84
+struct RouteEntryExit
+{
+    UAVFlightPoint entry;   // the first flight point
+    UAVFlightPoint exit;    // the last flight point
+};
 
 class FlightRouteDesign
 {
@@ -24,19 +36,52 @@ public:
     virtual void PerformRouteDesign();
     virtual void OutputRouteFile();
 
+    //the design and the output files at once, written strip by strip through UAVRouteSink,
+    //instead of PerformRouteDesign then OutputRouteFile;
+    //the default designs the whole route and then writes it, GetRouteDesign is valid only with the default
+    //return: the count of flight points written
+    virtual size_t StreamRouteDesign();
+
+    //the design in phases, for designing the regions of a multi-region design in parallel:
+    // 1. PrepareRouteDesign: the part independent of the airport, designers may run it in parallel
+    // 2. ChainRouteDesign:   place the design relative to the airport, return the last flight point in WGS84
+    // 3. FinishRouteDesign:  the rest of the design, designers may run it in parallel
+    //the default does the whole design in ChainRouteDesign
+    virtual void PrepareRouteDesign();
+    virtual UAVFlightPoint ChainRouteDesign(const Airport & airport);
+    virtual void FinishRouteDesign();
+
+    //the ways the design may enter and leave the region, valid after PrepareRouteDesign;
+    //the default provides none, and the design is placed by the airport only
+    virtual void GetEntryExitCandidates(std::vector<RouteEntryExit> & candidates);
+    //force ChainRouteDesign to fly the region by candidates[index], -1 to let the airport decide
+    virtual void SetEntryExitCandidate(int index);
+
     void AddOutPutFileName(std::string);
 
     //for convenience of multi-region routing connection,
     //provide the last flight point of the current region as the airport of next region
     UAVFlightPoint GetLastFlightPoint();
 
+    // the design result in WGS84, valid after PerformRouteDesign
+    inline const UAVRouteDesign & GetRouteDesign() const {
+        return m_route_design_WGS84; };
+
 
 protected:
     vector<std::string> m_output_files;
 
-    void InitialSpatialReference();
     void GaussProjection();
+    void GaussProjectionOfRegion();  // also acquires m_projector by the region centroid
+    void GaussProjectionOfAirport();
     void InverseGaussProjection();
+    UAVFlightPoint InverseGaussProjectionOfPoint(const UAVFlightPoint & pt_gauss);
+
+    // the header of the design in WGS84: the region envelope and the airport
+    void FillRouteHeader(UAVRouteHEADER & header) const;
+
+    // the sinks of m_output_files added to fan_out, the files of an unknown suffix are skipped
+    void CreateOutputSinks(FanOutRouteSink & fan_out) const;
 
     virtual void DesignInGaussPlane()=0;
 
@@ -66,12 +111,13 @@ protected:
     std::auto_ptr<OGRGeometry> m_FightRegion_Gauss;//摄区, 面状或者线状,in guass proj
     OGRPoint   m_AirportLoc_Gauss;           // 机场中心,in guass proj
 
-    UAVRouteDesign m_route_design_CaussProj;
+    UAVRouteDesign m_route_design_CaussProj;   // header and statistic, the points in m_route_columns_gauss
+    UAVRouteColumns m_route_columns_gauss;
     UAVRouteDesign m_route_design_WGS84;
 
-    //for Guass(Tranverse Mecator) projection
+    //for Guass(Tranverse Mecator) projection, lent by GaussProjectorCache
     double m_major_meridian;
-    OGRSpatialReference    m_ProjTM;
+    std::shared_ptr<GaussProjector> m_projector;
 
 };
 
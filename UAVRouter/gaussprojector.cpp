@@ -0,0 +1,311 @@
+#include "gaussprojector.h"
+
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include <QDebug>
+
+
+namespace {
+
+    std::atomic<int> & DefaultBackend()
+    {
+        static std::atomic<int> backend(GaussProjector::BACKEND_NATIVE);
+        return backend;
+    }
+}
+
+void GaussProjector::SetDefaultBackend(Backend backend)
+{
+    DefaultBackend() = backend;
+}
+
+GaussProjector::Backend GaussProjector::GetDefaultBackend()
+{
+    return (Backend)DefaultBackend().load();
+}
+
+
+GaussProjector::GaussProjector(double central_meridian, bool south, Backend backend)
+    :m_central_meridian(central_meridian),
+    m_south(south),
+    m_backend(backend),
+    m_LatLong(NULL),
+    m_forward(NULL),
+    m_inverse(NULL)
+{
+    double false_northing = south ? 10000000.0 : 0.0;
+
+    m_ProjTM.SetProjCS("Local Guass-Krugger on WGS84");
+    m_ProjTM.SetWellKnownGeogCS( "WGS84" );
+    m_ProjTM.SetTM( 0, central_meridian, 0.9996,
+           500000.0, false_northing );
+
+    if(m_backend==BACKEND_NATIVE)
+    {
+        m_native = std::auto_ptr<TransverseMercator>(
+                    new TransverseMercator(central_meridian, 0.9996, 500000.0, false_northing));
+    }
+    else
+    {
+        m_LatLong = m_ProjTM.CloneGeogCS();
+
+        m_forward = OGRCreateCoordinateTransformation( m_LatLong,&m_ProjTM);
+        m_inverse = OGRCreateCoordinateTransformation( &m_ProjTM,m_LatLong);
+    }
+}
+
+GaussProjector::~GaussProjector()
+{
+    if(m_forward!=NULL)
+    {
+        OGRCoordinateTransformation::DestroyCT(m_forward);
+    }
+    if(m_inverse!=NULL)
+    {
+        OGRCoordinateTransformation::DestroyCT(m_inverse);
+    }
+    if(m_LatLong!=NULL)
+    {
+        OGRSpatialReference::DestroySpatialReference(m_LatLong);
+    }
+}
+
+bool GaussProjector::Forward(int count, double * x, double * y, double * z)
+{
+    if(count<=0)
+    {
+        return true;
+    }
+    if(m_native.get()!=NULL)
+    {
+        m_native->Forward(count,x,y);
+        return true;
+    }
+    return m_forward!=NULL && m_forward->Transform(count,x,y,z);
+}
+
+bool GaussProjector::Inverse(int count, double * x, double * y, double * z)
+{
+    if(count<=0)
+    {
+        return true;
+    }
+    if(m_native.get()!=NULL)
+    {
+        m_native->Inverse(count,x,y);
+        return true;
+    }
+    return m_inverse!=NULL && m_inverse->Transform(count,x,y,z);
+}
+
+bool GaussProjector::ForwardLineString(OGRLineString * line)
+{
+    int count_points = line->getNumPoints();
+    if(count_points<=0)
+    {
+        return true;
+    }
+
+    std::vector<double> x(count_points), y(count_points);
+    for(int i=0; i<count_points; i++ )
+    {
+        x[i] = line->getX(i);
+        y[i] = line->getY(i);
+    }
+
+    if(!Forward(count_points,&x[0],&y[0]))
+    {
+        return false;
+    }
+
+    bool is3D = line->getCoordinateDimension()==3;
+    for(int i=0; i<count_points; i++ )
+    {
+        if(is3D)
+        {
+            line->setPoint(i,x[i],y[i],line->getZ(i));
+        }
+        else
+        {
+            line->setPoint(i,x[i],y[i]);
+        }
+    }
+    return true;
+}
+
+OGRErr GaussProjector::ForwardGeometry(OGRGeometry * geometry)
+{
+    if(geometry==NULL)
+    {
+        return OGRERR_FAILURE;
+    }
+
+    if(m_native.get()==NULL)
+    {
+        return geometry->transform(m_forward);
+    }
+
+    bool succeed = true;
+
+    switch(wkbFlatten(geometry->getGeometryType()))
+    {
+    case wkbPoint:
+        {
+            OGRPoint * pt = dynamic_cast<OGRPoint*>(geometry);
+            double x = pt->getX();
+            double y = pt->getY();
+            succeed = Forward(1,&x,&y);
+            pt->setX(x);
+            pt->setY(y);
+        }
+        break;
+
+    case wkbLineString:
+        succeed = ForwardLineString(dynamic_cast<OGRLineString*>(geometry));
+        break;
+
+    case wkbPolygon:
+        {
+            OGRPolygon * polygon = dynamic_cast<OGRPolygon*>(geometry);
+            if(polygon->getExteriorRing()!=NULL)
+            {
+                succeed = ForwardLineString(polygon->getExteriorRing());
+            }
+            for(int i=0; succeed && i<polygon->getNumInteriorRings(); i++ )
+            {
+                succeed = ForwardLineString(polygon->getInteriorRing(i));
+            }
+        }
+        break;
+
+    case wkbMultiPoint:
+    case wkbMultiLineString:
+    case wkbMultiPolygon:
+    case wkbGeometryCollection:
+        {
+            OGRGeometryCollection * collection = dynamic_cast<OGRGeometryCollection*>(geometry);
+            for(int i=0; succeed && i<collection->getNumGeometries(); i++ )
+            {
+                succeed = ForwardGeometry(collection->getGeometryRef(i))==OGRERR_NONE;
+            }
+        }
+        break;
+
+    default:
+        return OGRERR_UNSUPPORTED_GEOMETRY_TYPE;
+    }
+
+    if(!succeed)
+    {
+        return OGRERR_FAILURE;
+    }
+
+    geometry->assignSpatialReference(&m_ProjTM);
+    return OGRERR_NONE;
+}
+
+
+
+const double GaussProjectorCache::MERIDIAN_STEP = 0.01;
+const size_t GaussProjectorCache::MAX_IDLE_PROJECTORS = 64;
+
+namespace {
+
+    // ((central meridian in MERIDIAN_STEP, south), backend)
+    typedef std::pair<std::pair<long long,bool>,int> ProjectorKey;
+
+    struct IdleProjectors
+    {
+        std::mutex mutex;
+        std::multimap<ProjectorKey, GaussProjector*> projectors;
+    };
+
+    // never destroyed: the idle projectors must not be destroyed after GDAL at exit,
+    // GaussProjectorCache::Clear() releases them explicitly
+    IdleProjectors & GetIdleProjectors()
+    {
+        static IdleProjectors * idle = new IdleProjectors;
+        return *idle;
+    }
+
+    ProjectorKey KeyOf(const GaussProjector * projector)
+    {
+        return ProjectorKey(std::make_pair((long long)floor(projector->GetCentralMeridian()/GaussProjectorCache::MERIDIAN_STEP+0.5),
+                                           projector->IsSouth()),
+                            projector->GetBackend());
+    }
+
+    // the deleter of the shared_ptr lent by Acquire
+    void ReleaseProjector(GaussProjector * projector)
+    {
+        IdleProjectors & idle = GetIdleProjectors();
+        {
+            std::lock_guard<std::mutex> lock(idle.mutex);
+            if(idle.projectors.size() < GaussProjectorCache::MAX_IDLE_PROJECTORS)
+            {
+                idle.projectors.insert(std::make_pair(KeyOf(projector),projector));
+                return;
+            }
+        }
+        delete projector;
+    }
+}
+
+
+double GaussProjectorCache::CentralMeridianOf(double longitude)
+{
+    return floor(longitude/MERIDIAN_STEP+0.5)*MERIDIAN_STEP;
+}
+
+std::shared_ptr<GaussProjector> GaussProjectorCache::Acquire(double longitude, double latitude)
+{
+    double central_meridian = CentralMeridianOf(longitude);
+    bool south = latitude < 0.0;
+    GaussProjector::Backend backend = GaussProjector::GetDefaultBackend();
+
+    ProjectorKey key(std::make_pair((long long)floor(longitude/MERIDIAN_STEP+0.5), south), backend);
+
+    GaussProjector * projector = NULL;
+
+    IdleProjectors & idle = GetIdleProjectors();
+    {
+        std::lock_guard<std::mutex> lock(idle.mutex);
+        std::multimap<ProjectorKey, GaussProjector*>::iterator it = idle.projectors.find(key);
+        if(it != idle.projectors.end())
+        {
+            projector = it->second;
+            idle.projectors.erase(it);
+        }
+    }
+
+    // create it out of the lock, the other threads keep on reusing theirs
+    if(projector==NULL)
+    {
+        qDebug("GaussProjectorCache::Acquire(): new projector");
+        projector = new GaussProjector(central_meridian, south, backend);
+    }
+
+    return std::shared_ptr<GaussProjector>(projector, ReleaseProjector);
+}
+
+void GaussProjectorCache::Clear()
+{
+    std::multimap<ProjectorKey, GaussProjector*> projectors;
+
+    IdleProjectors & idle = GetIdleProjectors();
+    {
+        std::lock_guard<std::mutex> lock(idle.mutex);
+        projectors.swap(idle.projectors);
+    }
+
+    std::multimap<ProjectorKey, GaussProjector*>::iterator it = projectors.begin();
+    for( ; it!=projectors.end(); it++ )
+    {
+        delete it->second;
+    }
+}
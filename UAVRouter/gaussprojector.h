@@ -0,0 +1,99 @@
+#ifndef GAUSSPROJECTOR_H
+#define GAUSSPROJECTOR_H
+
+/// GaussProjector: the Gauss-Kruger (transverse mercator on WGS84) projection of a design,
+/// owns the spatial references and the forward/inverse coordinate transformations
+///
+/// GaussProjectorCache: creating the transformations (CloneGeogCS, OGRCreateCoordinateTransformation)
+/// costs more than projecting a small design, so the cache lends the projectors to the designs,
+/// keyed by the central meridian (rounded to MERIDIAN_STEP degree) and the hemisphere.
+/// A projector is used by one design at a time and goes back to the cache when the design
+/// releases it, so the designs and the jobs on any thread reuse the same few projectors
+///
+/// the backend of a projector is the native TransverseMercator (default),
+/// or GDAL/PROJ as the reference, selectable at runtime by GaussProjector::SetDefaultBackend
+
+#include <ogrsf_frmts.h>
+#include <ogr_spatialref.h>
+
+#include <memory>
+
+#include "transversemercator.h"
+
+
+class GaussProjector
+{
+public:
+    enum Backend
+    {
+        BACKEND_NATIVE,     // TransverseMercator
+        BACKEND_GDAL        // OGRCoordinateTransformation
+    };
+
+    // the backend of the projectors created from now on
+    static void    SetDefaultBackend(Backend backend);
+    static Backend GetDefaultBackend();
+
+public:
+    GaussProjector(double central_meridian, bool south, Backend backend=GetDefaultBackend());
+    ~GaussProjector();
+
+    inline double  GetCentralMeridian() const { return m_central_meridian; };
+    inline bool    IsSouth() const { return m_south; };
+    inline Backend GetBackend() const { return m_backend; };
+
+    inline OGRSpatialReference * GetProjection() { return &m_ProjTM; };
+
+    // transform count points in place, z may be NULL and is kept by the native backend;
+    // return false if any point fails
+    // WGS84 => gauss projection
+    bool Forward(int count, double * x, double * y, double * z=NULL);
+    // gauss projection => WGS84
+    bool Inverse(int count, double * x, double * y, double * z=NULL);
+
+    // WGS84 => gauss projection of a point, line, polygon or collection of them
+    OGRErr ForwardGeometry(OGRGeometry * geometry);
+
+private:
+    // not copyable: owns the transformations
+    GaussProjector(const GaussProjector &);
+    GaussProjector& operator=(const GaussProjector &);
+
+private:
+    bool ForwardLineString(OGRLineString * line);
+
+private:
+    double  m_central_meridian;
+    bool    m_south;
+    Backend m_backend;
+
+    OGRSpatialReference           m_ProjTM;
+
+    // BACKEND_NATIVE
+    std::auto_ptr<TransverseMercator> m_native;
+
+    // BACKEND_GDAL
+    OGRSpatialReference         * m_LatLong;
+    OGRCoordinateTransformation * m_forward;
+    OGRCoordinateTransformation * m_inverse;
+};
+
+
+class GaussProjectorCache
+{
+public:
+    static const double MERIDIAN_STEP;      // degree
+    static const size_t MAX_IDLE_PROJECTORS;
+
+    // the central meridian used for a region centered at longitude
+    static double CentralMeridianOf(double longitude);
+
+    // a projector of the default backend for the region centered at (longitude, latitude),
+    // exclusively owned by the caller until the returned pointer is released
+    static std::shared_ptr<GaussProjector> Acquire(double longitude, double latitude);
+
+    // destroy the idle projectors, e.g. before OGRCleanupAll()
+    static void Clear();
+};
+
+#endif // GAUSSPROJECTOR_H
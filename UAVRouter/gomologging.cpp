@@ -12,6 +12,7 @@ GomoLogging::GomoLogging()
 
 GomoLogging* GomoLogging::GetInstancePtr()
 {
+    // the initialization of a local static is thread safe (C++11)
     static GomoLogging loggingInstance;
     return &loggingInstance;
 
@@ -20,6 +21,8 @@ GomoLogging* GomoLogging::GetInstancePtr()
 
 void  GomoLogging::logging(std::string line)
 {
+    std::lock_guard<std::mutex> lock(m_logfile_mutex);
+
     m_logfile.write(line.c_str(),line.length());
     m_logfile.write("\n");
 }
@@ -5,6 +5,7 @@
 #include <QFile>
 #include <string>
 using std::string;
+#include <mutex>
 
 
 class GomoLogging
@@ -15,6 +16,7 @@ protected:
 
 protected:
     QFile m_logfile;
+    std::mutex m_logfile_mutex; // logging is called from the design worker threads
 
 
 public:
@@ -81,7 +81,7 @@ void LinearFlightRouteDesign::CreateNewFilghtPoint(unsigned int strip_id,
     pt.__flight_point_type = ptType;
     pt.__longitude= longitude;
     pt.__latitude = latitude;
-    m_route_design_CaussProj.__flight_point.push_back(pt);
+    m_route_columns_gauss.PushBack(pt);
 
 }
 
@@ -1,5 +1,12 @@
 #include "multiregiondesigner.h"
 #include "designtaskfactory.h"
+#include "threadpool.h"
+#include "regionorderplanner.h"
+#include "regiondecomposer.h"
+
+#include <memory>
+#include <sstream>
+using std::ostringstream;
 
     MultiRegionDesigner::MultiRegionDesigner()
     {
@@ -23,51 +30,165 @@
         FlightParameter param_single;// single region in multi-regions collection
         param_single = m_parameter;
         param_single.ClearFlightRegions(); // make sure the DesignTaskFactory would not create MultiRegionDesigner
+        param_single.DecomposeRegions = false;
+
+        std::vector< std::unique_ptr<OGRGeometry> > regions;
+        CollectRegions(regions);
+
+        std::vector< std::unique_ptr<FlightRouteDesign> > region_designers;
+
+        for(size_t i=0; i<regions.size(); i++ )
+        {
+            // make param_single as the parameter for the i-th region,
+            // its airport is set by ChainRouteDesign
+            param_single.FightRegion = std::auto_ptr<OGRGeometry>(regions[i]->clone());
+
+            region_designers.push_back(std::unique_ptr<FlightRouteDesign>(
+                                           DesignTaskFactory::CreateFlightRouteDeigner(param_single)));
+        }
+
+        // 1. the airport independent part of every region
+        {
+            TaskGroup prepare_group;
+            for(size_t i=0; i<region_designers.size(); i++ )
+            {
+                FlightRouteDesign * single_reg_desinger = region_designers[i].get();
+                prepare_group.Run([single_reg_desinger]{ single_reg_desinger->PrepareRouteDesign(); });
+            }
+            prepare_group.Wait();
+        }
+
+        // the visiting order and the entry corner of each region, to shorten the transit legs
+        if(m_parameter.OptimizeRegionOrder && region_designers.size()>1)
+        {
+            PlanRegionOrder(regions,region_designers);
+        }
 
-        UAVFlightPoint pre_last_point;
+        // 2. chain the regions: the regions except the first one do not have there real 'Airport',
+        // so here a pseudo airport is constructed from the last flight point of the previous flight region
+        Gomo::FlightRoute::Airport airport = m_parameter.airport;
 
-        if ( m_parameter.GetRegionCount()>=1)
+        for(size_t i=0; i<region_designers.size(); i++ )
         {
-            for(int i=0; i<m_parameter.GetRegionCount(); i++ )
+            UAVFlightPoint pre_last_point = region_designers[i]->ChainRouteDesign(airport);
+
+            Gomo::FlightRoute::Airport airport_pseudo;
+            airport_pseudo.SetLocation(pre_last_point.ToOGRPoint());
+            airport =  airport_pseudo;
+        }
+
+        // 3. the rest of every region
+        {
+            TaskGroup finish_group;
+            for(size_t i=0; i<region_designers.size(); i++ )
             {
+                FlightRouteDesign * single_reg_desinger = region_designers[i].get();
+                finish_group.Run([single_reg_desinger]{ single_reg_desinger->FinishRouteDesign(); });
+            }
+            finish_group.Wait();
+        }
+
+        // copy design result from the region designers to current class, ie MultiRegionDesigner
+        for(size_t i=0; i<region_designers.size(); i++ )
+        {
+            ShareDesign(*region_designers[i], i>0);
+        }
 
-                // make param_single as the parameter for the i-th region
-                param_single.FightRegion = m_parameter.GetFlightRegionGeometry(i);
+    }
 
-                // the regions except the first one do not have there real 'Airport',
-                // so here a pseudo airport is constructed from the last flight point of the previous flight region
-                if( i>0)
-                {
-                    Gomo::FlightRoute::Airport airport_pseudo;
-                    airport_pseudo.SetLocation(pre_last_point.ToOGRPoint());
-                    param_single.airport =  airport_pseudo;
-                }
 
-                FlightRouteDesign * single_reg_desinger = DesignTaskFactory::CreateFlightRouteDeigner(param_single);
-                single_reg_desinger->PerformRouteDesign();
 
-                pre_last_point = single_reg_desinger->GetLastFlightPoint();
 
-                ///to do , copy design result from single_reg_desinger to current class, ie MultiRegionDesigner
-                if( i==0)
-                {
-                    ShareDesign(*single_reg_desinger);
-                }
-                else
-                {
-                    ShareDesign(*single_reg_desinger,true);
-                }
 
+    void MultiRegionDesigner::CollectRegions(std::vector< std::unique_ptr<OGRGeometry> > & regions)
+    {
+        regions.clear();
 
-                delete single_reg_desinger;
-                single_reg_desinger=NULL;
+        // a single region is not in the region list but in FightRegion
+        int count_regions = m_parameter.GetRegionCount();
+        int count_sources = (count_regions>0) ? count_regions : 1;
+        for(int i=0; i<count_sources; i++ )
+        {
+            std::auto_ptr<OGRGeometry> region = (count_regions>0) ? m_parameter.GetFlightRegionGeometry(i)
+                                                                  : std::auto_ptr<OGRGeometry>(m_parameter.FightRegion->clone());
+            if(!m_parameter.DecomposeRegions)
+            {
+                regions.push_back(std::unique_ptr<OGRGeometry>(region.release()));
+                continue;
+            }
+
+            std::vector< std::unique_ptr<OGRGeometry> > cells;
+            RegionDecomposer::DecomposeRegion(region.get(),cells);
+            for(size_t c=0; c<cells.size(); c++ )
+            {
+                regions.push_back(std::move(cells[c]));
             }
         }
 
+        ostringstream streamdebug;
+        streamdebug<<"MultiRegionDesigner::CollectRegions(): "<<regions.size()<<" regions to design";
+        qDebug(streamdebug.str().c_str());
     }
 
+    void MultiRegionDesigner::PlanRegionOrder(const std::vector< std::unique_ptr<OGRGeometry> > & region_geometries,
+                                              std::vector< std::unique_ptr<FlightRouteDesign> > & region_designers)
+    {
+        std::vector<RegionOrderPlanner::Region> regions(region_designers.size());
 
+        for(size_t i=0; i<region_designers.size(); i++ )
+        {
+            OGRGeometry * region_geometry = region_geometries[i].get();
+            OGRPoint center;
+            if(region_geometry!=NULL && region_geometry->Centroid(&center)==OGRERR_NONE)
+            {
+                regions[i].center = Point2D(center.getX(),center.getY());
+            }
+
+            std::vector<RouteEntryExit> candidates;
+            region_designers[i]->GetEntryExitCandidates(candidates);
+            for(size_t c=0; c<candidates.size(); c++ )
+            {
+                RegionOrderPlanner::RegionCandidate candidate;
+                candidate.entry = Point2D(candidates[c].entry.__longitude,candidates[c].entry.__latitude);
+                candidate.exit  = Point2D(candidates[c].exit.__longitude, candidates[c].exit.__latitude);
+                regions[i].candidates.push_back(candidate);
+            }
+        }
 
+        Point2D airport(m_parameter.airport.getX(),m_parameter.airport.getY());
+
+        RegionOrderPlanner planner;
+
+        std::vector<size_t> file_order;
+        for(size_t i=0; i<regions.size(); i++ )
+        {
+            file_order.push_back(i);
+        }
+        std::vector<int> file_candidates;
+        double transit_file_order = planner.EvaluateOrder(airport,regions,file_order,file_candidates);
+
+        std::vector<size_t> order;
+        std::vector<int> candidate_of_region;
+        double transit = planner.Plan(airport,regions,order,candidate_of_region);
+
+        ostringstream streamdebug;
+        streamdebug<<"MultiRegionDesigner::PlanRegionOrder(): transit "<<transit
+                   <<" m, "<<transit_file_order<<" m in the file order, order:";
+        for(size_t i=0; i<order.size(); i++ )
+        {
+            streamdebug<<" "<<order[i];
+        }
+        qDebug(streamdebug.str().c_str());
+
+        // move the designers to the planned order
+        std::vector< std::unique_ptr<FlightRouteDesign> > ordered_designers;
+        for(size_t i=0; i<order.size(); i++ )
+        {
+            region_designers[order[i]]->SetEntryExitCandidate(candidate_of_region[order[i]]);
+            ordered_designers.push_back(std::move(region_designers[order[i]]));
+        }
+        region_designers.swap(ordered_designers);
+    }
 
 
     // space holder to make the function not virtual
@@ -4,12 +4,21 @@
 /// MultiRegionDesigner: public FlightRouteDesign
 /// special designer for combine the output of multi regions designing
 /// Note: the multi-region is sequential dependent becasue the previous exit point
-///       would be considered as the airport of current intermediate region
+///       would be considered as the airport of current intermediate region,
+///       so only FlightRouteDesign::ChainRouteDesign runs region by region,
+///       PrepareRouteDesign and FinishRouteDesign of all the regions run in parallel
+///       if FlightParameter::OptimizeRegionOrder, the regions are not flown in the given order
+///       but in the one planned by RegionOrderPlanner, entering each region by the planned corner
+///       if FlightParameter::DecomposeRegions, each region is first decomposed by RegionDecomposer,
+///       and its cells are designed as regions, a single region included
 
 
 
 #include "flightroutedesign.h"
 
+#include <memory>
+#include <vector>
+
 using namespace Gomo::FlightRoute;
 using Gomo::FlightRoute::FlightParameter;
 
@@ -25,6 +34,13 @@ public:
 
     void PerformRouteDesign();
 
+protected:
+    // the regions to design: the ones of the parameter, or their cells
+    void CollectRegions(std::vector< std::unique_ptr<OGRGeometry> > & regions);
+
+    // reorder the prepared region designers and force their entry/exit candidates
+    void PlanRegionOrder(const std::vector< std::unique_ptr<OGRGeometry> > & region_geometries,
+                         std::vector< std::unique_ptr<FlightRouteDesign> > & region_designers);
 
 /// space holders to make the function not virtual
 protected:
@@ -19,6 +19,7 @@
 
 #include <niGeom/geometry/tree/niBspTree.h>
 #include <niGeom/geometry/tree/niBvhTree.h>
+#include <niGeom/geometry/tree/niFlatBvhTree.h>
 #include <niGeom/geometry/tree/niKdTree.h>
 
 #include <map>
@@ -507,6 +508,40 @@ namespace ni
                 bool                    m_splited;
             };
 
+            /**
+             * \brief Leaf test of the topo edge bvh tree: a topo edge overlaps a segment
+             *
+             */
+            struct niTopoEdgeOverlap
+            {
+                niTopoEdgeOverlap(const niPoint2d &p0, const niPoint2d &p1)
+                    : m_p0(p0), m_p1(p1)
+                {
+                }
+
+                bool                operator()(const niRefGeom2d &refEdge) const;
+
+                const niPoint2d&    m_p0;
+                const niPoint2d&    m_p1;
+            };
+
+            /**
+             * \brief Leaf test of the split edge bvh tree: a split edge, not excluded, overlaps a segment
+             *
+             */
+            struct niSplitEdgeOverlap
+            {
+                niSplitEdgeOverlap(const niPoint2d &p0, const niPoint2d &p1)
+                    : m_p0(p0), m_p1(p1)
+                {
+                }
+
+                bool                operator()(const niRefGeom2d &refEdge) const;
+
+                const niPoint2d&    m_p0;
+                const niPoint2d&    m_p1;
+            };
+
             /**
              * \brief Build polygon
              *
@@ -603,11 +638,11 @@ namespace ni
 
             void                    _ClearSplitStatus();
 
-            tree::niBvhTree*        _CreateEdgeBvhTree(
+            tree::niFlatBvhTree*    _CreateEdgeBvhTree(
                 niArrayT<niTopoEdge> &topoEdges,
                 niArrayT<niBBox2d> &bboxes);
 
-            tree::niBvhTree*        _CreateEdgeBvhTree(
+            tree::niFlatBvhTree*    _CreateEdgeBvhTree(
                 niArrayT<niSplitEdge> &splitEdges);
 
             void                    _Destory();
@@ -672,19 +707,10 @@ namespace ni
                 const niPoint2d &p0,
                 const niPoint2d &p1);
 
-            bool                    _IsOverlapTopoEdge(
-                const niPoint2d &p0,
-                const niPoint2d &p1,
-                const tree::niBvhTree::niBvhNode *edgeBvhNode);
-
             bool                    _IsOverlapSplitEdge(
                 const niPoint2d &p0,
                 const niPoint2d &p1);
 
-            bool                    _IsOverlapSplitEdge(
-                const niPoint2d &p0,
-                const niPoint2d &p1,
-                const tree::niBvhTree::niBvhNode *edgeBvhNode);
             
             bool                    _RefineSplitEdges();
 
@@ -717,11 +743,11 @@ namespace ni
             niArrayT<niBBox2d>      m_polyBBoxes;
 
             tree::niBvhTree*        m_hBvh4Poly;
-            tree::niBvhTree*        m_hBvh4TopoEdge;
+            tree::niFlatBvhTree*    m_hBvh4TopoEdge;
             tree::niBspTree*        m_hBsp4Point;
 
             niArrayT<niSplitEdge>   m_splitEdges;
-            tree::niBvhTree*        m_hBvh4SplitEdge;
+            tree::niFlatBvhTree*    m_hBvh4SplitEdge;
             int                     m_numSplitEdgeInBVH;
 
             SplitMaps_T             m_splitMap4Point;
@@ -0,0 +1,233 @@
+//! \file
+// \brief
+// Constrained Delaunay triangulation of polygons with holes
+//
+// Revisions:
+//   Date        Author     Description
+//   ----------  --------   -------------------------------------------------
+// - 2026-10-17             Initial version
+
+#ifndef niDelaunay2d_H
+#define niDelaunay2d_H
+
+#include <niGeom/niTypes.h>
+#include <niGeom/geometry/niGeom2dTypes.h>
+#include <niGeom/geometry/tree/niTreeTypes.h>
+
+namespace ni
+{
+    namespace geometry
+    {
+        class niPolygon2d;
+        class niTriMesh2d;
+        class niTriMesh2dTopo;
+
+        /**
+         * \brief Constrained Delaunay triangulation
+         *
+         * The points are triangulated by divide and conquer (Guibas and Stolfi) on a
+         * quad-edge structure, cut at the median alternately in x and in y (Dwyer), the
+         * halves of the top levels optionally on their own threads. The borders of the
+         * rings are then forced into the triangulation by flipping the edges they cross
+         * (Sloan), and the triangles whose distance to the outside counts an even number
+         * of borders are dropped, which cuts out the holes.
+         * All the tests use the adaptive niGeomMath2d::Orient2d and InCircle, so
+         * collinear and cocircular points are handled exactly.
+         *
+         * Rings are added as polygons, the first one is the boundary and the ones inside
+         * it are holes; rings must not cross each other. Points added alone are vertices
+         * of the mesh without constraint. Without any ring the convex hull of the points
+         * is triangulated.
+         */
+        class niDelaunay2d
+        {
+        public:
+            enum
+            {
+                CParallelSize   = 8192
+            };
+
+            /**
+             * \brief directed edge of the quad-edge structure
+             *
+             * The 4 edges of a quad are stored together, m_rot is the position in the quad:
+             * 0 and 2 are the edge and its symmetric, 1 and 3 the dual edges.
+             */
+            struct niDtEdge
+            {
+                niDtEdge*           m_next;         //next edge ccw around the origin
+                int                 m_org;
+                int                 m_rot;
+                int                 m_face;         //triangle on the left, -1: none, -2: deleted
+            };
+
+            struct niDtQuad
+            {
+                niDtEdge            m_edges[4];
+            };
+
+            /**
+             * \brief quads of one thread
+             *
+             * The deleted quads are reused by the next edges, m_quads keeps all of them in
+             * the order of allocation, so the triangles are read out in one pass.
+             */
+            struct niDtPool
+            {
+                niDtPool            () : m_free(NULL) {}
+
+                void                Merge               (niDtPool &other);
+
+                tree::niTreeArena   m_arena;
+                niArrayT<niDtQuad*> m_quads;
+                niDtQuad*           m_free;         //linked by m_edges[0].m_next
+            };
+
+            /**
+             * \brief triangle, counterclockwise
+             *
+             * edge i is (m_v[i], m_v[(i+1)%3]), m_n[i] is the triangle across it,
+             * m_c[i] marks the edge of a ring
+             */
+            struct niDtTri
+            {
+                int                 m_v[3];
+                int                 m_n[3];
+                char                m_c[3];
+            };
+
+        public:
+            niDelaunay2d            (bool fParallel = false);
+
+            ~niDelaunay2d           ()
+            {
+                Clear();
+            }
+
+            bool                    AddPoints           (const niPoint2dArray &points);
+
+            bool                    AddRing             (const niPolygon2d &polygon);
+
+            void                    Clear               ();
+
+            bool                    Process             (niTriMesh2d &tri_mesh, String &error_msg);
+
+            bool                    Process             (
+                                                        niTriMesh2d &tri_mesh,
+                                                        niTriMesh2dTopo &topology,
+                                                        String &error_msg);
+
+        protected:
+            static inline niDtEdge* _Rot                (niDtEdge *e)
+            {
+                return e->m_rot < 3 ? e + 1 : e - 3;
+            }
+
+            static inline niDtEdge* _InvRot             (niDtEdge *e)
+            {
+                return e->m_rot > 0 ? e - 1 : e + 3;
+            }
+
+            static inline niDtEdge* _Sym                (niDtEdge *e)
+            {
+                return e->m_rot < 2 ? e + 2 : e - 2;
+            }
+
+            static inline niDtEdge* _Onext              (niDtEdge *e)
+            {
+                return e->m_next;
+            }
+
+            static inline niDtEdge* _Oprev              (niDtEdge *e)
+            {
+                return _Rot(_Rot(e)->m_next);
+            }
+
+            static inline niDtEdge* _Lnext              (niDtEdge *e)
+            {
+                return _Rot(_InvRot(e)->m_next);
+            }
+
+            static inline niDtEdge* _Rprev              (niDtEdge *e)
+            {
+                return _Sym(e)->m_next;
+            }
+
+            static inline int       _Dest               (niDtEdge *e)
+            {
+                return _Sym(e)->m_org;
+            }
+
+            static niDtEdge*        _MakeEdge           (niDtPool &pool, int org, int dest);
+
+            static void             _Splice             (niDtEdge *a, niDtEdge *b);
+
+            static niDtEdge*        _Connect            (niDtPool &pool, niDtEdge *a, niDtEdge *b);
+
+            static void             _DeleteEdge         (niDtPool &pool, niDtEdge *e);
+
+            bool                    _SortPoints         (int spawnDepth);
+
+            void                    _Triangulate        (
+                                                        int _l,
+                                                        int _r,
+                                                        int axis,
+                                                        int spawnDepth,
+                                                        niDtPool &pool,
+                                                        niDtEdge *&le,
+                                                        niDtEdge *&re);
+
+            static void             _TriangulateTask    (
+                                                        niDelaunay2d *delaunay,
+                                                        int _l,
+                                                        int _r,
+                                                        int axis,
+                                                        int spawnDepth,
+                                                        niDtPool *pool,
+                                                        niDtEdge **le,
+                                                        niDtEdge **re);
+
+            void                    _HullExtremes       (
+                                                        niDtEdge *e,
+                                                        int axis,
+                                                        niDtEdge *&first,
+                                                        niDtEdge *&last) const;
+
+            bool                    _BuildTriangles     (const niDtPool &pool);
+
+            bool                    _InsertConstraint   (int a, int b);
+
+            bool                    _RestoreDelaunay    (niIntArray &edges, int a, int b);
+
+            int                     _FindEdge           (int u, int w, int &edge) const;
+
+            int                     _FindSegment        (int u, int w, int &edge) const;
+
+            void                    _Flip               (int t, int edge);
+
+            void                    _MarkConstraint     (int t, int edge);
+
+            bool                    _MarkRegion         ();
+
+            bool                    _MakeMesh           (niTriMesh2d &tri_mesh);
+
+        protected:
+            bool                    m_fParallel;
+
+            //input
+            niPoint2dArray          m_inputPoints;
+            niIntArray              m_segments;         //pairs of ids in m_inputPoints
+
+            //vertices without duplicates, in the order of the cuts
+            niPoint2dArray          m_points;
+            niIntArray              m_IdOfVerts;        //id in m_points of an input point
+
+            //triangulation
+            niArrayT<niDtTri>       m_tris;
+            niIntArray              m_vertTris;         //a triangle of each vertex
+            niCharArray             m_inside;
+        };
+    }
+}
+
+#endif
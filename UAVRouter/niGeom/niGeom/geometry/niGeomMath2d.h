@@ -106,6 +106,12 @@ namespace ni
                 const niPoint2d &P1,
                 const niPoint2d &P2);
 
+            static double               InCircle(
+                const niPoint2d &a,
+                const niPoint2d &b,
+                const niPoint2d &c,
+                const niPoint2d &d);
+
             static bool                 IsBoxOverlapBox(
                 const niBBox2d &bbox1,
                 const niBBox2d &bbox2);
@@ -194,6 +200,11 @@ namespace ni
                 const niPoint2d &q1,
                 niPoint2d &isec);
 
+            static double               Orient2d(
+                const niPoint2d &a,
+                const niPoint2d &b,
+                const niPoint2d &c);
+
             static EOrientation         Orientation(
                 const niPoint2d &p0,
                 const niPoint2d &p1,
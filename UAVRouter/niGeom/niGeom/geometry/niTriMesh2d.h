@@ -34,6 +34,7 @@ namespace ni
          */
         class niTriMesh2d
         {
+            friend class niDelaunay2d;
             friend class niTriMesh2dFn;
             friend class niTriMesh2dTopo;
 
@@ -75,7 +75,26 @@ namespace ni
             };
 
         public:
-            niTriangulation2d(niPolygon2d &polygon);
+            /**
+             * \brief triangulation mode
+             *
+             * eTMMinAngleScan:     the convex verts are scanned by angle and tested against
+             *                      all the verts until an ear is found
+             * eTMIncrementalEars:  the ears are kept in a heap by angle, only the two
+             *                      neighbors of a clipped ear are tested again, against the
+             *                      reflex verts in a grid. The same ears are clipped unless
+             *                      a convex vert lies on the border of an ear. A ring with a
+             *                      vert of angle 0, a spike or a repeated point, is tested
+             *                      against all the verts as in eTMMinAngleScan.
+             */
+            enum ETriangulationMode
+            {
+                eTMMinAngleScan     = 0,
+                eTMIncrementalEars  = 1
+            };
+
+        public:
+            niTriangulation2d(niPolygon2d &polygon, ETriangulationMode mode = eTMMinAngleScan);
 
             ~niTriangulation2d()
             {
@@ -100,6 +119,31 @@ namespace ni
 
             bool                        _SplitEar                   (int _index);
 
+            bool                        _InitIncremental            ();
+
+            bool                        _ClipEarsIncremental        (niTriFace2dArray &faces);
+
+            bool                        _IsEarIncremental           (int _index) const;
+
+            void                        _UpdateEar                  (int _index);
+
+            void                        _CellOf                     (const niPoint2d &p, int &cx, int &cy) const;
+
+            void                        _DeleteReflex               (int _index);
+
+            inline bool                 _IsEarBefore                (int _index1, int _index2) const
+            {
+                if (m_angles[_index1] != m_angles[_index2])
+                    return m_angles[_index1] < m_angles[_index2];
+                return _index1 < _index2;
+            }
+
+            void                        _PushEar                    (int _index);
+
+            void                        _RemoveEar                  (int _index);
+
+            void                        _SiftEar                    (int pos);
+
         protected:
             niPolygon2d&                m_polygon;
             niPoint2dArray              m_inputPoints;
@@ -108,6 +152,26 @@ namespace ni
             void*                       m_hBst;
             void*                       m_hKdt;
             int                         m_remain_counter;
+
+            //eTMIncrementalEars, all the arrays in m_arena
+            ETriangulationMode          m_mode;
+            char*                       m_arena;
+            double*                     m_angles;
+            int*                        m_prev;
+            int*                        m_next;
+            int*                        m_ears;             //min-heap of the ears by angle
+            int*                        m_earPos;           //position in m_ears, -1: not an ear
+            int                         m_numEars;
+            int*                        m_cellStart;        //first reflex vert of a cell in m_cellItems
+            int*                        m_cellCount;        //reflex verts left in a cell
+            int*                        m_cellItems;
+            int*                        m_cellPos;          //position in m_cellItems, -1: not reflex
+            int                         m_numCellsX;
+            int                         m_numCellsY;
+            double                      m_cellScaleX;
+            double                      m_cellScaleY;
+            niPoint2d                   m_gridOrigin;
+            bool                        m_fFlatVerts;       //a vert of angle 0, the ears are tested against all the verts
         };
     }
 }
@@ -172,10 +172,71 @@ namespace ni
                     niBBoxCost*         m_cost_from_cache;
                 };
 
+                /**
+                 * \brief bsp tree builder by the cost on bins of the points
+                 *
+                 * Each node is split on one of CNumBins planes across its longest axis, with
+                 * the cost of niBuilder, in O(n) a node and no presorting. The subtrees of
+                 * the top CParallelSize or more points are built on their own threads, each
+                 * into its own arena, merged when the thread joins.
+                 */
+                class niBinnedBuilder
+                {
+                public:
+                    enum
+                    {
+                        CNumBins        = 16,
+                        CParallelSize   = 4096
+                    };
+
+                    niBinnedBuilder     ();
+
+                    bool                InitBuild               (const niArrayT<const niPoint2d*> &pointRefs);
+
+                    bool                InitBuild               (const niArrayT<niRefPoint2d> &refPoints);
+
+                    niBspNode*          Build                   (int threshold, niTreeArena &arena);
+
+                protected:
+                    niBspNode*          Build                   (
+                                                                int _l,
+                                                                int _r,
+                                                                int threshold,
+                                                                int spawnDepth,
+                                                                niTreeArena &arena);
+
+                    niBspNode*          BuildNode               (
+                                                                int _l,
+                                                                int _r,
+                                                                int threshold,
+                                                                int spawnDepth,
+                                                                niTreeArena &arena);
+
+                    bool                FindBestSplit           (int _l, int _r, const niBBox2d &bbox, int _axis, int &_bin);
+
+                    int                 Split                   (int _l, int _r, const niBBox2d &bbox, int _axis, int _bin);
+
+                    static void         _BuildTask              (
+                                                                niBinnedBuilder *builder,
+                                                                int _l,
+                                                                int _r,
+                                                                int threshold,
+                                                                int spawnDepth,
+                                                                niTreeArena *arena,
+                                                                niBspNode **node);
+
+                    niArrayT<niRefPoint2d>  m_refPoints;
+                    niArrayT<double>        m_coords[2];
+                    niArrayT<int>           m_order;
+                };
+
             public:
-                niBspTree               (int threshold = 16);
+                niBspTree               (int threshold = 16, ETreeBuilder builder = eTBExactSweep);
 
-                niBspTree               (const niArrayT<niRefPoint2d> &refPoints, int threshold = 16);
+                niBspTree               (
+                                        const niArrayT<niRefPoint2d> &refPoints,
+                                        int threshold = 16,
+                                        ETreeBuilder builder = eTBExactSweep);
 
                 ~niBspTree              ();
                 
@@ -195,11 +256,17 @@ namespace ni
                 int                     StatTool                ();
 
             protected:
+                bool                    _BuildBinned            (niBinnedBuilder &build);
+
+                static void             _DestructNodes          (niBspNode *node);
+
                 void                    _Destory                ();
 
             protected:
                 niBspNode*              m_root;
                 const int               m_cThreshold;
+                const ETreeBuilder      m_cBuilder;
+                niTreeArena*            m_arena;
             };
         }
     }
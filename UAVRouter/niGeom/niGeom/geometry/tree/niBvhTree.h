@@ -160,26 +160,90 @@ namespace ni
                     niBBoxCost*         m_cost_from_cache;
                 };
 
+                /**
+                 * \brief Build bvh tree by the cost on bins of the box centers
+                 *
+                 * Each node is split on one of CNumBins planes of the bounds of the centers,
+                 * with the cost of niBuilder, in O(n) a node and no presorting. The subtrees of
+                 * the top CParallelSize or more elements are built on their own threads, each
+                 * into its own arena, merged when the thread joins.
+                 */
+                class niBinnedBuilder
+                {
+                public:
+                    enum
+                    {
+                        CNumBins        = 16,
+                        CParallelSize   = 4096
+                    };
+
+                    niBinnedBuilder     ();
+
+                    bool                InitBuild               (
+                                                                const niArrayT<niRefGeom2d> &refGeomes,
+                                                                const niArrayT<const niBBox2d*> &bboxRefs);
+
+                    bool                InitBuild               (
+                                                                const niArrayT<niRefGeom2d> &refGeomes,
+                                                                const niArrayT<niBBox2d> &boxes);
+
+                    niBvhNode*          Build                   (niTreeArena &arena);
+
+                protected:
+                    niBvhNode*          Build                   (int _l, int _r, int spawnDepth, niTreeArena &arena);
+
+                    bool                FindBestSplit           (
+                                                                int _l,
+                                                                int _r,
+                                                                const niBBox2d &centerBBox,
+                                                                int &_axis,
+                                                                int &_bin);
+
+                    int                 Split                   (
+                                                                int _l,
+                                                                int _r,
+                                                                const niBBox2d &centerBBox,
+                                                                int _axis,
+                                                                int _bin);
+
+                    static void         _BuildTask              (
+                                                                niBinnedBuilder *builder,
+                                                                int _l,
+                                                                int _r,
+                                                                int spawnDepth,
+                                                                niTreeArena *arena,
+                                                                niBvhNode **node);
+
+                    niArrayT<niRefGeom2d>   m_refGeomes;
+                    niArrayT<niBBox2d>      m_boxes;
+                    niArrayT<double>        m_centers[2];
+                    niArrayT<int>           m_order;
+                };
+
             public:
-                niBvhTree               () : m_root(NULL){}
+                niBvhTree               () : m_root(NULL), m_arena(NULL){}
 
                 niBvhTree               (
                                         const niArrayT<niRefGeom2d> &refGeomes,
-                                        const niArrayT<const niBBox2d*> &bboxRefs);
+                                        const niArrayT<const niBBox2d*> &bboxRefs,
+                                        ETreeBuilder builder = eTBExactSweep);
 
                 niBvhTree               (
                                         const niArrayT<niRefGeom2d> &refGeomes,
-                                        const niArrayT<niBBox2d> &boxes);
+                                        const niArrayT<niBBox2d> &boxes,
+                                        ETreeBuilder builder = eTBExactSweep);
 
                 ~niBvhTree              ();
                 
                 bool                    Build                   (
                                                                 const niArrayT<niRefGeom2d> &refGeomes,
-                                                                const niArrayT<const niBBox2d*> &bboxRefs);
+                                                                const niArrayT<const niBBox2d*> &bboxRefs,
+                                                                ETreeBuilder builder = eTBExactSweep);
 
                 bool                    Build                   (
                                                                 const niArrayT<niRefGeom2d> &refGeomes,
-                                                                const niArrayT<niBBox2d> &boxes);
+                                                                const niArrayT<niBBox2d> &boxes,
+                                                                ETreeBuilder builder = eTBExactSweep);
 
                 int                     StatTool                ();
 
@@ -189,10 +253,13 @@ namespace ni
                 }
 
             protected:
+                bool                    _BuildBinned            (niBinnedBuilder &build);
+
                 void                    _Destory                ();
 
             protected:
                 niBvhNode*              m_root;
+                niTreeArena*            m_arena;
             };
         }
     }
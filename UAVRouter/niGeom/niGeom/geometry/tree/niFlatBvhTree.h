@@ -0,0 +1,333 @@
+//! \file
+// \brief
+// Flat 4-wide Bounding Volume Hierarchies tree
+//
+// Revisions:
+//   Date        Author     Description
+//   ----------  --------   -------------------------------------------------
+// - 2026-10-17             Initial version
+
+#ifndef niFlatBvhTree_H
+#define niFlatBvhTree_H
+
+#include <niGeom/niTypes.h>
+#include <niGeom/niArrayT.h>
+#include <niGeom/geometry/niGeom2dTypes.h>
+#include <niGeom/geometry/tree/niBvhTree.h>
+
+namespace ni
+{
+    namespace geometry
+    {
+        namespace tree
+        {
+            /**
+             * \brief Flat BVH tree
+             *
+             * The binary niBvhTree collapsed into nodes of 4 children, stored in one array in
+             * depth-first order. The child boxes of a node are kept as structure of arrays, so
+             * one node is tested against a box, a segment or a point in a few SIMD operations.
+             * Queries walk the nodes with a fixed size stack, no recursion and no allocation.
+             *
+             * The leaf geometries are opaque (niRefGeom2d), the queries call back for the exact
+             * test of a leaf whose box passes.
+             */
+            class niFlatBvhTree
+            {
+            public:
+                enum
+                {
+                    CNodeWidth      = 4,
+                    CStackSize      = 256
+                };
+
+                /**
+                 * \brief 4-wide node
+                 *
+                 * m_child[i] >= 0: index of the child node
+                 * m_child[i] <  0: ~index of the leaf
+                 */
+                struct niFlatBvhNode
+                {
+                    double              m_minX[CNodeWidth];
+                    double              m_minY[CNodeWidth];
+                    double              m_maxX[CNodeWidth];
+                    double              m_maxY[CNodeWidth];
+                    int                 m_child[CNodeWidth];
+                    int                 m_numChildren;
+                };
+
+                /**
+                 * \brief entry of the nearest query stack: node and distance of its box
+                 *
+                 */
+                struct niNearestEntry
+                {
+                    double              m_distance;
+                    int                 m_node;
+                };
+
+            public:
+                niFlatBvhTree           ();
+
+                niFlatBvhTree           (
+                                        const niArrayT<niRefGeom2d> &refGeomes,
+                                        const niArrayT<const niBBox2d*> &bboxRefs,
+                                        ETreeBuilder builder = eTBExactSweep);
+
+                niFlatBvhTree           (
+                                        const niArrayT<niRefGeom2d> &refGeomes,
+                                        const niArrayT<niBBox2d> &boxes,
+                                        ETreeBuilder builder = eTBExactSweep);
+
+                ~niFlatBvhTree          ();
+
+                bool                    Build                   (
+                                                                const niArrayT<niRefGeom2d> &refGeomes,
+                                                                const niArrayT<const niBBox2d*> &bboxRefs,
+                                                                ETreeBuilder builder = eTBExactSweep);
+
+                bool                    Build                   (
+                                                                const niArrayT<niRefGeom2d> &refGeomes,
+                                                                const niArrayT<niBBox2d> &boxes,
+                                                                ETreeBuilder builder = eTBExactSweep);
+
+                bool                    Build                   (const niBvhTree &bvhTree);
+
+                void                    Clear                   ();
+
+                inline bool             IsEmpty                 () const
+                {
+                    return m_nodes.empty();
+                }
+
+                inline size_t           NumNodes                () const
+                {
+                    return m_nodes.size();
+                }
+
+                inline size_t           NumLeaves               () const
+                {
+                    return m_leaves.size();
+                }
+
+                inline const niRefGeom2d& Leaf                  (int IdOfLeaf) const
+                {
+                    return m_leaves[IdOfLeaf];
+                }
+
+                inline const niBBox2d&  LeafBBox                (int IdOfLeaf) const
+                {
+                    return m_leafBoxes[IdOfLeaf];
+                }
+
+                int                     QueryBBox               (
+                                                                const niBBox2d &bbox,
+                                                                niArrayT<niRefGeom2d> &refGeomes) const;
+
+                template<class LeafTest>
+                bool                    FindSegmentHit          (
+                                                                const niPoint2d &p0,
+                                                                const niPoint2d &p1,
+                                                                LeafTest &leafTest) const;
+
+                template<class LeafDistance>
+                bool                    FindNearest             (
+                                                                const niPoint2d &p,
+                                                                LeafDistance &leafDistance,
+                                                                niRefGeom2d &nearest,
+                                                                double &distance) const;
+
+            protected:
+                int                     _Collapse               (const niBvhTree::niBvhNode *bvhNode, int depth);
+
+                int                     _AddLeaf                (const niBvhTree::niBvhNode *bvhNode);
+
+                static int              _OverlapBBox            (
+                                                                const niFlatBvhNode &node,
+                                                                const niBBox2d &bbox);
+
+                static int              _OverlapLine            (
+                                                                const niFlatBvhNode &node,
+                                                                const niPoint2d &p0,
+                                                                const niPoint2d &p1);
+
+                static void             _DistanceOfPoint        (
+                                                                const niFlatBvhNode &node,
+                                                                const niPoint2d &p,
+                                                                double distances[CNodeWidth]);
+
+            protected:
+                niArrayT<niFlatBvhNode> m_nodes;
+                niArrayT<niRefGeom2d>   m_leaves;
+                niArrayT<niBBox2d>      m_leafBoxes;
+                int                     m_stackSize;
+            };
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION FindSegmentHit
+            //-----------------------------------------------------------------------------
+            /**
+            * Find a leaf hit by a segment.
+            * The boxes are tested as niGeomMath2d::IsLineOverlapBox does, the leaves in the
+            * passed boxes by leafTest(const niRefGeom2d&), until it returns true.
+            *
+            * @param            p0:                 first point of segment
+            * @param            p1:                 second point of segment
+            * @param            leafTest:           exact test of a leaf
+            * @return           true:               a leaf is hit
+            *                   false:              no leaf is hit
+            *
+            */
+            template<class LeafTest>
+            bool niFlatBvhTree::FindSegmentHit(
+                const niPoint2d &p0,
+                const niPoint2d &p1,
+                LeafTest &leafTest) const
+            {
+                if (m_nodes.empty())
+                    return false;
+
+                int localStack[CStackSize];
+                niArrayT<int> heapStack;
+                int *stack = localStack;
+                if (m_stackSize > CStackSize)
+                {
+                    heapStack.resize(m_stackSize);
+                    stack = &heapStack[0];
+                }
+
+                int top = 0;
+                stack[top++] = 0;
+
+                while (top > 0)
+                {
+                    const niFlatBvhNode &node = m_nodes[ stack[--top] ];
+                    int mask = _OverlapLine(node, p0, p1);
+
+                    for (int i = 0; i < node.m_numChildren; ++i)
+                    {
+                        if (0 == (mask & (1 << i)))
+                            continue;
+
+                        int child = node.m_child[i];
+                        if (child < 0)
+                        {
+                            if (leafTest(m_leaves[~child]))
+                                return true;
+                        }
+                        else
+                        {
+                            stack[top++] = child;
+                        }
+                    }
+                }
+                return false;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION FindNearest
+            //-----------------------------------------------------------------------------
+            /**
+            * Find the nearest leaf to a point, within distance.
+            * The nodes are visited nearest box first and skipped when their box is farther
+            * than the nearest leaf found; leafDistance(const niRefGeom2d&) gives the exact
+            * distance of a leaf, a negative value to ignore it.
+            *
+            * @param            p:                  point
+            * @param            leafDistance:       exact distance of a leaf
+            * @param            nearest:            store the nearest leaf
+            * @param            distance:           in: the search radius, out: the distance of nearest
+            * @return           true:               found
+            *                   false:              no leaf within distance
+            *
+            */
+            template<class LeafDistance>
+            bool niFlatBvhTree::FindNearest(
+                const niPoint2d &p,
+                LeafDistance &leafDistance,
+                niRefGeom2d &nearest,
+                double &distance) const
+            {
+                if (m_nodes.empty())
+                    return false;
+
+                niNearestEntry localStack[CStackSize];
+                niArrayT<niNearestEntry> heapStack;
+                niNearestEntry *stack = localStack;
+                if (m_stackSize > CStackSize)
+                {
+                    heapStack.resize(m_stackSize);
+                    stack = &heapStack[0];
+                }
+
+                bool bFound = false;
+                int top = 0;
+                stack[top].m_distance   = 0.0;
+                stack[top].m_node       = 0;
+                ++top;
+
+                while (top > 0)
+                {
+                    --top;
+                    if (stack[top].m_distance > distance)
+                        continue;
+
+                    const niFlatBvhNode &node = m_nodes[ stack[top].m_node ];
+
+                    double boxDistances[CNodeWidth];
+                    _DistanceOfPoint(node, p, boxDistances);
+
+                    //children in the order of their distance, nearest first
+                    int order[CNodeWidth];
+                    int numOrder = 0;
+                    for (int i = 0; i < node.m_numChildren; ++i)
+                    {
+                        if (boxDistances[i] > distance)
+                            continue;
+
+                        int j = numOrder++;
+                        while (j > 0 && boxDistances[ order[j-1] ] > boxDistances[i])
+                        {
+                            order[j] = order[j-1];
+                            --j;
+                        }
+                        order[j] = i;
+                    }
+
+                    //leaves nearest first, to shrink distance early
+                    for (int k = 0; k < numOrder; ++k)
+                    {
+                        int child = node.m_child[ order[k] ];
+                        if (child >= 0 || boxDistances[ order[k] ] > distance)
+                            continue;
+
+                        const niRefGeom2d &leaf = m_leaves[~child];
+                        double d = leafDistance(leaf);
+                        if (d >= 0.0 && d <= distance)
+                        {
+                            distance = d;
+                            nearest = leaf;
+                            bFound = true;
+                        }
+                    }
+
+                    //nodes farthest first, so the nearest is popped first
+                    for (int k = numOrder-1; k >= 0; --k)
+                    {
+                        int child = node.m_child[ order[k] ];
+                        if (child < 0 || boxDistances[ order[k] ] > distance)
+                            continue;
+
+                        stack[top].m_distance   = boxDistances[ order[k] ];
+                        stack[top].m_node       = child;
+                        ++top;
+                    }
+                }
+                return bFound;
+            }
+        }
+    }
+}
+
+#endif
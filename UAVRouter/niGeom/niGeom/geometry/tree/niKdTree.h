@@ -23,126 +23,87 @@ namespace ni
         namespace tree
         {
             /**
-             * \brief KD-tree node.
+             * \brief KD-tree.
              *
+             * Implicit balanced tree: the points are permuted into one array, the node of
+             * the range [_l, _r] is its median (_l + _r) / 2, the left subtree is [_l, _m-1]
+             * and the right one [_m+1, _r]. The splitting axis alternates with the depth,
+             * x at the root. No node is allocated, the queries walk index ranges.
              */
             class niKdTree
             {
             public:
+                enum
+                {
+                    CStackSize      = 64,
+                    CBatchSize      = 1024
+                };
+
                 /**
-                 * \brief KD-tree node.
+                 * \brief neighbor found by the nearest query
                  *
                  */
-                class niKdNode
+                struct niKdNeighbor
                 {
-                    friend class niKdTree;
-                public:
-                    niKdNode            (const niPoint2d &point, int IdOfPoint, int axis)
-                        : m_refPoint2d(&point, IdOfPoint),
-                        m_axis(axis),
-                        l_child(NULL),
-                        r_child(NULL)
-                    {}
-
-                    niKdNode            (const niPoint2d *pointRef, int IdOfPoint, int axis)
-                        : m_refPoint2d(pointRef, IdOfPoint),
-                        m_axis(axis),
-                        l_child(NULL),
-                        r_child(NULL)
-                    {}
-
-                    niKdNode            (const niRefPoint2d &refPoint2d, int axis)
-                        : m_refPoint2d(refPoint2d),
-                        m_axis(axis),
-                        l_child(NULL),
-                        r_child(NULL)
-                    {}
-
-                protected:
-                    ~niKdNode           ()
-                    {
-                        if (NULL != l_child)
-                            delete l_child;
-                        if (NULL != r_child)
-                            delete r_child;
-                    }
+                    double              m_distance2;
+                    int                 m_index;
+                };
 
-                public:
-                    const niRefPoint2d  m_refPoint2d;
+            protected:
+                /**
+                 * \brief subtree of the query stack, with the lower bound of its squared distance
+                 *
+                 */
+                struct niKdRange
+                {
+                    int                 m_l;
+                    int                 m_r;
                     int                 m_axis;
-                    niKdNode*           l_child;
-                    niKdNode*           r_child;
+                    double              m_distance2;
                 };
 
-            protected:
                 /**
-                 * \brief KD-tree build node, used to build banlanced kd tree
+                 * \brief order of the build, by the coordinate on axis, then by the id of point
                  *
                  */
-                class niBuildNode
+                class niBuildCompare
                 {
                 public:
-                    niBuildNode         () : m_hit(false){}
-
-                    niRefPoint2d        m_refPoint2d;
-                    bool                m_hit;
+                    niBuildCompare      (const niArrayT<niRefPoint2d> &refPoints, int axis)
+                        : m_refPoints(refPoints), m_axis(axis)
+                    {}
 
-                    template<int axis_t>
-                    static bool         _compare_           (const niBuildNode* n1, const niBuildNode *n2)
+                    bool                operator()      (int i1, int i2) const
                     {
-                        double _a, _b;
-                        switch (axis_t)
-                        {
-                        case 0:
-                            _a = n1->m_refPoint2d.m_pointRef->X;
-                            _b = n2->m_refPoint2d.m_pointRef->X;
-                            break;
-                        default:
-                            _a = n1->m_refPoint2d.m_pointRef->Y;
-                            _b = n2->m_refPoint2d.m_pointRef->Y;
-                            break;
-                        }
+                        const niRefPoint2d &r1 = m_refPoints[i1];
+                        const niRefPoint2d &r2 = m_refPoints[i2];
+                        double _a = (*r1.m_pointRef)[m_axis];
+                        double _b = (*r2.m_pointRef)[m_axis];
                         if (_a < _b)
                             return true;
                         if (_a > _b)
                             return false;
-                        return n1->m_refPoint2d.m_IdOfPoint < n2->m_refPoint2d.m_IdOfPoint;
+                        return r1.m_IdOfPoint < r2.m_IdOfPoint;
                     }
+
+                protected:
+                    const niArrayT<niRefPoint2d>&   m_refPoints;
+                    int                 m_axis;
                 };
 
                 /**
-                 * \brief Build a banlanced kd tree.
+                 * \brief the nearest neighbor first, ties by position
                  *
                  */
-                class niBuilder
+                static bool             _IsNearer       (const niKdNeighbor &n1, const niKdNeighbor &n2)
                 {
-                public:
-                    niBuilder           ();
-
-                    ~niBuilder          ();
-
-                    niKdNode*           Build           (int axis1, int _l, int _r);
-
-                    bool                InitBuild       (const niArrayT<const niPoint2d*> &pointRefs);
-
-                    bool                InitBuild       (const niArrayT<niRefPoint2d> &refPoints);
-
-                    static bool         IsHit           (niBuildNode *node)
-                    {
-                        return node->m_hit;
-                    }
-
-                protected:
-                    void                Destory         ();
-
-
-                protected:
-                    niBuildNode*        m_build_nodes;
-                    niBuildNode**       m_sorted[2];
-                };
+                    if (n1.m_distance2 != n2.m_distance2)
+                        return n1.m_distance2 < n2.m_distance2;
+                    return n1.m_index < n2.m_index;
+                }
 
             public:
-                niKdTree                () : m_root(NULL){}
+                niKdTree                (){}
 
                 niKdTree                (const niArrayT<niRefPoint2d> &refPoints);
 
@@ -154,24 +115,69 @@ namespace ni
 
                 bool                    Build           (const niArrayT<niRefPoint2d> &refPoints);
 
+                void                    Clear           ();
+
+                inline bool             IsEmpty         () const
+                {
+                    return m_points.empty();
+                }
+
+                inline size_t           Size            () const
+                {
+                    return m_points.size();
+                }
+
                 bool                    PointsInBBox    (
                                                         const niBBox2d &bbox,
-                                                        niArrayT<const niPoint2d*> &pointRefs);
+                                                        niArrayT<const niPoint2d*> &pointRefs) const;
 
                 bool                    PointsInBBox    (
                                                         const niBBox2d &bbox,
-                                                        niIntArray &IdOfPoints);
+                                                        niIntArray &IdOfPoints) const;
 
-                const niKdNode*         Root            () const
-                {
-                    return m_root;
-                }
+                int                     KNearest        (
+                                                        const niPoint2d &p,
+                                                        int k,
+                                                        niIntArray &IdOfPoints,
+                                                        niDoubleArray *distances = NULL) const;
+
+                bool                    KNearest        (
+                                                        const niPoint2dArray &queries,
+                                                        int k,
+                                                        niIntArray &IdOfPoints,
+                                                        niDoubleArray *distances = NULL) const;
+
+                int                     PointsInRadius  (
+                                                        const niPoint2d &p,
+                                                        double radius,
+                                                        niIntArray &IdOfPoints) const;
+
+            protected:
+                void                    _IndicesInBBox  (
+                                                        const niBBox2d &bbox,
+                                                        niIntArray &indices) const;
+
+                int                     _KNearest       (
+                                                        const niPoint2d &p,
+                                                        int k,
+                                                        niKdNeighbor *heap) const;
+
+                static void             _KNearestTask   (
+                                                        const niKdTree *tree,
+                                                        const niPoint2dArray *queries,
+                                                        size_t first,
+                                                        size_t last,
+                                                        int k,
+                                                        niKdNeighbor *heap,
+                                                        int *IdOfPoints,
+                                                        double *distances);
 
             protected:
-                niKdNode*               m_root;
+                niPoint2dArray          m_points;
+                niArrayT<niRefPoint2d>  m_refPoints;
             };
         }
     }
 }
 
-#endif
\ No newline at end of file
+#endif
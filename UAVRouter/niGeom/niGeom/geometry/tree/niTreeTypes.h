@@ -11,6 +11,9 @@
 #define niTreeTypes_H
 
 #include <niGeom/geometry/niBBox2d.h>
+#include <niGeom/niArrayT.h>
+
+#include <new>
 
 namespace ni
 {
@@ -27,6 +30,128 @@ namespace ni
                 niBBox2d            m_bbox;
                 float               m_cost;
             };
+
+            /**
+             * \brief tree builder
+             *
+             * eTBExactSweep:   exact cost sweep over the elements presorted on both axes
+             * eTBBinnedSAH:    cost evaluated on bins of the element centers, top-level
+             *                  subtrees built in parallel, the nodes in a niTreeArena
+             */
+            enum ETreeBuilder
+            {
+                eTBExactSweep   = 0,
+                eTBBinnedSAH    = 1
+            };
+
+            /**
+             * \brief bins of the element centers on one axis, used by the binned builders
+             *
+             * The bins split [lower, lower + extent] evenly, the centers on the upper bound
+             * go to the last bin. As a predicate it is true for the elements in the bins up
+             * to m_bin.
+             */
+            struct niCenterBins
+            {
+                niCenterBins        (const double *centers, double lower, double extent, int numBins)
+                    : m_centers(centers), m_lower(lower), m_scale(numBins / extent), m_numBins(numBins), m_bin(0)
+                {
+                }
+
+                inline int          BinOf                   (int id) const
+                {
+                    int bin = int( (m_centers[id] - m_lower) * m_scale );
+                    return bin < m_numBins ? bin : m_numBins-1;
+                }
+
+                inline bool         operator()              (int id) const
+                {
+                    return BinOf(id) <= m_bin;
+                }
+
+                const double*       m_centers;
+                double              m_lower;
+                double              m_scale;
+                int                 m_numBins;
+                int                 m_bin;
+            };
+
+            /**
+             * \brief memory arena of the nodes of a tree
+             *
+             * The nodes are constructed in large blocks and the blocks are freed with the
+             * arena. The arena does not know the types of the nodes: the tree destructs
+             * them before it frees the arena.
+             */
+            class niTreeArena
+            {
+            public:
+                enum
+                {
+                    CBlockSize      = 64 * 1024,
+                    CAlignment      = 16
+                };
+
+                niTreeArena         () : m_used(0), m_blockSize(0)
+                {
+                }
+
+                ~niTreeArena        ()
+                {
+                    Clear();
+                }
+
+                inline void*        Allocate                (size_t size)
+                {
+                    size = (size + CAlignment - 1) & ~(size_t)(CAlignment - 1);
+                    if (m_used + size > m_blockSize)
+                    {
+                        size_t blockSize = size > (size_t)CBlockSize ? size : (size_t)CBlockSize;
+                        m_blocks.reserve(m_blocks.size() + 1);
+                        m_blocks.push_back(new char[blockSize]);
+                        m_used      = 0;
+                        m_blockSize = blockSize;
+                    }
+                    void *p = m_blocks.back() + m_used;
+                    m_used += size;
+                    return p;
+                }
+
+                template<class Type>
+                inline Type*        New                     ()
+                {
+                    return new (Allocate(sizeof(Type))) Type;
+                }
+
+                //take over the blocks of other, the current block stays the last one
+                void                Merge                   (niTreeArena &other)
+                {
+                    m_blocks.insert(m_blocks.begin(), other.m_blocks.begin(), other.m_blocks.end());
+                    other.m_blocks.clear();
+                    other.m_used        = 0;
+                    other.m_blockSize   = 0;
+                }
+
+                void                Clear                   ()
+                {
+                    for (size_t i = 0; i < m_blocks.size(); ++i)
+                    {
+                        delete []m_blocks[i];
+                    }
+                    m_blocks.clear();
+                    m_used      = 0;
+                    m_blockSize = 0;
+                }
+
+            private:
+                niTreeArena         (const niTreeArena &);
+                niTreeArena&        operator=               (const niTreeArena &);
+
+            protected:
+                niArrayT<char*>     m_blocks;
+                size_t              m_used;
+                size_t              m_blockSize;
+            };
         }
     }
 }
@@ -13,6 +13,7 @@
 #include <iostream>
 #include <fstream>
 #include <stack>
+#include <thread>
 
 #include <iomanip>
 
@@ -375,6 +376,397 @@ namespace ni
             }
 
 
+            //-----------------------------------------------------------------------------
+            // FUNCTION Construction
+            //-----------------------------------------------------------------------------
+            /**
+            * Construction
+            *
+            */
+            niBspTree::niBinnedBuilder::niBinnedBuilder()
+            {
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION InitBuild
+            //-----------------------------------------------------------------------------
+            /**
+            * Init build: copy the coordinates of the points
+            *
+            * @param            pointRefs:          point references
+            * @return           true:               success
+            *                   false:              failed
+            *
+            */
+            bool niBspTree::niBinnedBuilder::InitBuild(
+                const niArrayT<const niPoint2d*> &pointRefs)
+            {
+                size_t numPoints = pointRefs.size();
+                try
+                {
+                    m_refPoints.resize(numPoints);
+                    m_coords[0].resize(numPoints);
+                    m_coords[1].resize(numPoints);
+                    m_order.resize(numPoints);
+                }
+                catch (std::bad_alloc)
+                {
+                    return false;
+                }
+
+                for (size_t i = 0; i < numPoints; ++i)
+                {
+                    m_refPoints[i].m_pointRef   = pointRefs[i];
+                    m_refPoints[i].m_IdOfPoint  = int(i);
+                    m_coords[0][i]              = pointRefs[i]->X;
+                    m_coords[1][i]              = pointRefs[i]->Y;
+                    m_order[i]                  = int(i);
+                }
+                return true;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION InitBuild
+            //-----------------------------------------------------------------------------
+            /**
+            * Init build: copy the coordinates of the points
+            *
+            * @param            refPoints:          points
+            * @return           true:               success
+            *                   false:              failed
+            *
+            */
+            bool niBspTree::niBinnedBuilder::InitBuild(
+                const niArrayT<niRefPoint2d> &refPoints)
+            {
+                size_t numPoints = refPoints.size();
+                try
+                {
+                    m_refPoints.assign(refPoints.begin(), refPoints.end());
+                    m_coords[0].resize(numPoints);
+                    m_coords[1].resize(numPoints);
+                    m_order.resize(numPoints);
+                }
+                catch (std::bad_alloc)
+                {
+                    return false;
+                }
+
+                for (size_t i = 0; i < numPoints; ++i)
+                {
+                    m_coords[0][i]  = refPoints[i].m_pointRef->X;
+                    m_coords[1][i]  = refPoints[i].m_pointRef->Y;
+                    m_order[i]      = int(i);
+                }
+                return true;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Build
+            //-----------------------------------------------------------------------------
+            /**
+            * Build bsp, throw std::bad_alloc when out of memory.
+            * The root is a node even for a few points, as niBuilder builds it. The subtrees
+            * are spawned down to the depth that gives about two tasks a hardware thread.
+            *
+            * @param            threshold:          If the number of elements is more than
+            *                                       threshold, split it into two nodes.
+            * @param            arena:              arena of the nodes
+            * @return           bsp node
+            *
+            */
+            niBspTree::niBspNode* niBspTree::niBinnedBuilder::Build(int threshold, niTreeArena &arena)
+            {
+                int spawnDepth = 0;
+                unsigned int numThreads = std::thread::hardware_concurrency();
+                while (numThreads > 1 && (1u << spawnDepth) < 2*numThreads)
+                {
+                    ++spawnDepth;
+                }
+                return BuildNode(0, int(m_order.size())-1, threshold, spawnDepth, arena);
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Build
+            //-----------------------------------------------------------------------------
+            /**
+            * Build bsp of the points between [_l, _r]
+            *
+            * @param            _l:                 start position
+            * @param            _r:                 end position
+            * @param            threshold:          If the number of elements is more than
+            *                                       threshold, split it into two nodes.
+            * @param            spawnDepth:         levels left to build the left subtree on
+            *                                       another thread
+            * @param            arena:              arena of the nodes
+            * @return           bsp node
+            *
+            */
+            niBspTree::niBspNode* niBspTree::niBinnedBuilder::Build(
+                int _l,
+                int _r,
+                int threshold,
+                int spawnDepth,
+                niTreeArena &arena)
+            {
+                if (_r - _l <= threshold)
+                {
+                    niBspLeaf* leaf = arena.New<niBspLeaf>();
+                    try
+                    {
+                        leaf->m_refPoints.reserve(_r - _l + 1);
+                    }
+                    catch (std::bad_alloc)
+                    {
+                        leaf->~niBspLeaf();
+                        throw;
+                    }
+                    for (int i = _l; i <= _r; ++i)
+                    {
+                        const niRefPoint2d &refPoint = m_refPoints[ m_order[i] ];
+                        leaf->m_refPoints.push_back(refPoint);
+                        leaf->m_bbox.Append( refPoint.m_pointRef );
+                    }
+                    return leaf;
+                }
+                return BuildNode(_l, _r, threshold, spawnDepth, arena);
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION BuildNode
+            //-----------------------------------------------------------------------------
+            /**
+            * Build the node of the points between [_l, _r] and its subtrees.
+            * When out of memory, the nodes built are destructed before std::bad_alloc
+            * goes on, their leaves own the arrays of points.
+            *
+            * @param            _l:                 start position
+            * @param            _r:                 end position
+            * @param            threshold:          If the number of elements is more than
+            *                                       threshold, split it into two nodes.
+            * @param            spawnDepth:         levels left to build the left subtree on
+            *                                       another thread
+            * @param            arena:              arena of the nodes
+            * @return           bsp node
+            *
+            */
+            niBspTree::niBspNode* niBspTree::niBinnedBuilder::BuildNode(
+                int _l,
+                int _r,
+                int threshold,
+                int spawnDepth,
+                niTreeArena &arena)
+            {
+                niBspNode *node = arena.New<niBspNode>();
+                for (int i = _l; i <= _r; ++i)
+                {
+                    int id = m_order[i];
+                    node->m_bbox.Append(m_coords[0][id], m_coords[1][id]);
+                }
+
+                int _axis = node->m_bbox.MaxAxis();
+                int _bin, _separator;
+                if (FindBestSplit(_l, _r, node->m_bbox, _axis, _bin))
+                {
+                    _separator = Split(_l, _r, node->m_bbox, _axis, _bin);
+                }
+                else if (_l < _r)
+                {
+                    //all the points on one position
+                    _separator = (_l + _r) / 2;
+                }
+                else
+                {
+                    //one point: an empty left leaf, as niBuilder
+                    _separator = _l - 1;
+                }
+
+                try
+                {
+                    if (spawnDepth > 0 && _r - _l + 1 >= CParallelSize)
+                    {
+                        niTreeArena leftArena;
+                        niBspNode *left = NULL;
+                        std::thread task(_BuildTask, this, _l, _separator, threshold, spawnDepth-1, &leftArena, &left);
+                        try
+                        {
+                            node->r_child = Build(_separator+1, _r, threshold, spawnDepth-1, arena);
+                        }
+                        catch (std::bad_alloc)
+                        {
+                            task.join();
+                            _DestructNodes(left);
+                            throw;
+                        }
+                        task.join();
+
+                        arena.Merge(leftArena);
+                        if (NULL == left)
+                            throw std::bad_alloc();
+                        node->l_child = left;
+                    }
+                    else
+                    {
+                        node->l_child = Build(_l, _separator, threshold, spawnDepth, arena);
+                        node->r_child = Build(_separator+1, _r, threshold, spawnDepth, arena);
+                    }
+                }
+                catch (std::bad_alloc)
+                {
+                    _DestructNodes(node);
+                    throw;
+                }
+                return node;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION FindBestSplit
+            //-----------------------------------------------------------------------------
+            /**
+            * Find the best split plane between the bins of the points on the longest axis.
+            * The cost of a side is area * (count + log(count)), as niBuilder::FindBestSplit.
+            *
+            * @param            _l:                 start position
+            * @param            _r:                 end position
+            * @param            bbox:               bbox of the points
+            * @param            _axis:              longest axis
+            * @param            _bin:               last bin of the left side
+            * @return           true:               success
+            *                   false:              all the points on one position
+            *
+            */
+            bool niBspTree::niBinnedBuilder::FindBestSplit(
+                int _l,
+                int _r,
+                const niBBox2d &bbox,
+                int _axis,
+                int &_bin)
+            {
+                _bin = -1;
+
+                double lower    = 0 == _axis ? bbox.P1.X : bbox.P1.Y;
+                double extent   = 0 == _axis ? bbox.Xlength() : bbox.Ylength();
+                if (extent <= 0.0)
+                    return false;
+
+                niCenterBins centerBins(&m_coords[_axis][0], lower, extent, CNumBins);
+
+                niBBox2d bins[CNumBins];
+                int counts[CNumBins] = {0};
+                for (int i = _l; i <= _r; ++i)
+                {
+                    int id = m_order[i];
+                    int bin = centerBins.BinOf(id);
+                    bins[bin].Append(m_coords[0][id], m_coords[1][id]);
+                    ++counts[bin];
+                }
+
+                niBBox2d right_bboxes[CNumBins];
+                int right_counts[CNumBins];
+                right_bboxes[CNumBins-1] = bins[CNumBins-1];
+                right_counts[CNumBins-1] = counts[CNumBins-1];
+                for (int bin = CNumBins-2; bin > 0; --bin)
+                {
+                    right_bboxes[bin] = right_bboxes[bin+1];
+                    right_bboxes[bin].Append(bins[bin]);
+                    right_counts[bin] = right_counts[bin+1] + counts[bin];
+                }
+
+                double min_cost = (double)1e300;
+
+                niBBox2d left_bbox;
+                int left_count = 0;
+                for (int bin = 0; bin < CNumBins-1; ++bin)
+                {
+                    left_bbox.Append(bins[bin]);
+                    left_count += counts[bin];
+
+                    int right_count = right_counts[bin+1];
+                    if (0 == left_count || 0 == right_count)
+                        continue;
+
+                    double cost_left, cost_right, cost;
+                    cost_left = left_bbox.Area() * (left_count + log((double)left_count));
+                    cost_right = right_bboxes[bin+1].Area() * (right_count + log((double)right_count));
+
+                    cost = cost_left + cost_right;
+                    if (cost < min_cost)
+                    {
+                        min_cost = cost;
+                        _bin = bin;
+                    }
+                }
+                return -1 != _bin;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Split
+            //-----------------------------------------------------------------------------
+            /**
+            * Split: move the points in the bins up to _bin to the left
+            *
+            * @param            _l:                 start position
+            * @param            _r:                 end position
+            * @param            bbox:               bbox of the points
+            * @param            _axis:              split axis
+            * @param            _bin:               last bin of the left side
+            * @return           split position, the last point of the left
+            *
+            */
+            int niBspTree::niBinnedBuilder::Split(
+                int _l,
+                int _r,
+                const niBBox2d &bbox,
+                int _axis,
+                int _bin)
+            {
+                niCenterBins centerBins(
+                    &m_coords[_axis][0],
+                    0 == _axis ? bbox.P1.X : bbox.P1.Y,
+                    0 == _axis ? bbox.Xlength() : bbox.Ylength(),
+                    CNumBins);
+                centerBins.m_bin = _bin;
+
+                int *first = &m_order[0];
+                int *middle = std::partition(first + _l, first + _r + 1, centerBins);
+                return int(middle - first) - 1;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION _BuildTask
+            //-----------------------------------------------------------------------------
+            /**
+            * Build a subtree on another thread
+            *
+            * @param            builder:            builder
+            * @param            _l:                 start position
+            * @param            _r:                 end position
+            * @param            threshold:          leaf threshold
+            * @param            spawnDepth:         levels left to spawn
+            * @param            arena:              arena of the thread
+            * @param            node:               store the subtree, NULL when out of memory
+            *
+            */
+            void niBspTree::niBinnedBuilder::_BuildTask(
+                niBinnedBuilder *builder,
+                int _l,
+                int _r,
+                int threshold,
+                int spawnDepth,
+                niTreeArena *arena,
+                niBspNode **node)
+            {
+                try
+                {
+                    *node = builder->Build(_l, _r, threshold, spawnDepth, *arena);
+                }
+                catch (std::bad_alloc)
+                {
+                    *node = NULL;
+                }
+            }
+
+
             //-----------------------------------------------------------------------------
             // FUNCTION Construction
             //-----------------------------------------------------------------------------
@@ -383,11 +775,14 @@ namespace ni
             *
             * @param            threshold:          If the number of elements is more than
             *                                       threshold, split it into two nodes.
+            * @param            builder:            tree builder
             *
             */
-            niBspTree::niBspTree(int threshold)
+            niBspTree::niBspTree(int threshold, ETreeBuilder builder)
                 : m_root(NULL),
-                m_cThreshold(threshold)
+                m_cThreshold(threshold),
+                m_cBuilder(builder),
+                m_arena(NULL)
             {
             }
 
@@ -400,13 +795,17 @@ namespace ni
             * @param            refPoints:          points
             * @param            threshold:          If the number of elements is more than
             *                                       threshold, split it into two nodes.
+            * @param            builder:            tree builder
             *
             */
             niBspTree::niBspTree(
                 const niArrayT<niRefPoint2d> &refPoints,
-                int threshold)
+                int threshold,
+                ETreeBuilder builder)
                 : m_root(NULL)
                 , m_cThreshold(threshold)
+                , m_cBuilder(builder)
+                , m_arena(NULL)
             {
                 Build(refPoints);
             }
@@ -469,6 +868,15 @@ namespace ni
 
                 _Destory();
 
+                if (eTBBinnedSAH == m_cBuilder)
+                {
+                    niBinnedBuilder build;
+                    if (!build.InitBuild(pointRefs))
+                        return false;
+
+                    return _BuildBinned(build);
+                }
+
                 niBuilder build;
 
                 bool bStat = build.InitBuild(pointRefs);
@@ -499,6 +907,15 @@ namespace ni
 
                 _Destory();
 
+                if (eTBBinnedSAH == m_cBuilder)
+                {
+                    niBinnedBuilder build;
+                    if (!build.InitBuild(refPoints))
+                        return false;
+
+                    return _BuildBinned(build);
+                }
+
                 niBuilder build;
 
                 bool bStat = build.InitBuild(refPoints);
@@ -640,12 +1057,78 @@ namespace ni
             */
             void niBspTree::_Destory()
             {
-                if (NULL != m_root)
+                if (NULL != m_arena)
+                {
+                    //the nodes are in the arena: destruct them, the arena frees them
+                    _DestructNodes(m_root);
+                    m_root = NULL;
+
+                    delete m_arena;
+                    m_arena = NULL;
+                }
+                else if (NULL != m_root)
                 {
                     delete m_root;
                     m_root = NULL;
                 }
             }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION _BuildBinned
+            //-----------------------------------------------------------------------------
+            /**
+            * Build the nodes in a new arena
+            *
+            * @param            build:              initialized builder
+            * @return           true:               success
+            *                   false:              failed
+            */
+            bool niBspTree::_BuildBinned(niBinnedBuilder &build)
+            {
+                try
+                {
+                    m_arena = new niTreeArena;
+                    m_root = build.Build(m_cThreshold, *m_arena);
+                }
+                catch (std::bad_alloc)
+                {
+                    //the nodes built are destructed by the builder, freed with the arena
+                    m_root = NULL;
+                    delete m_arena;
+                    m_arena = NULL;
+                    return false;
+                }
+                return NULL != m_root;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION _DestructNodes
+            //-----------------------------------------------------------------------------
+            /**
+            * Destruct the nodes of a subtree in an arena, one by one, not by their parents
+            *
+            * @param            node:               root of the subtree, may be NULL
+            */
+            void niBspTree::_DestructNodes(niBspNode *node)
+            {
+                std::stack<niBspNode*> ns;
+                if (NULL != node)
+                    ns.push(node);
+
+                while (!ns.empty())
+                {
+                    node = ns.top();
+                    ns.pop();
+                    if (NULL != node->l_child)
+                        ns.push(node->l_child);
+                    if (NULL != node->r_child)
+                        ns.push(node->r_child);
+
+                    node->l_child = NULL;
+                    node->r_child = NULL;
+                    node->~niBspNode();
+                }
+            }
         }
     }
 }
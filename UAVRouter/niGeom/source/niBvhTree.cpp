@@ -11,6 +11,7 @@
 
 #include <iostream>
 #include <stack>
+#include <thread>
 
 namespace ni
 {
@@ -350,15 +351,340 @@ namespace ni
             /**
             * Construction
             *
+            */
+            niBvhTree::niBinnedBuilder::niBinnedBuilder()
+            {
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION InitBuild
+            //-----------------------------------------------------------------------------
+            /**
+            * Init build: copy the boxes, calc their centers
+            *
             * @param            refGeomes:          geometry references
             * @param            bboxRefs:           boxes references
+            * @return           true:               success
+            *                   false:              failed
             *
             */
-            niBvhTree::niBvhTree(
+            bool niBvhTree::niBinnedBuilder::InitBuild(
+                const niArrayT<niRefGeom2d> &refGeomes,
+                const niArrayT<const niBBox2d*> &bboxRefs)
+            {
+                size_t numGeoms = refGeomes.size();
+                try
+                {
+                    m_refGeomes.assign(refGeomes.begin(), refGeomes.end());
+                    m_boxes.resize(numGeoms);
+                    m_centers[0].resize(numGeoms);
+                    m_centers[1].resize(numGeoms);
+                    m_order.resize(numGeoms);
+                }
+                catch (std::bad_alloc)
+                {
+                    return false;
+                }
+
+                for (size_t i = 0; i < numGeoms; ++i)
+                {
+                    const niBBox2d &bbox    = *bboxRefs[i];
+                    m_boxes[i]              = bbox;
+                    m_centers[0][i]         = (bbox.P1.X + bbox.P2.X) * 0.5;
+                    m_centers[1][i]         = (bbox.P1.Y + bbox.P2.Y) * 0.5;
+                    m_order[i]              = int(i);
+                }
+                return true;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION InitBuild
+            //-----------------------------------------------------------------------------
+            /**
+            * Init build: copy the boxes, calc their centers
+            *
+            * @param            refGeomes:          geometry references
+            * @param            boxes:              boxes
+            * @return           true:               success
+            *                   false:              failed
+            *
+            */
+            bool niBvhTree::niBinnedBuilder::InitBuild(
                 const niArrayT<niRefGeom2d> &refGeomes,
-                const niArrayT<const niBBox2d*> &bboxRefs) : m_root(NULL)
+                const niArrayT<niBBox2d> &boxes)
+            {
+                size_t numGeoms = refGeomes.size();
+                try
+                {
+                    m_refGeomes.assign(refGeomes.begin(), refGeomes.end());
+                    m_boxes.assign(boxes.begin(), boxes.begin() + numGeoms);
+                    m_centers[0].resize(numGeoms);
+                    m_centers[1].resize(numGeoms);
+                    m_order.resize(numGeoms);
+                }
+                catch (std::bad_alloc)
+                {
+                    return false;
+                }
+
+                for (size_t i = 0; i < numGeoms; ++i)
+                {
+                    const niBBox2d &bbox    = m_boxes[i];
+                    m_centers[0][i]         = (bbox.P1.X + bbox.P2.X) * 0.5;
+                    m_centers[1][i]         = (bbox.P1.Y + bbox.P2.Y) * 0.5;
+                    m_order[i]              = int(i);
+                }
+                return true;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Build
+            //-----------------------------------------------------------------------------
+            /**
+            * Build bvh, throw std::bad_alloc when out of memory.
+            * The subtrees are spawned down to the depth that gives about two tasks a
+            * hardware thread.
+            *
+            * @param            arena:              arena of the nodes
+            * @return           root node
+            *
+            */
+            niBvhTree::niBvhNode* niBvhTree::niBinnedBuilder::Build(niTreeArena &arena)
+            {
+                int spawnDepth = 0;
+                unsigned int numThreads = std::thread::hardware_concurrency();
+                while (numThreads > 1 && (1u << spawnDepth) < 2*numThreads)
+                {
+                    ++spawnDepth;
+                }
+                return Build(0, int(m_order.size())-1, spawnDepth, arena);
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Build
+            //-----------------------------------------------------------------------------
+            /**
+            * Build bvh of the elements between [_l, _r]
+            *
+            * @param            _l:                 start position
+            * @param            _r:                 end position
+            * @param            spawnDepth:         levels left to build the left subtree on
+            *                                       another thread
+            * @param            arena:              arena of the nodes
+            * @return           bvh node
+            *
+            */
+            niBvhTree::niBvhNode* niBvhTree::niBinnedBuilder::Build(
+                int _l,
+                int _r,
+                int spawnDepth,
+                niTreeArena &arena)
+            {
+                if (_l == _r)
+                {
+                    niBvhLeaf *leaf = arena.New<niBvhLeaf>();
+                    leaf->m_bbox    = m_boxes[ m_order[_l] ];
+                    leaf->m_refGeom = m_refGeomes[ m_order[_l] ];
+                    return leaf;
+                }
+
+                niBvhNode *node = arena.New<niBvhNode>();
+                niBBox2d centerBBox;
+                for (int i = _l; i <= _r; ++i)
+                {
+                    int id = m_order[i];
+                    node->m_bbox.Append(m_boxes[id]);
+                    centerBBox.Append(m_centers[0][id], m_centers[1][id]);
+                }
+
+                int _axis, _bin, _separator;
+                if (FindBestSplit(_l, _r, centerBBox, _axis, _bin))
+                {
+                    _separator = Split(_l, _r, centerBBox, _axis, _bin);
+                }
+                else
+                {
+                    //all the centers on one point
+                    _separator = (_l + _r) / 2;
+                }
+
+                if (spawnDepth > 0 && _r - _l + 1 >= CParallelSize)
+                {
+                    niTreeArena leftArena;
+                    niBvhNode *left = NULL;
+                    std::thread task(_BuildTask, this, _l, _separator, spawnDepth-1, &leftArena, &left);
+                    try
+                    {
+                        node->r_child = Build(_separator+1, _r, spawnDepth-1, arena);
+                    }
+                    catch (std::bad_alloc)
+                    {
+                        task.join();
+                        throw;
+                    }
+                    task.join();
+
+                    arena.Merge(leftArena);
+                    if (NULL == left)
+                        throw std::bad_alloc();
+                    node->l_child = left;
+                }
+                else
+                {
+                    node->l_child = Build(_l, _separator, spawnDepth, arena);
+                    node->r_child = Build(_separator+1, _r, spawnDepth, arena);
+                }
+                return node;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION FindBestSplit
+            //-----------------------------------------------------------------------------
+            /**
+            * Find the best split plane between the bins of the centers, on both axes.
+            * The cost of a side is area * (count + log(count)), as niBuilder::FindBestSplit.
+            *
+            * @param            _l:                 start position
+            * @param            _r:                 end position
+            * @param            centerBBox:         bbox of the centers
+            * @param            _axis:              split axis
+            * @param            _bin:               last bin of the left side
+            * @return           true:               success
+            *                   false:              all the centers on one point
+            *
+            */
+            bool niBvhTree::niBinnedBuilder::FindBestSplit(
+                int _l,
+                int _r,
+                const niBBox2d &centerBBox,
+                int &_axis,
+                int &_bin)
+            {
+                _axis = -1;
+                _bin = -1;
+
+                double min_cost = (double)1e300;
+
+                for (int axis = 0; axis < 2; ++axis)
+                {
+                    double lower    = 0 == axis ? centerBBox.P1.X : centerBBox.P1.Y;
+                    double extent   = 0 == axis ? centerBBox.Xlength() : centerBBox.Ylength();
+                    if (extent <= 0.0)
+                        continue;
+
+                    niCenterBins centerBins(&m_centers[axis][0], lower, extent, CNumBins);
+
+                    niBBox2d bins[CNumBins];
+                    int counts[CNumBins] = {0};
+                    for (int i = _l; i <= _r; ++i)
+                    {
+                        int id = m_order[i];
+                        int bin = centerBins.BinOf(id);
+                        bins[bin].Append(m_boxes[id]);
+                        ++counts[bin];
+                    }
+
+                    niBBox2d right_bboxes[CNumBins];
+                    int right_counts[CNumBins];
+                    right_bboxes[CNumBins-1] = bins[CNumBins-1];
+                    right_counts[CNumBins-1] = counts[CNumBins-1];
+                    for (int bin = CNumBins-2; bin > 0; --bin)
+                    {
+                        right_bboxes[bin] = right_bboxes[bin+1];
+                        right_bboxes[bin].Append(bins[bin]);
+                        right_counts[bin] = right_counts[bin+1] + counts[bin];
+                    }
+
+                    niBBox2d left_bbox;
+                    int left_count = 0;
+                    for (int bin = 0; bin < CNumBins-1; ++bin)
+                    {
+                        left_bbox.Append(bins[bin]);
+                        left_count += counts[bin];
+
+                        int right_count = right_counts[bin+1];
+                        if (0 == left_count || 0 == right_count)
+                            continue;
+
+                        double cost_left, cost_right, cost;
+                        cost_left = left_bbox.Area() * (left_count + log((double)left_count));
+                        cost_right = right_bboxes[bin+1].Area() * (right_count + log((double)right_count));
+
+                        cost = cost_left + cost_right;
+                        if (cost < min_cost)
+                        {
+                            min_cost = cost;
+                            _axis = axis;
+                            _bin = bin;
+                        }
+                    }
+                }
+                return -1 != _axis;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Split
+            //-----------------------------------------------------------------------------
+            /**
+            * Split: move the elements in the bins up to _bin to the left
+            *
+            * @param            _l:                 start position
+            * @param            _r:                 end position
+            * @param            centerBBox:         bbox of the centers
+            * @param            _axis:              split axis
+            * @param            _bin:               last bin of the left side
+            * @return           split position, the last element of the left
+            *
+            */
+            int niBvhTree::niBinnedBuilder::Split(
+                int _l,
+                int _r,
+                const niBBox2d &centerBBox,
+                int _axis,
+                int _bin)
             {
-                Build(refGeomes, bboxRefs);
+                niCenterBins centerBins(
+                    &m_centers[_axis][0],
+                    0 == _axis ? centerBBox.P1.X : centerBBox.P1.Y,
+                    0 == _axis ? centerBBox.Xlength() : centerBBox.Ylength(),
+                    CNumBins);
+                centerBins.m_bin = _bin;
+
+                int *first = &m_order[0];
+                int *middle = std::partition(first + _l, first + _r + 1, centerBins);
+                return int(middle - first) - 1;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION _BuildTask
+            //-----------------------------------------------------------------------------
+            /**
+            * Build a subtree on another thread
+            *
+            * @param            builder:            builder
+            * @param            _l:                 start position
+            * @param            _r:                 end position
+            * @param            spawnDepth:         levels left to spawn
+            * @param            arena:              arena of the thread
+            * @param            node:               store the subtree, NULL when out of memory
+            *
+            */
+            void niBvhTree::niBinnedBuilder::_BuildTask(
+                niBinnedBuilder *builder,
+                int _l,
+                int _r,
+                int spawnDepth,
+                niTreeArena *arena,
+                niBvhNode **node)
+            {
+                try
+                {
+                    *node = builder->Build(_l, _r, spawnDepth, *arena);
+                }
+                catch (std::bad_alloc)
+                {
+                    *node = NULL;
+                }
             }
 
             //-----------------------------------------------------------------------------
@@ -369,13 +695,34 @@ namespace ni
             *
             * @param            refGeomes:          geometry references
             * @param            bboxRefs:           boxes references
+            * @param            builder:            tree builder
             *
             */
             niBvhTree::niBvhTree(
                 const niArrayT<niRefGeom2d> &refGeomes,
-                const niArrayT<niBBox2d> &boxes) : m_root(NULL)
+                const niArrayT<const niBBox2d*> &bboxRefs,
+                ETreeBuilder builder) : m_root(NULL), m_arena(NULL)
             {
-                Build(refGeomes, boxes);
+                Build(refGeomes, bboxRefs, builder);
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Construction
+            //-----------------------------------------------------------------------------
+            /**
+            * Construction
+            *
+            * @param            refGeomes:          geometry references
+            * @param            boxes:              boxes
+            * @param            builder:            tree builder
+            *
+            */
+            niBvhTree::niBvhTree(
+                const niArrayT<niRefGeom2d> &refGeomes,
+                const niArrayT<niBBox2d> &boxes,
+                ETreeBuilder builder) : m_root(NULL), m_arena(NULL)
+            {
+                Build(refGeomes, boxes, builder);
             }
 
             //-----------------------------------------------------------------------------
@@ -398,12 +745,14 @@ namespace ni
             *
             * @param            refGeomes:          geometry references
             * @param            bboxRefs:           boxes references
+            * @param            builder:            tree builder
             * @return           true:               success
             *                   false:              failed
             */
             bool niBvhTree::Build(
                 const niArrayT<niRefGeom2d> &refGeomes,
-                const niArrayT<const niBBox2d*> &bboxRefs)
+                const niArrayT<const niBBox2d*> &bboxRefs,
+                ETreeBuilder builder)
             {
                 _Destory();
 
@@ -411,6 +760,15 @@ namespace ni
                 if (numGeomes < 1)
                     return false;
 
+                if (eTBBinnedSAH == builder)
+                {
+                    niBinnedBuilder build;
+                    if (!build.InitBuild(refGeomes, bboxRefs))
+                        return false;
+
+                    return _BuildBinned(build);
+                }
+
                 niBuilder build;
 
                 bool bStat = build.InitBuild(refGeomes, bboxRefs);
@@ -430,12 +788,14 @@ namespace ni
             *
             * @param            refGeomes:          geometry references
             * @param            bboxRefs:           boxes references
+            * @param            builder:            tree builder
             * @return           true:               success
             *                   false:              failed
             */
             bool niBvhTree::Build(
                 const niArrayT<niRefGeom2d> &refGeomes,
-                const niArrayT<niBBox2d> &bboxes)
+                const niArrayT<niBBox2d> &bboxes,
+                ETreeBuilder builder)
             {
                 _Destory();
 
@@ -443,6 +803,15 @@ namespace ni
                 if (numGeomes < 1)
                     return false;
 
+                if (eTBBinnedSAH == builder)
+                {
+                    niBinnedBuilder build;
+                    if (!build.InitBuild(refGeomes, bboxes))
+                        return false;
+
+                    return _BuildBinned(build);
+                }
+
                 niBuilder build;
 
                 bool bStat = build.InitBuild(refGeomes, bboxes);
@@ -506,9 +875,70 @@ namespace ni
 
                 return maxDepth - minDepth;
             }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION _BuildBinned
+            //-----------------------------------------------------------------------------
+            /**
+            * Build the nodes in a new arena
+            *
+            * @param            build:              initialized builder
+            * @return           true:               success
+            *                   false:              failed
+            */
+            bool niBvhTree::_BuildBinned(niBinnedBuilder &build)
+            {
+                try
+                {
+                    m_arena = new niTreeArena;
+                    m_root = build.Build(*m_arena);
+                }
+                catch (std::bad_alloc)
+                {
+                    //the nodes built are freed with the arena
+                    m_root = NULL;
+                    delete m_arena;
+                    m_arena = NULL;
+                    return false;
+                }
+                return NULL != m_root;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Destory
+            //-----------------------------------------------------------------------------
+            /**
+            * Destory
+            *
+            */
             void niBvhTree::_Destory()
             {
-                if (NULL != m_root)
+                if (NULL != m_arena)
+                {
+                    //the nodes are in the arena: destruct them one by one, not by their parents
+                    std::stack<niBvhNode*> ns;
+                    if (NULL != m_root)
+                        ns.push(m_root);
+
+                    while (!ns.empty())
+                    {
+                        niBvhNode *node = ns.top();
+                        ns.pop();
+                        if (NULL != node->l_child)
+                            ns.push(node->l_child);
+                        if (NULL != node->r_child)
+                            ns.push(node->r_child);
+
+                        node->l_child = NULL;
+                        node->r_child = NULL;
+                        node->~niBvhNode();
+                    }
+                    m_root = NULL;
+
+                    delete m_arena;
+                    m_arena = NULL;
+                }
+                else if (NULL != m_root)
                 {
                     delete m_root;
                     m_root = NULL;
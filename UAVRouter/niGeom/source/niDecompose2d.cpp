@@ -1335,7 +1335,7 @@ namespace ni
         * return        bvh tree
         * 
         */
-        tree::niBvhTree* niDecompose2d::_CreateEdgeBvhTree(
+        tree::niFlatBvhTree* niDecompose2d::_CreateEdgeBvhTree(
             niArrayT<niTopoEdge> &topoEdges,
             niArrayT<niBBox2d> &bboxes)
         {
@@ -1354,7 +1354,7 @@ namespace ni
                 refEdges[i].m_geomRef   = (void*)(&topoEdges[i]);
                 refEdges[i].m_IdOfGeom  = i;
             }
-            return new tree::niBvhTree(refEdges, bboxes);
+            return new tree::niFlatBvhTree(refEdges, bboxes, tree::eTBBinnedSAH);
         }
 
         //-----------------------------------------------------------------------------
@@ -1366,7 +1366,7 @@ namespace ni
         * return        bvh tree
         * 
         */
-        tree::niBvhTree* niDecompose2d::_CreateEdgeBvhTree(
+        tree::niFlatBvhTree* niDecompose2d::_CreateEdgeBvhTree(
             niArrayT<niSplitEdge> &splitEdges)
         {
             niArrayT<niRefGeom2d> refEdges;
@@ -1389,7 +1389,7 @@ namespace ni
                 refEdges[i].m_geomRef = (void*)(&splitEdges[i]);
                 refEdges[i].m_IdOfGeom = i;
             }
-            return new tree::niBvhTree(refEdges, bboxes);
+            return new tree::niFlatBvhTree(refEdges, bboxes, tree::eTBBinnedSAH);
         }
 
         //-----------------------------------------------------------------------------
@@ -1896,9 +1896,9 @@ namespace ni
             refGeomes[NUM-1].m_IdOfGeom         = iGlobalPntId;
             ++iGlobalPntId;
 
-            topoPoly.m_hBsp4Point               = new tree::niBspTree(topoPoly.m_topoPoints);
+            topoPoly.m_hBsp4Point               = new tree::niBspTree(topoPoly.m_topoPoints, 16, tree::eTBBinnedSAH);
 
-            topoPoly.m_hBvh4Edge                = new tree::niBvhTree(refGeomes, bboxRefs);
+            topoPoly.m_hBvh4Edge                = new tree::niBvhTree(refGeomes, bboxRefs, tree::eTBBinnedSAH);
 
             for (int i = 0; i < NUM; ++i)
             {
@@ -1967,7 +1967,7 @@ namespace ni
 
             m_hBvh4TopoEdge = _CreateEdgeBvhTree(m_topoEdges, m_edgeBBoxes);
 
-            m_hBsp4Point = new tree::niBspTree(m_topoPoints);
+            m_hBsp4Point = new tree::niBspTree(m_topoPoints, 16, tree::eTBBinnedSAH);
             return true;
         }
 
@@ -2151,48 +2151,25 @@ namespace ni
             const niPoint2d &p0,
             const niPoint2d &p1)
         {
-            return _IsOverlapTopoEdge(p0, p1, m_hBvh4TopoEdge->Root());
+            niTopoEdgeOverlap leafTest(p0, p1);
+            return m_hBvh4TopoEdge->FindSegmentHit(p0, p1, leafTest);
         }
 
-        bool niDecompose2d::_IsOverlapTopoEdge(
-            const niPoint2d &p0,
-            const niPoint2d &p1,
-            const tree::niBvhTree::niBvhNode *edgeBvhNode)
+        //-----------------------------------------------------------------------------
+        // FUNCTION niTopoEdgeOverlap
+        //-----------------------------------------------------------------------------
+        /**
+        * Check a topo edge of the bvh tree overlaps the segment
+        * @param        refEdge:        leaf of the bvh tree
+        * return        true:           Overlap
+        *               false:          not overlap
+        * 
+        */
+        bool niDecompose2d::niTopoEdgeOverlap::operator()(const niRefGeom2d &refEdge) const
         {
-            bool bOverlap = niGeomMath2d::IsLineOverlapBox(p0, p1, edgeBvhNode->m_bbox);
-            if (!bOverlap)
-                return false;
-
-            if (edgeBvhNode->IsLeaf())
-            {
-                const tree::niBvhTree::niBvhLeaf *leaf = 
-                    dynamic_cast<const tree::niBvhTree::niBvhLeaf*>(edgeBvhNode);
-                const niTopoEdge* te = static_cast<const niTopoEdge*>(leaf->m_refGeom.m_geomRef);
-                bOverlap = niGeomMath2d::LineOverlapLine(
-                    p0, p1, *te->A().m_pointRef, *te->B().m_pointRef);
-
-                return bOverlap;
-            }
-            else
-            {
-                if (edgeBvhNode->l_child)
-                {
-                    bOverlap = _IsOverlapTopoEdge(p0, p1, edgeBvhNode->l_child);
-                    if (bOverlap)
-                    {
-                        return true;
-                    }
-                }
-                if (edgeBvhNode->r_child)
-                {
-                    bOverlap = _IsOverlapTopoEdge(p0, p1, edgeBvhNode->r_child);
-                    if (bOverlap)
-                    {
-                        return true;
-                    }
-                }
-                return false;
-            }
+            const niTopoEdge* te = static_cast<const niTopoEdge*>(refEdge.m_geomRef);
+            return niGeomMath2d::LineOverlapLine(
+                m_p0, m_p1, *te->A().m_pointRef, *te->B().m_pointRef);
         }
 
         //-----------------------------------------------------------------------------
@@ -2223,18 +2200,15 @@ namespace ni
                 }
                 m_hBvh4SplitEdge = _CreateEdgeBvhTree(m_splitEdges);
                 m_numSplitEdgeInBVH = numSplitEdges;
-                return _IsOverlapSplitEdge(
-                    p0,
-                    p1,
-                    m_hBvh4SplitEdge->Root());
+
+                niSplitEdgeOverlap leafTest(p0, p1);
+                return m_hBvh4SplitEdge->FindSegmentHit(p0, p1, leafTest);
             }
 
             if (NULL != m_hBvh4SplitEdge)
             {
-                bOverlap = _IsOverlapSplitEdge(
-                    p0,
-                    p1,
-                    m_hBvh4SplitEdge->Root());
+                niSplitEdgeOverlap leafTest(p0, p1);
+                bOverlap = m_hBvh4SplitEdge->FindSegmentHit(p0, p1, leafTest);
                 if (bOverlap)
                 {
                     return bOverlap;
@@ -2263,56 +2237,25 @@ namespace ni
         }
 
         //-----------------------------------------------------------------------------
-        // FUNCTION _IsOverlapSplitEdge
+        // FUNCTION niSplitEdgeOverlap
         //-----------------------------------------------------------------------------
         /**
-        * Check a split edge is overlap other split edges
-        * @param        p0:             first point
-        * @param        p1:             second point
-        * @param        edgeBvhNode:    bvh node
+        * Check a split edge of the bvh tree overlaps the segment
+        * @param        refEdge:        leaf of the bvh tree
         * return        true:           Overlap
-        *               false:          not overlap
+        *               false:          not overlap, or the split edge is excluded
         * 
         */
-        bool niDecompose2d::_IsOverlapSplitEdge(
-            const niPoint2d &p0,
-            const niPoint2d &p1,
-            const tree::niBvhTree::niBvhNode *edgeBvhNode)
+        bool niDecompose2d::niSplitEdgeOverlap::operator()(const niRefGeom2d &refEdge) const
         {
-            bool bOverlap = niGeomMath2d::IsLineOverlapBox(p0, p1, edgeBvhNode->m_bbox);
-            if (!bOverlap)
-                return false;
-
-            if (edgeBvhNode->IsLeaf())
+            const niSplitEdge* se = static_cast<const niSplitEdge*>(refEdge.m_geomRef);
+            if (se->IsExcluded())
             {
-                const tree::niBvhTree::niBvhLeaf *leaf = 
-                    dynamic_cast<const tree::niBvhTree::niBvhLeaf*>(edgeBvhNode);
-                const niSplitEdge* se = static_cast<const niSplitEdge*>(leaf->m_refGeom.m_geomRef);
-                if (se->IsExcluded())
-                {
-                    return false;
-                }
-
-                bOverlap = niGeomMath2d::LineOverlapLine(
-                    p0, p1, *se->A().m_pointRef, *se->B().m_pointRef);
-                return bOverlap;
-            }
-            else
-            {
-                if (edgeBvhNode->l_child)
-                {
-                    bOverlap = _IsOverlapSplitEdge(p0, p1, edgeBvhNode->l_child);
-                    if (bOverlap)
-                        return true;
-                }
-                if (edgeBvhNode->r_child)
-                {
-                    bOverlap = _IsOverlapSplitEdge(p0, p1, edgeBvhNode->r_child);
-                    if (bOverlap)
-                        return true;
-                }
                 return false;
             }
+
+            return niGeomMath2d::LineOverlapLine(
+                m_p0, m_p1, *se->A().m_pointRef, *se->B().m_pointRef);
         }
 
         //-----------------------------------------------------------------------------
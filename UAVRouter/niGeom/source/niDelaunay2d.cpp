@@ -0,0 +1,1318 @@
+//! \file
+// \brief
+// Constrained Delaunay triangulation of polygons with holes
+//
+// Revisions:
+//   Date        Author     Description
+//   ----------  --------   -------------------------------------------------
+// - 2026-10-17             Initial version
+
+#include <niGeom/geometry/niDelaunay2d.h>
+#include <niGeom/geometry/niGeomMath2d.h>
+#include <niGeom/geometry/niPolygon2d.h>
+#include <niGeom/geometry/niTriMesh2d.h>
+#include <niGeom/geometry/niTriMesh2dTopo.h>
+
+#include <algorithm>
+#include <deque>
+#include <thread>
+
+namespace ni
+{
+    namespace geometry
+    {
+        /**
+         * \brief input point to sort, by x then y, then by the id of point
+         *
+         */
+        struct _niSortPoint
+        {
+            double                  X;
+            double                  Y;
+            int                     m_IdOfPoint;
+
+            bool                    operator<           (const _niSortPoint &other) const
+            {
+                if (X != other.X)
+                    return X < other.X;
+                if (Y != other.Y)
+                    return Y < other.Y;
+                return m_IdOfPoint < other.m_IdOfPoint;
+            }
+        };
+
+        //order of the points along axis: x then y, or y then -x (x, y turned clockwise)
+        static inline bool _IsBefore(double x1, double y1, double x2, double y2, int axis)
+        {
+            if (0 == axis)
+                return x1 < x2 || (x1 == x2 && y1 < y2);
+            return y1 < y2 || (y1 == y2 && x1 > x2);
+        }
+
+        /**
+         * \brief order of the sort points along an axis
+         *
+         */
+        class _niAxisCompare
+        {
+        public:
+            _niAxisCompare          (int axis) : m_axis(axis)
+            {
+            }
+
+            bool                    operator()          (const _niSortPoint &p1, const _niSortPoint &p2) const
+            {
+                return _IsBefore(p1.X, p1.Y, p2.X, p2.Y, m_axis);
+            }
+
+        protected:
+            int                     m_axis;
+        };
+
+        //arrange the points between [_l, _r] into the cuts of niDelaunay2d::_Triangulate:
+        //the lower half along axis first, each half cut along the other axis
+        static void _PartitionPoints(_niSortPoint *points, int _l, int _r, int axis, int spawnDepth)
+        {
+            if (_r - _l + 1 <= 3)
+            {
+                std::sort(points + _l, points + _r + 1, _niAxisCompare(axis));
+                return;
+            }
+
+            int _m = (_l + _r) / 2;
+            std::nth_element(points + _l, points + _m, points + _r + 1, _niAxisCompare(axis));
+            if (spawnDepth > 0 && _r - _l + 1 >= niDelaunay2d::CParallelSize)
+            {
+                std::thread task(_PartitionPoints, points, _l, _m, 1 - axis, spawnDepth-1);
+                _PartitionPoints(points, _m+1, _r, 1 - axis, spawnDepth-1);
+                task.join();
+            }
+            else
+            {
+                _PartitionPoints(points, _l, _m, 1 - axis, spawnDepth);
+                _PartitionPoints(points, _m+1, _r, 1 - axis, spawnDepth);
+            }
+        }
+
+        //position of vert v in triangle tri
+        static inline int _IndexOf(const niDelaunay2d::niDtTri &tri, int v)
+        {
+            return tri.m_v[0] == v ? 0 : (tri.m_v[1] == v ? 1 : 2);
+        }
+
+        //is p on the side of b, seen from a, when a, p, b are collinear
+        static inline bool _IsAhead(const niPoint2d &a, const niPoint2d &p, const niPoint2d &b)
+        {
+            if (a.X != b.X)
+                return (p.X > a.X) == (b.X > a.X) && p.X != a.X;
+            return (p.Y > a.Y) == (b.Y > a.Y) && p.Y != a.Y;
+        }
+
+        //do the segments p-q and a-b cross, not at an endpoint
+        static inline bool _IsCrossing(double o_p, double o_q)
+        {
+            return (o_p > 0.0 && o_q < 0.0) || (o_p < 0.0 && o_q > 0.0);
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION Construction
+        //-----------------------------------------------------------------------------
+        /**
+        * Construction
+        *
+        * @param       fParallel:   triangulate the top halves on their own threads
+        */
+        niDelaunay2d::niDelaunay2d(bool fParallel)
+            : m_fParallel(fParallel)
+        {
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION AddPoints
+        //-----------------------------------------------------------------------------
+        /**
+        * Add points to triangulate, without constraint
+        *
+        * @param       points:      points
+        * @return      true:        sucess
+        *              false:       out of memory
+        */
+        bool niDelaunay2d::AddPoints(const niPoint2dArray &points)
+        {
+            try
+            {
+                m_inputPoints.insert(m_inputPoints.end(), points.begin(), points.end());
+            }
+            catch (std::bad_alloc)
+            {
+                return false;
+            }
+            return true;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION AddRing
+        //-----------------------------------------------------------------------------
+        /**
+        * Add a ring: the boundary, or a hole inside it. The borders of the ring are
+        * edges of the triangulation.
+        *
+        * @param       polygon:     ring
+        * @return      true:        sucess
+        *              false:       less than 3 points, or out of memory
+        */
+        bool niDelaunay2d::AddRing(const niPolygon2d &polygon)
+        {
+            const niPoint2dArray &points = polygon.GetPoints();
+            int num_points = int(points.size());
+            if (num_points < 3)
+                return false;
+
+            int first = int(m_inputPoints.size());
+            try
+            {
+                m_inputPoints.insert(m_inputPoints.end(), points.begin(), points.end());
+                m_segments.reserve(m_segments.size() + 2 * num_points);
+            }
+            catch (std::bad_alloc)
+            {
+                return false;
+            }
+            for (int i = 0; i < num_points; ++i)
+            {
+                m_segments.push_back(first + i);
+                m_segments.push_back(first + (i + 1) % num_points);
+            }
+            return true;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION Clear
+        //-----------------------------------------------------------------------------
+        /**
+        * Clear the points, the rings and the triangulation
+        *
+        */
+        void niDelaunay2d::Clear()
+        {
+            m_inputPoints.clear();
+            m_segments.clear();
+            m_points.clear();
+            m_IdOfVerts.clear();
+            m_tris.clear();
+            m_vertTris.clear();
+            m_inside.clear();
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION Process
+        //-----------------------------------------------------------------------------
+        /**
+        * Triangulate the region of the rings, or the convex hull without ring
+        *
+        * @param       tri_mesh:    store the triangles, counterclockwise. The points are
+        *                           the vertices of the triangles, in the order they were added
+        * @param       error_msg:   store the error message
+        * @return      true:        sucess
+        *              false:       failed
+        */
+        bool niDelaunay2d::Process(niTriMesh2d &tri_mesh, String &error_msg)
+        {
+            tri_mesh.Clear();
+            m_tris.clear();
+
+            try
+            {
+                int spawnDepth = 0;
+                if (m_fParallel)
+                {
+                    unsigned int numThreads = std::thread::hardware_concurrency();
+                    while (numThreads > 1 && (1u << spawnDepth) < 2*numThreads)
+                    {
+                        ++spawnDepth;
+                    }
+                }
+
+                if (!_SortPoints(spawnDepth))
+                {
+                    error_msg = "_points error!";
+                    return false;
+                }
+
+                //the quad-edges live until the triangles are built
+                {
+                    niDtPool pool;
+                    niDtEdge *le = NULL, *re = NULL;
+                    _Triangulate(0, int(m_points.size())-1, 0, spawnDepth, pool, le, re);
+
+                    if (!_BuildTriangles(pool))
+                    {
+                        error_msg = "Delaunay error!";
+                        return false;
+                    }
+                }
+
+                int num_segments = int(m_segments.size()) / 2;
+                for (int i = 0; i < num_segments; ++i)
+                {
+                    int a = m_IdOfVerts[ m_segments[2*i] ];
+                    int b = m_IdOfVerts[ m_segments[2*i+1] ];
+                    if (a == b)
+                        continue;
+                    if (!_InsertConstraint(a, b))
+                    {
+                        error_msg = "Constraint error!";
+                        return false;
+                    }
+                }
+
+                if (!_MarkRegion())
+                {
+                    error_msg = "Constraint error!";
+                    return false;
+                }
+
+                if (!_MakeMesh(tri_mesh))
+                {
+                    error_msg = "MakeTriMesh error!";
+                    return false;
+                }
+            }
+            catch (std::bad_alloc)
+            {
+                error_msg = "Out of memory!";
+                return false;
+            }
+            return true;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION Process
+        //-----------------------------------------------------------------------------
+        /**
+        * Triangulate, and build the topology of the triangles
+        *
+        * @param       tri_mesh:    store the triangles
+        * @param       topology:    store the topology of tri_mesh
+        * @param       error_msg:   store the error message
+        * @return      true:        sucess
+        *              false:       failed
+        */
+        bool niDelaunay2d::Process(
+            niTriMesh2d &tri_mesh,
+            niTriMesh2dTopo &topology,
+            String &error_msg)
+        {
+            if (!Process(tri_mesh, error_msg))
+                return false;
+
+            if (!topology.BuildTopology(tri_mesh, true))
+            {
+                error_msg = "BuildTopology error!";
+                return false;
+            }
+            return true;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION Merge
+        //-----------------------------------------------------------------------------
+        /**
+        * Take over the quads of another thread
+        *
+        * @param       other:       pool of the other thread
+        */
+        void niDelaunay2d::niDtPool::Merge(niDtPool &other)
+        {
+            m_arena.Merge(other.m_arena);
+            m_quads.insert(m_quads.end(), other.m_quads.begin(), other.m_quads.end());
+            other.m_quads.clear();
+
+            while (NULL != other.m_free)
+            {
+                niDtQuad *quad = other.m_free;
+                other.m_free = (niDtQuad*)quad->m_edges[0].m_next;
+                quad->m_edges[0].m_next = (niDtEdge*)m_free;
+                m_free = quad;
+            }
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _MakeEdge
+        //-----------------------------------------------------------------------------
+        /**
+        * Make a quad-edge from org to dest, alone. A deleted quad is reused first.
+        *
+        * @param       pool:        quads of the thread
+        * @param       org:         origin vertex
+        * @param       dest:        destination vertex
+        * @return      the edge
+        */
+        niDelaunay2d::niDtEdge* niDelaunay2d::_MakeEdge(niDtPool &pool, int org, int dest)
+        {
+            niDtQuad *quad = pool.m_free;
+            if (NULL != quad)
+            {
+                pool.m_free = (niDtQuad*)quad->m_edges[0].m_next;
+            }
+            else
+            {
+                quad = pool.m_arena.New<niDtQuad>();
+                pool.m_quads.push_back(quad);
+            }
+            niDtEdge *e = quad->m_edges;
+            for (int i = 0; i < 4; ++i)
+            {
+                e[i].m_rot  = i;
+                e[i].m_org  = -1;
+                e[i].m_face = -1;
+            }
+            e[0].m_next = e;
+            e[1].m_next = e + 3;
+            e[2].m_next = e + 2;
+            e[3].m_next = e + 1;
+            e[0].m_org  = org;
+            e[2].m_org  = dest;
+            return e;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _Splice
+        //-----------------------------------------------------------------------------
+        /**
+        * Join the rings of a and b around their origins, or split them if joined
+        *
+        * @param       a:           edge
+        * @param       b:           edge
+        */
+        void niDelaunay2d::_Splice(niDtEdge *a, niDtEdge *b)
+        {
+            niDtEdge *alpha = _Rot(a->m_next);
+            niDtEdge *beta  = _Rot(b->m_next);
+
+            std::swap(a->m_next, b->m_next);
+            std::swap(alpha->m_next, beta->m_next);
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _Connect
+        //-----------------------------------------------------------------------------
+        /**
+        * Add an edge from the destination of a to the origin of b, in the face on the
+        * left of both
+        *
+        * @param       pool:        quads of the thread
+        * @param       a:           edge
+        * @param       b:           edge
+        * @return      the new edge
+        */
+        niDelaunay2d::niDtEdge* niDelaunay2d::_Connect(niDtPool &pool, niDtEdge *a, niDtEdge *b)
+        {
+            niDtEdge *e = _MakeEdge(pool, _Dest(a), b->m_org);
+            _Splice(e, _Lnext(a));
+            _Splice(_Sym(e), b);
+            return e;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _DeleteEdge
+        //-----------------------------------------------------------------------------
+        /**
+        * Take an edge out of the structure, its quad goes to the free list
+        *
+        * @param       pool:        quads of the thread
+        * @param       e:           edge
+        */
+        void niDelaunay2d::_DeleteEdge(niDtPool &pool, niDtEdge *e)
+        {
+            _Splice(e, _Oprev(e));
+            _Splice(_Sym(e), _Oprev(_Sym(e)));
+
+            niDtQuad *quad = (niDtQuad*)(e - e->m_rot);
+            quad->m_edges[0].m_face = -2;
+            quad->m_edges[2].m_face = -2;
+            quad->m_edges[0].m_next = (niDtEdge*)pool.m_free;
+            pool.m_free = quad;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _SortPoints
+        //-----------------------------------------------------------------------------
+        /**
+        * Sort the input points into the vertices, the same points give one vertex, and
+        * arrange the vertices into the cuts of _Triangulate
+        *
+        * @param       spawnDepth:  levels left to arrange the first half on another thread
+        * @return      true:        at least 3 vertices
+        *              false:       less than 3 vertices
+        */
+        bool niDelaunay2d::_SortPoints(int spawnDepth)
+        {
+            m_points.clear();
+            m_IdOfVerts.clear();
+
+            int num_points = int(m_inputPoints.size());
+            if (num_points < 3)
+                return false;
+
+            niArrayT<_niSortPoint> order;
+            order.resize(num_points);
+            for (int i = 0; i < num_points; ++i)
+            {
+                order[i].X              = m_inputPoints[i].X;
+                order[i].Y              = m_inputPoints[i].Y;
+                order[i].m_IdOfPoint    = i;
+            }
+            std::sort(order.begin(), order.end());
+
+            //the same points next to each other, the first one stays
+            m_IdOfVerts.resize(num_points);
+            int num_verts = 0;
+            for (int i = 0; i < num_points; ++i)
+            {
+                int id = order[i].m_IdOfPoint;
+                if (0 == num_verts || order[i].X != order[num_verts-1].X || order[i].Y != order[num_verts-1].Y)
+                {
+                    order[num_verts] = order[i];
+                    order[num_verts].m_IdOfPoint = num_verts;
+                    ++num_verts;
+                }
+                m_IdOfVerts[id] = num_verts - 1;
+            }
+            if (num_verts < 3)
+                return false;
+            order.resize(num_verts);
+
+            _PartitionPoints(&order[0], 0, num_verts-1, 0, spawnDepth);
+
+            niIntArray posOfVerts;
+            posOfVerts.resize(num_verts);
+            m_points.resize(num_verts);
+            for (int i = 0; i < num_verts; ++i)
+            {
+                m_points[i].Init(order[i].X, order[i].Y);
+                posOfVerts[ order[i].m_IdOfPoint ] = i;
+            }
+            for (int i = 0; i < num_points; ++i)
+            {
+                m_IdOfVerts[i] = posOfVerts[ m_IdOfVerts[i] ];
+            }
+            return true;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _Triangulate
+        //-----------------------------------------------------------------------------
+        /**
+        * Delaunay triangulation of the vertices between [_l, _r] by divide and conquer,
+        * throw std::bad_alloc when out of memory. The halves are cut along the other axis,
+        * which keeps the cells square and the merges short. Along axis 1 the merge works
+        * on x, y turned clockwise, as the predicates do not change with a rotation.
+        *
+        * @param       _l:          start position
+        * @param       _r:          end position
+        * @param       axis:        0: cut in x, 1: cut in y
+        * @param       spawnDepth:  levels left to triangulate the left half on another thread
+        * @param       pool:        quads of the thread
+        * @param       le:          store the ccw convex hull edge out of the first vertex along axis
+        * @param       re:          store the cw convex hull edge out of the last vertex along axis
+        */
+        void niDelaunay2d::_Triangulate(
+            int _l,
+            int _r,
+            int axis,
+            int spawnDepth,
+            niDtPool &pool,
+            niDtEdge *&le,
+            niDtEdge *&re)
+        {
+            const niPoint2dArray &P = m_points;
+            int num = _r - _l + 1;
+
+            if (2 == num)
+            {
+                niDtEdge *a = _MakeEdge(pool, _l, _r);
+                le = a;
+                re = _Sym(a);
+                return;
+            }
+
+            if (3 == num)
+            {
+                niDtEdge *a = _MakeEdge(pool, _l, _l+1);
+                niDtEdge *b = _MakeEdge(pool, _l+1, _r);
+                _Splice(_Sym(a), b);
+
+                double o = niGeomMath2d::Orient2d(P[_l], P[_l+1], P[_r]);
+                if (o > 0.0)
+                {
+                    _Connect(pool, b, a);
+                    le = a;
+                    re = _Sym(b);
+                }
+                else if (o < 0.0)
+                {
+                    niDtEdge *c = _Connect(pool, b, a);
+                    le = _Sym(c);
+                    re = c;
+                }
+                else
+                {
+                    le = a;
+                    re = _Sym(b);
+                }
+                return;
+            }
+
+            int _m = (_l + _r) / 2;
+            niDtEdge *ldo, *ldi, *rdi, *rdo;
+            if (spawnDepth > 0 && num >= CParallelSize)
+            {
+                niDtPool leftPool;
+                niDtEdge *lo = NULL, *li = NULL;
+                std::thread task(_TriangulateTask, this, _l, _m, 1-axis, spawnDepth-1, &leftPool, &lo, &li);
+                try
+                {
+                    _Triangulate(_m+1, _r, 1-axis, spawnDepth-1, pool, rdi, rdo);
+                }
+                catch (std::bad_alloc)
+                {
+                    task.join();
+                    throw;
+                }
+                task.join();
+
+                pool.Merge(leftPool);
+                if (NULL == lo)
+                    throw std::bad_alloc();
+                ldo = lo;
+                ldi = li;
+            }
+            else
+            {
+                _Triangulate(_l, _m, 1-axis, spawnDepth, pool, ldo, ldi);
+                _Triangulate(_m+1, _r, 1-axis, spawnDepth, pool, rdi, rdo);
+            }
+
+            //the halves were cut along the other axis
+            _HullExtremes(ldo, axis, ldo, ldi);
+            _HullExtremes(rdi, axis, rdi, rdo);
+
+            //lower common tangent of the halves
+            for (;;)
+            {
+                if (niGeomMath2d::Orient2d(P[rdi->m_org], P[ldi->m_org], P[_Dest(ldi)]) > 0.0)
+                    ldi = _Lnext(ldi);
+                else if (niGeomMath2d::Orient2d(P[ldi->m_org], P[_Dest(rdi)], P[rdi->m_org]) > 0.0)
+                    rdi = _Rprev(rdi);
+                else
+                    break;
+            }
+
+            niDtEdge *basel = _Connect(pool, _Sym(rdi), ldi);
+            if (ldi->m_org == ldo->m_org)
+                ldo = _Sym(basel);
+            if (rdi->m_org == rdo->m_org)
+                rdo = basel;
+
+            //merge upwards, each step adds the cross edge of the empty circle
+            for (;;)
+            {
+                const niPoint2d &bo = P[basel->m_org];
+                const niPoint2d &bd = P[_Dest(basel)];
+
+                niDtEdge *lcand = _Onext(_Sym(basel));
+                bool lvalid = niGeomMath2d::Orient2d(P[_Dest(lcand)], bd, bo) > 0.0;
+                if (lvalid)
+                {
+                    while (niGeomMath2d::InCircle(bd, bo, P[_Dest(lcand)], P[_Dest(_Onext(lcand))]) > 0.0)
+                    {
+                        niDtEdge *t = _Onext(lcand);
+                        _DeleteEdge(pool, lcand);
+                        lcand = t;
+                    }
+                }
+
+                niDtEdge *rcand = _Oprev(basel);
+                bool rvalid = niGeomMath2d::Orient2d(P[_Dest(rcand)], bd, bo) > 0.0;
+                if (rvalid)
+                {
+                    while (niGeomMath2d::InCircle(bd, bo, P[_Dest(rcand)], P[_Dest(_Oprev(rcand))]) > 0.0)
+                    {
+                        niDtEdge *t = _Oprev(rcand);
+                        _DeleteEdge(pool, rcand);
+                        rcand = t;
+                    }
+                }
+
+                if (!lvalid && !rvalid)
+                    break;
+
+                if (!lvalid ||
+                    (rvalid && niGeomMath2d::InCircle(
+                        P[_Dest(lcand)], P[lcand->m_org], P[rcand->m_org], P[_Dest(rcand)]) > 0.0))
+                {
+                    basel = _Connect(pool, rcand, _Sym(basel));
+                }
+                else
+                {
+                    basel = _Connect(pool, _Sym(basel), _Sym(lcand));
+                }
+            }
+
+            le = ldo;
+            re = rdo;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _TriangulateTask
+        //-----------------------------------------------------------------------------
+        /**
+        * Triangulate a half on another thread
+        *
+        * @param       delaunay:    triangulation
+        * @param       _l:          start position
+        * @param       _r:          end position
+        * @param       axis:        axis of the cut
+        * @param       spawnDepth:  levels left to spawn
+        * @param       pool:        quads of the thread
+        * @param       le:          store the left hull edge, NULL when out of memory
+        * @param       re:          store the right hull edge
+        */
+        void niDelaunay2d::_TriangulateTask(
+            niDelaunay2d *delaunay,
+            int _l,
+            int _r,
+            int axis,
+            int spawnDepth,
+            niDtPool *pool,
+            niDtEdge **le,
+            niDtEdge **re)
+        {
+            try
+            {
+                delaunay->_Triangulate(_l, _r, axis, spawnDepth, *pool, *le, *re);
+            }
+            catch (std::bad_alloc)
+            {
+                *le = NULL;
+            }
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _HullExtremes
+        //-----------------------------------------------------------------------------
+        /**
+        * Walk around a convex hull to its first and last vertex along axis
+        *
+        * @param       e:           edge of the hull, the outside on its right
+        * @param       axis:        axis
+        * @param       first:       store the ccw hull edge out of the first vertex
+        * @param       last:        store the cw hull edge out of the last vertex
+        */
+        void niDelaunay2d::_HullExtremes(
+            niDtEdge *e,
+            int axis,
+            niDtEdge *&first,
+            niDtEdge *&last) const
+        {
+            const niPoint2dArray &P = m_points;
+            niDtEdge *_first = e;
+            niDtEdge *_last = _Sym(e);
+            niDtEdge *c = e;
+            do
+            {
+                const niPoint2d &o = P[c->m_org];
+                const niPoint2d &d = P[_Dest(c)];
+                if (_IsBefore(o.X, o.Y, P[_first->m_org].X, P[_first->m_org].Y, axis))
+                    _first = c;
+                if (_IsBefore(P[_last->m_org].X, P[_last->m_org].Y, d.X, d.Y, axis))
+                    _last = _Sym(c);
+                c = _Rprev(c);
+            } while (c != e);
+
+            first = _first;
+            last = _last;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _BuildTriangles
+        //-----------------------------------------------------------------------------
+        /**
+        * Convert the quad-edges into triangles with neighbors, in the order of the quads
+        *
+        * @param       pool:        quads of the triangulation
+        * @return      true:        sucess
+        *              false:       no triangle, all the vertices are collinear
+        */
+        bool niDelaunay2d::_BuildTriangles(const niDtPool &pool)
+        {
+            //the directed edges of the quads alive
+            niArrayT<niDtEdge*> edges;
+            int num_quads = int(pool.m_quads.size());
+            edges.reserve(2 * num_quads);
+            for (int i = 0; i < num_quads; ++i)
+            {
+                niDtEdge *e = pool.m_quads[i]->m_edges;
+                if (-2 == e[0].m_face)
+                    continue;
+                edges.push_back(e);
+                edges.push_back(e + 2);
+            }
+
+            //the counterclockwise faces of 3 edges
+            int num_edges = int(edges.size());
+            m_tris.reserve(num_edges / 3 + 1);
+            for (int i = 0; i < num_edges; ++i)
+            {
+                niDtEdge *e0 = edges[i];
+                if (e0->m_face >= 0)
+                    continue;
+                niDtEdge *e1 = _Lnext(e0);
+                niDtEdge *e2 = _Lnext(e1);
+                if (_Lnext(e2) != e0)
+                    continue;
+                if (niGeomMath2d::Orient2d(m_points[e0->m_org], m_points[e1->m_org], m_points[e2->m_org]) <= 0.0)
+                    continue;
+
+                int t = int(m_tris.size());
+                niDtTri tri;
+                tri.m_v[0] = e0->m_org;
+                tri.m_v[1] = e1->m_org;
+                tri.m_v[2] = e2->m_org;
+                m_tris.push_back(tri);
+                e0->m_face = e1->m_face = e2->m_face = t;
+            }
+
+            for (int i = 0; i < num_edges; ++i)
+            {
+                niDtEdge *e0 = edges[i];
+                if (e0->m_face < 0)
+                    continue;
+                niDtTri &tri = m_tris[e0->m_face];
+                int k = _IndexOf(tri, e0->m_org);
+                int nb = _Sym(e0)->m_face;
+                tri.m_n[k] = nb >= 0 ? nb : -1;
+                tri.m_c[k] = 0;
+            }
+
+            m_vertTris.assign(m_points.size(), -1);
+            int num_tris = int(m_tris.size());
+            for (int t = 0; t < num_tris; ++t)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    m_vertTris[ m_tris[t].m_v[k] ] = t;
+                }
+            }
+            return num_tris > 0;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _InsertConstraint
+        //-----------------------------------------------------------------------------
+        /**
+        * Force the segment a-b into the triangulation. The edges it crosses are flipped
+        * until none is left, then the new edges are flipped back to Delaunay. A vertex on
+        * the segment splits it.
+        *
+        * @param       a:           vertex
+        * @param       b:           vertex
+        * @return      true:        sucess
+        *              false:       the segment crosses another segment
+        */
+        bool niDelaunay2d::_InsertConstraint(int a, int b)
+        {
+            const niPoint2dArray &P = m_points;
+            niIntArray queue;
+            niIntArray newEdges;
+
+            while (a != b)
+            {
+                int edge;
+                int t = _FindSegment(a, b, edge);
+                if (t >= 0)
+                {
+                    _MarkConstraint(t, edge);
+                    break;
+                }
+
+                //the triangle around a that the segment leaves by its opposite edge,
+                //or the vertex on the segment next to a
+                int target = -1;
+                int ct = -1, ce = -1;
+                int t0 = m_vertTris[a];
+                for (int dir = 0; dir < 2 && target < 0 && ct < 0; ++dir)
+                {
+                    t = t0;
+                    do
+                    {
+                        const niDtTri &tri = m_tris[t];
+                        int k = _IndexOf(tri, a);
+                        int p = tri.m_v[(k+1)%3];
+                        int q = tri.m_v[(k+2)%3];
+                        double o1 = niGeomMath2d::Orient2d(P[a], P[p], P[b]);
+                        double o2 = niGeomMath2d::Orient2d(P[a], P[q], P[b]);
+                        if (0.0 == o1 && _IsAhead(P[a], P[p], P[b]))
+                        {
+                            target = p;
+                            break;
+                        }
+                        if (0.0 == o2 && _IsAhead(P[a], P[q], P[b]))
+                        {
+                            target = q;
+                            break;
+                        }
+                        if (o1 > 0.0 && o2 < 0.0)
+                        {
+                            ct = t;
+                            ce = (k+1)%3;
+                            break;
+                        }
+                        t = tri.m_n[ 0 == dir ? (k+2)%3 : k ];
+                    } while (t >= 0 && t != t0);
+                }
+
+                if (target >= 0)
+                {
+                    t = _FindSegment(a, target, edge);
+                    if (t < 0)
+                        return false;
+                    _MarkConstraint(t, edge);
+                    a = target;
+                    continue;
+                }
+                if (ct < 0)
+                    return false;
+
+                //walk to b, the crossed edges are (R, L), R on the right of a-b
+                queue.clear();
+                int R = m_tris[ct].m_v[ce];
+                int L = m_tris[ct].m_v[(ce+1)%3];
+                for (;;)
+                {
+                    const niDtTri &tri = m_tris[ct];
+                    if (tri.m_c[ce])
+                        return false;
+                    queue.push_back(R);
+                    queue.push_back(L);
+
+                    int u = tri.m_n[ce];
+                    if (u < 0)
+                        return false;
+                    const niDtTri &utri = m_tris[u];
+                    int j = _IndexOf(utri, L);
+                    int r = utri.m_v[(j+2)%3];
+                    if (r == b)
+                    {
+                        target = b;
+                        break;
+                    }
+                    double o = niGeomMath2d::Orient2d(P[a], P[b], P[r]);
+                    if (0.0 == o)
+                    {
+                        target = r;
+                        break;
+                    }
+                    if (o > 0.0)
+                    {
+                        L = r;
+                        ce = (j+1)%3;
+                    }
+                    else
+                    {
+                        R = r;
+                        ce = (j+2)%3;
+                    }
+                    ct = u;
+                }
+
+                //flip the crossing edges, again later when their quad is not convex
+                newEdges.clear();
+                int head = 0;
+                int stalled = 0;
+                while (head < int(queue.size()))
+                {
+                    int u0 = queue[head];
+                    int w0 = queue[head+1];
+                    head += 2;
+
+                    t = _FindEdge(u0, w0, edge);
+                    if (t < 0)
+                        return false;
+                    const niDtTri &tri = m_tris[t];
+                    int r = tri.m_v[(edge+2)%3];
+                    const niDtTri &ntri = m_tris[ tri.m_n[edge] ];
+                    int s = ntri.m_v[ (_IndexOf(ntri, w0)+2)%3 ];
+
+                    if (!_IsCrossing(
+                        niGeomMath2d::Orient2d(P[r], P[s], P[u0]),
+                        niGeomMath2d::Orient2d(P[r], P[s], P[w0])))
+                    {
+                        queue.push_back(u0);
+                        queue.push_back(w0);
+                        if (++stalled > (int(queue.size()) - head) / 2)
+                            return false;
+                        continue;
+                    }
+
+                    stalled = 0;
+                    _Flip(t, edge);
+                    if (_IsCrossing(
+                        niGeomMath2d::Orient2d(P[a], P[target], P[r]),
+                        niGeomMath2d::Orient2d(P[a], P[target], P[s])))
+                    {
+                        queue.push_back(r);
+                        queue.push_back(s);
+                    }
+                    else
+                    {
+                        newEdges.push_back(r);
+                        newEdges.push_back(s);
+                    }
+                }
+
+                t = _FindSegment(a, target, edge);
+                if (t < 0)
+                    return false;
+                _MarkConstraint(t, edge);
+
+                if (!_RestoreDelaunay(newEdges, a, target))
+                    return false;
+
+                a = target;
+            }
+            return true;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _RestoreDelaunay
+        //-----------------------------------------------------------------------------
+        /**
+        * Flip the new edges of a segment until all of them are Delaunay
+        *
+        * @param       edges:       new edges, pairs of vertices
+        * @param       a:           vertex of the segment
+        * @param       b:           vertex of the segment
+        * @return      true:        sucess
+        *              false:       an edge is lost
+        */
+        bool niDelaunay2d::_RestoreDelaunay(niIntArray &edges, int a, int b)
+        {
+            const niPoint2dArray &P = m_points;
+            int num_edges = int(edges.size()) / 2;
+
+            bool bSwapped = true;
+            while (bSwapped)
+            {
+                bSwapped = false;
+                for (int i = 0; i < num_edges; ++i)
+                {
+                    int u = edges[2*i];
+                    int w = edges[2*i+1];
+                    if ((u == a && w == b) || (u == b && w == a))
+                        continue;
+
+                    int edge;
+                    int t = _FindEdge(u, w, edge);
+                    if (t < 0)
+                        return false;
+                    const niDtTri &tri = m_tris[t];
+                    int nb = tri.m_n[edge];
+                    if (tri.m_c[edge] || nb < 0)
+                        continue;
+
+                    const niDtTri &ntri = m_tris[nb];
+                    int s = ntri.m_v[ (_IndexOf(ntri, w)+2)%3 ];
+                    if (niGeomMath2d::InCircle(P[tri.m_v[0]], P[tri.m_v[1]], P[tri.m_v[2]], P[s]) > 0.0)
+                    {
+                        int r = tri.m_v[(edge+2)%3];
+                        _Flip(t, edge);
+                        edges[2*i]      = r;
+                        edges[2*i+1]    = s;
+                        bSwapped = true;
+                    }
+                }
+            }
+            return true;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _FindEdge
+        //-----------------------------------------------------------------------------
+        /**
+        * Find the triangle of the directed edge u-w
+        *
+        * @param       u:           origin vertex
+        * @param       w:           destination vertex
+        * @param       edge:        store the edge index in the triangle
+        * @return      -1:          no such edge
+        *              >=0:         the triangle
+        */
+        int niDelaunay2d::_FindEdge(int u, int w, int &edge) const
+        {
+            int t0 = m_vertTris[u];
+            for (int dir = 0; dir < 2; ++dir)
+            {
+                int t = t0;
+                do
+                {
+                    const niDtTri &tri = m_tris[t];
+                    int k = _IndexOf(tri, u);
+                    if (tri.m_v[(k+1)%3] == w)
+                    {
+                        edge = k;
+                        return t;
+                    }
+                    t = tri.m_n[ 0 == dir ? (k+2)%3 : k ];
+                } while (t >= 0 && t != t0);
+
+                //all around u
+                if (t == t0)
+                    break;
+            }
+            return -1;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _FindSegment
+        //-----------------------------------------------------------------------------
+        /**
+        * Find a triangle of the edge u-w in either direction; an edge of the convex
+        * hull has a triangle on one side only
+        *
+        * @param       u:           vertex
+        * @param       w:           vertex
+        * @param       edge:        store the edge index in the triangle
+        * @return      -1:          no such edge
+        *              >=0:         the triangle
+        */
+        int niDelaunay2d::_FindSegment(int u, int w, int &edge) const
+        {
+            int t = _FindEdge(u, w, edge);
+            if (t < 0)
+                t = _FindEdge(w, u, edge);
+            return t;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _Flip
+        //-----------------------------------------------------------------------------
+        /**
+        * Flip the edge between triangle t and its neighbor
+        *
+        *         r                r
+        *        / \              /|\
+        *       /   \            / | \
+        *      p-----q   ==>    p  |  q
+        *       \   /            \ | /
+        *        \ /              \|/
+        *         s                s
+        *
+        * @param       t:           triangle (p, q, r)
+        * @param       edge:        index of the edge p-q in t
+        */
+        void niDelaunay2d::_Flip(int t, int edge)
+        {
+            niDtTri &tri = m_tris[t];
+            int p = tri.m_v[edge];
+            int q = tri.m_v[(edge+1)%3];
+            int r = tri.m_v[(edge+2)%3];
+            int nA = tri.m_n[(edge+1)%3];
+            int nB = tri.m_n[(edge+2)%3];
+            char cA = tri.m_c[(edge+1)%3];
+            char cB = tri.m_c[(edge+2)%3];
+
+            int u = tri.m_n[edge];
+            niDtTri &utri = m_tris[u];
+            int j = _IndexOf(utri, q);
+            int s = utri.m_v[(j+2)%3];
+            int nC = utri.m_n[(j+1)%3];
+            int nD = utri.m_n[(j+2)%3];
+            char cC = utri.m_c[(j+1)%3];
+            char cD = utri.m_c[(j+2)%3];
+
+            tri.m_v[0] = r;     tri.m_v[1] = p;     tri.m_v[2] = s;
+            tri.m_n[0] = nB;    tri.m_n[1] = nC;    tri.m_n[2] = u;
+            tri.m_c[0] = cB;    tri.m_c[1] = cC;    tri.m_c[2] = 0;
+
+            utri.m_v[0] = s;    utri.m_v[1] = q;    utri.m_v[2] = r;
+            utri.m_n[0] = nD;   utri.m_n[1] = nA;   utri.m_n[2] = t;
+            utri.m_c[0] = cD;   utri.m_c[1] = cA;   utri.m_c[2] = 0;
+
+            if (nA >= 0)
+            {
+                niDtTri &atri = m_tris[nA];
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (atri.m_n[k] == t)
+                        atri.m_n[k] = u;
+                }
+            }
+            if (nC >= 0)
+            {
+                niDtTri &ctri = m_tris[nC];
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (ctri.m_n[k] == u)
+                        ctri.m_n[k] = t;
+                }
+            }
+
+            m_vertTris[p] = t;
+            m_vertTris[r] = t;
+            m_vertTris[s] = t;
+            m_vertTris[q] = u;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _MarkConstraint
+        //-----------------------------------------------------------------------------
+        /**
+        * Mark an edge as a border of ring, on both of its sides
+        *
+        * @param       t:           triangle
+        * @param       edge:        edge index in t
+        */
+        void niDelaunay2d::_MarkConstraint(int t, int edge)
+        {
+            niDtTri &tri = m_tris[t];
+            tri.m_c[edge] = 1;
+
+            int nb = tri.m_n[edge];
+            if (nb < 0)
+                return;
+            niDtTri &ntri = m_tris[nb];
+            ntri.m_c[ _IndexOf(ntri, tri.m_v[(edge+1)%3]) ] = 1;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _MarkRegion
+        //-----------------------------------------------------------------------------
+        /**
+        * Mark the triangles inside the rings: the least number of borders crossed from
+        * the outside is odd
+        *
+        * @return      true:        sucess
+        *              false:       no triangle inside
+        */
+        bool niDelaunay2d::_MarkRegion()
+        {
+            int num_tris = int(m_tris.size());
+            m_inside.assign(num_tris, 1);
+            if (m_segments.empty())
+                return true;
+
+            niIntArray depth;
+            depth.assign(num_tris, -1);
+
+            //0-1 breadth first: no cost across an edge, 1 across a border
+            std::deque<int> tris;
+            for (int t = 0; t < num_tris; ++t)
+            {
+                const niDtTri &tri = m_tris[t];
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (tri.m_n[k] >= 0)
+                        continue;
+                    int d = tri.m_c[k] ? 1 : 0;
+                    if (-1 == depth[t] || d < depth[t])
+                    {
+                        depth[t] = d;
+                        if (0 == d)
+                            tris.push_front(t);
+                        else
+                            tris.push_back(t);
+                    }
+                }
+            }
+
+            while (!tris.empty())
+            {
+                int t = tris.front();
+                tris.pop_front();
+
+                const niDtTri &tri = m_tris[t];
+                for (int k = 0; k < 3; ++k)
+                {
+                    int nb = tri.m_n[k];
+                    if (nb < 0)
+                        continue;
+                    int d = depth[t] + (tri.m_c[k] ? 1 : 0);
+                    if (-1 == depth[nb] || d < depth[nb])
+                    {
+                        depth[nb] = d;
+                        if (tri.m_c[k])
+                            tris.push_back(nb);
+                        else
+                            tris.push_front(nb);
+                    }
+                }
+            }
+
+            bool bInside = false;
+            for (int t = 0; t < num_tris; ++t)
+            {
+                m_inside[t] = char(depth[t] & 1);
+                bInside = bInside || (0 != m_inside[t]);
+            }
+            return bInside;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _MakeMesh
+        //-----------------------------------------------------------------------------
+        /**
+        * Store the triangles inside into the mesh, with the vertices they use, in the
+        * order of the input points
+        *
+        * @param       tri_mesh:    store the triangles
+        * @return      true:        sucess
+        *              false:       failed
+        */
+        bool niDelaunay2d::_MakeMesh(niTriMesh2d &tri_mesh)
+        {
+            int num_verts = int(m_points.size());
+            int num_tris = int(m_tris.size());
+
+            niIntArray IdOfPoints;
+            IdOfPoints.assign(num_verts, -1);
+            for (int t = 0; t < num_tris; ++t)
+            {
+                if (!m_inside[t])
+                    continue;
+                for (int k = 0; k < 3; ++k)
+                {
+                    IdOfPoints[ m_tris[t].m_v[k] ] = -2;
+                }
+            }
+
+            tri_mesh.Clear();
+            niPoint2dArray &points = tri_mesh.m_points;
+            points.reserve(num_verts);
+            int num_inputs = int(m_inputPoints.size());
+            for (int i = 0; i < num_inputs; ++i)
+            {
+                int v = m_IdOfVerts[i];
+                if (-2 != IdOfPoints[v])
+                    continue;
+                IdOfPoints[v] = int(points.size());
+                points.push_back(m_points[v]);
+            }
+
+            niTriFace2dArray faces;
+            faces.reserve(num_tris);
+            for (int t = 0; t < num_tris; ++t)
+            {
+                if (!m_inside[t])
+                    continue;
+                const niDtTri &tri = m_tris[t];
+                niTriFace2d face;
+                face.Init(IdOfPoints[tri.m_v[0]], IdOfPoints[tri.m_v[1]], IdOfPoints[tri.m_v[2]]);
+                faces.push_back(face);
+            }
+
+            return tri_mesh.InitFaces(faces);
+        }
+    }
+}
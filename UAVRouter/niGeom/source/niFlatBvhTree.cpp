@@ -0,0 +1,519 @@
+//! \file
+// \brief
+// Flat 4-wide Bounding Volume Hierarchies tree
+//
+// Revisions:
+//   Date        Author     Description
+//   ----------  --------   -------------------------------------------------
+// - 2026-10-17             Initial version
+
+#include <niGeom/geometry/tree/niFlatBvhTree.h>
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NI_FLATBVH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ni
+{
+    namespace geometry
+    {
+        namespace tree
+        {
+            //-----------------------------------------------------------------------------
+            // FUNCTION Construction
+            //-----------------------------------------------------------------------------
+            /**
+            * Construction
+            *
+            */
+            niFlatBvhTree::niFlatBvhTree() : m_stackSize(0)
+            {
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Construction
+            //-----------------------------------------------------------------------------
+            /**
+            * Construction
+            *
+            * @param            refGeomes:          geometry references
+            * @param            bboxRefs:           boxes references
+            * @param            builder:            builder of the binary tree
+            *
+            */
+            niFlatBvhTree::niFlatBvhTree(
+                const niArrayT<niRefGeom2d> &refGeomes,
+                const niArrayT<const niBBox2d*> &bboxRefs,
+                ETreeBuilder builder) : m_stackSize(0)
+            {
+                Build(refGeomes, bboxRefs, builder);
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Construction
+            //-----------------------------------------------------------------------------
+            /**
+            * Construction
+            *
+            * @param            refGeomes:          geometry references
+            * @param            boxes:              boxes
+            * @param            builder:            builder of the binary tree
+            *
+            */
+            niFlatBvhTree::niFlatBvhTree(
+                const niArrayT<niRefGeom2d> &refGeomes,
+                const niArrayT<niBBox2d> &boxes,
+                ETreeBuilder builder) : m_stackSize(0)
+            {
+                Build(refGeomes, boxes, builder);
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION DeConstruction
+            //-----------------------------------------------------------------------------
+            /**
+            * DeConstruction
+            *
+            */
+            niFlatBvhTree::~niFlatBvhTree()
+            {
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Build
+            //-----------------------------------------------------------------------------
+            /**
+            * Build the binary tree and collapse it
+            *
+            * @param            refGeomes:          geometry references
+            * @param            bboxRefs:           boxes references
+            * @param            builder:            builder of the binary tree
+            * @return           true:               success
+            *                   false:              failed
+            */
+            bool niFlatBvhTree::Build(
+                const niArrayT<niRefGeom2d> &refGeomes,
+                const niArrayT<const niBBox2d*> &bboxRefs,
+                ETreeBuilder builder)
+            {
+                niBvhTree bvhTree(refGeomes, bboxRefs, builder);
+                return Build(bvhTree);
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Build
+            //-----------------------------------------------------------------------------
+            /**
+            * Build the binary tree and collapse it
+            *
+            * @param            refGeomes:          geometry references
+            * @param            boxes:              boxes
+            * @param            builder:            builder of the binary tree
+            * @return           true:               success
+            *                   false:              failed
+            */
+            bool niFlatBvhTree::Build(
+                const niArrayT<niRefGeom2d> &refGeomes,
+                const niArrayT<niBBox2d> &boxes,
+                ETreeBuilder builder)
+            {
+                niBvhTree bvhTree(refGeomes, boxes, builder);
+                return Build(bvhTree);
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Build
+            //-----------------------------------------------------------------------------
+            /**
+            * Collapse a binary bvh tree into 4-wide nodes
+            *
+            * @param            bvhTree:            binary bvh tree
+            * @return           true:               success
+            *                   false:              failed
+            */
+            bool niFlatBvhTree::Build(const niBvhTree &bvhTree)
+            {
+                Clear();
+
+                const niBvhTree::niBvhNode *root = bvhTree.Root();
+                if (NULL == root)
+                    return false;
+
+                try
+                {
+                    if (root->IsLeaf())
+                    {
+                        niFlatBvhNode node;
+                        node.m_minX[0]      = root->m_bbox.P1.X;
+                        node.m_minY[0]      = root->m_bbox.P1.Y;
+                        node.m_maxX[0]      = root->m_bbox.P2.X;
+                        node.m_maxY[0]      = root->m_bbox.P2.Y;
+                        node.m_numChildren  = 1;
+                        for (int i = 1; i < CNodeWidth; ++i)
+                        {
+                            node.m_minX[i] = node.m_minY[i] = node.m_maxX[i] = node.m_maxY[i] = 0.0;
+                            node.m_child[i] = 0;
+                        }
+                        m_nodes.push_back(node);
+
+                        m_nodes[0].m_child[0] = ~_AddLeaf(root);
+                        m_stackSize = 1;
+                    }
+                    else
+                    {
+                        _Collapse(root, 1);
+                    }
+                }
+                catch (std::bad_alloc)
+                {
+                    Clear();
+                    return false;
+                }
+                return true;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION Clear
+            //-----------------------------------------------------------------------------
+            /**
+            * Clear memory
+            *
+            */
+            void niFlatBvhTree::Clear()
+            {
+                m_nodes.clear();
+                m_leaves.clear();
+                m_leafBoxes.clear();
+                m_stackSize = 0;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION QueryBBox
+            //-----------------------------------------------------------------------------
+            /**
+            * Find the leaves whose box overlaps a box
+            *
+            * @param            bbox:               box
+            * @param            refGeomes:          store the leaves, appended
+            * @return           number of leaves found
+            *
+            */
+            int niFlatBvhTree::QueryBBox(
+                const niBBox2d &bbox,
+                niArrayT<niRefGeom2d> &refGeomes) const
+            {
+                if (m_nodes.empty())
+                    return 0;
+
+                int localStack[CStackSize];
+                niArrayT<int> heapStack;
+                int *stack = localStack;
+                if (m_stackSize > CStackSize)
+                {
+                    heapStack.resize(m_stackSize);
+                    stack = &heapStack[0];
+                }
+
+                int numFound = 0;
+                int top = 0;
+                stack[top++] = 0;
+
+                while (top > 0)
+                {
+                    const niFlatBvhNode &node = m_nodes[ stack[--top] ];
+                    int mask = _OverlapBBox(node, bbox);
+
+                    for (int i = 0; i < node.m_numChildren; ++i)
+                    {
+                        if (0 == (mask & (1 << i)))
+                            continue;
+
+                        int child = node.m_child[i];
+                        if (child < 0)
+                        {
+                            refGeomes.push_back(m_leaves[~child]);
+                            ++numFound;
+                        }
+                        else
+                        {
+                            stack[top++] = child;
+                        }
+                    }
+                }
+                return numFound;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION _Collapse
+            //-----------------------------------------------------------------------------
+            /**
+            * Collapse a binary node and its subtree, depth first.
+            * The children of the node are opened, the largest box first, until there are
+            * 4 of them or all of them are leaves.
+            *
+            * @param            bvhNode:            binary node, not a leaf
+            * @param            depth:              depth of the node
+            * @return           index of the 4-wide node
+            *
+            */
+            int niFlatBvhTree::_Collapse(const niBvhTree::niBvhNode *bvhNode, int depth)
+            {
+                const niBvhTree::niBvhNode *children[CNodeWidth];
+                int numChildren = 0;
+                children[numChildren++] = bvhNode->l_child;
+                children[numChildren++] = bvhNode->r_child;
+
+                while (numChildren < CNodeWidth)
+                {
+                    int iOpen = -1;
+                    double maxArea = -1.0;
+                    for (int i = 0; i < numChildren; ++i)
+                    {
+                        if (children[i]->IsLeaf())
+                            continue;
+
+                        double area = children[i]->m_bbox.Area();
+                        if (area > maxArea)
+                        {
+                            maxArea = area;
+                            iOpen = i;
+                        }
+                    }
+                    if (-1 == iOpen)
+                        break;
+
+                    const niBvhTree::niBvhNode *opened = children[iOpen];
+                    children[iOpen] = opened->l_child;
+                    children[numChildren++] = opened->r_child;
+                }
+
+                int IdOfNode = (int)m_nodes.size();
+                m_nodes.push_back(niFlatBvhNode());
+
+                //a node pushes at most CNodeWidth-1 more entries than it pops
+                int stackSize = (CNodeWidth-1) * depth + 1;
+                m_stackSize = m_stackSize > stackSize ? m_stackSize : stackSize;
+
+                for (int i = 0; i < CNodeWidth; ++i)
+                {
+                    //m_nodes may be reallocated by the children
+                    niFlatBvhNode &node = m_nodes[IdOfNode];
+                    if (i >= numChildren)
+                    {
+                        node.m_minX[i] = node.m_minY[i] = node.m_maxX[i] = node.m_maxY[i] = 0.0;
+                        node.m_child[i] = 0;
+                        continue;
+                    }
+
+                    node.m_minX[i]  = children[i]->m_bbox.P1.X;
+                    node.m_minY[i]  = children[i]->m_bbox.P1.Y;
+                    node.m_maxX[i]  = children[i]->m_bbox.P2.X;
+                    node.m_maxY[i]  = children[i]->m_bbox.P2.Y;
+
+                    int child;
+                    if (children[i]->IsLeaf())
+                    {
+                        child = ~_AddLeaf(children[i]);
+                    }
+                    else
+                    {
+                        child = _Collapse(children[i], depth+1);
+                    }
+                    m_nodes[IdOfNode].m_child[i] = child;
+                }
+                m_nodes[IdOfNode].m_numChildren = numChildren;
+
+                return IdOfNode;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION _AddLeaf
+            //-----------------------------------------------------------------------------
+            /**
+            * Add a leaf
+            *
+            * @param            bvhNode:            binary leaf
+            * @return           index of the leaf
+            *
+            */
+            int niFlatBvhTree::_AddLeaf(const niBvhTree::niBvhNode *bvhNode)
+            {
+                const niBvhTree::niBvhLeaf *leaf =
+                    dynamic_cast<const niBvhTree::niBvhLeaf*>(bvhNode);
+
+                m_leaves.push_back(leaf->m_refGeom);
+                m_leafBoxes.push_back(leaf->m_bbox);
+                return (int)m_leaves.size() - 1;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION _OverlapBBox
+            //-----------------------------------------------------------------------------
+            /**
+            * Test the child boxes of a node against a box, as niGeomMath2d::IsBoxOverlapBox
+            *
+            * @param            node:               node
+            * @param            bbox:               box
+            * @return           bit i set if child i overlaps the box
+            *
+            */
+            int niFlatBvhTree::_OverlapBBox(
+                const niFlatBvhNode &node,
+                const niBBox2d &bbox)
+            {
+                int mask = 0;
+#ifdef NI_FLATBVH_SSE2
+                const __m128d qMinX = _mm_set1_pd(bbox.P1.X);
+                const __m128d qMinY = _mm_set1_pd(bbox.P1.Y);
+                const __m128d qMaxX = _mm_set1_pd(bbox.P2.X);
+                const __m128d qMaxY = _mm_set1_pd(bbox.P2.Y);
+
+                for (int i = 0; i < CNodeWidth; i += 2)
+                {
+                    __m128d separated = _mm_cmplt_pd(_mm_loadu_pd(&node.m_maxX[i]), qMinX);
+                    separated = _mm_or_pd(separated, _mm_cmplt_pd(_mm_loadu_pd(&node.m_maxY[i]), qMinY));
+                    separated = _mm_or_pd(separated, _mm_cmpgt_pd(_mm_loadu_pd(&node.m_minX[i]), qMaxX));
+                    separated = _mm_or_pd(separated, _mm_cmpgt_pd(_mm_loadu_pd(&node.m_minY[i]), qMaxY));
+
+                    mask |= (~_mm_movemask_pd(separated) & 3) << i;
+                }
+#else
+                for (int i = 0; i < CNodeWidth; ++i)
+                {
+                    bool separated = node.m_maxX[i] < bbox.P1.X || node.m_maxY[i] < bbox.P1.Y ||
+                                     node.m_minX[i] > bbox.P2.X || node.m_minY[i] > bbox.P2.Y;
+                    mask |= (separated ? 0 : 1) << i;
+                }
+#endif
+                return mask & ((1 << node.m_numChildren) - 1);
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION _OverlapLine
+            //-----------------------------------------------------------------------------
+            /**
+            * Test the child boxes of a node against a segment, with the separating axes
+            * of niGeomMath2d::IsLineOverlapBox and the same arithmetic
+            *
+            * @param            node:               node
+            * @param            p0:                 first point of segment
+            * @param            p1:                 second point of segment
+            * @return           bit i set if the segment overlaps child i
+            *
+            */
+            int niFlatBvhTree::_OverlapLine(
+                const niFlatBvhNode &node,
+                const niPoint2d &p0,
+                const niPoint2d &p1)
+            {
+                const double sX = p0.X + p1.X;
+                const double sY = p0.Y + p1.Y;
+                const double dX = p1.X - p0.X;
+                const double dY = p1.Y - p0.Y;
+
+                int mask = 0;
+#ifdef NI_FLATBVH_SSE2
+                const __m128d signMask  = _mm_set1_pd(-0.0);
+                const __m128d vSX       = _mm_set1_pd(sX);
+                const __m128d vSY       = _mm_set1_pd(sY);
+                const __m128d vDX       = _mm_set1_pd(dX);
+                const __m128d vDY       = _mm_set1_pd(dY);
+                const __m128d vAbsDX    = _mm_set1_pd(fabs(dX));
+                const __m128d vAbsDY    = _mm_set1_pd(fabs(dY));
+
+                for (int i = 0; i < CNodeWidth; i += 2)
+                {
+                    __m128d minX = _mm_loadu_pd(&node.m_minX[i]);
+                    __m128d minY = _mm_loadu_pd(&node.m_minY[i]);
+                    __m128d maxX = _mm_loadu_pd(&node.m_maxX[i]);
+                    __m128d maxY = _mm_loadu_pd(&node.m_maxY[i]);
+
+                    __m128d hX = _mm_sub_pd(maxX, minX);
+                    __m128d tX = _mm_sub_pd(_mm_sub_pd(vSX, maxX), minX);
+                    __m128d hY = _mm_sub_pd(maxY, minY);
+                    __m128d tY = _mm_sub_pd(_mm_sub_pd(vSY, maxY), minY);
+
+                    //not greater: a NaN does not separate, as in the scalar test
+                    __m128d overlap = _mm_cmpngt_pd(_mm_andnot_pd(signMask, tX), _mm_add_pd(hX, vAbsDX));
+                    overlap = _mm_and_pd(overlap,
+                        _mm_cmpngt_pd(_mm_andnot_pd(signMask, tY), _mm_add_pd(hY, vAbsDY)));
+
+                    __m128d cross = _mm_sub_pd(_mm_mul_pd(tY, vDX), _mm_mul_pd(tX, vDY));
+                    __m128d bound = _mm_add_pd(
+                        _mm_andnot_pd(signMask, _mm_mul_pd(hX, vDY)),
+                        _mm_andnot_pd(signMask, _mm_mul_pd(hY, vDX)));
+                    overlap = _mm_and_pd(overlap,
+                        _mm_cmpngt_pd(_mm_andnot_pd(signMask, cross), bound));
+
+                    mask |= _mm_movemask_pd(overlap) << i;
+                }
+#else
+                for (int i = 0; i < CNodeWidth; ++i)
+                {
+                    double hX = node.m_maxX[i] - node.m_minX[i];
+                    double tX = sX - node.m_maxX[i] - node.m_minX[i];
+                    double hY = node.m_maxY[i] - node.m_minY[i];
+                    double tY = sY - node.m_maxY[i] - node.m_minY[i];
+
+                    bool separated = fabs(tX) > (hX + fabs(dX)) ||
+                                     fabs(tY) > (hY + fabs(dY)) ||
+                                     fabs(tY*dX-tX*dY) > (fabs(hX*dY) + fabs(hY*dX));
+                    mask |= (separated ? 0 : 1) << i;
+                }
+#endif
+                return mask & ((1 << node.m_numChildren) - 1);
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION _DistanceOfPoint
+            //-----------------------------------------------------------------------------
+            /**
+            * Distances from a point to the child boxes of a node, 0 inside a box
+            *
+            * @param            node:               node
+            * @param            p:                  point
+            * @param            distances:          store the distances
+            *
+            */
+            void niFlatBvhTree::_DistanceOfPoint(
+                const niFlatBvhNode &node,
+                const niPoint2d &p,
+                double distances[CNodeWidth])
+            {
+#ifdef NI_FLATBVH_SSE2
+                const __m128d pX    = _mm_set1_pd(p.X);
+                const __m128d pY    = _mm_set1_pd(p.Y);
+                const __m128d zero  = _mm_setzero_pd();
+
+                for (int i = 0; i < CNodeWidth; i += 2)
+                {
+                    __m128d dX = _mm_max_pd(_mm_sub_pd(_mm_loadu_pd(&node.m_minX[i]), pX),
+                                            _mm_sub_pd(pX, _mm_loadu_pd(&node.m_maxX[i])));
+                    __m128d dY = _mm_max_pd(_mm_sub_pd(_mm_loadu_pd(&node.m_minY[i]), pY),
+                                            _mm_sub_pd(pY, _mm_loadu_pd(&node.m_maxY[i])));
+                    dX = _mm_max_pd(dX, zero);
+                    dY = _mm_max_pd(dY, zero);
+
+                    _mm_storeu_pd(&distances[i],
+                        _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dX, dX), _mm_mul_pd(dY, dY))));
+                }
+#else
+                for (int i = 0; i < CNodeWidth; ++i)
+                {
+                    double dX = node.m_minX[i] - p.X;
+                    double dY = node.m_minY[i] - p.Y;
+                    dX = dX > p.X - node.m_maxX[i] ? dX : p.X - node.m_maxX[i];
+                    dY = dY > p.Y - node.m_maxY[i] ? dY : p.Y - node.m_maxY[i];
+                    dX = dX > 0.0 ? dX : 0.0;
+                    dY = dY > 0.0 ? dY : 0.0;
+
+                    distances[i] = sqrt(dX * dX + dY * dY);
+                }
+#endif
+            }
+        }
+    }
+}
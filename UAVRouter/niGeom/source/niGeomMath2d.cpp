@@ -15,6 +15,7 @@
 #include <niGeom/geometry/niTriangle2d.h>
 #include <niGeom/geometry/tree/niBvhTree.h>
 
+#include <algorithm>
 #include <stack>
 #include <iostream>
 
@@ -22,6 +23,267 @@ namespace ni
 {
     namespace geometry
     {
+        //-----------------------------------------------------------------------------
+        // Exact arithmetic of the adaptive predicates
+        //
+        // An expansion is a sum of doubles, of increasing magnitude and not overlapping,
+        // whose sign is the sign of its last component (J.R. Shewchuk, Adaptive Precision
+        // Floating-Point Arithmetic and Fast Robust Geometric Predicates).
+        //-----------------------------------------------------------------------------
+        static const double _EPSILON_       = 1.1102230246251565e-16;   //2^-53
+        static const double _SPLITTER_      = 134217729.0;              //2^27 + 1
+        static const double _CCW_ERRBOUND_  = (3.0 + 16.0 * _EPSILON_) * _EPSILON_;
+        static const double _ICC_ERRBOUND_  = (10.0 + 96.0 * _EPSILON_) * _EPSILON_;
+
+        static inline void _FastTwoSum(double a, double b, double &x, double &y)
+        {
+            x = a + b;
+            double bv = x - a;
+            y = b - bv;
+        }
+
+        static inline void _TwoSum(double a, double b, double &x, double &y)
+        {
+            x = a + b;
+            double bv = x - a;
+            double av = x - bv;
+            y = (a - av) + (b - bv);
+        }
+
+        static inline void _TwoDiff(double a, double b, double &x, double &y)
+        {
+            x = a - b;
+            double bv = a - x;
+            double av = x + bv;
+            y = (a - av) + (bv - b);
+        }
+
+        static inline void _Split(double a, double &hi, double &lo)
+        {
+            double c = _SPLITTER_ * a;
+            double abig = c - a;
+            hi = c - abig;
+            lo = a - hi;
+        }
+
+        static inline void _TwoProduct(double a, double b, double &x, double &y)
+        {
+            x = a * b;
+            double ahi, alo, bhi, blo;
+            _Split(a, ahi, alo);
+            _Split(b, bhi, blo);
+            double err1 = x - (ahi * bhi);
+            double err2 = err1 - (alo * bhi);
+            double err3 = err2 - (ahi * blo);
+            y = (alo * blo) - err3;
+        }
+
+        //a - b as an expansion of 1 or 2 components
+        static inline int _DiffExpansion(double a, double b, double *h)
+        {
+            double x, y;
+            _TwoDiff(a, b, x, y);
+            if (0.0 == y)
+            {
+                h[0] = x;
+                return 1;
+            }
+            h[0] = y;
+            h[1] = x;
+            return 2;
+        }
+
+        //h = e + f, zero components eliminated
+        static int _SumExpansion(int elen, const double *e, int flen, const double *f, double *h)
+        {
+            double Q, Qnew, hh;
+            int eindex = 0, findex = 0, hindex = 0;
+            double enow = e[0];
+            double fnow = f[0];
+            if ((fnow > enow) == (fnow > -enow))
+            {
+                Q = enow;
+                ++eindex;
+            }
+            else
+            {
+                Q = fnow;
+                ++findex;
+            }
+            enow = eindex < elen ? e[eindex] : 0.0;
+            fnow = findex < flen ? f[findex] : 0.0;
+
+            if (eindex < elen && findex < flen)
+            {
+                if ((fnow > enow) == (fnow > -enow))
+                {
+                    _FastTwoSum(enow, Q, Qnew, hh);
+                    ++eindex;
+                    enow = eindex < elen ? e[eindex] : 0.0;
+                }
+                else
+                {
+                    _FastTwoSum(fnow, Q, Qnew, hh);
+                    ++findex;
+                    fnow = findex < flen ? f[findex] : 0.0;
+                }
+                Q = Qnew;
+                if (0.0 != hh)
+                    h[hindex++] = hh;
+
+                while (eindex < elen && findex < flen)
+                {
+                    if ((fnow > enow) == (fnow > -enow))
+                    {
+                        _TwoSum(Q, enow, Qnew, hh);
+                        ++eindex;
+                        enow = eindex < elen ? e[eindex] : 0.0;
+                    }
+                    else
+                    {
+                        _TwoSum(Q, fnow, Qnew, hh);
+                        ++findex;
+                        fnow = findex < flen ? f[findex] : 0.0;
+                    }
+                    Q = Qnew;
+                    if (0.0 != hh)
+                        h[hindex++] = hh;
+                }
+            }
+            while (eindex < elen)
+            {
+                _TwoSum(Q, e[eindex++], Qnew, hh);
+                Q = Qnew;
+                if (0.0 != hh)
+                    h[hindex++] = hh;
+            }
+            while (findex < flen)
+            {
+                _TwoSum(Q, f[findex++], Qnew, hh);
+                Q = Qnew;
+                if (0.0 != hh)
+                    h[hindex++] = hh;
+            }
+            if (0.0 != Q || 0 == hindex)
+                h[hindex++] = Q;
+            return hindex;
+        }
+
+        //h = e * b, zero components eliminated
+        static int _ScaleExpansion(int elen, const double *e, double b, double *h)
+        {
+            double Q, sum, hh, product1, product0;
+            int hindex = 0;
+            _TwoProduct(e[0], b, Q, hh);
+            if (0.0 != hh)
+                h[hindex++] = hh;
+            for (int eindex = 1; eindex < elen; ++eindex)
+            {
+                _TwoProduct(e[eindex], b, product1, product0);
+                _TwoSum(Q, product0, sum, hh);
+                if (0.0 != hh)
+                    h[hindex++] = hh;
+                _FastTwoSum(product1, sum, Q, hh);
+                if (0.0 != hh)
+                    h[hindex++] = hh;
+            }
+            if (0.0 != Q || 0 == hindex)
+                h[hindex++] = Q;
+            return hindex;
+        }
+
+        //h = e * f, scaled by each component of f and summed; h holds 2*elen*flen,
+        //scale 2*elen and sum 2*elen*flen doubles
+        static int _MulExpansion(
+            int elen, const double *e,
+            int flen, const double *f,
+            double *h, double *scale, double *sum)
+        {
+            int hlen = _ScaleExpansion(elen, e, f[0], h);
+            for (int i = 1; i < flen; ++i)
+            {
+                int slen = _ScaleExpansion(elen, e, f[i], scale);
+                int len = _SumExpansion(hlen, h, slen, scale, sum);
+                std::copy(sum, sum + len, h);
+                hlen = len;
+            }
+            return hlen;
+        }
+
+        //h = a*d - b*c of 2 component expansions, h holds 16 doubles
+        static int _Det2Expansion(
+            int alen, const double *a, int blen, const double *b,
+            int clen, const double *c, int dlen, const double *d,
+            double *h)
+        {
+            double ad[8], bc[8], scale[4], sum[8];
+            int adlen = _MulExpansion(alen, a, dlen, d, ad, scale, sum);
+            int bclen = _MulExpansion(blen, b, clen, c, bc, scale, sum);
+            for (int i = 0; i < bclen; ++i)
+            {
+                bc[i] = -bc[i];
+            }
+            return _SumExpansion(adlen, ad, bclen, bc, h);
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _Orient2dExact
+        //-----------------------------------------------------------------------------
+        static double _Orient2dExact(const niPoint2d &a, const niPoint2d &b, const niPoint2d &c)
+        {
+            double acx[2], acy[2], bcx[2], bcy[2], det[16];
+            int acxlen = _DiffExpansion(a.X, c.X, acx);
+            int acylen = _DiffExpansion(a.Y, c.Y, acy);
+            int bcxlen = _DiffExpansion(b.X, c.X, bcx);
+            int bcylen = _DiffExpansion(b.Y, c.Y, bcy);
+            int len = _Det2Expansion(acxlen, acx, acylen, acy, bcxlen, bcx, bcylen, bcy, det);
+            return det[len-1];
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _InCircleExact
+        //-----------------------------------------------------------------------------
+        static double _InCircleExact(
+            const niPoint2d &a,
+            const niPoint2d &b,
+            const niPoint2d &c,
+            const niPoint2d &d)
+        {
+            double dx[3][2], dy[3][2];
+            int dxlen[3], dylen[3];
+            const niPoint2d *p[3] = {&a, &b, &c};
+            for (int i = 0; i < 3; ++i)
+            {
+                dxlen[i] = _DiffExpansion(p[i]->X, d.X, dx[i]);
+                dylen[i] = _DiffExpansion(p[i]->Y, d.Y, dy[i]);
+            }
+
+            double scale[32], sum[512], term[512], det[1536], acc[1536];
+            int detlen = 1;
+            det[0] = 0.0;
+            for (int i = 0; i < 3; ++i)
+            {
+                int j = (i + 1) % 3;
+                int k = (i + 2) % 3;
+
+                //lift of i times the minor of j, k
+                double xx[8], yy[8], lift[16], minor[16];
+                int xxlen = _MulExpansion(dxlen[i], dx[i], dxlen[i], dx[i], xx, scale, sum);
+                int yylen = _MulExpansion(dylen[i], dy[i], dylen[i], dy[i], yy, scale, sum);
+                int liftlen = _SumExpansion(xxlen, xx, yylen, yy, lift);
+                int minorlen = _Det2Expansion(
+                    dxlen[j], dx[j], dylen[j], dy[j],
+                    dxlen[k], dx[k], dylen[k], dy[k],
+                    minor);
+
+                int termlen = _MulExpansion(liftlen, lift, minorlen, minor, term, scale, sum);
+                int acclen = _SumExpansion(detlen, det, termlen, term, acc);
+                std::copy(acc, acc + acclen, det);
+                detlen = acclen;
+            }
+            return det[detlen-1];
+        }
+
         //-----------------------------------------------------------------------------
         // FUNCTION Angle
         //-----------------------------------------------------------------------------
@@ -742,6 +1004,62 @@ namespace ni
             }
         }
 
+        //-----------------------------------------------------------------------------
+        // FUNCTION InCircle
+        //-----------------------------------------------------------------------------
+        /**
+        * Robust in circle test. The determinant is evaluated in doubles and checked
+        * against its error bound, exactly only when the bound can not tell the sign.
+        *
+        * @param       a:           point of the circle
+        * @param       b:           point of the circle
+        * @param       c:           point of the circle
+        * @param       d:           point to test
+        * @return      > 0:         d is in the circle of the counterclockwise a, b, c
+        *              < 0:         d is out of the circle
+        *              = 0:         the four points are on one circle
+        */
+        double niGeomMath2d::InCircle(
+            const niPoint2d &a,
+            const niPoint2d &b,
+            const niPoint2d &c,
+            const niPoint2d &d)
+        {
+            double adx = a.X - d.X;
+            double bdx = b.X - d.X;
+            double cdx = c.X - d.X;
+            double ady = a.Y - d.Y;
+            double bdy = b.Y - d.Y;
+            double cdy = c.Y - d.Y;
+
+            double bdxcdy = bdx * cdy;
+            double cdxbdy = cdx * bdy;
+            double alift = adx * adx + ady * ady;
+
+            double cdxady = cdx * ady;
+            double adxcdy = adx * cdy;
+            double blift = bdx * bdx + bdy * bdy;
+
+            double adxbdy = adx * bdy;
+            double bdxady = bdx * ady;
+            double clift = cdx * cdx + cdy * cdy;
+
+            double det =
+                alift * (bdxcdy - cdxbdy) +
+                blift * (cdxady - adxcdy) +
+                clift * (adxbdy - bdxady);
+
+            double permanent =
+                (fabs(bdxcdy) + fabs(cdxbdy)) * alift +
+                (fabs(cdxady) + fabs(adxcdy)) * blift +
+                (fabs(adxbdy) + fabs(bdxady)) * clift;
+            double errbound = _ICC_ERRBOUND_ * permanent;
+            if (det > errbound || -det > errbound)
+                return det;
+
+            return _InCircleExact(a, b, c, d);
+        }
+
         //-----------------------------------------------------------------------------
         // FUNCTION IsBoxOverlapBox
         //-----------------------------------------------------------------------------
@@ -1535,6 +1853,35 @@ namespace ni
             return true;
         }
 
+        //-----------------------------------------------------------------------------
+        // FUNCTION Orient2d
+        //-----------------------------------------------------------------------------
+        /**
+        * Robust orientation test, exact when the error bound can not tell the sign
+        *
+        * @param       a:           point
+        * @param       b:           point
+        * @param       c:           point
+        * @return      > 0:         a, b, c are counterclockwise
+        *              < 0:         a, b, c are clockwise
+        *              = 0:         a, b, c are collinear
+        */
+        double niGeomMath2d::Orient2d(
+            const niPoint2d &a,
+            const niPoint2d &b,
+            const niPoint2d &c)
+        {
+            double detleft = (a.X - c.X) * (b.Y - c.Y);
+            double detright = (a.Y - c.Y) * (b.X - c.X);
+            double det = detleft - detright;
+
+            double errbound = _CCW_ERRBOUND_ * (fabs(detleft) + fabs(detright));
+            if (det > errbound || -det > errbound)
+                return det;
+
+            return _Orient2dExact(a, b, c);
+        }
+
         //-----------------------------------------------------------------------------
         // FUNCTION Orientation
         //-----------------------------------------------------------------------------
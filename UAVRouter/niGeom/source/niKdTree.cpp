@@ -10,7 +10,10 @@
 #include <niGeom/geometry/tree/niKdTree.h>
 #include <niGeom/geometry/niGeomMath2d.h>
 
-#include <stack>
+#include <cmath>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 namespace ni
 {
@@ -24,13 +27,13 @@ namespace ni
             /**
             * Construction
             *
+            * @param       refPoints:   the input points
             */
-            niKdTree::niBuilder::niBuilder()
+            niKdTree::niKdTree(const niArrayT<niRefPoint2d> &refPoints)
             {
-                m_build_nodes   = NULL;
-                m_sorted[0]     = NULL;
-                m_sorted[1]     = NULL;
+                Build(refPoints);
             }
+
             //-----------------------------------------------------------------------------
             // FUNCTION DeConstruction
             //-----------------------------------------------------------------------------
@@ -38,385 +41,630 @@ namespace ni
             * DeConstruction
             *
             */
-            niKdTree::niBuilder::~niBuilder()
-            {
-                Destory();
-            }
-            //-----------------------------------------------------------------------------
-            // FUNCTION Destory
-            //-----------------------------------------------------------------------------
-            /**
-            * Free all memory
-            *
-            */
-            void niKdTree::niBuilder::Destory()
+            niKdTree::~niKdTree()
             {
-                if (NULL != m_sorted[0])
-                {
-                    delete []m_sorted[0];
-                    m_sorted[0] = NULL;
-                }
-                if (NULL != m_sorted[1])
-                {
-                    delete []m_sorted[1];
-                    m_sorted[1] = NULL;
-                }
-                if (NULL != m_build_nodes)
-                {
-                    delete []m_build_nodes;
-                    m_build_nodes = NULL;
-                }
             }
+
             //-----------------------------------------------------------------------------
-            // FUNCTION niBuilder::Build
+            // FUNCTION niKdTree::Build
             //-----------------------------------------------------------------------------
             /**
-            * Build subtree iteratively.
+            * Build tree.
             *
-            * @param       axis1:       0 indicates x axis, 1 incidates y axis
-            * @param       _l:          the start index of datas
-            * @param       _r:          the finish index of datas
-            * @return      if success, return the root of subtree,
-            *                or return NULL
+            * @param       points:      the input points
+            * @return      if success, return true
+            *                or return false
             */
-            niKdTree::niKdNode* niKdTree::niBuilder::Build(
-                int axis1, int _l, int _r)
+            bool niKdTree::Build(const niPoint2dArray &points)
             {
-                int _m = (_l + _r) / 2;
-
-                niKdNode* kd_node = new niKdNode(
-                    m_sorted[axis1][_m]->m_refPoint2d,
-                    axis1);
+                size_t num_points = points.size();
+                if (num_points < 1)
+                    return false;
 
-                if (_l == _r)
-                {
-                    return kd_node;
-                }
+                niArrayT<const niPoint2d*> pointRefs;
+                pointRefs.resize(num_points);
 
-                for (int i = _l; i <= _r; ++i)
+                for (size_t i = 0; i < num_points; ++i)
                 {
-                    m_sorted[axis1][i]->m_hit = (i <= _m);
+                    pointRefs[i] = &points[i];
                 }
 
-                int axis2 = (axis1+1) % 2;
-
-                // stable partition, maintain the order, so we do not need sort them any more.
-                std::stable_partition(&m_sorted[axis2][_l], &m_sorted[axis2][_r+1], IsHit);
-                m_sorted[axis1][_m]->m_hit = false; 
-                std::stable_partition(&m_sorted[axis2][_l], &m_sorted[axis2][_m+1], IsHit);
-
-                if (_l < _m)
-                    kd_node->l_child = Build(axis2, _l, _m-1);
-                if (_m < _r)
-                    kd_node->r_child = Build(axis2, _m+1, _r);
-
-                return kd_node;
+                return Build(pointRefs);
             }
 
             //-----------------------------------------------------------------------------
-            // FUNCTION niBuilder::InitBuild
+            // FUNCTION niKdTree::Build
             //-----------------------------------------------------------------------------
             /**
-            * Init builder
+            * Build tree, the id of a point is its index in pointRefs.
             *
-            * @param       points:      the input points
+            * @param       pointRefs:   the input points
             * @return      if success, return true
             *                or return false
             */
-            bool niKdTree::niBuilder::InitBuild(
-                const niArrayT<const niPoint2d*> &pointRefs)
+            bool niKdTree::Build(const niArrayT<const niPoint2d*> &pointRefs)
             {
-                int num_points = int(pointRefs.size());
+                Clear();
+
+                size_t num_points = pointRefs.size();
                 if (num_points < 1)
                     return false;
 
+                niArrayT<niRefPoint2d> refPoints;
                 try
                 {
-                    m_build_nodes   = new niBuildNode[num_points];
-                    m_sorted[0]     = new niBuildNode*[num_points];
-                    m_sorted[1]     = new niBuildNode*[num_points];
+                    refPoints.resize(num_points);
                 }
                 catch (std::bad_alloc)
                 {
-                    Destory();
                     return false;
                 }
 
-                for (int i = 0; i < num_points; ++i)
+                for (size_t i = 0; i < num_points; ++i)
                 {
-                    m_build_nodes[i].m_refPoint2d.m_pointRef = pointRefs[i];
-                    m_build_nodes[i].m_refPoint2d.m_IdOfPoint = i;
-                    m_sorted[0][i] = &m_build_nodes[i];
-                    m_sorted[1][i] = &m_build_nodes[i];
+                    refPoints[i].m_pointRef     = pointRefs[i];
+                    refPoints[i].m_IdOfPoint    = int(i);
                 }
 
-                std::sort(m_sorted[0], &m_sorted[0][num_points], niBuildNode::_compare_<0>);
-
-                std::sort(m_sorted[1], &m_sorted[1][num_points], niBuildNode::_compare_<1>);
-
-                return true;
+                return Build(refPoints);
             }
 
             //-----------------------------------------------------------------------------
-            // FUNCTION niBuilder::InitBuild
+            // FUNCTION niKdTree::Build
             //-----------------------------------------------------------------------------
             /**
-            * Init builder
+            * Build tree: put the median of each range on its axis in the middle of the
+            * range with nth_element, then the ranges of both sides.
+            * The order (coordinate, then id) is the one of the sorted build, so the tree
+            * is the same.
             *
-            * @param       points:      the input points
+            * @param       refPoints:   the input points
             * @return      if success, return true
             *                or return false
             */
-            bool niKdTree::niBuilder::InitBuild(
-                const niArrayT<niRefPoint2d> &refPoints)
+            bool niKdTree::Build(const niArrayT<niRefPoint2d> &refPoints)
             {
+                Clear();
+
                 int num_points = int(refPoints.size());
                 if (num_points < 1)
                     return false;
 
+                niIntArray order;
                 try
                 {
-                    m_build_nodes   = new niBuildNode[num_points];
-                    m_sorted[0]     = new niBuildNode*[num_points];
-                    m_sorted[1]     = new niBuildNode*[num_points];
+                    order.resize(num_points);
+                    m_points.resize(num_points);
+                    m_refPoints.resize(num_points);
                 }
                 catch (std::bad_alloc)
                 {
-                    Destory();
+                    Clear();
                     return false;
                 }
 
                 for (int i = 0; i < num_points; ++i)
                 {
-                    m_build_nodes[i].m_refPoint2d = refPoints[i];
-                    m_sorted[0][i] = &m_build_nodes[i];
-                    m_sorted[1][i] = &m_build_nodes[i];
+                    order[i] = i;
                 }
 
-                std::sort(m_sorted[0], &m_sorted[0][num_points], niBuildNode::_compare_<0>);
+                int *first = &order[0];
 
-                std::sort(m_sorted[1], &m_sorted[1][num_points], niBuildNode::_compare_<1>);
+                niKdRange stack[CStackSize];
+                int top = 0;
+                stack[top].m_l          = 0;
+                stack[top].m_r          = num_points-1;
+                stack[top].m_axis       = 0;
+                stack[top].m_distance2  = 0.0;
+                ++top;
 
-                return true;
-            }
+                while (top > 0)
+                {
+                    niKdRange range = stack[--top];
+                    int _m = (range.m_l + range.m_r) / 2;
 
-            niKdTree::niKdTree(const niArrayT<niRefPoint2d> &refPoints) : m_root(NULL)
-            {
-                Build(refPoints);
+                    std::nth_element(
+                        first + range.m_l,
+                        first + _m,
+                        first + range.m_r + 1,
+                        niBuildCompare(refPoints, range.m_axis));
+
+                    int axis2 = (range.m_axis+1) % 2;
+                    if (range.m_l < _m)
+                    {
+                        stack[top].m_l          = range.m_l;
+                        stack[top].m_r          = _m-1;
+                        stack[top].m_axis       = axis2;
+                        stack[top].m_distance2  = 0.0;
+                        ++top;
+                    }
+                    if (_m < range.m_r)
+                    {
+                        stack[top].m_l          = _m+1;
+                        stack[top].m_r          = range.m_r;
+                        stack[top].m_axis       = axis2;
+                        stack[top].m_distance2  = 0.0;
+                        ++top;
+                    }
+                }
+
+                for (int i = 0; i < num_points; ++i)
+                {
+                    m_refPoints[i]  = refPoints[ order[i] ];
+                    m_points[i]     = *m_refPoints[i].m_pointRef;
+                }
+                return true;
             }
 
-            niKdTree::~niKdTree()            
+            //-----------------------------------------------------------------------------
+            // FUNCTION niKdTree::Clear
+            //-----------------------------------------------------------------------------
+            /**
+            * Free all memory
+            *
+            */
+            void niKdTree::Clear()
             {
-                delete m_root;
-                m_root = NULL;
+                m_points.clear();
+                m_refPoints.clear();
             }
 
             //-----------------------------------------------------------------------------
-            // FUNCTION niKdTree::Build
+            // FUNCTION niKdTree::PointsInBBox
             //-----------------------------------------------------------------------------
             /**
-            * Build subtree iteratively.
+            * Get points in bbox.
             *
-            * @param       points:      the input points
+            * @param       bbox:        the input points
+            * @param       pointRefs:   save points in bbox
             * @return      if success, return true
             *                or return false
             */
-            bool niKdTree::Build(const niPoint2dArray &points)
+            bool niKdTree::PointsInBBox(
+                const niBBox2d &bbox,
+                niArrayT<const niPoint2d *> &pointRefs) const
             {
-                size_t num_points = points.size();
-                if (num_points < 1)
-                    return false;
+                pointRefs.clear();
 
-                niArrayT<const niPoint2d*> pointRefs;
-                pointRefs.resize(num_points);
+                niIntArray indices;
+                _IndicesInBBox(bbox, indices);
 
-                for (size_t i = 0; i < num_points; ++i)
+                pointRefs.resize(indices.size());
+                for (size_t i = 0; i < indices.size(); ++i)
                 {
-                    pointRefs[i] = &points[i];
+                    pointRefs[i] = m_refPoints[ indices[i] ].m_pointRef;
                 }
-
-                return Build(pointRefs);
+                return pointRefs.size() > 0;
             }
 
             //-----------------------------------------------------------------------------
-            // FUNCTION niKdTree::Build
+            // FUNCTION niKdTree::PointsInBBox
             //-----------------------------------------------------------------------------
             /**
-            * Build subtree iteratively.
+            * Get points in bbox.
             *
-            * @param       points:      the input points
+            * @param       bbox:        the input points
+            * @param       IdOfPoints:      save points' refids in bbox
             * @return      if success, return true
             *                or return false
             */
-            bool niKdTree::Build(const niArrayT<const niPoint2d*> &pointRefs)
+            bool niKdTree::PointsInBBox(
+                const niBBox2d &bbox,
+                niIntArray &IdOfPoints) const
             {
-                if (NULL != m_root)
+                _IndicesInBBox(bbox, IdOfPoints);
+
+                for (size_t i = 0; i < IdOfPoints.size(); ++i)
                 {
-                    delete m_root;
-                    m_root = NULL;
+                    IdOfPoints[i] = m_refPoints[ IdOfPoints[i] ].m_IdOfPoint;
                 }
+                return IdOfPoints.size() > 0;
+            }
 
-                int num_points = int(pointRefs.size());
-                if (num_points < 1)
-                    return false;
+            //-----------------------------------------------------------------------------
+            // FUNCTION niKdTree::KNearest
+            //-----------------------------------------------------------------------------
+            /**
+            * Get the k nearest points.
+            *
+            * @param       p:           the query point
+            * @param       k:           number of points
+            * @param       IdOfPoints:  save ids of the points, the nearest first
+            * @param       distances:   save distances of the points, may be NULL
+            * @return      number of points found, k or all the points if fewer
+            */
+            int niKdTree::KNearest(
+                const niPoint2d &p,
+                int k,
+                niIntArray &IdOfPoints,
+                niDoubleArray *distances) const
+            {
+                IdOfPoints.clear();
+                if (NULL != distances)
+                    distances->clear();
 
-                niBuilder builder;
+                if (k < 1 || m_points.empty())
+                    return 0;
 
-                bool bStat = builder.InitBuild(pointRefs);
-                if (!bStat)
-                    return false;
+                int num_points = int(m_points.size());
+                k = k < num_points ? k : num_points;
 
-                m_root = builder.Build(0, 0, num_points-1);
+                niArrayT<niKdNeighbor> heap;
+                try
+                {
+                    heap.resize(k);
+                    IdOfPoints.reserve(k);
+                    if (NULL != distances)
+                        distances->reserve(k);
+                }
+                catch (std::bad_alloc)
+                {
+                    return 0;
+                }
 
-                return m_root != NULL;
+                int count = _KNearest(p, k, &heap[0]);
+                for (int i = 0; i < count; ++i)
+                {
+                    IdOfPoints.push_back(m_refPoints[ heap[i].m_index ].m_IdOfPoint);
+                    if (NULL != distances)
+                        distances->push_back(sqrt(heap[i].m_distance2));
+                }
+                return count;
             }
 
             //-----------------------------------------------------------------------------
-            // FUNCTION niKdTree::Build
+            // FUNCTION niKdTree::KNearest
             //-----------------------------------------------------------------------------
             /**
-            * Build subtree iteratively.
+            * Get the k nearest points of many query points, in parallel.
+            * The queries are cut into chunks of at least CBatchSize, one a hardware thread.
+            * The result of queries[i] is at [i*k, i*k+k), the nearest first, padded with
+            * id -1 and distance -1.0 when the tree has fewer than k points.
             *
-            * @param       points:      the input points
+            * @param       queries:     the query points
+            * @param       k:           number of points of each query
+            * @param       IdOfPoints:  save ids of the points
+            * @param       distances:   save distances of the points, may be NULL
             * @return      if success, return true
             *                or return false
             */
-            bool niKdTree::Build(const niArrayT<niRefPoint2d> &refPoints)
+            bool niKdTree::KNearest(
+                const niPoint2dArray &queries,
+                int k,
+                niIntArray &IdOfPoints,
+                niDoubleArray *distances) const
             {
-                if (NULL != m_root)
-                {
-                    delete m_root;
-                    m_root = NULL;
-                }
+                IdOfPoints.clear();
+                if (NULL != distances)
+                    distances->clear();
 
-                int num_points = int(refPoints.size());
-                if (num_points < 1)
+                if (k < 1 || m_points.empty())
                     return false;
 
-                niBuilder builder;
+                size_t num_queries  = queries.size();
+                int num_points      = int(m_points.size());
+                int capacity        = k < num_points ? k : num_points;
+
+                size_t num_tasks = std::thread::hardware_concurrency();
+                size_t max_tasks = (num_queries + CBatchSize - 1) / CBatchSize;
+                num_tasks = num_tasks < max_tasks ? num_tasks : max_tasks;
+                num_tasks = num_tasks > 1 ? num_tasks : 1;
 
-                bool bStat = builder.InitBuild(refPoints);
-                if (!bStat)
+                niArrayT<niKdNeighbor> heaps;
+                std::vector<std::thread> tasks;
+                try
+                {
+                    IdOfPoints.assign(num_queries * k, -1);
+                    if (NULL != distances)
+                        distances->assign(num_queries * k, -1.0);
+                    heaps.resize(num_tasks * capacity);
+                    tasks.reserve(num_tasks);
+                }
+                catch (std::bad_alloc)
+                {
+                    IdOfPoints.clear();
+                    if (NULL != distances)
+                        distances->clear();
                     return false;
+                }
+
+                if (0 == num_queries)
+                    return true;
 
-                m_root = builder.Build(0, 0, num_points-1);
+                int *ids        = &IdOfPoints[0];
+                double *dists   = NULL != distances ? &(*distances)[0] : NULL;
+                size_t chunk    = (num_queries + num_tasks - 1) / num_tasks;
+
+                //chunk 0 on this thread, with the chunks no thread could be started for
+                size_t task = 1;
+                try
+                {
+                    for (; task < num_tasks; ++task)
+                    {
+                        size_t first    = task * chunk;
+                        size_t last     = std::min(first + chunk, num_queries);
+                        tasks.push_back(std::thread(
+                            _KNearestTask, this, &queries, first, last, k, &heaps[task * capacity], ids, dists));
+                    }
+                }
+                catch (std::system_error)
+                {
+                }
+                for (size_t left = task; left < num_tasks; ++left)
+                {
+                    size_t first    = left * chunk;
+                    size_t last     = std::min(first + chunk, num_queries);
+                    _KNearestTask(this, &queries, first, last, k, &heaps[0], ids, dists);
+                }
+                _KNearestTask(this, &queries, 0, std::min(chunk, num_queries), k, &heaps[0], ids, dists);
 
-                return m_root != NULL;
+                for (size_t i = 0; i < tasks.size(); ++i)
+                {
+                    tasks[i].join();
+                }
+                return true;
             }
 
             //-----------------------------------------------------------------------------
-            // FUNCTION niKdTree::PointsInBBox
+            // FUNCTION niKdTree::PointsInRadius
             //-----------------------------------------------------------------------------
             /**
-            * Get points in bbox.
+            * Get points within radius.
             *
-            * @param       bbox:        the input points
-            * @param       pointRefs:   save points in bbox
-            * @return      if success, return true
-            *                or return false
+            * @param       p:           the query point
+            * @param       radius:      the radius, the points on the circle are in
+            * @param       IdOfPoints:  save ids of the points, in the order of the tree
+            * @return      number of points found
             */
-            bool niKdTree::PointsInBBox(
-                const niBBox2d &bbox,
-                niArrayT<const niPoint2d *> &pointRefs)
+            int niKdTree::PointsInRadius(
+                const niPoint2d &p,
+                double radius,
+                niIntArray &IdOfPoints) const
             {
-                pointRefs.clear();
-                if (NULL == m_root)
-                    return false;
+                IdOfPoints.clear();
+                if (radius < 0.0 || m_points.empty())
+                    return 0;
 
-                std::stack<niKdNode*> stack;
-                stack.push(m_root);
+                double radius2 = radius * radius;
 
-                niKdNode* iter;
-                double _v;
+                niKdRange stack[CStackSize];
+                int top = 0;
+                stack[top].m_l          = 0;
+                stack[top].m_r          = int(m_points.size())-1;
+                stack[top].m_axis       = 0;
+                stack[top].m_distance2  = 0.0;
+                ++top;
 
-                while (!stack.empty())
+                while (top > 0)
                 {
-                    iter = stack.top();
-                    stack.pop();
+                    niKdRange range = stack[--top];
+                    int _l      = range.m_l;
+                    int _r      = range.m_r;
+                    int axis    = range.m_axis;
 
-                    _v = (*iter->m_refPoint2d.m_pointRef)[iter->m_axis];
-
-                    if (_v < bbox.P1[iter->m_axis])
-                    {
-                        if (NULL != iter->r_child)
-                            stack.push(iter->r_child);
-                    }
-                    else if (_v > bbox.P2[iter->m_axis])
+                    //down the near side, the far side pushed when the radius crosses the plane
+                    while (_l <= _r)
                     {
-                        if (NULL != iter->l_child)
-                            stack.push(iter->l_child);
-                    }
-                    else
-                    {
-                        if (niGeomMath2d::IsPointInBox(*iter->m_refPoint2d.m_pointRef, bbox))
+                        int _m = (_l + _r) / 2;
+                        const niPoint2d &q = m_points[_m];
+
+                        double dx = q.X - p.X;
+                        double dy = q.Y - p.Y;
+                        if (dx*dx + dy*dy <= radius2)
                         {
-                            pointRefs.push_back( iter->m_refPoint2d.m_pointRef );
+                            IdOfPoints.push_back(m_refPoints[_m].m_IdOfPoint);
                         }
-                        if (NULL != iter->l_child)
-                            stack.push(iter->l_child);
-                        if (NULL != iter->r_child)
-                            stack.push(iter->r_child);
+
+                        double diff = p[axis] - q[axis];
+                        int axis2 = (axis+1) % 2;
+                        if (diff*diff <= radius2)
+                        {
+                            niKdRange &far_range = stack[top];
+                            far_range.m_l       = diff < 0.0 ? _m+1 : _l;
+                            far_range.m_r       = diff < 0.0 ? _r : _m-1;
+                            far_range.m_axis    = axis2;
+                            far_range.m_distance2 = diff*diff;
+                            if (far_range.m_l <= far_range.m_r)
+                                ++top;
+                        }
+
+                        if (diff < 0.0)
+                            _r = _m-1;
+                        else
+                            _l = _m+1;
+                        axis = axis2;
                     }
                 }
-                return pointRefs.size() > 0;
+                return int(IdOfPoints.size());
             }
 
             //-----------------------------------------------------------------------------
-            // FUNCTION niKdTree::PointsInBBox
+            // FUNCTION niKdTree::_IndicesInBBox
             //-----------------------------------------------------------------------------
             /**
-            * Get points in bbox.
+            * Get positions in the tree of the points in bbox.
             *
             * @param       bbox:        the input points
-            * @param       IdOfPoints:      save points' refids in bbox
-            * @return      if success, return true
-            *                or return false
+            * @param       indices:     save positions of points in bbox
             */
-            bool niKdTree::PointsInBBox(
+            void niKdTree::_IndicesInBBox(
                 const niBBox2d &bbox,
-                niIntArray &IdOfPoints)
+                niIntArray &indices) const
             {
-                IdOfPoints.clear();
-                if (NULL == m_root)
-                    return false;
-
-                std::stack<niKdNode*> stack;
-                stack.push(m_root);
-
-                niKdNode* iter;
-                double _v;
-
-                while (!stack.empty())
+                indices.clear();
+                if (m_points.empty())
+                    return;
+
+                niKdRange stack[CStackSize];
+                int top = 0;
+                stack[top].m_l          = 0;
+                stack[top].m_r          = int(m_points.size())-1;
+                stack[top].m_axis       = 0;
+                stack[top].m_distance2  = 0.0;
+                ++top;
+
+                while (top > 0)
                 {
-                    iter = stack.top();
-                    stack.pop();
+                    niKdRange range = stack[--top];
+                    int _m      = (range.m_l + range.m_r) / 2;
+                    int axis    = range.m_axis;
+                    int axis2   = (axis+1) % 2;
+
+                    double _v = m_points[_m][axis];
 
-                    _v = (*iter->m_refPoint2d.m_pointRef)[iter->m_axis];
+                    bool bLeft  = _v >= bbox.P1[axis] && range.m_l < _m;
+                    bool bRight = _v <= bbox.P2[axis] && _m < range.m_r;
 
-                    if (_v < bbox.P1[iter->m_axis])
+                    if (_v >= bbox.P1[axis] && _v <= bbox.P2[axis] &&
+                        niGeomMath2d::IsPointInBox(m_points[_m], bbox))
                     {
-                        if (NULL != iter->r_child)
-                            stack.push(iter->r_child);
+                        indices.push_back(_m);
                     }
-                    else if (_v > bbox.P2[iter->m_axis])
+                    if (bLeft)
                     {
-                        if (NULL != iter->l_child)
-                            stack.push(iter->l_child);
+                        stack[top].m_l          = range.m_l;
+                        stack[top].m_r          = _m-1;
+                        stack[top].m_axis       = axis2;
+                        stack[top].m_distance2  = 0.0;
+                        ++top;
                     }
-                    else
+                    if (bRight)
                     {
-                        if (niGeomMath2d::IsPointInBox(*iter->m_refPoint2d.m_pointRef, bbox))
+                        stack[top].m_l          = _m+1;
+                        stack[top].m_r          = range.m_r;
+                        stack[top].m_axis       = axis2;
+                        stack[top].m_distance2  = 0.0;
+                        ++top;
+                    }
+                }
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION niKdTree::_KNearest
+            //-----------------------------------------------------------------------------
+            /**
+            * Get the k nearest points into a bounded max-heap of k neighbors: a point goes
+            * in when the heap is not full or it is nearer than the farthest one, a far
+            * side is visited when the plane is not farther than the farthest one.
+            *
+            * @param       p:           the query point
+            * @param       k:           number of points, 1 to the size of the tree
+            * @param       heap:        k neighbors, sorted the nearest first on return
+            * @return      number of points found
+            */
+            int niKdTree::_KNearest(
+                const niPoint2d &p,
+                int k,
+                niKdNeighbor *heap) const
+            {
+                int count = 0;
+
+                niKdRange stack[CStackSize];
+                int top = 0;
+                stack[top].m_l          = 0;
+                stack[top].m_r          = int(m_points.size())-1;
+                stack[top].m_axis       = 0;
+                stack[top].m_distance2  = 0.0;
+                ++top;
+
+                while (top > 0)
+                {
+                    niKdRange range = stack[--top];
+                    if (count == k && heap[0].m_distance2 < range.m_distance2)
+                        continue;
+
+                    int _l      = range.m_l;
+                    int _r      = range.m_r;
+                    int axis    = range.m_axis;
+
+                    while (_l <= _r)
+                    {
+                        int _m = (_l + _r) / 2;
+                        const niPoint2d &q = m_points[_m];
+
+                        niKdNeighbor neighbor;
+                        double dx = q.X - p.X;
+                        double dy = q.Y - p.Y;
+                        neighbor.m_distance2    = dx*dx + dy*dy;
+                        neighbor.m_index        = _m;
+
+                        if (count < k)
+                        {
+                            heap[count++] = neighbor;
+                            std::push_heap(heap, heap + count, _IsNearer);
+                        }
+                        else if (_IsNearer(neighbor, heap[0]))
+                        {
+                            std::pop_heap(heap, heap + k, _IsNearer);
+                            heap[k-1] = neighbor;
+                            std::push_heap(heap, heap + k, _IsNearer);
+                        }
+
+                        double diff = p[axis] - q[axis];
+                        double far_distance2 = diff*diff > range.m_distance2 ? diff*diff : range.m_distance2;
+                        int axis2 = (axis+1) % 2;
+                        if (count < k || far_distance2 <= heap[0].m_distance2)
                         {
-                            IdOfPoints.push_back(iter->m_refPoint2d.m_IdOfPoint);
+                            niKdRange &far_range = stack[top];
+                            far_range.m_l       = diff < 0.0 ? _m+1 : _l;
+                            far_range.m_r       = diff < 0.0 ? _r : _m-1;
+                            far_range.m_axis    = axis2;
+                            far_range.m_distance2 = far_distance2;
+                            if (far_range.m_l <= far_range.m_r)
+                                ++top;
                         }
-                        if (NULL != iter->l_child)
-                            stack.push(iter->l_child);
-                        if (NULL != iter->r_child)
-                            stack.push(iter->r_child);
+
+                        if (diff < 0.0)
+                            _r = _m-1;
+                        else
+                            _l = _m+1;
+                        axis = axis2;
+                    }
+                }
+
+                std::sort_heap(heap, heap + count, _IsNearer);
+                return count;
+            }
+
+            //-----------------------------------------------------------------------------
+            // FUNCTION niKdTree::_KNearestTask
+            //-----------------------------------------------------------------------------
+            /**
+            * Answer the queries [first, last) of a batch.
+            *
+            * @param       tree:        the tree
+            * @param       queries:     the query points
+            * @param       first:       first query
+            * @param       last:        end of the queries
+            * @param       k:           number of points of each query
+            * @param       heap:        heap of the task, k or the size of tree neighbors
+            * @param       IdOfPoints:  k ids a query
+            * @param       distances:   k distances a query, may be NULL
+            */
+            void niKdTree::_KNearestTask(
+                const niKdTree *tree,
+                const niPoint2dArray *queries,
+                size_t first,
+                size_t last,
+                int k,
+                niKdNeighbor *heap,
+                int *IdOfPoints,
+                double *distances)
+            {
+                int num_points  = int(tree->m_points.size());
+                int capacity    = k < num_points ? k : num_points;
+
+                for (size_t i = first; i < last; ++i)
+                {
+                    int count = tree->_KNearest((*queries)[i], capacity, heap);
+                    for (int j = 0; j < count; ++j)
+                    {
+                        IdOfPoints[i*k + j] = tree->m_refPoints[ heap[j].m_index ].m_IdOfPoint;
+                        if (NULL != distances)
+                            distances[i*k + j] = sqrt(heap[j].m_distance2);
                     }
                 }
-                return IdOfPoints.size() > 0;
             }
         }
     }
-}
\ No newline at end of file
+}
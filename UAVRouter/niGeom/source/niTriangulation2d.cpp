@@ -18,16 +18,30 @@
 #define THRESHOLH_ACCE2     256
 
 #include <algorithm>
-#include <stack>
+#include <cmath>
 #include <iostream>
 namespace ni
 {
     namespace geometry
     {
-        niTriangulation2d::niTriangulation2d(niPolygon2d &polygon)
-            : m_polygon(polygon), m_hBst(NULL), m_hKdt(NULL)
+        niTriangulation2d::niTriangulation2d(niPolygon2d &polygon, ETriangulationMode mode)
+            : m_polygon(polygon), m_hBst(NULL), m_hKdt(NULL), m_mode(mode), m_arena(NULL), m_fFlatVerts(false)
         {
             m_remain_counter = 0;
+            m_angles    = NULL;
+            m_prev      = NULL;
+            m_next      = NULL;
+            m_ears      = NULL;
+            m_earPos    = NULL;
+            m_numEars   = 0;
+            m_cellStart = NULL;
+            m_cellCount = NULL;
+            m_cellItems = NULL;
+            m_cellPos   = NULL;
+            m_numCellsX = 0;
+            m_numCellsY = 0;
+            m_cellScaleX= 0.0;
+            m_cellScaleY= 0.0;
         }
 
         //-----------------------------------------------------------------------------
@@ -140,49 +154,17 @@ namespace ni
             const niBBox2d &bbox,
             niIntArray &IdOfPoints)
         {
-            IdOfPoints.clear();
             tree::niKdTree *kdt = (tree::niKdTree *)m_hKdt;
-            const tree::niKdTree::niKdNode *root = kdt->Root();
+            kdt->PointsInBBox(bbox, IdOfPoints);
 
-            if (NULL == root)
-                return false;
-
-            std::stack<const tree::niKdTree::niKdNode*> stack;
-            stack.push(root);
-
-            const tree::niKdTree::niKdNode* iter;
-            double _v;
-
-            while (!stack.empty())
+            //skip the marked points, in place
+            size_t num_ids = 0;
+            for (size_t i = 0; i < IdOfPoints.size(); ++i)
             {
-                iter = stack.top();
-                stack.pop();
-
-                _v = (*iter->m_refPoint2d.m_pointRef)[iter->m_axis];
-
-                if (_v < bbox.P1[iter->m_axis])
-                {
-                    if (NULL != iter->r_child)
-                        stack.push(iter->r_child);
-                }
-                else if (_v > bbox.P2[iter->m_axis])
-                {
-                    if (NULL != iter->l_child)
-                        stack.push(iter->l_child);
-                }
-                else
-                {
-                    if (!m_markers[iter->m_refPoint2d.m_IdOfPoint] &&
-                        niGeomMath2d::IsPointInBox(*iter->m_refPoint2d.m_pointRef, bbox))
-                    {
-                        IdOfPoints.push_back(iter->m_refPoint2d.m_IdOfPoint);
-                    }
-                    if (NULL != iter->l_child)
-                        stack.push(iter->l_child);
-                    if (NULL != iter->r_child)
-                        stack.push(iter->r_child);
-                }
+                if (!m_markers[ IdOfPoints[i] ])
+                    IdOfPoints[num_ids++] = IdOfPoints[i];
             }
+            IdOfPoints.resize(num_ids);
             return IdOfPoints.size() > 0;
         }
 
@@ -201,49 +183,16 @@ namespace ni
             const niBBox2d &bbox,
             niArrayT<const niPoint2d*> &pointRefs)
         {
-            tree::niKdTree *kdt = (tree::niKdTree *)m_hKdt;
             pointRefs.clear();
 
-            const tree::niKdTree::niKdNode *root = kdt->Root();
+            //the ids of the kd-tree are the indices of m_inputPoints
+            niIntArray IdOfPoints;
+            _PointsInBBox(bbox, IdOfPoints);
 
-            if (NULL == root)
-                return false;
-
-            std::stack<const tree::niKdTree::niKdNode*> stack;
-            stack.push(root);
-
-            const tree::niKdTree::niKdNode* iter;
-            double _v;
-
-            while (!stack.empty())
+            pointRefs.resize(IdOfPoints.size());
+            for (size_t i = 0; i < IdOfPoints.size(); ++i)
             {
-                iter = stack.top();
-                stack.pop();
-
-                _v = (*iter->m_refPoint2d.m_pointRef)[iter->m_axis];
-
-                if (_v < bbox.P1[iter->m_axis])
-                {
-                    if (NULL != iter->r_child)
-                        stack.push(iter->r_child);
-                }
-                else if (_v > bbox.P2[iter->m_axis])
-                {
-                    if (NULL != iter->l_child)
-                        stack.push(iter->l_child);
-                }
-                else
-                {
-                    if (!m_markers[iter->m_refPoint2d.m_IdOfPoint] &&
-                        niGeomMath2d::IsPointInBox(*iter->m_refPoint2d.m_pointRef, bbox))
-                    {
-                        pointRefs.push_back( iter->m_refPoint2d.m_pointRef );
-                    }
-                    if (NULL != iter->l_child)
-                        stack.push(iter->l_child);
-                    if (NULL != iter->r_child)
-                        stack.push(iter->r_child);
-                }
+                pointRefs[i] = &m_inputPoints[ IdOfPoints[i] ];
             }
             return pointRefs.size() > 0;
         }
@@ -272,6 +221,33 @@ namespace ni
                 return false;
             }
 
+            niTriFace2dArray faces;
+
+            if (eTMIncrementalEars == m_mode)
+            {
+                bStat = _InitIncremental();
+                if (!bStat)
+                {
+                    error_msg = "_Init error!";
+                    return false;
+                }
+
+                bStat = _ClipEarsIncremental(faces);
+                if (!bStat)
+                {
+                    error_msg = "FindEarWithMinAngle error!";
+                    return false;
+                }
+
+                bStat = tri_mesh.InitFaces(faces);
+                if (!bStat)
+                {
+                    error_msg = "MakeTriMesh error!";
+                    return false;
+                }
+                return true;
+            }
+
             bStat = _Init();
             if (!bStat)
             {
@@ -279,8 +255,6 @@ namespace ni
                 return false;
             }
 
-            niTriFace2dArray faces;
-
             int num_points = int(m_inputPoints.size());
             faces.resize(num_points-2);
             for (int i = 0; i < num_points-2; ++i)
@@ -338,6 +312,11 @@ namespace ni
                 delete kdt;
                 m_hKdt = NULL;
             }
+            if (NULL != m_arena)
+            {
+                delete []m_arena;
+                m_arena = NULL;
+            }
         }
 
         //-----------------------------------------------------------------------------
@@ -480,5 +459,450 @@ namespace ni
             --m_remain_counter;
             return true;
         }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _InitIncremental
+        //-----------------------------------------------------------------------------
+        /**
+        * Init eTMIncrementalEars: the links and angles of the verts, the grid of the
+        * reflex verts and the heap of the ears, all in one arena.
+        *
+        * @return      true:        init sucess
+        *              false:       no convex vert, or out of memory
+        */
+        bool niTriangulation2d::_InitIncremental()
+        {
+            _Destory();
+
+            int num_points = int(m_inputPoints.size());
+            if (num_points < 3)
+                return false;
+
+            //Avoid abnormal data
+            niBBox2d bbox;
+            for (int i = 0; i < num_points; ++i)
+            {
+                bbox.Append(m_inputPoints[i]);
+            }
+            niGeomMath2d::AvoidAbnormalData(10, bbox, m_inputPoints);
+
+            bbox = niBBox2d();
+            for (int i = 0; i < num_points; ++i)
+            {
+                bbox.Append(m_inputPoints[i]);
+            }
+
+            //the angles first, the reflex verts size the grid
+            int num_reflex = 0;
+            niDoubleArray angles;
+            try
+            {
+                angles.resize(num_points);
+            }
+            catch (std::bad_alloc)
+            {
+                return false;
+            }
+            for (int i = 0; i < num_points; ++i)
+            {
+                int _l = (i + num_points - 1) % num_points;
+                int _r = (i + 1) % num_points;
+                angles[i] = niGeomMath2d::Angle(
+                    m_inputPoints[i],
+                    m_inputPoints[_r],
+                    m_inputPoints[_l]);
+                if (!(angles[i] < _PI_))
+                    ++num_reflex;
+            }
+            if (num_reflex == num_points)
+                return false;
+
+            //a vert of angle 0, a spike or a repeated point, breaks the reflex test
+            m_fFlatVerts = false;
+            for (int i = 0; i < num_points; ++i)
+            {
+                if (0 == angles[i])
+                {
+                    m_fFlatVerts = true;
+                    break;
+                }
+            }
+
+            //about one reflex vert a cell
+            double width    = bbox.Xlength();
+            double height   = bbox.Ylength();
+            m_numCellsX = 1;
+            m_numCellsY = 1;
+            if (num_reflex > 1 && width > 0.0 && height > 0.0)
+            {
+                double numCellsX = sqrt(num_reflex * width / height);
+                m_numCellsX = numCellsX < 1.0 ? 1 : (numCellsX > num_reflex ? num_reflex : int(numCellsX));
+                m_numCellsY = (num_reflex + m_numCellsX - 1) / m_numCellsX;
+            }
+            m_cellScaleX = width > 0.0 ? m_numCellsX / width : 0.0;
+            m_cellScaleY = height > 0.0 ? m_numCellsY / height : 0.0;
+            m_gridOrigin = bbox.P1;
+
+            int num_cells = m_numCellsX * m_numCellsY;
+
+            size_t bytes =
+                num_points * sizeof(double) +
+                num_points * sizeof(int) * 5 +
+                (num_cells * 2 + 1) * sizeof(int) +
+                (num_reflex > 0 ? num_reflex : 1) * sizeof(int);
+            try
+            {
+                m_arena = new char[bytes];
+            }
+            catch (std::bad_alloc)
+            {
+                return false;
+            }
+
+            char *cursor = m_arena;
+            m_angles    = (double*)cursor;  cursor += num_points * sizeof(double);
+            m_prev      = (int*)cursor;     cursor += num_points * sizeof(int);
+            m_next      = (int*)cursor;     cursor += num_points * sizeof(int);
+            m_ears      = (int*)cursor;     cursor += num_points * sizeof(int);
+            m_earPos    = (int*)cursor;     cursor += num_points * sizeof(int);
+            m_cellPos   = (int*)cursor;     cursor += num_points * sizeof(int);
+            m_cellStart = (int*)cursor;     cursor += (num_cells + 1) * sizeof(int);
+            m_cellCount = (int*)cursor;     cursor += num_cells * sizeof(int);
+            m_cellItems = (int*)cursor;
+
+            for (int i = 0; i < num_points; ++i)
+            {
+                m_angles[i] = angles[i];
+                m_prev[i]   = (i + num_points - 1) % num_points;
+                m_next[i]   = (i + 1) % num_points;
+                m_earPos[i] = -1;
+                m_cellPos[i]= -1;
+            }
+
+            //reflex verts bucketed by cell
+            std::fill(m_cellCount, m_cellCount + num_cells, 0);
+            int cx, cy;
+            for (int i = 0; i < num_points; ++i)
+            {
+                if (m_angles[i] < _PI_)
+                    continue;
+                _CellOf(m_inputPoints[i], cx, cy);
+                ++m_cellCount[cy * m_numCellsX + cx];
+            }
+            m_cellStart[0] = 0;
+            for (int c = 0; c < num_cells; ++c)
+            {
+                m_cellStart[c+1] = m_cellStart[c] + m_cellCount[c];
+                m_cellCount[c] = 0;
+            }
+            for (int i = 0; i < num_points; ++i)
+            {
+                if (m_angles[i] < _PI_)
+                    continue;
+                _CellOf(m_inputPoints[i], cx, cy);
+                int c = cy * m_numCellsX + cx;
+                int pos = m_cellStart[c] + m_cellCount[c]++;
+                m_cellItems[pos]    = i;
+                m_cellPos[i]        = pos;
+            }
+
+            //heap of the ears
+            m_numEars = 0;
+            for (int i = 0; i < num_points; ++i)
+            {
+                if (m_angles[i] < _PI_ && _IsEarIncremental(i))
+                {
+                    m_earPos[i] = m_numEars;
+                    m_ears[m_numEars++] = i;
+                }
+            }
+            for (int pos = m_numEars / 2 - 1; pos >= 0; --pos)
+            {
+                _SiftEar(pos);
+            }
+
+            m_remain_counter = num_points;
+            return true;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _ClipEarsIncremental
+        //-----------------------------------------------------------------------------
+        /**
+        * Clip the ear of min angle, num_points-2 times. Only the neighbors of the ear
+        * change: their angles, their reflex state and their ear state.
+        *
+        * @param       faces:       store the triangles
+        * @return      true:        sucess
+        *              false:       no ear left
+        */
+        bool niTriangulation2d::_ClipEarsIncremental(niTriFace2dArray &faces)
+        {
+            int num_points = int(m_inputPoints.size());
+            faces.resize(num_points-2);
+            for (int i = 0; i < num_points-2; ++i)
+            {
+                if (0 == m_numEars)
+                    return false;
+
+                int _index = m_ears[0];
+                int _l = m_prev[_index];
+                int _r = m_next[_index];
+
+                faces[i].aIdx = _index;
+                faces[i].bIdx = _r;
+                faces[i].cIdx = _l;
+
+                _RemoveEar(_index);
+
+                m_next[_l] = _r;
+                m_prev[_r] = _l;
+
+                m_angles[_l] = niGeomMath2d::Angle(
+                    m_inputPoints[_l],
+                    m_inputPoints[_r],
+                    m_inputPoints[ m_prev[_l] ]);
+                m_angles[_r] = niGeomMath2d::Angle(
+                    m_inputPoints[_r],
+                    m_inputPoints[ m_next[_r] ],
+                    m_inputPoints[_l]);
+
+                //a reflex vert may turn convex, never the other way
+                if (m_angles[_l] < _PI_ && -1 != m_cellPos[_l])
+                    _DeleteReflex(_l);
+                if (m_angles[_r] < _PI_ && -1 != m_cellPos[_r])
+                    _DeleteReflex(_r);
+
+                --m_remain_counter;
+
+                _UpdateEar(_l);
+                _UpdateEar(_r);
+            }
+            return true;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _IsEarIncremental
+        //-----------------------------------------------------------------------------
+        /**
+        * Is the convex vert an ear: no reflex vert in or on its triangle.
+        * A vert in the triangle of a convex vert means a reflex vert in it too.
+        *
+        * @param       _index:      vert index
+        * @return      ture:        is ear
+        *              false:       is not ear
+        */
+        bool niTriangulation2d::_IsEarIncremental(int _index) const
+        {
+            int _l = m_prev[_index];
+            int _r = m_next[_index];
+            const niPoint2d &a = m_inputPoints[_index];
+            const niPoint2d &b = m_inputPoints[_l];
+            const niPoint2d &c = m_inputPoints[_r];
+
+            niBBox2d bbox;
+            bbox.Append(a);
+            bbox.Append(b);
+            bbox.Append(c);
+
+            double area = fabs( (b-a).Cross(c-a) );
+
+            EPointInGeometry fInGeometry;
+
+            //a ring touching itself may have a convex vert in an ear and no reflex one:
+            //test all the remaining verts, as eTMMinAngleScan does
+            if (m_fFlatVerts)
+            {
+                for (int _it = m_next[_r]; _it != _l; _it = m_next[_it])
+                {
+                    const niPoint2d &p = m_inputPoints[_it];
+                    if (!niGeomMath2d::IsPointInBox(p, bbox))
+                        continue;
+
+                    fInGeometry = niGeomMath2d::IsPointInTriangle(p, a, b, c, area);
+                    if (fInGeometry == eInGeometry || fInGeometry == eOnBorder)
+                        return false;
+                    if (fInGeometry == eErrorGeometry)
+                        return false;
+                }
+                return true;
+            }
+
+            int cx1, cy1, cx2, cy2;
+            _CellOf(bbox.P1, cx1, cy1);
+            _CellOf(bbox.P2, cx2, cy2);
+
+            for (int cy = cy1; cy <= cy2; ++cy)
+            {
+                for (int cx = cx1; cx <= cx2; ++cx)
+                {
+                    int cell = cy * m_numCellsX + cx;
+                    const int *items = m_cellItems + m_cellStart[cell];
+                    int num_items = m_cellCount[cell];
+                    for (int k = 0; k < num_items; ++k)
+                    {
+                        int _it = items[k];
+                        if (_it == _index || _it == _l || _it == _r)
+                            continue;
+
+                        const niPoint2d &p = m_inputPoints[_it];
+                        if (!niGeomMath2d::IsPointInBox(p, bbox))
+                            continue;
+
+                        fInGeometry = niGeomMath2d::IsPointInTriangle(p, a, b, c, area);
+                        if (fInGeometry == eInGeometry || fInGeometry == eOnBorder)
+                            return false;
+                        if (fInGeometry == eErrorGeometry)
+                            return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _UpdateEar
+        //-----------------------------------------------------------------------------
+        /**
+        * Test the vert again and move it in or out of the heap, by its new angle
+        *
+        * @param       _index:      vert index
+        */
+        void niTriangulation2d::_UpdateEar(int _index)
+        {
+            if (-1 != m_earPos[_index])
+                _RemoveEar(_index);
+
+            if (m_angles[_index] < _PI_ && _IsEarIncremental(_index))
+                _PushEar(_index);
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _CellOf
+        //-----------------------------------------------------------------------------
+        /**
+        * Cell of a point, clamped to the grid
+        *
+        * @param       p:           point
+        * @param       cx:          store the column
+        * @param       cy:          store the row
+        */
+        void niTriangulation2d::_CellOf(const niPoint2d &p, int &cx, int &cy) const
+        {
+            cx = int( (p.X - m_gridOrigin.X) * m_cellScaleX );
+            cy = int( (p.Y - m_gridOrigin.Y) * m_cellScaleY );
+            cx = cx < 0 ? 0 : (cx < m_numCellsX ? cx : m_numCellsX-1);
+            cy = cy < 0 ? 0 : (cy < m_numCellsY ? cy : m_numCellsY-1);
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _DeleteReflex
+        //-----------------------------------------------------------------------------
+        /**
+        * Delete a vert turned convex from the grid: the last one of its cell takes its place
+        *
+        * @param       _index:      vert index
+        */
+        void niTriangulation2d::_DeleteReflex(int _index)
+        {
+            int cx, cy;
+            _CellOf(m_inputPoints[_index], cx, cy);
+            int c = cy * m_numCellsX + cx;
+
+            int pos = m_cellPos[_index];
+            int last = m_cellStart[c] + (--m_cellCount[c]);
+
+            int moved = m_cellItems[last];
+            m_cellItems[pos] = moved;
+            m_cellPos[moved] = pos;
+            m_cellPos[_index] = -1;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _PushEar
+        //-----------------------------------------------------------------------------
+        /**
+        * Push an ear into the heap
+        *
+        * @param       _index:      vert index
+        */
+        void niTriangulation2d::_PushEar(int _index)
+        {
+            int pos = m_numEars++;
+            while (pos > 0)
+            {
+                int parent = (pos - 1) / 2;
+                if (!_IsEarBefore(_index, m_ears[parent]))
+                    break;
+                m_ears[pos] = m_ears[parent];
+                m_earPos[ m_ears[pos] ] = pos;
+                pos = parent;
+            }
+            m_ears[pos] = _index;
+            m_earPos[_index] = pos;
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _RemoveEar
+        //-----------------------------------------------------------------------------
+        /**
+        * Remove an ear from the heap: the last one takes its place
+        *
+        * @param       _index:      vert index
+        */
+        void niTriangulation2d::_RemoveEar(int _index)
+        {
+            int pos = m_earPos[_index];
+            m_earPos[_index] = -1;
+
+            int last = m_ears[--m_numEars];
+            if (last == _index)
+                return;
+
+            m_ears[pos] = last;
+            m_earPos[last] = pos;
+
+            //up when it is before its parent, else down
+            while (pos > 0)
+            {
+                int parent = (pos - 1) / 2;
+                if (!_IsEarBefore(last, m_ears[parent]))
+                    break;
+                m_ears[pos] = m_ears[parent];
+                m_earPos[ m_ears[pos] ] = pos;
+                pos = parent;
+            }
+            m_ears[pos] = last;
+            m_earPos[last] = pos;
+            _SiftEar(pos);
+        }
+
+        //-----------------------------------------------------------------------------
+        // FUNCTION _SiftEar
+        //-----------------------------------------------------------------------------
+        /**
+        * Move the ear at pos down the heap, to the place of its angle
+        *
+        * @param       pos:         position in the heap
+        */
+        void niTriangulation2d::_SiftEar(int pos)
+        {
+            int _index = m_ears[pos];
+            for (;;)
+            {
+                int child = 2 * pos + 1;
+                if (child >= m_numEars)
+                    break;
+                if (child + 1 < m_numEars && _IsEarBefore(m_ears[child+1], m_ears[child]))
+                    ++child;
+                if (!_IsEarBefore(m_ears[child], _index))
+                    break;
+                m_ears[pos] = m_ears[child];
+                m_earPos[ m_ears[pos] ] = pos;
+                pos = child;
+            }
+            m_ears[pos] = _index;
+            m_earPos[_index] = pos;
+        }
     }
-}
\ No newline at end of file
+}
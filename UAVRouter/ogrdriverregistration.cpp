@@ -0,0 +1,12 @@
+#include "ogrdriverregistration.h"
+
+#include <ogrsf_frmts.h>
+
+#include <mutex>
+
+
+void OGRDriverRegistration::RegisterAllOnce()
+{
+    static std::once_flag registered;
+    std::call_once(registered, OGRRegisterAll);
+}
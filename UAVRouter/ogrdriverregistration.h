@@ -0,0 +1,14 @@
+#ifndef OGRDRIVERREGISTRATION_H
+#define OGRDRIVERREGISTRATION_H
+
+/// OGRDriverRegistration: OGRRegisterAll exactly once per process
+/// OGRRegisterAll is not safe to run from several threads at the same time,
+/// every reader/writer calls RegisterAllOnce instead
+
+class OGRDriverRegistration
+{
+public:
+    static void RegisterAllOnce();
+};
+
+#endif // OGRDRIVERREGISTRATION_H
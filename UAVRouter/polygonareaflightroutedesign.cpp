@@ -6,6 +6,8 @@ using std::vector;
 using std::ofstream;
 #include <sstream>
 using std::ostringstream;
+#include <algorithm>
+#include <cmath>
 
 #include <QDebug>
 
@@ -15,11 +17,25 @@ using namespace Gomo::Geometry2D;
 #include "gomologging.h"
 
 PolygonAreaFlightRouteDesign::PolygonAreaFlightRouteDesign()
+    :m_isAirportleft(true),
+    m_isAirportUp(true),
+    m_forced_entry_candidate(-1),
+    m_strip_sinks(NULL),
+    m_stream_course_length_guass(0.0),
+    m_stream_count_exposures(0),
+    m_stream_count_points(0)
 {
 }
 
 PolygonAreaFlightRouteDesign::PolygonAreaFlightRouteDesign(const FlightParameter & parameter)
-    :FlightRouteDesign(parameter)
+    :FlightRouteDesign(parameter),
+    m_isAirportleft(true),
+    m_isAirportUp(true),
+    m_forced_entry_candidate(-1),
+    m_strip_sinks(NULL),
+    m_stream_course_length_guass(0.0),
+    m_stream_count_exposures(0),
+    m_stream_count_points(0)
 {
 
 }
@@ -48,6 +64,10 @@ void PolygonAreaFlightRouteDesign::DesignInGaussPlane()
 
     DesignInTransformedCoords();
 
+    PlaceAirportInTransformedCoords();
+
+    FlipOrthoPlaneOrientation(m_orthoplane_center,m_isAirportleft,m_isAirportUp);
+
     InversePlaneTransform();
 }
 
@@ -56,10 +76,262 @@ void PolygonAreaFlightRouteDesign::PerformRouteDesign()
 
     qDebug("PolygonAreaFlightRouteDesign::PerformRouteDesign()");
 
-    FlightRouteDesign::PerformRouteDesign();
+    PrepareRouteDesign();
+
+    ChainRouteDesign(m_parameter.airport);
+
+    FinishRouteDesign();
+
+}
+
+// the same steps as DesignInGaussPlane, but the airport is not known yet
+void PolygonAreaFlightRouteDesign::PrepareRouteDesign()
+{
+    qDebug("PolygonAreaFlightRouteDesign::PrepareRouteDesign()");
+
+    GaussProjectionOfRegion();
+
+    Point2DArray region_Points_GaussCoords;
+
+    GeomertyConvertor::OGRGeomery2Point2DArray(m_FightRegion_Gauss.get(),region_Points_GaussCoords);
+
+    CalculatePolygonOrientaion(region_Points_GaussCoords,m_region_center_GuassProj,m_angle_region_GuassProj);
+
+    ostringstream streamdebug;
+    streamdebug.str("");
+    streamdebug<< "PolygonAreaFlightRouteDesign::PrepareRouteDesign(): CalculatePolygonOrientaion"<<std::endl;
+    streamdebug<<"region_center="<<m_region_center_GuassProj.X<<","<<m_region_center_GuassProj.Y<<"  "<<"angle="<<m_angle_region_GuassProj<<std::endl;
+    qDebug(streamdebug.str().c_str());
 
+    PlaneTransformOfRegion(region_Points_GaussCoords);
+
+    DesignInTransformedCoords();
 }
 
+UAVFlightPoint PolygonAreaFlightRouteDesign::ChainRouteDesign(const Airport & airport)
+{
+    qDebug("PolygonAreaFlightRouteDesign::ChainRouteDesign()");
+
+    m_parameter.airport = airport;
+
+    GaussProjectionOfAirport();
+
+    Point2D pt_AirportLoc_Gauss;
+    GeomertyConvertor::OGRPoint2Point2D(m_AirportLoc_Gauss,pt_AirportLoc_Gauss);
+
+    PlaneTransformOfAirport(pt_AirportLoc_Gauss);
+
+    PlaceAirportInTransformedCoords();
+
+    // the flip planned by the caller instead of the one of the airport
+    if(m_forced_entry_candidate>=0)
+    {
+        m_isAirportleft = (m_forced_entry_candidate & 1)==0;
+        m_isAirportUp   = (m_forced_entry_candidate & 2)==0;
+    }
+
+    if(m_route_columns_plane.Empty())
+    {
+        throw "no flight point in the region, PolygonAreaFlightRouteDesign::ChainRouteDesign";
+    }
+
+    // the last flight point as FinishRouteDesign will create it
+    return OrthoPlanePointToWGS84(m_route_columns_plane.GetPoint(m_route_columns_plane.Size()-1),
+                                  m_orthoplane_center,m_isAirportleft,m_isAirportUp);
+}
+
+// candidate c flips the design plane by isAirportleft=!(c&1), isAirportUp=!(c&2)
+void PolygonAreaFlightRouteDesign::GetEntryExitCandidates(std::vector<RouteEntryExit> & candidates)
+{
+    candidates.clear();
+
+    if(m_route_columns_plane.Empty())
+    {
+        return;
+    }
+
+    // the flip center does not depend on the airport
+    Point2D orthoplane_center = (m_mbr_leftTop_planetransformed+m_mbr_rightBot_planetransformed)/2.0;
+
+    for(int c=0; c<4; c++)
+    {
+        bool isAirportleft = (c & 1)==0;
+        bool isAirportUp   = (c & 2)==0;
+
+        RouteEntryExit candidate;
+        candidate.entry = OrthoPlanePointToWGS84(m_route_columns_plane.GetPoint(0),
+                                                 orthoplane_center,isAirportleft,isAirportUp);
+        candidate.exit  = OrthoPlanePointToWGS84(m_route_columns_plane.GetPoint(m_route_columns_plane.Size()-1),
+                                                 orthoplane_center,isAirportleft,isAirportUp);
+        candidates.push_back(candidate);
+    }
+}
+
+void PolygonAreaFlightRouteDesign::SetEntryExitCandidate(int index)
+{
+    m_forced_entry_candidate = (index>=0 && index<4) ? index : -1;
+}
+
+UAVFlightPoint PolygonAreaFlightRouteDesign::OrthoPlanePointToWGS84(
+        UAVFlightPoint pt_plane,
+        const Point2D & orthoplane_center,
+        bool isAirportleft,
+        bool isAirportUp)
+{
+    Point2D pt = FlipOrthoPlanePoint(pt_plane.ToGomoPoint2D(),orthoplane_center,isAirportleft,isAirportUp);
+    Point2D pt_guass = InversePlaneTransformPoint(pt);
+
+    pt_plane.__longitude = pt_guass.X;
+    pt_plane.__latitude  = pt_guass.Y;
+
+    return InverseGaussProjectionOfPoint(pt_plane);
+}
+
+void PolygonAreaFlightRouteDesign::FinishRouteDesign()
+{
+    qDebug("PolygonAreaFlightRouteDesign::FinishRouteDesign()");
+
+    FlipOrthoPlaneOrientation(m_orthoplane_center,m_isAirportleft,m_isAirportUp);
+
+    InversePlaneTransform();
+
+    InverseGaussProjection();
+}
+
+
+
+// PrepareRouteDesign and ChainRouteDesign, but the airport is placed before the strips are designed
+// so that DesignInTransformedCoords can hand over each strip as it is created
+size_t PolygonAreaFlightRouteDesign::StreamRouteDesign()
+{
+    qDebug("PolygonAreaFlightRouteDesign::StreamRouteDesign()");
+
+    FanOutRouteSink sinks;
+    CreateOutputSinks(sinks);
+
+    GaussProjectionOfRegion();
+
+    Point2DArray region_Points_GaussCoords;
+
+    GeomertyConvertor::OGRGeomery2Point2DArray(m_FightRegion_Gauss.get(),region_Points_GaussCoords);
+
+    CalculatePolygonOrientaion(region_Points_GaussCoords,m_region_center_GuassProj,m_angle_region_GuassProj);
+
+    PlaneTransformOfRegion(region_Points_GaussCoords);
+
+    GaussProjectionOfAirport();
+
+    Point2D pt_AirportLoc_Gauss;
+    GeomertyConvertor::OGRPoint2Point2D(m_AirportLoc_Gauss,pt_AirportLoc_Gauss);
+
+    PlaneTransformOfAirport(pt_AirportLoc_Gauss);
+
+    // the same MBR as DesignInTransformedCoords
+    MBR2D(m_region_polygonPoints_planetransformed,m_mbr_leftTop_planetransformed,m_mbr_rightBot_planetransformed);
+
+    PlaceAirportInTransformedCoords();
+
+    //header
+    UAVRouteHEADER header;
+    FillRouteHeader(header);
+
+    sinks.BeginRoute(header);
+
+    //strips
+    m_strip_sinks = &sinks;
+    m_stream_prev_point_guass.__strip_id = 0;
+    m_stream_course_length_guass = 0.0;
+    m_stream_count_exposures = 0;
+    m_stream_count_points = 0;
+
+    try
+    {
+        DesignInTransformedCoords();
+    }
+    catch(...)
+    {
+        m_strip_sinks = NULL;
+        throw;
+    }
+
+    m_strip_sinks = NULL;
+
+    //statistic
+    UAVFlightStatisticInfo statistic;
+    statistic.__count_exposures   = m_stream_count_exposures;
+    statistic.__count_strips      = m_route_design_plane.__flight_statistic.__count_strips;
+    statistic.__flight_region_area= dynamic_cast<OGRPolygon*>(m_FightRegion_Gauss.get())->get_Area();
+    statistic.__photo_flight_course_chainage = m_stream_course_length_guass;
+    statistic.__MBR_Area          = m_route_design_plane.__flight_statistic.__MBR_Area;
+
+    sinks.EndRoute(statistic);
+
+    ostringstream streamdebug;
+    streamdebug<< "StreamRouteDesign: "<<m_stream_count_points<<" flight points in "
+               <<statistic.__count_strips<<" strips"<<std::endl;
+    qDebug(streamdebug.str().c_str());
+
+    return m_stream_count_points;
+}
+
+// the steps of FlipOrthoPlaneOrientation, InversePlaneTransform and InverseGaussProjection on one strip
+void PolygonAreaFlightRouteDesign::StreamCurrentStrip()
+{
+    if(m_strip_sinks==NULL || m_current_strip.__flight_point.empty())
+    {
+        return;
+    }
+
+    const std::vector<UAVFlightPoint> & points_plane = m_current_strip.__flight_point;
+    size_t count_points = points_plane.size();
+
+    m_stream_columns.Clear();
+    m_stream_columns.Append(&points_plane[0],count_points);
+
+    double * x = m_stream_columns.GetX();
+    double * y = m_stream_columns.GetY();
+    const BYTE8 * strip_ids = m_stream_columns.GetStripIds();
+
+    if(m_isAirportleft==false)
+    {
+        UAVRouteColumns::FlipColumn(x,count_points,m_orthoplane_center.X);
+    }
+
+    if(m_isAirportUp==false)
+    {
+        UAVRouteColumns::FlipColumn(y,count_points,m_orthoplane_center.Y);
+    }
+
+    UAVRouteColumns::RotateTranslate(x,y,count_points,m_angle_region_GuassProj,m_region_center_GuassProj);
+
+    m_stream_count_exposures += UAVRouteColumns::CountPointType(m_stream_columns.GetPointTypes(),
+                                                                count_points,FLIGTH_POINT_TYPE_EXPOSURE);
+
+    // the first point continues the last one of the previous strip
+    if( m_stream_prev_point_guass.__strip_id == strip_ids[0] )
+    {
+        double dx = x[0]- m_stream_prev_point_guass.__longitude;
+        double dy = y[0]- m_stream_prev_point_guass.__latitude;
+        m_stream_course_length_guass += sqrt(dx*dx + dy*dy);
+    }
+
+    UAVRouteColumns::AddCourseLength(x,y,strip_ids,count_points,m_stream_course_length_guass);
+
+    m_stream_prev_point_guass.__strip_id  = strip_ids[count_points-1];
+    m_stream_prev_point_guass.__longitude = x[count_points-1];
+    m_stream_prev_point_guass.__latitude  = y[count_points-1];
+
+    m_stream_columns.FillZ(m_parameter.FightHeight);
+
+    m_projector->Inverse((int)count_points,x,y,m_stream_columns.GetZ());
+
+    m_stream_strip.clear();
+    m_stream_columns.GetPoints(m_stream_strip);
+
+    m_strip_sinks->AddStrip(&m_stream_strip[0],count_points);
+
+    m_stream_count_points += count_points;
+}
 
 
 bool PolygonAreaFlightRouteDesign::CalculatePolygonOrientaion(const Point2DArray&  polygon_2d,Point2D& center,double& angle)
@@ -71,6 +343,33 @@ bool PolygonAreaFlightRouteDesign::CalculatePolygonOrientaion(const Point2DArray
 
     Polygon_orien.SetExtendBaseLineLength(m_baseline_length*(m_parameter.RedudantBaselines+1)*2);
 
+    if(m_parameter.OrientationByFlightLength)
+    {
+        Polygon_orien.SetObjective(PolygonOrientation2D::OBJECTIVE_FLIGHT_LENGTH,m_cross_strip_distance);
+    }
+
+    if(m_parameter.OrientationSweepResolution > 0.0)
+    {
+        // the whole route: strips, turns, and the legs from and back to the airport of the job
+        RouteCostModel cost_model;
+        cost_model.baseline_length      = m_baseline_length;
+        cost_model.redundant_baselines  = m_parameter.RedudantBaselines;
+        cost_model.guidance_distance    = m_parameter.GuidanceEntrancePointsDistance;
+        cost_model.cross_strip_distance = m_cross_strip_distance;
+        cost_model.clip_strips          = m_parameter.ClipStripsToRegion;
+
+        double x_airport = m_parameter.airport.getX();
+        double y_airport = m_parameter.airport.getY();
+        if(m_projector.get()!=NULL && m_projector->Forward(1,&x_airport,&y_airport))
+        {
+            cost_model.has_airport = true;
+            cost_model.airport = Point2D(x_airport,y_airport) - center;
+        }
+
+        Polygon_orien.SetRouteCostModel(cost_model);
+        Polygon_orien.SetAngleSweep(m_parameter.OrientationSweepResolution*_PI_/180.0);
+    }
+
     return Polygon_orien.GetOptimalOrientation(angle);
 
 
@@ -87,6 +386,14 @@ void PolygonAreaFlightRouteDesign::PlaneTransform(
         const Point2D & ptAirport)
 {
     qDebug("PolygonAreaFlightRouteDesign::PlaneTransform()");
+
+    PlaneTransformOfRegion(polygonPoints_gauss);
+
+    PlaneTransformOfAirport(ptAirport);
+}
+
+void PolygonAreaFlightRouteDesign::PlaneTransformOfRegion(const Point2DArray & polygonPoints_gauss)
+{
     ostringstream streamdebug;
     streamdebug.str("");
 
@@ -99,9 +406,8 @@ void PolygonAreaFlightRouteDesign::PlaneTransform(
     for ( ; it!=polygonPoints_gauss.end(); it++)
     {
         // 1. first translate the origin point to m_region_center_GuassProj, ie centralized
-        Point2D point_centralized = *it - m_region_center_GuassProj;
         // 2. rotate the points, in order to make m_angle_region_GuassProj as the x-axis of Guass plane coords sys
-        Point2D point_rotated     = Rotate2D( point_centralized, -m_angle_region_GuassProj);
+        Point2D point_rotated     = PlaneTransformPoint(*it);
         m_region_polygonPoints_planetransformed.push_back(point_rotated);
         streamdebug<<"("<<point_rotated.X<<","<<point_rotated.Y<<")  ";
 
@@ -110,27 +416,29 @@ void PolygonAreaFlightRouteDesign::PlaneTransform(
 
     streamdebug<<std::endl<<"sum of points roated:"<<sum_verify.X<<","<<sum_verify.Y<<")  ";//sum of points roated:1.06593e-009,-7.45786e-011)
 
-    Point2D pt_airport_centralized = ptAirport - m_region_center_GuassProj;
-    m_airport_planetransformed     = Rotate2D( pt_airport_centralized, -m_angle_region_GuassProj);
-    streamdebug<<std::endl<<"airport after plane tranform: ("<<m_airport_planetransformed.X<<","<<m_airport_planetransformed.Y<<")  ";
-
     qDebug(streamdebug.str().c_str());
+}
+
+void PolygonAreaFlightRouteDesign::PlaneTransformOfAirport(const Point2D & ptAirport)
+{
+    ostringstream streamdebug;
+    streamdebug.str("");
+
+    m_airport_planetransformed     = PlaneTransformPoint(ptAirport);
+    streamdebug<<"airport after plane tranform: ("<<m_airport_planetransformed.X<<","<<m_airport_planetransformed.Y<<")  ";
 
+    qDebug(streamdebug.str().c_str());
 }
 
 // recover the coods to gauss projection
 void PolygonAreaFlightRouteDesign::InversePlaneTransform()
 {
-    GomoLogging * pLog = GomoLogging::GetInstancePtr();
-
-
     qDebug("PolygonAreaFlightRouteDesign::InversePlaneTransform()");
     ostringstream streamdebug;
     streamdebug.str("");
 
     //verify header, ie, airport
-    Point2D pt_airport_centralized = Rotate2D( m_airport_planetransformed, m_angle_region_GuassProj);
-    Point2D airport_guass_recovered= pt_airport_centralized + m_region_center_GuassProj;
+    Point2D airport_guass_recovered= InversePlaneTransformPoint(m_airport_planetransformed);
     Point2D pt_AirportLoc_Gauss;
     GeomertyConvertor::OGRPoint2Point2D(m_AirportLoc_Gauss,pt_AirportLoc_Gauss);
     if (airport_guass_recovered == pt_AirportLoc_Gauss)
@@ -146,52 +454,23 @@ void PolygonAreaFlightRouteDesign::InversePlaneTransform()
 
     qDebug(streamdebug.str().c_str());
 
-    //points
-    unsigned int count_exposure = 0;
-    std::vector< UAVFlightPoint >::iterator it= m_route_design_plane.__flight_point.begin();
-
-    UAVFlightPoint prevPt;
-    prevPt.__strip_id=0;
-    double course_length_guass =0.0;
-
-    for( ; it!= m_route_design_plane.__flight_point.end() ; it++ )
-    {
-        UAVFlightPoint flight_pt_guass;
-        flight_pt_guass.__strip_id         = (*it).__strip_id;
-        flight_pt_guass.__id_in_strip      = (*it).__id_in_strip;
-        flight_pt_guass.__flight_point_type= (*it).__flight_point_type;
-
-        Point2D pt((*it).__longitude,(*it).__latitude);
-        Point2D pt_guass_recover = m_region_center_GuassProj + Rotate2D( pt, m_angle_region_GuassProj);
+    //points, appended to the gauss columns and transformed there
+    size_t first_point  = m_route_columns_gauss.Size();
+    size_t count_points = m_route_columns_plane.Size();
 
-        flight_pt_guass.__longitude = pt_guass_recover.X;
-        flight_pt_guass.__latitude  = pt_guass_recover.Y;
+    m_route_columns_gauss.Append(m_route_columns_plane);
 
-        m_route_design_CaussProj.__flight_point.push_back(flight_pt_guass);
+    double * x_guass = m_route_columns_gauss.GetX()+ first_point;
+    double * y_guass = m_route_columns_gauss.GetY()+ first_point;
 
-        if (flight_pt_guass.__flight_point_type == FLIGTH_POINT_TYPE_EXPOSURE)
-        {
-            count_exposure++;
-        }
+    UAVRouteColumns::RotateTranslate(x_guass,y_guass,count_points,m_angle_region_GuassProj,m_region_center_GuassProj);
 
-        if( prevPt.__strip_id == flight_pt_guass.__strip_id  )
-        {
-            double dist_pts=pt_guass_recover.DistanceTo(prevPt.__longitude,prevPt.__latitude);
-            course_length_guass += dist_pts;
-            streamdebug.str("");
-            streamdebug<<"prePoint:"
-                      <<"longitude"<<prevPt.__longitude
-                      <<"latitude" <<prevPt.__latitude << std::endl;
-            streamdebug<<"current:"
-                      <<"longitude"<<pt_guass_recover.X
-                      <<"latitude" <<pt_guass_recover.Y<< std::endl;
-            streamdebug<<"dist of points in guass: "<<dist_pts<<std::endl;
-            std::string logstr = streamdebug.str();
-            pLog->logging(logstr);
-        }
+    unsigned int count_exposure = UAVRouteColumns::CountPointType(m_route_columns_gauss.GetPointTypes()+ first_point,
+                                                                  count_points,FLIGTH_POINT_TYPE_EXPOSURE);
 
-        prevPt = flight_pt_guass;
-    }
+    double course_length_guass =0.0;
+    UAVRouteColumns::AddCourseLength(x_guass,y_guass,m_route_columns_gauss.GetStripIds()+ first_point,
+                                     count_points,course_length_guass);
 
     //statistic
     streamdebug.str("");
@@ -223,33 +502,19 @@ void PolygonAreaFlightRouteDesign::DesignInTransformedCoords()
     qDebug("PolygonAreaFlightRouteDesign::DesignInTransformedCoords()");
 
     //-----------------------------------
-    // 1.Header
-    //-----------------------------------
-    m_route_design_plane.__header.airport_height = m_parameter.airport.getZ();
-    m_route_design_plane.__header.airport_longitude = m_airport_planetransformed.X;
-    m_route_design_plane.__header.airport_latitude  = m_airport_planetransformed.Y;
-
-    //-----------------------------------
-    // 2.main: create flight points in strips
+    // 1.main: create flight points in strips
     //-----------------------------------
     // figure out the MBR of the region after plane transformed
     Point2D leftTop,rightBot;
     MBR2D(m_region_polygonPoints_planetransformed,leftTop,rightBot);
+    m_mbr_leftTop_planetransformed  = leftTop;
+    m_mbr_rightBot_planetransformed = rightBot;
     ostringstream streamdebug;
     streamdebug.str("");
     streamdebug<<"mbr of the polygon after transform: ("<<leftTop.X<<","<<leftTop.Y<<") - ("
               <<rightBot.X<<","<<rightBot.Y<<")"<<std::endl;
     qDebug(streamdebug.str().c_str());
 
-
-    //caculate the orientation of plane,
-    // if the airport near the lefttop, then make the first strip start from lefttop,
-    // otherwise the coordinate should be mirrored by x or y to make this is the case
-    bool isAirportleft  =true;
-    bool isAirportUp =true;
-    Point2D orthoplane_center(0,0);
-    AirportOrientationInOrthoPlane(m_airport_planetransformed,leftTop,rightBot,orthoplane_center,isAirportleft,isAirportUp);
-
     streamdebug.str("");
 
     // create strips from left top of MBR of flight region        
@@ -259,13 +524,18 @@ void PolygonAreaFlightRouteDesign::DesignInTransformedCoords()
     float mbr_height =fabs(leftTop.Y - rightBot.Y);
     bool isSingleStrip = fabs(m_cross_strip_distance) >  mbr_height*1.2;
 
-    if(isSingleStrip)
+    if(m_parameter.ClipStripsToRegion)
+    {
+        course_length = DesignClippedStrips(leftTop,rightBot,isSingleStrip,strip_seq);
+    }
+    else if(isSingleStrip)
     {
         //create the single strip in the center of the y coordinate
         //Create the first strip
         float current_strip_y = (leftTop.Y+ rightBot.Y)/2.0;
         double strip_legth=CreateFirstStrip(strip_seq,current_strip_y,leftTop.X,rightBot.X);
         course_length += strip_legth;
+        StreamCurrentStrip();
 
         streamdebug<<"CreateSingleStrip: "<<std::endl;
         qDebug(streamdebug.str().c_str());
@@ -277,6 +547,7 @@ void PolygonAreaFlightRouteDesign::DesignInTransformedCoords()
         float current_strip_y = leftTop.Y;
         double strip_legth=CreateFirstStrip(strip_seq,current_strip_y,leftTop.X,rightBot.X);
         course_length += strip_legth;
+        StreamCurrentStrip();
 
         streamdebug<<"CreateFirstStrip: "<<std::endl;
         qDebug(streamdebug.str().c_str());
@@ -289,15 +560,13 @@ void PolygonAreaFlightRouteDesign::DesignInTransformedCoords()
             current_strip_y -= m_cross_strip_distance;
             strip_legth=CreateNewStripBasedOnLastStrip(strip_seq,current_strip_y);
             course_length += strip_legth;
+            StreamCurrentStrip();
         }
 
     }
 
 
-    // flip the flight points on the design plane according to the relative position of airport to lefttop
-    //if isAirportleft==false, then flip the flight points on X axis
-    //if isAirportUp == false, then flip the flight points on Y axis
-    FlipOrthoPlaneOrientation(orthoplane_center,isAirportleft,isAirportUp);
+    // the flight points are flipped later by FlipOrthoPlaneOrientation, when the airport is known
 
     //-----------------------------------
     // 2.statistic
@@ -312,6 +581,151 @@ void PolygonAreaFlightRouteDesign::DesignInTransformedCoords()
     qDebug(streamdebug.str().c_str());
 }
 
+double PolygonAreaFlightRouteDesign::DesignClippedStrips(
+        const Point2D & leftTop,
+        const Point2D & rightBot,
+        bool isSingleStrip,
+        int & count_strips)
+{
+    std::vector<double> strips_y;
+    double band_half_height = 0.0;
+    RouteCostModel::StripLines(rightBot.Y,leftTop.Y,m_cross_strip_distance,isSingleStrip,strips_y,band_half_height);
+
+    std::vector< std::vector<StripInterval> > strips_intervals;
+    ClipStripsToRegion(strips_y,band_half_height,strips_intervals);
+
+    // the strips outside of the region are dropped, the others keep on alternating the direction
+    double course_length = 0.0;
+    count_strips = 0;
+    for(size_t i=0; i<strips_y.size(); i++ )
+    {
+        if(strips_intervals[i].empty())
+        {
+            continue;
+        }
+        course_length += CreateClippedStrip(count_strips+1,strips_y[i],leftTop.X,strips_intervals[i],(count_strips%2)==1);
+        StreamCurrentStrip();
+        count_strips++;
+    }
+
+    if(count_strips==0)
+    {
+        throw "no strip intersects the region, PolygonAreaFlightRouteDesign::DesignClippedStrips";
+    }
+
+    ostringstream streamdebug;
+    streamdebug<<"DesignClippedStrips: "<<count_strips<<" of "<<strips_y.size()<<" strips, course length "
+              <<course_length<<std::endl;
+    qDebug(streamdebug.str().c_str());
+
+    return course_length;
+}
+
+void PolygonAreaFlightRouteDesign::ClipStripsToRegion(
+        const std::vector<double> & strips_y,
+        double band_half_height,
+        std::vector< std::vector<StripInterval> > & strips_intervals) const
+{
+    ClipStripsToPolygon(m_region_polygonPoints_planetransformed,strips_y,band_half_height,strips_intervals);
+}
+
+double PolygonAreaFlightRouteDesign::CreateClippedStrip(
+        int strip_id,
+        double current_strip_y,
+        double grid_origin_x,
+        const std::vector<StripInterval> & intervals,
+        bool reverse)
+{
+    m_current_strip.Clear();
+
+    if(intervals.empty())
+    {
+        return 0.0;
+    }
+
+    // the exposures of the grid covering each interval, as CreateFirstStrip covers
+    // [first_valid_exposure_x,last_valid_exposure_x], with the reductant baselines around each run
+    long long redudant = m_parameter.RedudantBaselines;
+    std::vector<double> exposures_x;
+    long long last_k = 0;
+    for(size_t i=0; i<intervals.size(); i++ )
+    {
+        long long first = (long long)floor((intervals[i].first - grid_origin_x)/m_baseline_length) - redudant;
+        long long last  = (long long)ceil ((intervals[i].second- grid_origin_x)/m_baseline_length) + redudant;
+        if(!exposures_x.empty() && first <= last_k)
+        {
+            first = last_k+1;
+        }
+        for(long long k=first; k<=last; k++ )
+        {
+            exposures_x.push_back(grid_origin_x + k*m_baseline_length);
+            last_k = k;
+        }
+    }
+
+    double x_entrance     = exposures_x.front() - m_baseline_length;
+    double x_exit         = exposures_x.back()  + m_baseline_length;
+    double x_guidance     = x_entrance - m_parameter.GuidanceEntrancePointsDistance;
+    double x_guidance_end = x_exit     + m_parameter.GuidanceEntrancePointsDistance;
+
+    unsigned int count_exposures = (unsigned int)exposures_x.size();
+
+    if(!reverse)
+    {
+        //A1:Guidance start, A2:entrance
+        CreateNewFilghtPoint(strip_id,1,(enumFlightPointType)(FLIGTH_POINT_TYPE_GUIDE | FLIGTH_POINT_TYPE_A_POINT_MASK),x_guidance,current_strip_y);
+        CreateNewFilghtPoint(strip_id,2,(enumFlightPointType)(FLIGTH_POINT_TYPE_ETRANCE_EXIT | FLIGTH_POINT_TYPE_A_POINT_MASK),x_entrance,current_strip_y);
+
+        for(unsigned int i=0; i<count_exposures; i++ )
+        {
+            CreateNewFilghtPoint(strip_id,i+1,FLIGTH_POINT_TYPE_EXPOSURE,exposures_x[i],current_strip_y);
+        }
+
+        //B2:exit, B1:Guidance end
+        CreateNewFilghtPoint(strip_id,0,(enumFlightPointType)(FLIGTH_POINT_TYPE_ETRANCE_EXIT | FLIGTH_POINT_TYPE_B_POINT_MASK),x_exit,current_strip_y);
+        CreateNewFilghtPoint(strip_id,0,(enumFlightPointType)(FLIGTH_POINT_TYPE_GUIDE | FLIGTH_POINT_TYPE_B_POINT_MASK),x_guidance_end,current_strip_y);
+    }
+    else
+    {
+        // as CreateNewStripBasedOnLastStrip: A points on the right
+        CreateNewFilghtPoint(strip_id,0,(enumFlightPointType)(FLIGTH_POINT_TYPE_GUIDE | FLIGTH_POINT_TYPE_A_POINT_MASK),x_guidance_end,current_strip_y);
+        CreateNewFilghtPoint(strip_id,0,(enumFlightPointType)(FLIGTH_POINT_TYPE_ETRANCE_EXIT | FLIGTH_POINT_TYPE_A_POINT_MASK),x_exit,current_strip_y);
+
+        for(unsigned int i=0; i<count_exposures; i++ )
+        {
+            CreateNewFilghtPoint(strip_id,i+1,FLIGTH_POINT_TYPE_EXPOSURE,exposures_x[count_exposures-1-i],current_strip_y);
+        }
+
+        CreateNewFilghtPoint(strip_id,0,(enumFlightPointType)(FLIGTH_POINT_TYPE_ETRANCE_EXIT | FLIGTH_POINT_TYPE_B_POINT_MASK),x_entrance,current_strip_y);
+        CreateNewFilghtPoint(strip_id,0,(enumFlightPointType)(FLIGTH_POINT_TYPE_GUIDE | FLIGTH_POINT_TYPE_B_POINT_MASK),x_guidance,current_strip_y);
+    }
+
+    return x_guidance_end - x_guidance;
+}
+
+void PolygonAreaFlightRouteDesign::PlaceAirportInTransformedCoords()
+{
+    //-----------------------------------
+    // Header
+    //-----------------------------------
+    m_route_design_plane.__header.airport_height = m_parameter.airport.getZ();
+    m_route_design_plane.__header.airport_longitude = m_airport_planetransformed.X;
+    m_route_design_plane.__header.airport_latitude  = m_airport_planetransformed.Y;
+
+    //caculate the orientation of plane,
+    // if the airport near the lefttop, then make the first strip start from lefttop,
+    // otherwise the coordinate should be mirrored by x or y to make this is the case
+    m_isAirportleft  =true;
+    m_isAirportUp =true;
+    m_orthoplane_center = Point2D(0,0);
+    AirportOrientationInOrthoPlane(m_airport_planetransformed,
+                                   m_mbr_leftTop_planetransformed,
+                                   m_mbr_rightBot_planetransformed,
+                                   m_orthoplane_center,
+                                   m_isAirportleft,
+                                   m_isAirportUp);
+}
+
 // create the first strip(paralle with x axis)
 double PolygonAreaFlightRouteDesign::CreateFirstStrip(
         int strip_id,
@@ -568,7 +982,12 @@ void PolygonAreaFlightRouteDesign::CreateNewFilghtPoint(
     pt.__flight_point_type = ptType;
     pt.__longitude= longitude;
     pt.__latitude = latitude;
-    m_route_design_plane.__flight_point.push_back(pt);
+
+    // streamed strip by strip by StreamCurrentStrip instead
+    if(m_strip_sinks==NULL)
+    {
+        m_route_columns_plane.PushBack(pt);
+    }
 
     m_current_strip.AddPoint(pt);
 
@@ -600,18 +1019,15 @@ void PolygonAreaFlightRouteDesign::FlipOrthoPlaneOrientation(
         bool isAirportleft,
         bool isAirportUp)
 {
-    std::vector< UAVFlightPoint >::iterator it= m_route_design_plane.__flight_point.begin();
-
-    for( ; it!= m_route_design_plane.__flight_point.end() ; it++ )
+    //flip operation, one column at a time
+    if(isAirportleft==false)
     {
-        Point2D curfightpt = it->ToGomoPoint2D();
-
-        //flip operation
-        curfightpt.X= (isAirportleft==true) ? curfightpt.X : -(curfightpt.X- orthoplane_center.X)+ orthoplane_center.X;
-        curfightpt.Y= (isAirportUp  ==true) ? curfightpt.Y : -(curfightpt.Y- orthoplane_center.Y)+ orthoplane_center.Y;
+        UAVRouteColumns::FlipColumn(m_route_columns_plane.GetX(),m_route_columns_plane.Size(),orthoplane_center.X);
+    }
 
-        it->__longitude = curfightpt.X;
-        it->__latitude  = curfightpt.Y;
+    if(isAirportUp==false)
+    {
+        UAVRouteColumns::FlipColumn(m_route_columns_plane.GetY(),m_route_columns_plane.Size(),orthoplane_center.Y);
     }
 
 }
@@ -3,6 +3,8 @@
 
 #include "flightroutedesign.h"
 
+#include <utility>
+
 
 
 class PolygonAreaFlightRouteDesign : public FlightRouteDesign
@@ -14,6 +16,19 @@ public:
     void PerformRouteDesign();
     virtual void OutputRouteFile( );
 
+    //each strip is flipped, transformed back to WGS84 and written as soon as it is designed,
+    //the route is never kept as a whole
+    virtual size_t StreamRouteDesign();
+
+    //the strips are designed in PrepareRouteDesign, the airport only decides the flip of them
+    virtual void PrepareRouteDesign();
+    virtual UAVFlightPoint ChainRouteDesign(const Airport & airport);
+    virtual void FinishRouteDesign();
+
+    //4 candidates, one per flip of the design plane, i.e. per corner of the region MBR to start from
+    virtual void GetEntryExitCandidates(std::vector<RouteEntryExit> & candidates);
+    virtual void SetEntryExitCandidate(int index);
+
     //overide
 protected:
     virtual void DesignInGaussPlane();
@@ -35,6 +50,13 @@ protected:
     // 1.rotate the gauss projection axis to the m_angle_region, which is the orientation of the flight polygon
     // 2.move the gauss projection origin to m_region_center
     void PlaneTransform(const Point2DArray & polygonPoints_gauss, const Point2D & ptAirport );
+    void PlaneTransformOfRegion(const Point2DArray & polygonPoints_gauss);
+    void PlaneTransformOfAirport(const Point2D & ptAirport);
+
+    inline Point2D PlaneTransformPoint(const Point2D & pt_gauss) const {
+        return Rotate2D( pt_gauss - m_region_center_GuassProj, -m_angle_region_GuassProj); };
+    inline Point2D InversePlaneTransformPoint(const Point2D & pt) const {
+        return m_region_center_GuassProj + Rotate2D( pt, m_angle_region_GuassProj); };
 
     // recover the coods to gauss projection
     void InversePlaneTransform();
@@ -44,11 +66,32 @@ protected:
     ///
     void DesignInTransformedCoords();
 
+    // FlightParameter::ClipStripsToRegion: the strips of DesignInTransformedCoords clipped to the region
+    // return: the course length of all the strips
+    double DesignClippedStrips(const Point2D & leftTop, const Point2D & rightBot, bool isSingleStrip, int & count_strips);
+
+    // ClipStripsToPolygon of the region: the x intervals of the region within the band
+    // [y-band_half_height, y+band_half_height] of each strip, strips_y in descending order
+    void ClipStripsToRegion(const std::vector<double> & strips_y,
+                            double band_half_height,
+                            std::vector< std::vector< std::pair<double,double> > > & strips_intervals) const;
+
+    // the airport dependent part of DesignInTransformedCoords: decide the flip of the design plane
+    void PlaceAirportInTransformedCoords();
+
     // to make sure the Airport be put near the lefttop of the flight region box
     void FlipOrthoPlaneOrientation(Point2D orthoplane_center,
                                     bool isAirportleft,
                                     bool isAirportUp);
 
+    static inline Point2D FlipOrthoPlanePoint(Point2D pt,
+                                              const Point2D & orthoplane_center,
+                                              bool isAirportleft,
+                                              bool isAirportUp) {
+        pt.X= (isAirportleft==true) ? pt.X : -(pt.X- orthoplane_center.X)+ orthoplane_center.X;
+        pt.Y= (isAirportUp  ==true) ? pt.Y : -(pt.Y- orthoplane_center.Y)+ orthoplane_center.Y;
+        return pt; };
+
     //"Ortho Plane" is infact the plane after "PlaneTransform"
     // here we should figure out the relative orientation of the airport to the original point of "Ortho Plane";
     // then we could make a mirror transform to the output flight points to make the first flight point close to airport
@@ -61,6 +104,16 @@ protected:
             bool& isAirportUp);
 
 
+    // StreamRouteDesign: m_current_strip flipped, back to WGS84 and to the sinks, with the statistic of it
+    void StreamCurrentStrip();
+
+    // a flight point of the design plane, flipped, back to WGS84
+    UAVFlightPoint OrthoPlanePointToWGS84(UAVFlightPoint pt_plane,
+                                          const Point2D & orthoplane_center,
+                                          bool isAirportleft,
+                                          bool isAirportUp);
+
+
     ///
     ///lowest level: OrthoPlane,ie, design plane: strip parralle with X axis, and Airport close to left top of the region mbr
     ///
@@ -79,6 +132,15 @@ protected:
     // reuse the x coordinates of the last strip but in a reverse direction
     double CreateNewStripBasedOnLastStrip(int strip_id,double current_strip_y);
 
+    // a strip with the exposures of the grid x=grid_origin_x+k*baseline covering the intervals,
+    // plus the reductant baselines of each run; flown from right to left if reverse
+    // return: the length of strip, 0 and no flight point if intervals is empty
+    double CreateClippedStrip(int strip_id,
+                              double current_strip_y,
+                              double grid_origin_x,
+                              const std::vector< std::pair<double,double> > & intervals,
+                              bool reverse);
+
 protected:
 
     Point2DArray m_region_polygonPoints_planetransformed;
@@ -87,8 +149,32 @@ protected:
     Point2D      m_region_center_GuassProj;
     double       m_angle_region_GuassProj;
 
-    UAVRouteDesign m_route_design_plane;
+    UAVRouteDesign m_route_design_plane;   // header and statistic, the points in m_route_columns_plane
+    UAVRouteColumns m_route_columns_plane;
+
+    // MBR of the region on the design plane and the flip decided by the airport
+    Point2D      m_mbr_leftTop_planetransformed;
+    Point2D      m_mbr_rightBot_planetransformed;
+    Point2D      m_orthoplane_center;
+    bool         m_isAirportleft;
+    bool         m_isAirportUp;
+
+    // the entry/exit candidate forced by SetEntryExitCandidate, -1 if none
+    int          m_forced_entry_candidate;
+
+
+    // the sinks of StreamRouteDesign, NULL when the design is kept in m_route_columns_plane
+    UAVRouteSink * m_strip_sinks;
+
+    // the statistic of the strips streamed so far, as InversePlaneTransform computes it
+    UAVFlightPoint m_stream_prev_point_guass;
+    double       m_stream_course_length_guass;
+    unsigned int m_stream_count_exposures;
+    size_t       m_stream_count_points;
 
+    // the buffers of StreamCurrentStrip, reused from strip to strip
+    std::vector<UAVFlightPoint> m_stream_strip;
+    UAVRouteColumns m_stream_columns;
 
 protected:
     //the following two members are used in CreateNewStripBasedOnLastStrip() for reuse the last valid strip
@@ -0,0 +1,447 @@
+#include "regiondecomposer.h"
+#include "gaussprojector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+using std::ostringstream;
+
+#include <QDebug>
+
+
+namespace {
+
+    // an edge of the rotated region, not parallel to the sweep line, xl < xr
+    struct SweepEdge
+    {
+        double xl, yl;
+        double xr, yr;
+    };
+
+    inline bool EdgeLeftOf(const SweepEdge & a, const SweepEdge & b)
+    {
+        return a.xl < b.xl;
+    }
+
+    inline double EdgeYAt(const SweepEdge & edge, double x)
+    {
+        return edge.yl + (edge.yr-edge.yl)*(x-edge.xl)/(edge.xr-edge.xl);
+    }
+
+    // the piece of the region between two consecutive events and two edges
+    struct Trapezoid
+    {
+        double x0, x1;
+        int lower, upper;   // index of the edges
+        int cell;
+    };
+
+    struct EdgeAtSweep
+    {
+        double y;
+        int edge;
+        bool operator<(const EdgeAtSweep & rs) const { return y < rs.y; };
+    };
+
+    // twice the signed area of (a,b,c) within tolerance of the length of (a,c)
+    inline bool Collinear(const Point2D & a, const Point2D & b, const Point2D & c, double tolerance)
+    {
+        double cross = (b.X-a.X)*(c.Y-a.Y) - (b.Y-a.Y)*(c.X-a.X);
+        return fabs(cross) <= tolerance*std::max(a.DistanceTo(c.X,c.Y),tolerance);
+    }
+
+    // drop the repeated and the collinear points of a ring
+    void SimplifyRing(Point2DArray & ring, double tolerance)
+    {
+        Point2DArray simplified;
+        for(size_t i=0; i<ring.size(); i++ )
+        {
+            const Point2D & pt = ring[i];
+            if(!simplified.empty() && simplified.back().DistanceTo(pt.X,pt.Y) <= tolerance)
+            {
+                continue;
+            }
+            while(simplified.size()>=2 && Collinear(simplified[simplified.size()-2],simplified.back(),pt,tolerance))
+            {
+                simplified.pop_back();
+            }
+            simplified.push_back(pt);
+        }
+
+        // around the first point
+        bool changed = true;
+        while(changed && simplified.size()>=3)
+        {
+            changed = false;
+            size_t count = simplified.size();
+            if(simplified[count-1].DistanceTo(simplified[0].X,simplified[0].Y) <= tolerance
+               || Collinear(simplified[count-2],simplified[count-1],simplified[0],tolerance))
+            {
+                simplified.pop_back();
+                changed = true;
+            }
+            else if(Collinear(simplified[count-1],simplified[0],simplified[1],tolerance))
+            {
+                simplified.erase(simplified.begin());
+                changed = true;
+            }
+        }
+
+        ring = simplified;
+    }
+
+    void OGRRingToPoint2DArray(OGRLinearRing * ring, Point2DArray & points)
+    {
+        points.clear();
+        int count_points = ring->getNumPoints();
+        // not closed
+        if(count_points>1 && ring->getX(0)==ring->getX(count_points-1) && ring->getY(0)==ring->getY(count_points-1))
+        {
+            count_points--;
+        }
+        for(int i=0; i<count_points; i++ )
+        {
+            points.push_back(Point2D(ring->getX(i),ring->getY(i)));
+        }
+    }
+}
+
+
+void RegionDecomposer::DecomposePlane(const std::vector<Point2DArray> & rings,
+                                      double sweep_angle,
+                                      std::vector<Point2DArray> & cells)
+{
+    cells.clear();
+
+    // rotate the sweep direction to the x axis, the sweep line is then vertical
+    std::vector<SweepEdge> edges;
+    std::vector<double> events;
+    double extent = 0.0;
+
+    for(size_t r=0; r<rings.size(); r++ )
+    {
+        const Point2DArray & ring = rings[r];
+        size_t count_points = ring.size();
+        for(size_t i=0; i<count_points; i++ )
+        {
+            Point2D a = Rotate2D(ring[i], -sweep_angle);
+            Point2D b = Rotate2D(ring[(i+1)%count_points], -sweep_angle);
+            events.push_back(a.X);
+            extent = std::max(extent, std::max(fabs(a.X), fabs(a.Y)));
+
+            // the edges along the sweep line do not bound any trapezoid
+            if(a.X==b.X)
+            {
+                continue;
+            }
+            SweepEdge edge;
+            if(a.X < b.X)
+            {
+                edge.xl = a.X; edge.yl = a.Y;
+                edge.xr = b.X; edge.yr = b.Y;
+            }
+            else
+            {
+                edge.xl = b.X; edge.yl = b.Y;
+                edge.xr = a.X; edge.yr = a.Y;
+            }
+            edges.push_back(edge);
+        }
+    }
+
+    if(edges.size()<2)
+    {
+        return;
+    }
+
+    std::sort(events.begin(),events.end());
+    events.erase(std::unique(events.begin(),events.end()),events.end());
+    std::sort(edges.begin(),edges.end(),EdgeLeftOf);
+
+    double tolerance = std::max(extent,1.0)*1e-9;
+
+    // 1. the trapezoids of each slab between two events, by an active edge table
+    std::vector< std::vector<Trapezoid> > slabs(events.size()>0 ? events.size()-1 : 0);
+    std::vector<int> active;
+    std::vector<EdgeAtSweep> crossings;
+    size_t next_edge = 0;
+
+    for(size_t s=0; s<slabs.size(); s++ )
+    {
+        double x_mid = (events[s]+events[s+1])/2.0;
+
+        while(next_edge<edges.size() && edges[next_edge].xl < x_mid)
+        {
+            active.push_back((int)next_edge);
+            next_edge++;
+        }
+        size_t count_active = 0;
+        for(size_t i=0; i<active.size(); i++ )
+        {
+            if(edges[active[i]].xr > x_mid)
+            {
+                active[count_active++] = active[i];
+            }
+        }
+        active.resize(count_active);
+
+        crossings.clear();
+        for(size_t i=0; i<active.size(); i++ )
+        {
+            EdgeAtSweep crossing;
+            crossing.y = EdgeYAt(edges[active[i]],x_mid);
+            crossing.edge = active[i];
+            crossings.push_back(crossing);
+        }
+        std::sort(crossings.begin(),crossings.end());
+
+        for(size_t i=0; i+1<crossings.size(); i+=2 )
+        {
+            Trapezoid trapezoid;
+            trapezoid.x0 = events[s];
+            trapezoid.x1 = events[s+1];
+            trapezoid.lower = crossings[i].edge;
+            trapezoid.upper = crossings[i+1].edge;
+            trapezoid.cell = -1;
+            slabs[s].push_back(trapezoid);
+        }
+    }
+
+    // 2. merge the trapezoids of consecutive slabs into cells,
+    //    unless the sweep line splits or joins there (a critical vertex)
+    int count_cells = 0;
+    std::vector<int> count_right, count_left, left_of;
+    for(size_t s=0; s<slabs.size(); s++ )
+    {
+        std::vector<Trapezoid> & current = slabs[s];
+        if(s==0 || slabs[s-1].empty())
+        {
+            for(size_t j=0; j<current.size(); j++ )
+            {
+                current[j].cell = count_cells++;
+            }
+            continue;
+        }
+
+        std::vector<Trapezoid> & previous = slabs[s-1];
+        double x = events[s];
+
+        count_right.assign(previous.size(),0);
+        count_left.assign(current.size(),0);
+        left_of.assign(current.size(),-1);
+
+        // both sorted by y and disjoint: two pointers on the common sweep line
+        size_t i=0, j=0;
+        while(i<previous.size() && j<current.size())
+        {
+            double lo_p = EdgeYAt(edges[previous[i].lower],x), hi_p = EdgeYAt(edges[previous[i].upper],x);
+            double lo_c = EdgeYAt(edges[current[j].lower],x),  hi_c = EdgeYAt(edges[current[j].upper],x);
+
+            if(std::max(lo_p,lo_c) < std::min(hi_p,hi_c) - tolerance)
+            {
+                count_right[i]++;
+                count_left[j]++;
+                left_of[j] = (int)i;
+            }
+            if(hi_p < hi_c)
+            {
+                i++;
+            }
+            else
+            {
+                j++;
+            }
+        }
+
+        for(size_t c=0; c<current.size(); c++ )
+        {
+            int p = left_of[c];
+            if(count_left[c]==1 && count_right[p]==1)
+            {
+                current[c].cell = previous[p].cell;
+            }
+            else
+            {
+                current[c].cell = count_cells++;
+            }
+        }
+    }
+
+    // 3. the boundary of each cell: the lower chain forward, the upper chain backward
+    std::vector<Point2DArray> lower_chains(count_cells), upper_chains(count_cells);
+    for(size_t s=0; s<slabs.size(); s++ )
+    {
+        for(size_t j=0; j<slabs[s].size(); j++ )
+        {
+            const Trapezoid & trapezoid = slabs[s][j];
+            const SweepEdge & lower = edges[trapezoid.lower];
+            const SweepEdge & upper = edges[trapezoid.upper];
+
+            lower_chains[trapezoid.cell].push_back(Point2D(trapezoid.x0,EdgeYAt(lower,trapezoid.x0)));
+            lower_chains[trapezoid.cell].push_back(Point2D(trapezoid.x1,EdgeYAt(lower,trapezoid.x1)));
+            upper_chains[trapezoid.cell].push_back(Point2D(trapezoid.x0,EdgeYAt(upper,trapezoid.x0)));
+            upper_chains[trapezoid.cell].push_back(Point2D(trapezoid.x1,EdgeYAt(upper,trapezoid.x1)));
+        }
+    }
+
+    for(int c=0; c<count_cells; c++ )
+    {
+        Point2DArray cell;
+        for(size_t i=0; i<lower_chains[c].size(); i++ )
+        {
+            cell.push_back(lower_chains[c][i]);
+        }
+        for(size_t i=upper_chains[c].size(); i>0; i-- )
+        {
+            cell.push_back(upper_chains[c][i-1]);
+        }
+
+        SimplifyRing(cell,tolerance);
+        if(cell.size()<3)
+        {
+            continue;
+        }
+
+        for(size_t i=0; i<cell.size(); i++ )
+        {
+            cell[i] = Rotate2D(cell[i],sweep_angle);
+        }
+        cells.push_back(cell);
+    }
+}
+
+void RegionDecomposer::DecomposePolygon(OGRPolygon * polygon,
+                                        std::vector< std::unique_ptr<OGRGeometry> > & cells)
+{
+    OGRLinearRing * exterior = polygon->getExteriorRing();
+    if(exterior==NULL || exterior->getNumPoints()<4)
+    {
+        return;
+    }
+
+    OGRPoint centroid;
+    if(polygon->Centroid(&centroid)!=OGRERR_NONE)
+    {
+        throw "Can not get the centroid of the region, RegionDecomposer::DecomposePolygon";
+    }
+
+    std::shared_ptr<GaussProjector> projector = GaussProjectorCache::Acquire(centroid.getX(),centroid.getY());
+
+    // the rings on the gauss projection plane, relative to the centroid to keep the precision
+    std::vector<Point2DArray> rings(1+polygon->getNumInteriorRings());
+    OGRRingToPoint2DArray(exterior,rings[0]);
+    for(int i=0; i<polygon->getNumInteriorRings(); i++ )
+    {
+        OGRRingToPoint2DArray(polygon->getInteriorRing(i),rings[i+1]);
+    }
+
+    double x_origin = centroid.getX();
+    double y_origin = centroid.getY();
+    if(!projector->Forward(1,&x_origin,&y_origin))
+    {
+        throw "Gauss projection of the region failed, RegionDecomposer::DecomposePolygon";
+    }
+
+    for(size_t r=0; r<rings.size(); r++ )
+    {
+        Point2DArray & ring = rings[r];
+        std::vector<double> x(ring.size()), y(ring.size());
+        for(size_t i=0; i<ring.size(); i++ )
+        {
+            x[i] = ring[i].X;
+            y[i] = ring[i].Y;
+        }
+        if(!ring.empty() && !projector->Forward((int)ring.size(),&x[0],&y[0]))
+        {
+            throw "Gauss projection of the region failed, RegionDecomposer::DecomposePolygon";
+        }
+        for(size_t i=0; i<ring.size(); i++ )
+        {
+            ring[i] = Point2D(x[i]-x_origin,y[i]-y_origin);
+        }
+    }
+
+    // the sweep line along the strips of the whole region: a strip of that orientation
+    // crosses each cell only once
+    double strip_angle = 0.0;
+    PolygonOrientation2D orientation(rings[0]);
+    orientation.GetOptimalOrientation(strip_angle);
+    double sweep_angle = strip_angle + _PI_/2.0;
+
+    std::vector<Point2DArray> cells_plane;
+    DecomposePlane(rings,sweep_angle,cells_plane);
+
+    for(size_t c=0; c<cells_plane.size(); c++ )
+    {
+        const Point2DArray & cell = cells_plane[c];
+        std::vector<double> x(cell.size()), y(cell.size());
+        for(size_t i=0; i<cell.size(); i++ )
+        {
+            x[i] = cell[i].X + x_origin;
+            y[i] = cell[i].Y + y_origin;
+        }
+        if(!projector->Inverse((int)cell.size(),&x[0],&y[0]))
+        {
+            throw "Inverse gauss projection of the cell failed, RegionDecomposer::DecomposePolygon";
+        }
+
+        OGRLinearRing ring;
+        for(size_t i=0; i<cell.size(); i++ )
+        {
+            ring.addPoint(x[i],y[i]);
+        }
+        ring.closeRings();
+
+        OGRPolygon * cell_polygon = new OGRPolygon;
+        cell_polygon->addRing(&ring);
+        cell_polygon->assignSpatialReference(polygon->getSpatialReference());
+        cells.push_back(std::unique_ptr<OGRGeometry>(cell_polygon));
+    }
+
+    ostringstream streamdebug;
+    streamdebug<<"RegionDecomposer::DecomposePolygon(): "<<polygon->getNumInteriorRings()<<" holes, "
+               <<exterior->getNumPoints()<<" points => "<<cells_plane.size()<<" cells"<<std::endl;
+    qDebug(streamdebug.str().c_str());
+}
+
+void RegionDecomposer::DecomposeRegion(OGRGeometry * region,
+                                       std::vector< std::unique_ptr<OGRGeometry> > & cells)
+{
+    cells.clear();
+    if(region==NULL)
+    {
+        return;
+    }
+
+    switch(wkbFlatten(region->getGeometryType()))
+    {
+    case wkbPolygon:
+        DecomposePolygon(dynamic_cast<OGRPolygon*>(region),cells);
+        break;
+
+    case wkbMultiPolygon:
+        {
+            OGRGeometryCollection * collection = dynamic_cast<OGRGeometryCollection*>(region);
+            for(int i=0; i<collection->getNumGeometries(); i++ )
+            {
+                std::vector< std::unique_ptr<OGRGeometry> > cells_polygon;
+                DecomposeRegion(collection->getGeometryRef(i),cells_polygon);
+                for(size_t c=0; c<cells_polygon.size(); c++ )
+                {
+                    cells.push_back(std::move(cells_polygon[c]));
+                }
+            }
+        }
+        break;
+
+    default:
+        cells.push_back(std::unique_ptr<OGRGeometry>(region->clone()));
+        break;
+    }
+
+    // nothing left of a degenerated polygon: keep it as it is
+    if(cells.empty())
+    {
+        cells.push_back(std::unique_ptr<OGRGeometry>(region->clone()));
+    }
+}
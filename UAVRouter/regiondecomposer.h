@@ -0,0 +1,42 @@
+#ifndef REGIONDECOMPOSER_H
+#define REGIONDECOMPOSER_H
+
+/// RegionDecomposer: boustrophedon cell decomposition of a concave or holed flight region
+///
+/// the region is swept by a line along its main orientation (the strips); between two consecutive vertices
+/// the sweep line cuts the region into trapezoids, and the trapezoids are merged into one cell
+/// as long as the number of the pieces of the sweep line does not change (no critical vertex),
+/// so every cell is monotone along the sweep and without hole, and is flown with its own orientation
+///
+/// the decomposition runs on the gauss projection plane of the region, the cells are returned in WGS84,
+/// in the order of the sweep so that the neighbouring cells are flown one after the other
+
+#include <memory>
+#include <vector>
+
+#include <ogrsf_frmts.h>
+
+#include "GomoGeometry2D.h"
+using namespace Gomo::Geometry2D;
+
+
+class RegionDecomposer
+{
+public:
+    // the cells of the region on a plane: rings[0] the exterior, the others the holes, not closed;
+    // the sweep line is perpendicular to sweep_angle (radian, to the x axis)
+    static void DecomposePlane(const std::vector<Point2DArray> & rings,
+                               double sweep_angle,
+                               std::vector<Point2DArray> & cells);
+
+    // the cells of a polygon (or of each polygon of a multipolygon) in WGS84,
+    // any other geometry is returned as it is
+    static void DecomposeRegion(OGRGeometry * region,
+                                std::vector< std::unique_ptr<OGRGeometry> > & cells);
+
+protected:
+    static void DecomposePolygon(OGRPolygon * polygon,
+                                 std::vector< std::unique_ptr<OGRGeometry> > & cells);
+};
+
+#endif // REGIONDECOMPOSER_H
@@ -0,0 +1,417 @@
+#include "regionorderplanner.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include <QDebug>
+
+#include <sstream>
+using std::ostringstream;
+
+
+namespace {
+
+    // meters of one degree of latitude (WGS84 semi-major axis)
+    const double METERS_PER_DEGREE = 6378137.0*3.14159265358979323846/180.0;
+
+    // gains smaller than this are rounding noise, avoids cycling in the local search
+    const double MIN_GAIN = 1.0e-6;
+
+}
+
+
+RegionOrderPlanner::RegionOrderPlanner()
+    :m_return_to_airport(false),
+    m_count_nodes(0)
+{
+}
+
+
+void RegionOrderPlanner::SetReturnToAirport(bool return_to_airport)
+{
+    m_return_to_airport = return_to_airport;
+}
+
+
+void RegionOrderPlanner::InitLocalPlane(const Point2D & airport, const std::vector<Region> & regions)
+{
+    // equirectangular plane centred at the airport
+    m_airport_lonlat = airport;
+    m_airport = ToLocalPlane(airport);
+
+    m_candidates.clear();
+    m_has_candidates.clear();
+
+    for(size_t i=0; i<regions.size(); i++)
+    {
+        std::vector<RegionCandidate> candidates;
+
+        if(regions[i].candidates.empty())
+        {
+            RegionCandidate pseudo;
+            pseudo.entry = ToLocalPlane(regions[i].center);
+            pseudo.exit  = pseudo.entry;
+            candidates.push_back(pseudo);
+        }
+        else
+        {
+            for(size_t c=0; c<regions[i].candidates.size(); c++)
+            {
+                RegionCandidate cand;
+                cand.entry = ToLocalPlane(regions[i].candidates[c].entry);
+                cand.exit  = ToLocalPlane(regions[i].candidates[c].exit);
+                candidates.push_back(cand);
+            }
+        }
+
+        m_candidates.push_back(candidates);
+        m_has_candidates.push_back(!regions[i].candidates.empty());
+    }
+}
+
+
+Point2D RegionOrderPlanner::ToLocalPlane(const Point2D & lonlat) const
+{
+    double cos_lat = cos(m_airport_lonlat.Y*3.14159265358979323846/180.0);
+
+    Point2D pt;
+    pt.X = (lonlat.X - m_airport_lonlat.X)*cos_lat*METERS_PER_DEGREE;
+    pt.Y = (lonlat.Y - m_airport_lonlat.Y)*METERS_PER_DEGREE;
+    return pt;
+}
+
+
+void RegionOrderPlanner::BuildDistanceMatrix()
+{
+    m_count_nodes = m_candidates.size()+1;
+    m_distances.assign(m_count_nodes*m_count_nodes, 0.0);
+
+    // all the points where a region may be entered or left
+    std::vector< std::vector<Point2D> > endpoints(m_count_nodes);
+    endpoints[0].push_back(m_airport);
+    for(size_t i=0; i<m_candidates.size(); i++)
+    {
+        for(size_t c=0; c<m_candidates[i].size(); c++)
+        {
+            endpoints[i+1].push_back(m_candidates[i][c].entry);
+            endpoints[i+1].push_back(m_candidates[i][c].exit);
+        }
+    }
+
+    for(size_t a=0; a<m_count_nodes; a++)
+    {
+        for(size_t b=a+1; b<m_count_nodes; b++)
+        {
+            double min_dist = std::numeric_limits<double>::max();
+
+            for(size_t pa=0; pa<endpoints[a].size(); pa++)
+            {
+                for(size_t pb=0; pb<endpoints[b].size(); pb++)
+                {
+                    double d = endpoints[a][pa].DistanceTo(endpoints[b][pb].X,endpoints[b][pb].Y);
+                    min_dist = (d < min_dist) ? d : min_dist;
+                }
+            }
+
+            m_distances[a*m_count_nodes+b] = min_dist;
+            m_distances[b*m_count_nodes+a] = min_dist;
+        }
+    }
+}
+
+
+void RegionOrderPlanner::NearestNeighbourTour(std::vector<size_t> & tour) const
+{
+    std::vector<bool> visited(m_count_nodes,false);
+
+    tour.clear();
+    tour.push_back(0);
+    visited[0] = true;
+
+    for(size_t step=1; step<m_count_nodes; step++)
+    {
+        size_t current = tour.back();
+        size_t nearest = 0;
+        double min_dist = std::numeric_limits<double>::max();
+
+        for(size_t n=1; n<m_count_nodes; n++)
+        {
+            if(!visited[n] && Distance(current,n) < min_dist)
+            {
+                min_dist = Distance(current,n);
+                nearest  = n;
+            }
+        }
+
+        tour.push_back(nearest);
+        visited[nearest] = true;
+    }
+}
+
+
+// reverse tour[i..j] if it shortens the path, the airport tour[0] never moves
+bool RegionOrderPlanner::TwoOptPass(std::vector<size_t> & tour) const
+{
+    bool improved = false;
+    size_t n = tour.size();
+
+    for(size_t i=1; i+1<n; i++)
+    {
+        for(size_t j=i+1; j<n; j++)
+        {
+            double before = Distance(tour[i-1],tour[i]) + LegLength(tour,j);
+
+            double after  = Distance(tour[i-1],tour[j]);
+            if(j+1 < n)
+            {
+                after += Distance(tour[i],tour[j+1]);
+            }
+            else if(m_return_to_airport)
+            {
+                after += Distance(tour[i],0);
+            }
+
+            if(after < before - MIN_GAIN)
+            {
+                std::reverse(tour.begin()+i, tour.begin()+j+1);
+                improved = true;
+            }
+        }
+    }
+
+    return improved;
+}
+
+
+// move a segment of 1..3 regions to another place of the path, reversed or not
+bool RegionOrderPlanner::OrOptPass(std::vector<size_t> & tour) const
+{
+    bool improved = false;
+
+    for(size_t seg_len=1; seg_len<=3; seg_len++)
+    {
+        for(size_t i=1; i+seg_len<=tour.size(); i++)
+        {
+            size_t n = tour.size();
+            size_t last = i+seg_len-1;
+
+            size_t seg_first = tour[i];
+            size_t seg_last  = tour[last];
+
+            // the gain of taking the segment out
+            double removed = Distance(tour[i-1],seg_first) + LegLength(tour,last);
+            double bridged;
+            if(last+1 < n)
+            {
+                bridged = Distance(tour[i-1],tour[last+1]);
+            }
+            else
+            {
+                bridged = m_return_to_airport ? Distance(tour[i-1],0) : 0.0;
+            }
+            double gain = removed - bridged;
+
+            if(gain <= MIN_GAIN)
+            {
+                continue;
+            }
+
+            // the best place: after the tour position k, k outside of [i-1,last]
+            double best_cost = gain - MIN_GAIN;
+            size_t best_k = 0;
+            bool best_reversed = false;
+            bool found = false;
+
+            for(size_t k=0; k<n; k++)
+            {
+                if(k+1 >= i && k <= last)
+                {
+                    continue;
+                }
+
+                size_t prev = tour[k];
+                double cost_fwd, cost_rev;
+
+                if(k+1 < n)
+                {
+                    size_t next = tour[k+1];
+                    double leg = Distance(prev,next);
+                    cost_fwd = Distance(prev,seg_first) + Distance(seg_last,next) - leg;
+                    cost_rev = Distance(prev,seg_last) + Distance(seg_first,next) - leg;
+                }
+                else if(m_return_to_airport)
+                {
+                    double leg = Distance(prev,0);
+                    cost_fwd = Distance(prev,seg_first) + Distance(seg_last,0) - leg;
+                    cost_rev = Distance(prev,seg_last) + Distance(seg_first,0) - leg;
+                }
+                else
+                {
+                    cost_fwd = Distance(prev,seg_first);
+                    cost_rev = Distance(prev,seg_last);
+                }
+
+                if(cost_fwd < best_cost)
+                {
+                    best_cost = cost_fwd;
+                    best_k = k;
+                    best_reversed = false;
+                    found = true;
+                }
+                if(cost_rev < best_cost)
+                {
+                    best_cost = cost_rev;
+                    best_k = k;
+                    best_reversed = true;
+                    found = true;
+                }
+            }
+
+            if(!found)
+            {
+                continue;
+            }
+
+            std::vector<size_t> segment(tour.begin()+i, tour.begin()+last+1);
+            if(best_reversed)
+            {
+                std::reverse(segment.begin(), segment.end());
+            }
+
+            tour.erase(tour.begin()+i, tour.begin()+last+1);
+            size_t insert_pos = (best_k < i) ? best_k+1 : best_k+1-seg_len;
+            tour.insert(tour.begin()+insert_pos, segment.begin(), segment.end());
+
+            improved = true;
+        }
+    }
+
+    return improved;
+}
+
+
+// exact choice of the candidates for a given order: shortest path over the candidates of the regions in turn
+double RegionOrderPlanner::ChooseCandidates(const std::vector<size_t> & order,
+                                            std::vector<int> & candidate_of_region) const
+{
+    candidate_of_region.assign(m_candidates.size(), -1);
+
+    if(order.empty())
+    {
+        return 0.0;
+    }
+
+    // cost[c]: the shortest transit to leave the current region by its candidate c
+    std::vector< std::vector<double> > cost(order.size());
+    std::vector< std::vector<int> >    from(order.size());
+
+    for(size_t k=0; k<order.size(); k++)
+    {
+        const std::vector<RegionCandidate> & cands = m_candidates[order[k]];
+        cost[k].assign(cands.size(), std::numeric_limits<double>::max());
+        from[k].assign(cands.size(), -1);
+
+        for(size_t c=0; c<cands.size(); c++)
+        {
+            if(k == 0)
+            {
+                cost[k][c] = m_airport.DistanceTo(cands[c].entry.X,cands[c].entry.Y);
+                continue;
+            }
+
+            const std::vector<RegionCandidate> & prev_cands = m_candidates[order[k-1]];
+            for(size_t p=0; p<prev_cands.size(); p++)
+            {
+                double d = cost[k-1][p] + prev_cands[p].exit.DistanceTo(cands[c].entry.X,cands[c].entry.Y);
+                if(d < cost[k][c])
+                {
+                    cost[k][c] = d;
+                    from[k][c] = (int)p;
+                }
+            }
+        }
+    }
+
+    // the end of the path
+    size_t last = order.size()-1;
+    const std::vector<RegionCandidate> & last_cands = m_candidates[order[last]];
+    double best = std::numeric_limits<double>::max();
+    int best_c = 0;
+    for(size_t c=0; c<last_cands.size(); c++)
+    {
+        double d = cost[last][c];
+        if(m_return_to_airport)
+        {
+            d += last_cands[c].exit.DistanceTo(m_airport.X,m_airport.Y);
+        }
+        if(d < best)
+        {
+            best = d;
+            best_c = (int)c;
+        }
+    }
+
+    // back track
+    int c = best_c;
+    for(size_t k=order.size(); k-- > 0; )
+    {
+        if(m_has_candidates[order[k]])
+        {
+            candidate_of_region[order[k]] = c;
+        }
+        c = from[k][c];
+    }
+
+    return best;
+}
+
+
+double RegionOrderPlanner::EvaluateOrder(const Point2D & airport,
+                                         const std::vector<Region> & regions,
+                                         const std::vector<size_t> & order,
+                                         std::vector<int> & candidate_of_region)
+{
+    InitLocalPlane(airport,regions);
+
+    return ChooseCandidates(order,candidate_of_region);
+}
+
+
+double RegionOrderPlanner::Plan(const Point2D & airport,
+                                const std::vector<Region> & regions,
+                                std::vector<size_t> & order,
+                                std::vector<int> & candidate_of_region)
+{
+    InitLocalPlane(airport,regions);
+
+    BuildDistanceMatrix();
+
+    std::vector<size_t> tour;
+    NearestNeighbourTour(tour);
+
+    // alternate the two neighbourhoods until neither improves, the pass count is only a safety net
+    for(int pass=0; pass<1000; pass++)
+    {
+        bool improved = TwoOptPass(tour);
+        improved = OrOptPass(tour) || improved;
+        if(!improved)
+        {
+            break;
+        }
+    }
+
+    order.clear();
+    for(size_t i=1; i<tour.size(); i++)
+    {
+        order.push_back(tour[i]-1);
+    }
+
+    double transit = ChooseCandidates(order,candidate_of_region);
+
+    ostringstream streamdebug;
+    streamdebug<<"RegionOrderPlanner::Plan: "<<regions.size()<<" regions, transit "<<transit<<" m";
+    qDebug(streamdebug.str().c_str());
+
+    return transit;
+}
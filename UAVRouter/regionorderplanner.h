@@ -0,0 +1,98 @@
+#ifndef REGIONORDERPLANNER_H
+#define REGIONORDERPLANNER_H
+
+/// RegionOrderPlanner: the visiting order of the regions of a multi-region design
+/// and the way (entry/exit) each region is flown, to shorten the transit legs
+/// from the airport through all the regions
+///
+/// 1. the order: open path from the airport over a precomputed distance matrix,
+///    the distance of two regions is the shortest one between their entry/exit points;
+///    nearest neighbour seed, then 2-opt and Or-opt (segments of 1..3 regions) until no gain
+/// 2. the entry/exit of each region: exact dynamic programming along the order
+///
+/// all the coordinates are longitude/latitude in degree, the distances are computed on a
+/// local plane around the airport, which is accurate enough to compare transit legs
+
+#include <vector>
+
+#include "GomoGeometry2D.h"
+using namespace Gomo::Geometry2D;
+
+
+class RegionOrderPlanner
+{
+public:
+    struct RegionCandidate
+    {
+        Point2D entry;      // X: longitude, Y: latitude
+        Point2D exit;
+    };
+
+    struct Region
+    {
+        Point2D center;                             // used when there is no candidate
+        std::vector<RegionCandidate> candidates;    // the ways the region can be flown
+    };
+
+public:
+    RegionOrderPlanner();
+
+    // count the leg from the last region back to the airport, default false
+    void SetReturnToAirport(bool return_to_airport);
+
+    /*@param
+     *      input:  airport, regions
+     *      output: order, the region index of each visit;
+     *              candidate_of_region, the candidate chosen for each region (-1 if it has none)
+     *@return
+     *      the total transit length in meters
+     */
+    double Plan(const Point2D & airport,
+                const std::vector<Region> & regions,
+                std::vector<size_t> & order,
+                std::vector<int> & candidate_of_region);
+
+    // the total transit length in meters of a given order, with the best candidates for it
+    double EvaluateOrder(const Point2D & airport,
+                         const std::vector<Region> & regions,
+                         const std::vector<size_t> & order,
+                         std::vector<int> & candidate_of_region);
+
+protected:
+    void InitLocalPlane(const Point2D & airport, const std::vector<Region> & regions);
+
+    Point2D ToLocalPlane(const Point2D & lonlat) const;
+
+    // node 0 is the airport, node i+1 is the region i
+    void BuildDistanceMatrix();
+
+    inline double Distance(size_t node_a, size_t node_b) const {
+        return m_distances[node_a*m_count_nodes+node_b]; };
+
+    // the length of the leg from the tour position i to i+1, 0 for the open end
+    inline double LegLength(const std::vector<size_t> & tour, size_t i) const {
+        if (i+1 < tour.size()) return Distance(tour[i],tour[i+1]);
+        return m_return_to_airport ? Distance(tour[i],0) : 0.0; };
+
+    void NearestNeighbourTour(std::vector<size_t> & tour) const;
+    bool TwoOptPass(std::vector<size_t> & tour) const;
+    bool OrOptPass(std::vector<size_t> & tour) const;
+
+    double ChooseCandidates(const std::vector<size_t> & order,
+                            std::vector<int> & candidate_of_region) const;
+
+protected:
+    bool m_return_to_airport;
+
+    Point2D m_airport_lonlat;
+
+    // on the local plane
+    Point2D m_airport;
+    std::vector< std::vector<RegionCandidate> > m_candidates;   // the center as entry/exit if none
+    std::vector<bool> m_has_candidates;
+
+    size_t m_count_nodes;
+    std::vector<double> m_distances;
+};
+
+#endif // REGIONORDERPLANNER_H
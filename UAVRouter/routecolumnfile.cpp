@@ -0,0 +1,479 @@
+#include "routecolumnfile.h"
+
+#include <cmath>
+#include <cstring>
+
+#include <QDebug>
+#include <sstream>
+using std::ostringstream;
+
+
+namespace {
+
+    const BYTE8 GRC_MAGIC[4] = { 'G', 'R', 'C', '1' };
+    const unsigned int GRC_VERSION = 1;
+
+    const double DEGREE_TO_FIXED = 1e8;     // 1e-8 degree
+    const double METER_TO_FIXED  = 1e2;     // 1 cm
+
+    // magic, version, 7 doubles, length of the airport name
+    const size_t FILE_HEADER_SIZE = 4 + 4 + 7*8 + 4;
+    // block offset, first point, count, offsets of the 4 delta columns in the block, block size
+    const size_t INDEX_ENTRY_SIZE = 8 + 8 + 4 + 4*4 + 4;
+    // index offset, count of points, count of strips, 5 numbers of the statistic, version, magic
+    const size_t TRAILER_SIZE = 8 + 8 + 4 + 5*4 + 4 + 4;
+
+    // little endian, whatever the host is
+    inline void PutU32(std::vector<BYTE8> & bytes, unsigned int value)
+    {
+        for(int i=0; i<4; i++)
+        {
+            bytes.push_back((BYTE8)(value>>(8*i)));
+        }
+    }
+
+    inline void PutU64(std::vector<BYTE8> & bytes, unsigned long long value)
+    {
+        for(int i=0; i<8; i++)
+        {
+            bytes.push_back((BYTE8)(value>>(8*i)));
+        }
+    }
+
+    inline void PutF32(std::vector<BYTE8> & bytes, float value)
+    {
+        unsigned int bits;
+        memcpy(&bits,&value,4);
+        PutU32(bytes,bits);
+    }
+
+    inline void PutF64(std::vector<BYTE8> & bytes, double value)
+    {
+        unsigned long long bits;
+        memcpy(&bits,&value,8);
+        PutU64(bytes,bits);
+    }
+
+    inline unsigned int GetU32(const BYTE8 * p)
+    {
+        return (unsigned int)p[0] | ((unsigned int)p[1]<<8) | ((unsigned int)p[2]<<16) | ((unsigned int)p[3]<<24);
+    }
+
+    inline unsigned long long GetU64(const BYTE8 * p)
+    {
+        return (unsigned long long)GetU32(p) | ((unsigned long long)GetU32(p+4)<<32);
+    }
+
+    inline float GetF32(const BYTE8 * p)
+    {
+        unsigned int bits = GetU32(p);
+        float value;
+        memcpy(&value,&bits,4);
+        return value;
+    }
+
+    inline double GetF64(const BYTE8 * p)
+    {
+        unsigned long long bits = GetU64(p);
+        double value;
+        memcpy(&value,&bits,8);
+        return value;
+    }
+
+    // the delta columns: zigzag (small negative deltas stay small) then 7 bits per byte
+    inline void PutDelta(std::vector<BYTE8> & bytes, long long delta)
+    {
+        unsigned long long value = ((unsigned long long)delta<<1) ^ (unsigned long long)(delta>>63);
+        while(value >= 0x80)
+        {
+            bytes.push_back((BYTE8)(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back((BYTE8)value);
+    }
+
+    inline long long GetDelta(const BYTE8 *& p, const BYTE8 * end)
+    {
+        unsigned long long value = 0;
+        for(int shift=0; ; shift+=7)
+        {
+            if(p>=end || shift>63)
+            {
+                throw "corrupt delta column, ColumnarStripView::Decode";
+            }
+            BYTE8 byte = *p++;
+            value |= (unsigned long long)(byte & 0x7F)<<shift;
+            if((byte & 0x80)==0)
+            {
+                break;
+            }
+        }
+        return (long long)(value>>1) ^ -(long long)(value & 1);
+    }
+
+    inline long long ToFixed(double value, double scale)
+    {
+        if(!(fabs(value*scale) < 9.0e18))
+        {
+            throw "coordinate out of the fixed point range, ColumnarRouteFileSink::AddStrip";
+        }
+        return (long long)floor(value*scale + 0.5);
+    }
+
+    // the deltas of a column of count values in [begin,end), to values
+    template<typename GetValue>
+    void DecodeDeltas(const BYTE8 * begin, const BYTE8 * end, size_t count, GetValue set_value)
+    {
+        long long value = 0;
+        for(size_t i=0; i<count; i++)
+        {
+            value += GetDelta(begin,end);
+            set_value(i,value);
+        }
+    }
+}
+
+
+ColumnarRouteFileSink::ColumnarRouteFileSink(const std::string & output_file)
+    :m_file_offset(0),
+    m_count_points(0),
+    m_count_strips(0)
+{
+    m_output_file.open(output_file,ios::binary | ios::out);
+}
+
+void ColumnarRouteFileSink::Write(const std::vector<BYTE8> & bytes)
+{
+    if(!bytes.empty())
+    {
+        m_output_file.write((const char *)&bytes[0],bytes.size());
+        m_file_offset += bytes.size();
+    }
+}
+
+void ColumnarRouteFileSink::BeginRoute(const UAVRouteHEADER & header)
+{
+    m_block.clear();
+    m_block.insert(m_block.end(),GRC_MAGIC,GRC_MAGIC+4);
+    PutU32(m_block,GRC_VERSION);
+
+    PutF64(m_block,header.min_latitude);
+    PutF64(m_block,header.max_latitude);
+    PutF64(m_block,header.min_longitude);
+    PutF64(m_block,header.max_longitude);
+    PutF64(m_block,header.airport_latitude);
+    PutF64(m_block,header.airport_longitude);
+    PutF64(m_block,header.airport_height);
+
+    PutU32(m_block,(unsigned int)header.airport_name.size());
+    m_block.insert(m_block.end(),header.airport_name.begin(),header.airport_name.end());
+
+    Write(m_block);
+}
+
+void ColumnarRouteFileSink::AddStrip(const UAVFlightPoint * points, size_t count)
+{
+    if(count==0)
+    {
+        return;
+    }
+
+    m_block.clear();
+
+    for(size_t i=0; i<count; i++)
+    {
+        m_block.push_back(points[i].__strip_id);
+    }
+    for(size_t i=0; i<count; i++)
+    {
+        m_block.push_back((BYTE8)points[i].__flight_point_type);
+    }
+
+    unsigned int offset_ids = (unsigned int)m_block.size();
+    long long previous = 0;
+    for(size_t i=0; i<count; i++)
+    {
+        long long id = points[i].__id_in_strip;
+        PutDelta(m_block,id-previous);
+        previous = id;
+    }
+
+    unsigned int offset_latitudes = (unsigned int)m_block.size();
+    previous = 0;
+    for(size_t i=0; i<count; i++)
+    {
+        long long latitude = ToFixed(points[i].__latitude,DEGREE_TO_FIXED);
+        PutDelta(m_block,latitude-previous);
+        previous = latitude;
+    }
+
+    unsigned int offset_longitudes = (unsigned int)m_block.size();
+    previous = 0;
+    for(size_t i=0; i<count; i++)
+    {
+        long long longitude = ToFixed(points[i].__longitude,DEGREE_TO_FIXED);
+        PutDelta(m_block,longitude-previous);
+        previous = longitude;
+    }
+
+    unsigned int offset_heights = (unsigned int)m_block.size();
+    previous = 0;
+    for(size_t i=0; i<count; i++)
+    {
+        long long height = ToFixed(points[i].__height,METER_TO_FIXED);
+        PutDelta(m_block,height-previous);
+        previous = height;
+    }
+
+    PutU64(m_index,m_file_offset);
+    PutU64(m_index,m_count_points);
+    PutU32(m_index,(unsigned int)count);
+    PutU32(m_index,offset_ids);
+    PutU32(m_index,offset_latitudes);
+    PutU32(m_index,offset_longitudes);
+    PutU32(m_index,offset_heights);
+    PutU32(m_index,(unsigned int)m_block.size());
+
+    Write(m_block);
+
+    m_count_points += count;
+    m_count_strips++;
+}
+
+void ColumnarRouteFileSink::EndRoute(const UAVFlightStatisticInfo & statistic)
+{
+    unsigned long long offset_index = m_file_offset;
+    Write(m_index);
+
+    m_block.clear();
+    PutU64(m_block,offset_index);
+    PutU64(m_block,m_count_points);
+    PutU32(m_block,m_count_strips);
+
+    PutF32(m_block,statistic.__MBR_Area);
+    PutF32(m_block,statistic.__flight_region_area);
+    PutU32(m_block,statistic.__count_exposures);
+    PutU32(m_block,statistic.__count_strips);
+    PutF32(m_block,statistic.__photo_flight_course_chainage);
+
+    PutU32(m_block,GRC_VERSION);
+    m_block.insert(m_block.end(),GRC_MAGIC,GRC_MAGIC+4);
+    Write(m_block);
+
+    m_output_file.close();
+
+    m_index.clear();
+}
+
+
+ColumnarStripView::ColumnarStripView()
+    :m_count(0),
+    m_first_point(0),
+    m_strip_ids(NULL),
+    m_point_types(NULL),
+    m_ids_begin(NULL),
+    m_latitudes_begin(NULL),
+    m_longitudes_begin(NULL),
+    m_heights_begin(NULL),
+    m_block_end(NULL)
+{
+}
+
+void ColumnarStripView::Decode(UAVFlightPoint * points) const
+{
+    for(size_t i=0; i<m_count; i++)
+    {
+        points[i].__strip_id = m_strip_ids[i];
+        points[i].__flight_point_type = (enumFlightPointType)m_point_types[i];
+    }
+
+    DecodeDeltas(m_ids_begin,m_latitudes_begin,m_count,[points](size_t i,long long value){
+        points[i].__id_in_strip = (unsigned int)value; });
+    DecodeDeltas(m_latitudes_begin,m_longitudes_begin,m_count,[points](size_t i,long long value){
+        points[i].__latitude = value/DEGREE_TO_FIXED; });
+    DecodeDeltas(m_longitudes_begin,m_heights_begin,m_count,[points](size_t i,long long value){
+        points[i].__longitude = value/DEGREE_TO_FIXED; });
+    DecodeDeltas(m_heights_begin,m_block_end,m_count,[points](size_t i,long long value){
+        points[i].__height = value/METER_TO_FIXED; });
+}
+
+void ColumnarStripView::Decode(std::vector<UAVFlightPoint> & points) const
+{
+    points.resize(m_count);
+    if(m_count>0)
+    {
+        Decode(&points[0]);
+    }
+}
+
+
+ColumnarRouteReader::ColumnarRouteReader()
+    :m_data(NULL),
+    m_size(0),
+    m_count_points(0),
+    m_count_strips(0),
+    m_index(NULL)
+{
+}
+
+ColumnarRouteReader::~ColumnarRouteReader()
+{
+    Close();
+}
+
+void ColumnarRouteReader::Open(const std::string & input_file)
+{
+    Close();
+
+    m_file.setFileName(QString(input_file.c_str()));
+    if(!m_file.open(QIODevice::ReadOnly))
+    {
+        throw "can not open the route file, ColumnarRouteReader::Open";
+    }
+
+    m_size = m_file.size();
+    if(m_size < FILE_HEADER_SIZE + TRAILER_SIZE)
+    {
+        Close();
+        throw "not a .grc route file, ColumnarRouteReader::Open";
+    }
+
+    m_data = m_file.map(0,m_size);
+    if(m_data==NULL)
+    {
+        Close();
+        throw "can not map the route file, ColumnarRouteReader::Open";
+    }
+
+    const BYTE8 * trailer = m_data + m_size - TRAILER_SIZE;
+    if(memcmp(m_data,GRC_MAGIC,4)!=0 || memcmp(trailer+TRAILER_SIZE-4,GRC_MAGIC,4)!=0)
+    {
+        Close();
+        throw "not a .grc route file, ColumnarRouteReader::Open";
+    }
+    if(GetU32(m_data+4)!=GRC_VERSION || GetU32(trailer+TRAILER_SIZE-8)!=GRC_VERSION)
+    {
+        Close();
+        throw "unknown version of the .grc route file, ColumnarRouteReader::Open";
+    }
+
+    //trailer
+    unsigned long long offset_index = GetU64(trailer);
+    m_count_points = GetU64(trailer+8);
+    m_count_strips = GetU32(trailer+16);
+
+    unsigned int airport_name_length = GetU32(m_data+FILE_HEADER_SIZE-4);
+    // the index fills the bytes between the offset and the trailer, compared
+    // without adding to the offset which is read from the file
+    unsigned long long end_index = m_size - TRAILER_SIZE;
+    if(offset_index < (unsigned long long)FILE_HEADER_SIZE + airport_name_length
+       || offset_index > end_index
+       || (end_index - offset_index) % INDEX_ENTRY_SIZE != 0
+       || (end_index - offset_index) / INDEX_ENTRY_SIZE != m_count_strips)
+    {
+        Close();
+        throw "corrupt .grc route file, ColumnarRouteReader::Open";
+    }
+    m_index = m_data + offset_index;
+
+    m_statistic.__MBR_Area = GetF32(trailer+20);
+    m_statistic.__flight_region_area = GetF32(trailer+24);
+    m_statistic.__count_exposures = GetU32(trailer+28);
+    m_statistic.__count_strips = (unsigned char)GetU32(trailer+32);
+    m_statistic.__photo_flight_course_chainage = GetF32(trailer+36);
+
+    //header
+    m_header.min_latitude      = GetF64(m_data+8);
+    m_header.max_latitude      = GetF64(m_data+16);
+    m_header.min_longitude     = GetF64(m_data+24);
+    m_header.max_longitude     = GetF64(m_data+32);
+    m_header.airport_latitude  = GetF64(m_data+40);
+    m_header.airport_longitude = GetF64(m_data+48);
+    m_header.airport_height    = GetF64(m_data+56);
+    m_header.airport_name.assign((const char *)m_data+FILE_HEADER_SIZE,airport_name_length);
+}
+
+void ColumnarRouteReader::Close()
+{
+    if(m_data!=NULL)
+    {
+        m_file.unmap(const_cast<BYTE8 *>(m_data));
+        m_data = NULL;
+    }
+    m_file.close();
+
+    m_size = 0;
+    m_count_points = 0;
+    m_count_strips = 0;
+    m_index = NULL;
+}
+
+ColumnarStripView ColumnarRouteReader::GetStrip(size_t index) const
+{
+    if(index >= m_count_strips)
+    {
+        throw "strip index out of range, ColumnarRouteReader::GetStrip";
+    }
+
+    const BYTE8 * entry = m_index + index*INDEX_ENTRY_SIZE;
+
+    unsigned long long offset_block = GetU64(entry);
+    unsigned int count             = GetU32(entry+16);
+    unsigned int offset_ids        = GetU32(entry+20);
+    unsigned int offset_latitudes  = GetU32(entry+24);
+    unsigned int offset_longitudes = GetU32(entry+28);
+    unsigned int offset_heights    = GetU32(entry+32);
+    unsigned int block_size        = GetU32(entry+36);
+
+    // the columns in order within the block, the block before the index
+    if( offset_block + block_size > (unsigned long long)(m_index-m_data)
+        || offset_ids != 2ULL*count
+        || offset_latitudes < offset_ids || offset_longitudes < offset_latitudes
+        || offset_heights < offset_longitudes || block_size < offset_heights )
+    {
+        throw "corrupt strip index, ColumnarRouteReader::GetStrip";
+    }
+
+    const BYTE8 * block = m_data + offset_block;
+
+    ColumnarStripView strip;
+    strip.m_count            = count;
+    strip.m_first_point      = GetU64(entry+8);
+    strip.m_strip_ids        = block;
+    strip.m_point_types      = block + count;
+    strip.m_ids_begin        = block + offset_ids;
+    strip.m_latitudes_begin  = block + offset_latitudes;
+    strip.m_longitudes_begin = block + offset_longitudes;
+    strip.m_heights_begin    = block + offset_heights;
+    strip.m_block_end        = block + block_size;
+
+    return strip;
+}
+
+void ColumnarRouteReader::ReadRouteDesign(UAVRouteDesign & route_design) const
+{
+    route_design.__header = m_header;
+    route_design.__flight_statistic = m_statistic;
+
+    std::vector<UAVFlightPoint> & points = route_design.__flight_point;
+    points.clear();
+    points.resize((size_t)m_count_points);
+
+    for(size_t i=0; i<m_count_strips; i++)
+    {
+        ColumnarStripView strip = GetStrip(i);
+        if(strip.GetFirstPoint() + strip.GetCount() > points.size())
+        {
+            throw "corrupt strip index, ColumnarRouteReader::ReadRouteDesign";
+        }
+        if(strip.GetCount()>0)
+        {
+            strip.Decode(&points[(size_t)strip.GetFirstPoint()]);
+        }
+    }
+
+    ostringstream streamdebug;
+    streamdebug<< "ColumnarRouteReader::ReadRouteDesign: "<<points.size()<<" flight points in "
+               <<m_count_strips<<" strips";
+    qDebug(streamdebug.str().c_str());
+}
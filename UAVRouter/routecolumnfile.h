@@ -0,0 +1,127 @@
+#ifndef ROUTECOLUMNFILE_H
+#define ROUTECOLUMNFILE_H
+
+/// the columnar route file (.grc): a compact, machine readable copy of a UAVRouteDesign
+/// for post-processing (QA, merging, re-export), neither encrypted nor tied to the text format
+///
+///     file header:  "GRC1", version, the 7 doubles of UAVRouteHEADER, length and bytes of the airport name
+///     strip blocks: one per strip, the columns of its points one after the other:
+///                       strip id     1 byte per point
+///                       point type   1 byte per point
+///                       id in strip  varint of the zigzag delta to the previous point
+///                       latitude     varint of the zigzag delta, fixed point of 1e-8 degree (about 1 mm)
+///                       longitude    the same
+///                       height       varint of the zigzag delta, fixed point of 1 cm
+///                   the deltas start from 0 at each strip, so any strip is decoded on its own
+///     strip index:  per strip the offset of its block and of its columns, the first point and the count
+///     trailer:      offset of the index, count of points and strips, UAVFlightStatisticInfo, "GRC1"
+///
+/// all the numbers are little endian; the writer keeps one strip in memory,
+/// the reader maps the file and decodes the strips on demand, so opening a route only reads the trailer
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <QFile>
+
+#include "uavroutesink.h"
+
+
+class ColumnarStripView;
+
+
+// writes the .grc file strip by strip
+class ColumnarRouteFileSink : public UAVRouteSink
+{
+public:
+    explicit ColumnarRouteFileSink(const std::string & output_file);
+
+    virtual void BeginRoute(const UAVRouteHEADER & header);
+    virtual void AddStrip(const UAVFlightPoint * points, size_t count);
+    virtual void EndRoute(const UAVFlightStatisticInfo & statistic);
+
+protected:
+    void Write(const std::vector<BYTE8> & bytes);
+
+protected:
+    std::ofstream m_output_file;
+    unsigned long long m_file_offset;
+    unsigned long long m_count_points;
+
+    std::vector<BYTE8> m_block;     // the block of the current strip
+    std::vector<BYTE8> m_index;     // the index entries of the strips written
+    unsigned int m_count_strips;
+};
+
+
+// the strip view of the mapped file: the byte columns are read in place, the delta columns decoded on demand
+class ColumnarStripView
+{
+public:
+    ColumnarStripView();
+
+    inline size_t GetCount() const { return m_count; };
+    inline unsigned long long GetFirstPoint() const { return m_first_point; };
+
+    // zero copy columns of count bytes
+    inline const BYTE8 * GetStripIds() const { return m_strip_ids; };
+    inline const BYTE8 * GetPointTypes() const { return m_point_types; };
+
+    // decode the points of the strip to points[GetCount()], throw if the block is corrupt
+    void Decode(UAVFlightPoint * points) const;
+    void Decode(std::vector<UAVFlightPoint> & points) const;
+
+protected:
+    friend class ColumnarRouteReader;
+
+    size_t m_count;
+    unsigned long long m_first_point;
+
+    const BYTE8 * m_strip_ids;
+    const BYTE8 * m_point_types;
+    const BYTE8 * m_ids_begin;
+    const BYTE8 * m_latitudes_begin;
+    const BYTE8 * m_longitudes_begin;
+    const BYTE8 * m_heights_begin;
+    const BYTE8 * m_block_end;
+};
+
+
+// reads a .grc file through a memory map of it
+class ColumnarRouteReader
+{
+public:
+    ColumnarRouteReader();
+    ~ColumnarRouteReader();
+
+    // map the file and check its trailer, throw if it is not a .grc file
+    void Open(const std::string & input_file);
+    void Close();
+
+    inline unsigned long long GetPointCount() const { return m_count_points; };
+    inline size_t GetStripCount() const { return m_count_strips; };
+
+    inline const UAVRouteHEADER & GetHeader() const { return m_header; };
+    inline const UAVFlightStatisticInfo & GetStatistic() const { return m_statistic; };
+
+    // the strip in the flight order, throw if its index entry is out of the file
+    ColumnarStripView GetStrip(size_t index) const;
+
+    // all the strips decoded
+    void ReadRouteDesign(UAVRouteDesign & route_design) const;
+
+protected:
+    QFile m_file;
+    const BYTE8 * m_data;
+    unsigned long long m_size;
+
+    unsigned long long m_count_points;
+    size_t m_count_strips;
+    const BYTE8 * m_index;
+
+    UAVRouteHEADER m_header;
+    UAVFlightStatisticInfo m_statistic;
+};
+
+#endif // ROUTECOLUMNFILE_H
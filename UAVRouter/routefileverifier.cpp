@@ -0,0 +1,212 @@
+#include "routefileverifier.h"
+
+#include "uavroutedecoder.h"
+#include "uavrouteoutputer.h"
+#include "threadpool.h"
+
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QElapsedTimer>
+
+#include <memory>
+#include <exception>
+#include <iomanip>
+#include <algorithm>
+#include <sstream>
+using std::ostringstream;
+
+
+namespace {
+
+    // the first byte where the two files differ
+    void CompareContents(const char * original, size_t size_original,
+                         const char * encoded, size_t size_encoded,
+                         RouteFileCheck & check)
+    {
+        size_t size = std::min(size_original,size_encoded);
+        size_t offset = std::mismatch(original,original+size,encoded).first - original;
+
+        if(offset==size && size_original==size_encoded)
+        {
+            check.passed = true;
+            return;
+        }
+
+        ostringstream streamerror;
+        streamerror<< "differs from the route encoded again at byte "<<offset
+                   <<" (file: "<<size_original<<" bytes, encoded: "<<size_encoded<<" bytes)";
+        check.error = streamerror.str();
+    }
+}
+
+
+RouteFileCheck::RouteFileCheck()
+    :passed(false),
+    count_flight_points(0),
+    verify_ms(0.0)
+{
+}
+
+
+RouteFileVerifier::RouteFileVerifier(size_t count_threads)
+    :m_count_threads(count_threads)
+{
+}
+
+
+RouteFileCheck RouteFileVerifier::VerifyFile(const std::string & file)
+{
+    RouteFileCheck check;
+    check.file = file;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    try
+    {
+        QString suffix = QFileInfo(QString(file.c_str())).suffix();
+        bool binary = suffix.compare(QString("bht"), Qt::CaseInsensitive)==0;
+        bool encrypted = suffix.compare(QString("gst"), Qt::CaseInsensitive)==0;
+
+        if(!binary && !encrypted && suffix.compare(QString("ght"), Qt::CaseInsensitive)!=0)
+        {
+            throw "unknown route file suffix, RouteFileVerifier::VerifyFile";
+        }
+
+        std::string contents;
+        UAVRouteDecoder::ReadFileContents(file,contents,binary);
+
+        UAVRouteDesign route_design;
+
+        if(binary)
+        {
+            UAVRouteDecoder::DecodeRouteDesignFromBinary((const BYTE8 *)contents.data(),contents.size(),route_design);
+
+            std::vector<BYTE8> encoded;
+            UAVRouteOutputer::EncodeRouteDesignAsBinary(route_design,encoded);
+
+            CompareContents(contents.data(),contents.size(),
+                            (const char *)&encoded[0],encoded.size(),check);
+        }
+        else
+        {
+            UAVRouteDecoder::DecodeRouteDesignFromText(contents,route_design,encrypted);
+
+            ostringstream encoded;
+            UAVRouteOutputer::EncodeRouteDesignAsText(route_design,encoded,encrypted);
+            std::string encoded_text = encoded.str();
+
+            CompareContents(contents.data(),contents.size(),
+                            encoded_text.data(),encoded_text.size(),check);
+        }
+
+        check.count_flight_points = route_design.__flight_point.size();
+    }
+    catch(const char * error)
+    {
+        check.error = error;
+    }
+    catch(const std::string & error)
+    {
+        check.error = error;
+    }
+    catch(const std::exception & e)
+    {
+        check.error = e.what();
+    }
+    catch(...)
+    {
+        check.error = "unknown error";
+    }
+
+    check.verify_ms = timer.nsecsElapsed()/1.0e6;
+
+    return check;
+}
+
+std::vector<std::string> RouteFileVerifier::FindRouteFiles(const std::string & directory)
+{
+    QStringList name_filters;
+    name_filters<<"*.bht"<<"*.ght"<<"*.gst";
+
+    std::vector<std::string> files;
+
+    QDirIterator it(QString(directory.c_str()), name_filters, QDir::Files, QDirIterator::Subdirectories);
+    while(it.hasNext())
+    {
+        files.push_back(it.next().toStdString());
+    }
+
+    std::sort(files.begin(),files.end());
+
+    return files;
+}
+
+std::vector<RouteFileCheck> RouteFileVerifier::VerifyFiles(const std::vector<std::string> & files)
+{
+    std::vector<RouteFileCheck> checks(files.size());
+
+    if(m_count_threads == 1)
+    {
+        // the task groups of the decoder run in place too
+        WorkStealingThreadPool::PoolScope serial_scope(NULL);
+
+        for(size_t i=0; i<files.size(); i++)
+        {
+            checks[i] = VerifyFile(files[i]);
+        }
+
+        return checks;
+    }
+
+    // the calling thread verifies files while it waits for them, so the pool has one thread less
+    std::auto_ptr<WorkStealingThreadPool> own_pool;
+    if(m_count_threads != 0)
+    {
+        own_pool.reset(new WorkStealingThreadPool(m_count_threads-1));
+    }
+
+    // each file to its own slot of checks
+    TaskGroup verify_group(own_pool.get() ? *own_pool : WorkStealingThreadPool::GlobalInstance());
+    for(size_t i=0; i<files.size(); i++)
+    {
+        const std::string * file = &files[i];
+        RouteFileCheck * check = &checks[i];
+        verify_group.Run([file,check]{
+            *check = VerifyFile(*file);
+        });
+    }
+
+    verify_group.Wait();
+
+    return checks;
+}
+
+void RouteFileVerifier::ReportChecks(const std::vector<RouteFileCheck> & checks, std::ostream & out_stream)
+{
+    size_t count_failed = 0;
+    size_t count_flight_points = 0;
+    double total_ms = 0.0;
+
+    out_stream<<std::setiosflags(std::ios::fixed)<<std::setiosflags(std::ios::showpoint);
+    out_stream.precision(1);
+
+    for(size_t i=0; i<checks.size(); i++)
+    {
+        const RouteFileCheck & c = checks[i];
+
+        if(!c.passed)
+        {
+            out_stream<<"[FAIL] "<<c.file<<", error: "<<c.error<<"\n";
+            count_failed++;
+        }
+
+        count_flight_points += c.count_flight_points;
+        total_ms += c.verify_ms;
+    }
+
+    out_stream<<"Files: "<<checks.size()
+              <<", failed: "<<count_failed
+              <<", points: "<<count_flight_points
+              <<", total: "<<total_ms<<" ms\n";
+}
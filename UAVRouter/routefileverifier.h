@@ -0,0 +1,50 @@
+#ifndef ROUTEFILEVERIFIER_H
+#define ROUTEFILEVERIFIER_H
+
+/// RouteFileVerifier: the round trip of the route files written by UAVRouteOutputer,
+/// each file decoded by UAVRouteDecoder, encoded again and compared byte by byte with itself,
+/// so a change of the encoders is checked against the files written before it;
+/// the files of a directory are checked in parallel, a failed file does not stop the others
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+
+struct RouteFileCheck
+{
+public:
+    RouteFileCheck();
+
+    std::string file;
+    bool passed;
+    std::string error;      // why it failed: a decoding error or the first byte which differs
+
+    size_t count_flight_points;
+    double verify_ms;
+};
+
+
+class RouteFileVerifier
+{
+public:
+    // count_threads=0: one thread per core, 1: all the files in the calling thread
+    explicit RouteFileVerifier(size_t count_threads=0);
+
+public:
+    // thread safe, never throws; .bht, .ght or .gst
+    static RouteFileCheck VerifyFile(const std::string & file);
+
+    // the .bht, .ght and .gst files of the directory and of its sub directories, sorted by name
+    static std::vector<std::string> FindRouteFiles(const std::string & directory);
+
+    std::vector<RouteFileCheck> VerifyFiles(const std::vector<std::string> & files);
+
+    // one line per failed file, then the summary
+    static void ReportChecks(const std::vector<RouteFileCheck> & checks, std::ostream & out_stream);
+
+protected:
+    size_t m_count_threads;
+};
+
+#endif // ROUTEFILEVERIFIER_H
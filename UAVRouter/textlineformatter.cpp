@@ -0,0 +1,148 @@
+#include "textlineformatter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+
+namespace {
+
+    const int MAX_FAST_PRECISION = 9;
+
+    const double POW10[MAX_FAST_PRECISION+1] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+
+    // above it value*10^precision does not fit into an unsigned long long
+    const double MAX_FAST_VALUE = 1e9;
+
+    // the digits of value backward from end, return the first one
+    inline char * FormatDigitsBackward(unsigned long long value, char * end, int min_digits)
+    {
+        char * p = end;
+        int count = 0;
+        do
+        {
+            *--p = (char)('0' + value%10);
+            value /= 10;
+            count++;
+        }
+        while(value!=0 || count<min_digits);
+        return p;
+    }
+
+    // value with precision decimals into text[64], return the length as snprintf (larger if truncated)
+    int FormatFixed(double value, int precision, char * text)
+    {
+        if(precision<0 || precision>MAX_FAST_PRECISION || !(fabs(value) < MAX_FAST_VALUE))
+        {
+            return snprintf(text, 64, "%.*f", precision, value);
+        }
+
+        double scaled   = fabs(value)*POW10[precision];
+        double integral = floor(scaled);
+        double fraction = scaled - integral;
+
+        // the product is rounded: near the tie only the exact binary value decides
+        if(fabs(fraction-0.5) <= scaled*4.5e-16 + 1e-300)
+        {
+            return snprintf(text, 64, "%.*f", precision, value);
+        }
+
+        unsigned long long scaled_int = (unsigned long long)integral + (fraction>0.5 ? 1 : 0);
+        unsigned long long divisor = (unsigned long long)POW10[precision];
+
+        char digits[64];
+        char * end = digits + sizeof(digits);
+        char * p = end;
+        if(precision>0)
+        {
+            p = FormatDigitsBackward(scaled_int%divisor, p, precision);
+            *--p = '.';
+        }
+        p = FormatDigitsBackward(scaled_int/divisor, p, 1);
+        // -0.00000 as printf
+        if(std::signbit(value))
+        {
+            *--p = '-';
+        }
+
+        int length = (int)(end-p);
+        memcpy(text, p, length);
+        text[length] = '\0';
+        return length;
+    }
+}
+
+
+TextLineFormatter::TextLineFormatter()
+{
+    m_buffer.reserve(256);
+}
+
+void TextLineFormatter::WriteTo(std::ostream & out_stream)
+{
+    if(!m_buffer.empty())
+    {
+        out_stream.write(&m_buffer[0], m_buffer.size());
+    }
+    m_buffer.clear();
+}
+
+void TextLineFormatter::Append(char c)
+{
+    m_buffer.push_back(c);
+}
+
+void TextLineFormatter::Append(const char * text)
+{
+    m_buffer.insert(m_buffer.end(), text, text+strlen(text));
+}
+
+void TextLineFormatter::Append(const std::string & text)
+{
+    m_buffer.insert(m_buffer.end(), text.begin(), text.end());
+}
+
+void TextLineFormatter::Append(const char * text, size_t length)
+{
+    m_buffer.insert(m_buffer.end(), text, text+length);
+}
+
+// the fill goes before the sign, as std::right (the default adjustment) does
+void TextLineFormatter::AppendPadded(const char * text, size_t length, int width, char fill)
+{
+    if(width>0 && length<(size_t)width)
+    {
+        m_buffer.insert(m_buffer.end(), (size_t)width-length, fill);
+    }
+    m_buffer.insert(m_buffer.end(), text, text+length);
+}
+
+void TextLineFormatter::AppendInteger(long long value, int width, char fill)
+{
+    char digits[32];
+    char * end = digits + sizeof(digits);
+    unsigned long long magnitude = value<0 ? 0ULL-(unsigned long long)value : (unsigned long long)value;
+
+    char * p = FormatDigitsBackward(magnitude, end, 1);
+    if(value<0)
+    {
+        *--p = '-';
+    }
+    AppendPadded(p, end-p, width, fill);
+}
+
+void TextLineFormatter::AppendFixed(double value, int precision, int width, char fill)
+{
+    char text[64];
+    int length = FormatFixed(value, precision, text);
+    if(length >= (int)sizeof(text))
+    {
+        // above 1e63 or so the digits of snprintf do not fit into text
+        std::vector<char> long_text(length+1);
+        snprintf(&long_text[0], long_text.size(), "%.*f", precision, value);
+        AppendPadded(&long_text[0], length, width, fill);
+        return;
+    }
+    AppendPadded(text, length, width, fill);
+}
@@ -0,0 +1,48 @@
+#ifndef TEXTLINEFORMATTER_H
+#define TEXTLINEFORMATTER_H
+
+/// TextLineFormatter: appends the text of the route files (.ght, .gst) to a reusable char buffer,
+/// the output is the same as the one of an ostream with std::fixed, precision, setw and setfill('0'),
+/// but without the stream state and without allocation once the buffer is large enough
+///
+/// the fixed point numbers are formatted as integers (value*10^precision, rounded),
+/// the few values too close to a rounding tie for the double product are formatted by snprintf,
+/// which rounds the exact binary value as the ostream does
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+class TextLineFormatter
+{
+public:
+    TextLineFormatter();
+
+    inline void Clear() { m_buffer.clear(); };
+    inline size_t Size() const { return m_buffer.size(); };
+    inline const char * Data() const { return m_buffer.empty() ? "" : &m_buffer[0]; };
+
+    // write the buffer to the stream and clear it
+    void WriteTo(std::ostream & out_stream);
+
+    void Append(char c);
+    void Append(const char * text);
+    void Append(const std::string & text);
+    void Append(const char * text, size_t length);
+
+    // as out_stream<<std::setw(width)<<std::setfill(fill)<<value, width 0 for no padding
+    void AppendInteger(long long value, int width=0, char fill='0');
+
+    // as out_stream<<std::fixed<<std::setprecision(precision)<<std::setw(width)<<std::setfill(fill)<<value
+    void AppendFixed(double value, int precision, int width=0, char fill='0');
+
+protected:
+    void AppendPadded(const char * text, size_t length, int width, char fill);
+
+protected:
+    std::vector<char> m_buffer;
+};
+
+#endif // TEXTLINEFORMATTER_H
@@ -0,0 +1,379 @@
+#include "threadpool.h"
+
+#include <chrono>
+
+#include <QDebug>
+
+
+namespace {
+
+    // the pool and queue index of the current worker thread, NULL for the other threads
+    thread_local const WorkStealingThreadPool * tls_worker_pool = NULL;
+    thread_local size_t tls_worker_index = 0;
+
+    // the pool of the TaskGroups of the thread, see WorkStealingThreadPool::PoolScope
+    thread_local WorkStealingThreadPool * tls_current_pool = NULL;
+    thread_local bool tls_in_pool_scope = false;
+
+}
+
+
+WorkStealingThreadPool::WorkStealingThreadPool(size_t count_threads, size_t queue_capacity)
+    :m_count_pending(0),
+    m_next_queue(0),
+    m_stop(false),
+    m_count_waiting_submitters(0)
+{
+    if(count_threads == 0)
+    {
+        count_threads = std::thread::hardware_concurrency();
+        if(count_threads == 0)
+        {
+            count_threads = 1;
+        }
+    }
+
+    m_queue_capacity = (queue_capacity == 0) ? count_threads*64 : queue_capacity;
+
+    for(size_t i=0; i<count_threads; i++)
+    {
+        m_queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue));
+    }
+
+    // start the threads after all the queues exist, the workers steal from each other
+    for(size_t i=0; i<count_threads; i++)
+    {
+        m_threads.push_back(std::thread(&WorkStealingThreadPool::WorkerLoop, this, i));
+    }
+}
+
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    m_space.notify_all();
+
+    for(size_t i=0; i<m_threads.size(); i++)
+    {
+        m_threads[i].join();
+    }
+}
+
+
+WorkStealingThreadPool & WorkStealingThreadPool::GlobalInstance()
+{
+    static WorkStealingThreadPool poolInstance;
+    return poolInstance;
+}
+
+
+WorkStealingThreadPool * WorkStealingThreadPool::CurrentInstance()
+{
+    return tls_in_pool_scope ? tls_current_pool : &GlobalInstance();
+}
+
+
+size_t WorkStealingThreadPool::CurrentThreadCount()
+{
+    WorkStealingThreadPool * pool = CurrentInstance();
+    return pool ? pool->GetThreadCount() : 1;
+}
+
+
+bool WorkStealingThreadPool::IsInPoolScope()
+{
+    return tls_in_pool_scope;
+}
+
+
+WorkStealingThreadPool::PoolScope::PoolScope(WorkStealingThreadPool * pool)
+    :m_previous_pool(tls_current_pool),
+    m_previous_in_scope(tls_in_pool_scope)
+{
+    tls_current_pool = pool;
+    tls_in_pool_scope = true;
+}
+
+
+WorkStealingThreadPool::PoolScope::~PoolScope()
+{
+    tls_current_pool = m_previous_pool;
+    tls_in_pool_scope = m_previous_in_scope;
+}
+
+
+bool WorkStealingThreadPool::IsWorkerThread() const
+{
+    return tls_worker_pool == this;
+}
+
+
+void WorkStealingThreadPool::Submit(Task task)
+{
+    size_t queue_index;
+
+    if(IsWorkerThread())
+    {
+        // a worker must not block on a full pool, run the task in place
+        if(m_count_pending >= m_queue_capacity)
+        {
+            ExecuteTask(task);
+            return;
+        }
+        queue_index = tls_worker_index;
+    }
+    else
+    {
+        if(m_count_pending >= m_queue_capacity)
+        {
+            std::unique_lock<std::mutex> lock(m_wake_mutex);
+            m_count_waiting_submitters++;
+            while(m_count_pending >= m_queue_capacity && !m_stop)
+            {
+                m_space.wait(lock);
+            }
+            m_count_waiting_submitters--;
+        }
+        queue_index = (m_next_queue++) % m_queues.size();
+    }
+
+    // count first, a worker may take the task as soon as it is in the queue
+    m_count_pending++;
+    {
+        std::lock_guard<std::mutex> lock(m_queues[queue_index]->mutex);
+        m_queues[queue_index]->tasks.push_back(task);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+    }
+    m_wake.notify_one();
+}
+
+
+bool WorkStealingThreadPool::RunPendingTask()
+{
+    Task task;
+
+    bool found = IsWorkerThread() ? PopTask(tls_worker_index, task)
+                                  : StealTask(m_queues.size(), task);
+    if(found)
+    {
+        ExecuteTask(task);
+    }
+    return found;
+}
+
+
+bool WorkStealingThreadPool::PopTask(size_t index, Task & task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+        std::deque<Task> & tasks = m_queues[index]->tasks;
+        if(!tasks.empty())
+        {
+            task.swap(tasks.back());
+            tasks.pop_back();
+        }
+    }
+
+    if(!task)
+    {
+        return StealTask(index, task);
+    }
+
+    m_count_pending--;
+    if(m_count_waiting_submitters > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_space.notify_one();
+    }
+    return true;
+}
+
+
+bool WorkStealingThreadPool::StealTask(size_t thief, Task & task)
+{
+    size_t count_queues = m_queues.size();
+    size_t start = (thief < count_queues) ? thief+1 : m_next_queue.load();
+
+    for(size_t i=0; i<count_queues; i++)
+    {
+        size_t victim = (start+i) % count_queues;
+        if(victim == thief)
+        {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(m_queues[victim]->mutex);
+        std::deque<Task> & tasks = m_queues[victim]->tasks;
+        if(!tasks.empty())
+        {
+            task.swap(tasks.front());
+            tasks.pop_front();
+            break;
+        }
+    }
+
+    if(!task)
+    {
+        return false;
+    }
+
+    m_count_pending--;
+    if(m_count_waiting_submitters > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_space.notify_one();
+    }
+    return true;
+}
+
+
+void WorkStealingThreadPool::ExecuteTask(Task & task)
+{
+    // a task runs within its pool, also when a waiting thread of another pool executes it
+    PoolScope scope(this);
+
+    try
+    {
+        task();
+    }
+    catch(...)
+    {
+        // the tasks of a TaskGroup never get here, their exceptions are kept by the group
+        qDebug("WorkStealingThreadPool: exception in task is ignored");
+    }
+}
+
+
+void WorkStealingThreadPool::WorkerLoop(size_t index)
+{
+    tls_worker_pool = this;
+    tls_worker_index = index;
+
+    for(;;)
+    {
+        Task task;
+        if(PopTask(index, task))
+        {
+            ExecuteTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wake_mutex);
+        if(m_stop && m_count_pending == 0)
+        {
+            break;
+        }
+        // the pending count may be up while the task is not in its queue yet, just retry then
+        m_wake.wait(lock, [this]{ return m_stop || m_count_pending > 0; });
+    }
+
+    tls_worker_pool = NULL;
+}
+
+
+TaskGroup::TaskGroup()
+    :m_pool(WorkStealingThreadPool::CurrentInstance()),
+    m_count_unfinished(0)
+{
+}
+
+
+TaskGroup::TaskGroup(WorkStealingThreadPool & pool)
+    :m_pool(&pool),
+    m_count_unfinished(0)
+{
+}
+
+
+TaskGroup::~TaskGroup()
+{
+    try
+    {
+        Wait();
+    }
+    catch(...)
+    {
+    }
+}
+
+
+void TaskGroup::Run(WorkStealingThreadPool::Task task)
+{
+    m_count_unfinished++;
+
+    if(m_pool == NULL)
+    {
+        RunTask(task);
+        return;
+    }
+
+    m_pool->Submit([this, task]()
+    {
+        RunTask(task);
+    });
+}
+
+
+void TaskGroup::RunTask(const WorkStealingThreadPool::Task & task)
+{
+    try
+    {
+        task();
+    }
+    catch(...)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!m_exception)
+        {
+            m_exception = std::current_exception();
+        }
+    }
+    TaskFinished();
+}
+
+
+void TaskGroup::TaskFinished()
+{
+    // decrease under the lock, Wait may return and destroy the group as soon as it is 0
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(--m_count_unfinished == 0)
+    {
+        m_done.notify_all();
+    }
+}
+
+
+void TaskGroup::Wait()
+{
+    while(m_count_unfinished > 0)
+    {
+        // help the pool instead of sleeping, the tasks of this group may be queued behind us
+        if(m_pool != NULL && m_pool->RunPendingTask())
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait_for(lock, std::chrono::milliseconds(1),
+                        [this]{ return m_count_unfinished == 0; });
+    }
+
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        exception = m_exception;
+        m_exception = std::exception_ptr();
+    }
+
+    if(exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
@@ -0,0 +1,148 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+/// WorkStealingThreadPool: a fixed set of worker threads, one task deque per worker
+/// a worker pushes/pops its own tasks at the back (LIFO, cache friendly) and steals
+/// from the front of the other deques when its own one is empty
+///
+/// the queues are bounded: Submit from a non-worker thread blocks while the pool is full,
+/// Submit from a worker runs the task in place instead (blocking a worker could dead lock)
+///
+/// TaskGroup: waits for a set of tasks, the waiting thread executes pending tasks meanwhile
+/// so groups can be nested (a task may start and wait for its own group), the first
+/// exception thrown by a task of the group is rethrown by Wait
+///
+/// a TaskGroup created without a pool uses the current pool of the thread: the one it is a
+/// task of, or the one of a PoolScope; so the groups nested in a task stay on the threads
+/// of its pool, and a PoolScope without pool runs them in place in the calling thread
+
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+
+class WorkStealingThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    // count_threads=0: one thread per core; queue_capacity=0: 64 pending tasks per thread
+    explicit WorkStealingThreadPool(size_t count_threads=0, size_t queue_capacity=0);
+    ~WorkStealingThreadPool();
+
+    inline size_t GetThreadCount() const {
+        return m_threads.size(); };
+
+    void Submit(Task task);
+
+    // execute one pending task in the calling thread, return false if there is none
+    bool RunPendingTask();
+
+    // true if the calling thread is a worker of this pool
+    bool IsWorkerThread() const;
+
+    // the pool shared by the whole process, sized to the core count
+    static WorkStealingThreadPool & GlobalInstance();
+
+    // the pool of the task the calling thread runs, or of the enclosing PoolScope,
+    // GlobalInstance outside of both; NULL in a PoolScope without pool
+    static WorkStealingThreadPool * CurrentInstance();
+
+    // the threads the tasks of the calling thread may run on, 1 in a PoolScope without pool
+    static size_t CurrentThreadCount();
+
+    // true if the calling thread runs a task of a pool or is in a PoolScope:
+    // the work it starts must stay on the threads of that pool
+    static bool IsInPoolScope();
+
+    // the TaskGroups created by the calling thread use the pool while the scope lives,
+    // NULL to run their tasks in place; the scopes nest
+    class PoolScope
+    {
+    public:
+        explicit PoolScope(WorkStealingThreadPool * pool);
+        ~PoolScope();
+
+    protected:
+        WorkStealingThreadPool * m_previous_pool;
+        bool m_previous_in_scope;
+
+    private:
+        PoolScope(const PoolScope &);
+        PoolScope & operator=(const PoolScope &);
+    };
+
+protected:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void WorkerLoop(size_t index);
+
+    bool PopTask(size_t index, Task & task);
+    bool StealTask(size_t thief, Task & task);
+
+    void ExecuteTask(Task & task);
+
+protected:
+    std::vector<std::thread> m_threads;
+    std::vector< std::unique_ptr<WorkerQueue> > m_queues;
+
+    size_t m_queue_capacity;
+
+    std::atomic<size_t> m_count_pending;   // queued, not yet started
+    std::atomic<size_t> m_next_queue;      // round robin for the external submissions
+    std::atomic<bool>   m_stop;
+
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake;        // workers wait for tasks
+    std::condition_variable m_space;       // external submitters wait for room in the queues
+    std::atomic<size_t> m_count_waiting_submitters;
+
+private:
+    WorkStealingThreadPool(const WorkStealingThreadPool &);
+    WorkStealingThreadPool & operator=(const WorkStealingThreadPool &);
+};
+
+
+class TaskGroup
+{
+public:
+    // the tasks go to WorkStealingThreadPool::CurrentInstance, run in place if there is none
+    TaskGroup();
+    explicit TaskGroup(WorkStealingThreadPool & pool);
+    ~TaskGroup();
+
+    void Run(WorkStealingThreadPool::Task task);
+
+    // wait for all the tasks run so far, rethrow the first exception of them
+    void Wait();
+
+protected:
+    void RunTask(const WorkStealingThreadPool::Task & task);
+    void TaskFinished();
+
+protected:
+    WorkStealingThreadPool * m_pool;
+
+    std::atomic<size_t> m_count_unfinished;
+
+    std::mutex m_mutex;
+    std::condition_variable m_done;
+    std::exception_ptr m_exception;
+
+private:
+    TaskGroup(const TaskGroup &);
+    TaskGroup & operator=(const TaskGroup &);
+};
+
+#endif // THREADPOOL_H
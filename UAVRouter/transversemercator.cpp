@@ -0,0 +1,285 @@
+#include "transversemercator.h"
+
+#include <cmath>
+#include <atomic>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+    const double PI = 3.14159265358979323846;
+    const double DEG2RAD = PI/180.0;
+    const double RAD2DEG = 180.0/PI;
+
+    // WGS84
+    const double WGS84_A = 6378137.0;
+    const double WGS84_F = 1.0/298.257223563;
+
+    // the points projected at a time, the scratch buffers stay on the stack
+    const size_t BLOCK_SIZE = 256;
+
+    // the inverse of the conformal latitude converges in 2 Newton steps, 3 for margin
+    const int COUNT_NEWTON_STEPS = 3;
+
+    struct Ellipsoid
+    {
+        double e;           // eccentricity
+        double e2m;         // 1 - e^2
+        double A;           // rectifying radius
+        double alpha[6];    // Kruger series, forward
+        double beta[6];     // Kruger series, inverse
+
+        Ellipsoid()
+        {
+            double f = WGS84_F;
+            double n = f/(2.0-f);
+            double n2 = n*n, n3 = n2*n, n4 = n3*n, n5 = n4*n, n6 = n5*n;
+
+            e   = sqrt(f*(2.0-f));
+            e2m = 1.0 - e*e;
+            A   = WGS84_A/(1.0+n)*(1.0 + n2/4.0 + n4/64.0 + n6/256.0);
+
+            alpha[0] = n/2.0 - 2.0*n2/3.0 + 5.0*n3/16.0 + 41.0*n4/180.0 - 127.0*n5/288.0 + 7891.0*n6/37800.0;
+            alpha[1] = 13.0*n2/48.0 - 3.0*n3/5.0 + 557.0*n4/1440.0 + 281.0*n5/630.0 - 1983433.0*n6/1935360.0;
+            alpha[2] = 61.0*n3/240.0 - 103.0*n4/140.0 + 15061.0*n5/26880.0 + 167603.0*n6/181440.0;
+            alpha[3] = 49561.0*n4/161280.0 - 179.0*n5/168.0 + 6601661.0*n6/7257600.0;
+            alpha[4] = 34729.0*n5/80640.0 - 3418889.0*n6/1995840.0;
+            alpha[5] = 212378941.0*n6/319334400.0;
+
+            beta[0] = n/2.0 - 2.0*n2/3.0 + 37.0*n3/96.0 - n4/360.0 - 81.0*n5/512.0 + 96199.0*n6/604800.0;
+            beta[1] = n2/48.0 + n3/15.0 - 437.0*n4/1440.0 + 46.0*n5/105.0 - 1118711.0*n6/3870720.0;
+            beta[2] = 17.0*n3/480.0 - 37.0*n4/840.0 - 209.0*n5/4480.0 + 5569.0*n6/90720.0;
+            beta[3] = 4397.0*n4/161280.0 - 11.0*n5/504.0 - 830251.0*n6/7257600.0;
+            beta[4] = 4583.0*n5/161280.0 - 108847.0*n6/3991680.0;
+            beta[5] = 20648693.0*n6/638668800.0;
+        }
+    };
+
+    const Ellipsoid & WGS84()
+    {
+        static const Ellipsoid wgs84;
+        return wgs84;
+    }
+
+    // tan of the conformal latitude from tan of the latitude
+    inline double ConformalTau(double tau, const Ellipsoid & ell)
+    {
+        double tau1 = sqrt(1.0 + tau*tau);
+        double sig  = sinh(ell.e*atanh(ell.e*tau/tau1));
+        return sqrt(1.0 + sig*sig)*tau - sig*tau1;
+    }
+
+    bool DetectAVX2()
+    {
+        if(!TransverseMercatorSeriesAVX2Compiled())
+        {
+            return false;
+        }
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int info[4];
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1<<27)) != 0;
+        bool avx     = (info[2] & (1<<28)) != 0;
+        if(!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1<<5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        return __builtin_cpu_supports("avx2") != 0;
+#else
+        return false;
+#endif
+    }
+
+    std::atomic<bool> & AVX2Enabled()
+    {
+        static std::atomic<bool> enabled(true);
+        return enabled;
+    }
+
+    inline void Series(size_t count, const double coef[6], double sign,
+                       double * xi, double * eta,
+                       const double * s2, const double * c2,
+                       const double * sh2, const double * ch2)
+    {
+        if(TransverseMercator::IsAVX2Enabled())
+        {
+            TransverseMercatorSeriesAVX2(count, coef, sign, xi, eta, s2, c2, sh2, ch2);
+        }
+        else
+        {
+            TransverseMercatorSeries(count, coef, sign, xi, eta, s2, c2, sh2, ch2);
+        }
+    }
+}
+
+
+void TransverseMercatorSeries(size_t count, const double coef[6], double sign,
+                              double * xi, double * eta,
+                              const double * s2, const double * c2,
+                              const double * sh2, const double * ch2)
+{
+    for(size_t i=0; i<count; i++ )
+    {
+        double two_c2  = 2.0*c2[i];
+        double two_ch2 = 2.0*ch2[i];
+
+        // multiple angles by the Chebyshev recurrences, j=1
+        double s_prev  = 0.0, s_cur  = s2[i];
+        double c_prev  = 1.0, c_cur  = c2[i];
+        double sh_prev = 0.0, sh_cur = sh2[i];
+        double ch_prev = 1.0, ch_cur = ch2[i];
+
+        double sum_xi = 0.0, sum_eta = 0.0;
+
+        for(int j=0; j<6; j++ )
+        {
+            sum_xi  = sum_xi  + coef[j]*(s_cur*ch_cur);
+            sum_eta = sum_eta + coef[j]*(c_cur*sh_cur);
+
+            double s_next  = two_c2*s_cur   - s_prev;
+            double c_next  = two_c2*c_cur   - c_prev;
+            double sh_next = two_ch2*sh_cur - sh_prev;
+            double ch_next = two_ch2*ch_cur - ch_prev;
+
+            s_prev = s_cur;   s_cur = s_next;
+            c_prev = c_cur;   c_cur = c_next;
+            sh_prev = sh_cur; sh_cur = sh_next;
+            ch_prev = ch_cur; ch_cur = ch_next;
+        }
+
+        xi[i]  = xi[i]  + sign*sum_xi;
+        eta[i] = eta[i] + sign*sum_eta;
+    }
+}
+
+
+TransverseMercator::TransverseMercator(double central_meridian,
+                                       double scale_factor,
+                                       double false_easting,
+                                       double false_northing)
+    :m_central_meridian(central_meridian),
+    m_k0A(scale_factor*WGS84().A),
+    m_false_easting(false_easting),
+    m_false_northing(false_northing)
+{
+}
+
+bool TransverseMercator::HasAVX2()
+{
+    static const bool has_avx2 = DetectAVX2();
+    return has_avx2;
+}
+
+void TransverseMercator::EnableAVX2(bool enable)
+{
+    AVX2Enabled() = enable;
+}
+
+bool TransverseMercator::IsAVX2Enabled()
+{
+    return HasAVX2() && AVX2Enabled();
+}
+
+void TransverseMercator::Forward(size_t count, double * x, double * y) const
+{
+    for(size_t i=0; i<count; i+=BLOCK_SIZE )
+    {
+        size_t count_block = (count-i < BLOCK_SIZE) ? count-i : BLOCK_SIZE;
+        ForwardBlock(count_block, x+i, y+i);
+    }
+}
+
+void TransverseMercator::Inverse(size_t count, double * x, double * y) const
+{
+    for(size_t i=0; i<count; i+=BLOCK_SIZE )
+    {
+        size_t count_block = (count-i < BLOCK_SIZE) ? count-i : BLOCK_SIZE;
+        InverseBlock(count_block, x+i, y+i);
+    }
+}
+
+void TransverseMercator::ForwardBlock(size_t count, double * x, double * y) const
+{
+    const Ellipsoid & ell = WGS84();
+
+    double xi[BLOCK_SIZE], eta[BLOCK_SIZE];
+    double s2[BLOCK_SIZE], c2[BLOCK_SIZE], sh2[BLOCK_SIZE], ch2[BLOCK_SIZE];
+
+    // the spherical transverse mercator of the conformal latitude
+    for(size_t i=0; i<count; i++ )
+    {
+        double lam = (x[i]-m_central_meridian)*DEG2RAD;
+        double taup = ConformalTau(tan(y[i]*DEG2RAD), ell);
+
+        double cos_lam = cos(lam);
+        double xip  = atan2(taup, cos_lam);
+        double etap = asinh(sin(lam)/sqrt(taup*taup + cos_lam*cos_lam));
+
+        xi[i]  = xip;
+        eta[i] = etap;
+        s2[i]  = sin(2.0*xip);
+        c2[i]  = cos(2.0*xip);
+        sh2[i] = sinh(2.0*etap);
+        ch2[i] = cosh(2.0*etap);
+    }
+
+    Series(count, ell.alpha, 1.0, xi, eta, s2, c2, sh2, ch2);
+
+    for(size_t i=0; i<count; i++ )
+    {
+        x[i] = m_false_easting  + m_k0A*eta[i];
+        y[i] = m_false_northing + m_k0A*xi[i];
+    }
+}
+
+void TransverseMercator::InverseBlock(size_t count, double * x, double * y) const
+{
+    const Ellipsoid & ell = WGS84();
+
+    double xi[BLOCK_SIZE], eta[BLOCK_SIZE];
+    double s2[BLOCK_SIZE], c2[BLOCK_SIZE], sh2[BLOCK_SIZE], ch2[BLOCK_SIZE];
+
+    for(size_t i=0; i<count; i++ )
+    {
+        double xi0  = (y[i]-m_false_northing)/m_k0A;
+        double eta0 = (x[i]-m_false_easting)/m_k0A;
+
+        xi[i]  = xi0;
+        eta[i] = eta0;
+        s2[i]  = sin(2.0*xi0);
+        c2[i]  = cos(2.0*xi0);
+        sh2[i] = sinh(2.0*eta0);
+        ch2[i] = cosh(2.0*eta0);
+    }
+
+    Series(count, ell.beta, -1.0, xi, eta, s2, c2, sh2, ch2);
+
+    for(size_t i=0; i<count; i++ )
+    {
+        double sin_xip  = sin(xi[i]);
+        double cos_xip  = cos(xi[i]);
+        double sinh_etap = sinh(eta[i]);
+
+        double taup = sin_xip/sqrt(sinh_etap*sinh_etap + cos_xip*cos_xip);
+        double lam  = atan2(sinh_etap, cos_xip);
+
+        // latitude from the conformal latitude by Newton
+        double tau = taup/ell.e2m;
+        for(int k=0; k<COUNT_NEWTON_STEPS; k++ )
+        {
+            double tau1  = sqrt(1.0 + tau*tau);
+            double taupa = ConformalTau(tau, ell);
+            tau += (taup - taupa)/sqrt(1.0 + taupa*taupa)*(1.0 + ell.e2m*tau*tau)/(ell.e2m*tau1);
+        }
+
+        x[i] = m_central_meridian + lam*RAD2DEG;
+        y[i] = atan(tau)*RAD2DEG;
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef TRANSVERSEMERCATOR_H
+#define TRANSVERSEMERCATOR_H
+
+/// TransverseMercator: native Gauss-Kruger (transverse mercator) projection on WGS84,
+/// the Kruger series to the 6th order of the third flattening n (Karney 2011),
+/// accurate to well below a millimetre within 3000 km of the central meridian
+///
+/// the points are processed as structure of arrays (x[] and y[] apart) in blocks:
+/// the trigonometric part is done per point, the series (the most of the arithmetic)
+/// runs on 4 points at a time with AVX2 if the cpu supports it, otherwise scalar
+
+#include <cstddef>
+
+
+class TransverseMercator
+{
+public:
+    TransverseMercator(double central_meridian,
+                       double scale_factor=0.9996,
+                       double false_easting=500000.0,
+                       double false_northing=0.0);
+
+    // in place: x longitude, y latitude in degree => x easting, y northing in meters
+    void Forward(size_t count, double * x, double * y) const;
+
+    // in place: x easting, y northing in meters => x longitude, y latitude in degree
+    void Inverse(size_t count, double * x, double * y) const;
+
+    inline double GetCentralMeridian() const { return m_central_meridian; };
+
+    // AVX2 compiled in and supported by the cpu
+    static bool HasAVX2();
+    // use AVX2 if it is available, default true; false to compare with the scalar code
+    static void EnableAVX2(bool enable);
+    static bool IsAVX2Enabled();
+
+protected:
+    void ForwardBlock(size_t count, double * x, double * y) const;
+    void InverseBlock(size_t count, double * x, double * y) const;
+
+protected:
+    double m_central_meridian;  // degree
+    double m_k0A;               // scale factor * rectifying radius
+    double m_false_easting;
+    double m_false_northing;
+};
+
+
+// the series of the forward (sign=1, alpha) or inverse (sign=-1, beta) projection:
+//      xi  += sign * sum_j coef[j] * sin(2j xi0) * cosh(2j eta0)
+//      eta += sign * sum_j coef[j] * cos(2j xi0) * sinh(2j eta0)
+// given s2, c2, sh2, ch2: sin(2 xi0), cos(2 xi0), sinh(2 eta0), cosh(2 eta0)
+void TransverseMercatorSeries(size_t count, const double coef[6], double sign,
+                              double * xi, double * eta,
+                              const double * s2, const double * c2,
+                              const double * sh2, const double * ch2);
+
+// the same with AVX2, only defined if transversemercator_avx2.cpp is compiled for AVX2
+bool TransverseMercatorSeriesAVX2Compiled();
+void TransverseMercatorSeriesAVX2(size_t count, const double coef[6], double sign,
+                                  double * xi, double * eta,
+                                  const double * s2, const double * c2,
+                                  const double * sh2, const double * ch2);
+
+#endif // TRANSVERSEMERCATOR_H
@@ -0,0 +1,79 @@
+/// the AVX2 kernel of TransverseMercatorSeries,
+/// compiled with AVX2 enabled (AVX2_SOURCES in qmake, -mavx2 or /arch:AVX2 in CMake),
+/// otherwise it falls back to the scalar code and TransverseMercator never calls it
+
+#include "transversemercator.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+bool TransverseMercatorSeriesAVX2Compiled()
+{
+#if defined(__AVX2__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+void TransverseMercatorSeriesAVX2(size_t count, const double coef[6], double sign,
+                                  double * xi, double * eta,
+                                  const double * s2, const double * c2,
+                                  const double * sh2, const double * ch2)
+{
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d vsign = _mm256_set1_pd(sign);
+
+    for( ; i+4<=count; i+=4 )
+    {
+        __m256d vs2  = _mm256_loadu_pd(s2+i);
+        __m256d vc2  = _mm256_loadu_pd(c2+i);
+        __m256d vsh2 = _mm256_loadu_pd(sh2+i);
+        __m256d vch2 = _mm256_loadu_pd(ch2+i);
+
+        __m256d two_c2  = _mm256_mul_pd(two, vc2);
+        __m256d two_ch2 = _mm256_mul_pd(two, vch2);
+
+        // multiple angles by the Chebyshev recurrences, j=1
+        __m256d s_prev  = _mm256_setzero_pd(),   s_cur  = vs2;
+        __m256d c_prev  = _mm256_set1_pd(1.0),   c_cur  = vc2;
+        __m256d sh_prev = _mm256_setzero_pd(),   sh_cur = vsh2;
+        __m256d ch_prev = _mm256_set1_pd(1.0),   ch_cur = vch2;
+
+        __m256d sum_xi  = _mm256_setzero_pd();
+        __m256d sum_eta = _mm256_setzero_pd();
+
+        for(int j=0; j<6; j++ )
+        {
+            __m256d vcoef = _mm256_set1_pd(coef[j]);
+            sum_xi  = _mm256_add_pd(sum_xi,  _mm256_mul_pd(vcoef, _mm256_mul_pd(s_cur, ch_cur)));
+            sum_eta = _mm256_add_pd(sum_eta, _mm256_mul_pd(vcoef, _mm256_mul_pd(c_cur, sh_cur)));
+
+            __m256d s_next  = _mm256_sub_pd(_mm256_mul_pd(two_c2,  s_cur),  s_prev);
+            __m256d c_next  = _mm256_sub_pd(_mm256_mul_pd(two_c2,  c_cur),  c_prev);
+            __m256d sh_next = _mm256_sub_pd(_mm256_mul_pd(two_ch2, sh_cur), sh_prev);
+            __m256d ch_next = _mm256_sub_pd(_mm256_mul_pd(two_ch2, ch_cur), ch_prev);
+
+            s_prev = s_cur;   s_cur = s_next;
+            c_prev = c_cur;   c_cur = c_next;
+            sh_prev = sh_cur; sh_cur = sh_next;
+            ch_prev = ch_cur; ch_cur = ch_next;
+        }
+
+        _mm256_storeu_pd(xi+i,  _mm256_add_pd(_mm256_loadu_pd(xi+i),  _mm256_mul_pd(vsign, sum_xi)));
+        _mm256_storeu_pd(eta+i, _mm256_add_pd(_mm256_loadu_pd(eta+i), _mm256_mul_pd(vsign, sum_eta)));
+    }
+#endif
+
+    // the tail, or everything without AVX2
+    if(i<count)
+    {
+        TransverseMercatorSeries(count-i, coef, sign, xi+i, eta+i, s2+i, c2+i, sh2+i, ch2+i);
+    }
+}
@@ -0,0 +1,167 @@
+#include "uavroutecolumns.h"
+
+#include <cmath>
+
+
+UAVRouteColumns::UAVRouteColumns()
+{
+}
+
+void UAVRouteColumns::Clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_strip_ids.clear();
+    m_ids_in_strip.clear();
+    m_point_types.clear();
+}
+
+void UAVRouteColumns::Reserve(size_t count)
+{
+    m_x.reserve(count);
+    m_y.reserve(count);
+    m_z.reserve(count);
+    m_strip_ids.reserve(count);
+    m_ids_in_strip.reserve(count);
+    m_point_types.reserve(count);
+}
+
+void UAVRouteColumns::PushBack(const UAVFlightPoint & pt)
+{
+    m_x.push_back(pt.__longitude);
+    m_y.push_back(pt.__latitude);
+    m_z.push_back(pt.__height);
+    m_strip_ids.push_back(pt.__strip_id);
+    m_ids_in_strip.push_back(pt.__id_in_strip);
+    m_point_types.push_back((BYTE8)pt.__flight_point_type);
+}
+
+void UAVRouteColumns::Append(const UAVFlightPoint * points, size_t count)
+{
+    size_t first = Size();
+
+    m_x.resize(first+count);
+    m_y.resize(first+count);
+    m_z.resize(first+count);
+    m_strip_ids.resize(first+count);
+    m_ids_in_strip.resize(first+count);
+    m_point_types.resize(first+count);
+
+    // one pass over the points, scattered to the columns
+    for(size_t i=0; i<count; i++)
+    {
+        m_x[first+i]            = points[i].__longitude;
+        m_y[first+i]            = points[i].__latitude;
+        m_z[first+i]            = points[i].__height;
+        m_strip_ids[first+i]    = points[i].__strip_id;
+        m_ids_in_strip[first+i] = points[i].__id_in_strip;
+        m_point_types[first+i]  = (BYTE8)points[i].__flight_point_type;
+    }
+}
+
+void UAVRouteColumns::Append(const UAVRouteColumns & columns)
+{
+    m_x.insert(m_x.end(),columns.m_x.begin(),columns.m_x.end());
+    m_y.insert(m_y.end(),columns.m_y.begin(),columns.m_y.end());
+    m_z.insert(m_z.end(),columns.m_z.begin(),columns.m_z.end());
+    m_strip_ids.insert(m_strip_ids.end(),columns.m_strip_ids.begin(),columns.m_strip_ids.end());
+    m_ids_in_strip.insert(m_ids_in_strip.end(),columns.m_ids_in_strip.begin(),columns.m_ids_in_strip.end());
+    m_point_types.insert(m_point_types.end(),columns.m_point_types.begin(),columns.m_point_types.end());
+}
+
+UAVFlightPoint UAVRouteColumns::GetPoint(size_t index) const
+{
+    UAVFlightPoint pt;
+    pt.__strip_id         = m_strip_ids[index];
+    pt.__id_in_strip      = m_ids_in_strip[index];
+    pt.__flight_point_type= (enumFlightPointType)m_point_types[index];
+    pt.__longitude        = m_x[index];
+    pt.__latitude         = m_y[index];
+    pt.__height           = m_z[index];
+
+    return pt;
+}
+
+void UAVRouteColumns::GetPoints(std::vector<UAVFlightPoint> & points) const
+{
+    size_t first = points.size();
+    size_t count = Size();
+
+    points.resize(first+count);
+
+    for(size_t i=0; i<count; i++)
+    {
+        UAVFlightPoint & pt = points[first+i];
+        pt.__strip_id         = m_strip_ids[i];
+        pt.__id_in_strip      = m_ids_in_strip[i];
+        pt.__flight_point_type= (enumFlightPointType)m_point_types[i];
+        pt.__longitude        = m_x[i];
+        pt.__latitude         = m_y[i];
+        pt.__height           = m_z[i];
+    }
+}
+
+void UAVRouteColumns::FillZ(double z)
+{
+    m_z.assign(m_z.size(),z);
+}
+
+void UAVRouteColumns::FlipColumn(double * values, size_t count, double center)
+{
+    for(size_t i=0; i<count; i++)
+    {
+        values[i] = -(values[i]- center)+ center;
+    }
+}
+
+void UAVRouteColumns::RotateTranslate(double * x, double * y, size_t count,
+                                      double angle_to_x, const Point2D & offset)
+{
+    // Rotate2D evaluates these for every point
+    const double cos_angle = cos(angle_to_x);
+    const double sin_angle = sin(angle_to_x);
+
+    const double offset_x = offset.X;
+    const double offset_y = offset.Y;
+
+    for(size_t i=0; i<count; i++)
+    {
+        double rotated_x = x[i]*cos_angle- y[i]*sin_angle;
+        double rotated_y = x[i]*sin_angle+ y[i]*cos_angle;
+
+        x[i] = offset_x + rotated_x;
+        y[i] = offset_y + rotated_y;
+    }
+}
+
+void UAVRouteColumns::AddCourseLength(const double * x, const double * y, const BYTE8 * strip_ids,
+                                      size_t count, double & course_length)
+{
+    // added in the order of the points, so the sum is the same as point by point
+    double length = course_length;
+
+    for(size_t i=1; i<count; i++)
+    {
+        double dx = x[i]- x[i-1];
+        double dy = y[i]- y[i-1];
+        double dist_pts = sqrt(dx*dx + dy*dy);
+
+        length += (strip_ids[i]==strip_ids[i-1]) ? dist_pts : 0.0;
+    }
+
+    course_length = length;
+}
+
+unsigned int UAVRouteColumns::CountPointType(const BYTE8 * point_types, size_t count, enumFlightPointType point_type)
+{
+    const BYTE8 type = (BYTE8)point_type;
+
+    unsigned int count_type = 0;
+    for(size_t i=0; i<count; i++)
+    {
+        count_type += (point_types[i]==type) ? 1 : 0;
+    }
+
+    return count_type;
+}
@@ -0,0 +1,85 @@
+#ifndef UAVROUTECOLUMNS_H
+#define UAVROUTECOLUMNS_H
+
+/// UAVRouteColumns: the flight points of a route as columns (structure of arrays)
+///
+///     x, y, z      the coordinates, x for __longitude (or the easting), y for __latitude (or the northing)
+///     strip id     1 byte per point
+///     id in strip  4 bytes per point
+///     point type   1 byte per point, enumFlightPointType
+///
+/// UAVFlightPoint pads its 6 fields to 48 bytes, while the passes over a route (flip, plane transform,
+/// projection) read only the coordinates or only the attributes; on columns each pass streams
+/// just the bytes it needs, in loops the compiler can vectorize.
+/// PushBack, Append and GetPoints adapt the columns to the code kept on UAVFlightPoint
+
+#include <vector>
+
+#include "UAVRoute.h"
+#include "GomoGeometry2D.h"
+using namespace Gomo::FlightRoute;
+using namespace Gomo::Geometry2D;
+
+
+class UAVRouteColumns
+{
+public:
+    UAVRouteColumns();
+
+    inline size_t Size() const { return m_strip_ids.size(); };
+    inline bool Empty() const { return m_strip_ids.empty(); };
+
+    void Clear();
+    void Reserve(size_t count);
+
+    // the adapter from and to UAVFlightPoint
+    void PushBack(const UAVFlightPoint & pt);
+    void Append(const UAVFlightPoint * points, size_t count);
+    void Append(const UAVRouteColumns & columns);
+    UAVFlightPoint GetPoint(size_t index) const;
+    // the points appended to points
+    void GetPoints(std::vector<UAVFlightPoint> & points) const;
+
+    // the height of all the points
+    void FillZ(double z);
+
+    inline double * GetX() { return m_x.empty() ? NULL : &m_x[0]; };
+    inline double * GetY() { return m_y.empty() ? NULL : &m_y[0]; };
+    inline double * GetZ() { return m_z.empty() ? NULL : &m_z[0]; };
+    inline const double * GetX() const { return m_x.empty() ? NULL : &m_x[0]; };
+    inline const double * GetY() const { return m_y.empty() ? NULL : &m_y[0]; };
+    inline const double * GetZ() const { return m_z.empty() ? NULL : &m_z[0]; };
+
+    inline const BYTE8 * GetStripIds() const { return m_strip_ids.empty() ? NULL : &m_strip_ids[0]; };
+    inline const unsigned int * GetIdsInStrip() const { return m_ids_in_strip.empty() ? NULL : &m_ids_in_strip[0]; };
+    inline const BYTE8 * GetPointTypes() const { return m_point_types.empty() ? NULL : &m_point_types[0]; };
+
+    ///
+    /// the kernels on the columns, with the arithmetic of the per point functions they replace
+    ///
+
+    // values[i] mirrored at center, as PolygonAreaFlightRouteDesign::FlipOrthoPlanePoint
+    static void FlipColumn(double * values, size_t count, double center);
+
+    // (x[i],y[i]) rotated anticlockwise by angle_to_x and moved by offset: offset + Rotate2D(pt,angle_to_x)
+    static void RotateTranslate(double * x, double * y, size_t count,
+                                double angle_to_x, const Point2D & offset);
+
+    // the distances between the neighbour points of the same strip added to course_length, in order
+    static void AddCourseLength(const double * x, const double * y, const BYTE8 * strip_ids,
+                                size_t count, double & course_length);
+
+    // the count of the points of point_type
+    static unsigned int CountPointType(const BYTE8 * point_types, size_t count, enumFlightPointType point_type);
+
+protected:
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    std::vector<double> m_z;
+
+    std::vector<BYTE8>        m_strip_ids;
+    std::vector<unsigned int> m_ids_in_strip;
+    std::vector<BYTE8>        m_point_types;
+};
+
+#endif // UAVROUTECOLUMNS_H
@@ -0,0 +1,489 @@
+#include "uavroutedecoder.h"
+#include "routecolumnfile.h"
+
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+
+#include <QFileInfo>
+
+#include "threadpool.h"
+
+namespace {
+
+    // the frames decoded by a task of DecodeFlightPointsFromBinary
+    const size_t POINTS_PER_DECODING_TASK = 16384;
+
+    const char * const STATISTIC_LABELS[5] = {
+        "MBR Area(m2):",
+        "Flight Region Polygon Area(m2):",
+        "Exposure Points Count:",
+        "Strips Count:",
+        "Flight Course Length(m):"
+    };
+
+    // the lines of a text one after the other, without the end of line
+    class TextLines
+    {
+    public:
+        explicit TextLines(const std::string & text)
+            :m_next(text.c_str()),
+            m_end(text.c_str()+text.size())
+        {
+        }
+
+        bool Next(const char *& begin, const char *& end)
+        {
+            if(m_next>=m_end)
+            {
+                return false;
+            }
+
+            begin = m_next;
+            const char * end_of_line = (const char *)memchr(m_next,'\n',m_end-m_next);
+            end = end_of_line!=NULL ? end_of_line : m_end;
+            m_next = end_of_line!=NULL ? end_of_line+1 : m_end;
+
+            if(end>begin && end[-1]=='\r')
+            {
+                end--;
+            }
+            return true;
+        }
+
+        void NextLine(const char *& begin, const char *& end)
+        {
+            if(!Next(begin,end))
+            {
+                throw "unexpected end of the route file, UAVRouteDecoder::DecodeRouteDesignFromText";
+            }
+        }
+
+    protected:
+        const char * m_next;
+        const char * m_end;
+    };
+
+    inline bool IsLine(const char * begin, const char * end, const char * line)
+    {
+        size_t length = strlen(line);
+        return (size_t)(end-begin)==length && memcmp(begin,line,length)==0;
+    }
+
+    // the tokens of a line separated by SPACE, at most max_count, return the count
+    size_t SplitLine(const char * begin, const char * end, const char * tokens[][2], size_t max_count)
+    {
+        size_t count = 0;
+        while(begin<end && count<max_count)
+        {
+            const char * space = (const char *)memchr(begin,' ',end-begin);
+            const char * token_end = space!=NULL ? space : end;
+
+            tokens[count][0] = begin;
+            tokens[count][1] = token_end;
+            count++;
+
+            begin = space!=NULL ? space+1 : end;
+        }
+        if(begin<end)
+        {
+            throw "too many fields in a line, UAVRouteDecoder::DecodeRouteDesignFromText";
+        }
+        return count;
+    }
+
+    // TextLineFormatter pads a negative number by '0' before its sign
+    inline const char * SkipPadding(const char * begin, const char * end)
+    {
+        const char * p = begin;
+        while(p<end && *p=='0')
+        {
+            p++;
+        }
+        return (p<end && *p=='-') ? p : begin;
+    }
+
+    long long ParseInteger(const char * begin, const char * end)
+    {
+        const char * p = SkipPadding(begin,end);
+
+        bool negative = (p<end && *p=='-');
+        if(negative)
+        {
+            p++;
+        }
+        if(p>=end)
+        {
+            throw "not a number, UAVRouteDecoder::DecodeRouteDesignFromText";
+        }
+
+        long long value = 0;
+        for( ; p<end; p++)
+        {
+            if(*p<'0' || *p>'9')
+            {
+                throw "not a number, UAVRouteDecoder::DecodeRouteDesignFromText";
+            }
+            value = value*10 + (*p-'0');
+        }
+        return negative ? -value : value;
+    }
+
+    const double POWERS_OF_10[16] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                                      1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+
+    // the number is followed by a SPACE, an end of line or the end of the text, so strtod stops there;
+    // the fixed point numbers of at most 15 digits are parsed directly: both the digits and the power of 10
+    // are exact doubles, so their quotient is rounded as strtod rounds
+    double ParseDouble(const char * begin, const char * end)
+    {
+        const char * p = SkipPadding(begin,end);
+
+        bool negative = (p<end && *p=='-');
+        const char * digits = negative ? p+1 : p;
+
+        long long mantissa = 0;
+        int count_digits = 0, count_decimals = -1;
+        const char * q = digits;
+        for( ; q<end && count_digits<=15; q++)
+        {
+            if(*q>='0' && *q<='9')
+            {
+                mantissa = mantissa*10 + (*q-'0');
+                count_digits++;
+                if(count_decimals>=0)
+                {
+                    count_decimals++;
+                }
+            }
+            else if(*q=='.' && count_decimals<0)
+            {
+                count_decimals = 0;
+            }
+            else
+            {
+                break;
+            }
+        }
+        if(q==end && count_digits>0 && count_digits<=15)
+        {
+            double value = count_decimals>0 ? mantissa/POWERS_OF_10[count_decimals] : (double)mantissa;
+            return negative ? -value : value;
+        }
+
+        char * parsed_end = NULL;
+        double value = strtod(p,&parsed_end);
+        if(p==end || parsed_end!=end)
+        {
+            throw "not a number, UAVRouteDecoder::DecodeRouteDesignFromText";
+        }
+        return value;
+    }
+
+    // the two lines of UAVROUTE_HEADER::Output, not encrypted
+    void DecodeHeaderLines(TextLines & lines, UAVRouteHEADER & header)
+    {
+        const char * begin, * end;
+        const char * tokens[4][2];
+
+        lines.NextLine(begin,end);
+        if(SplitLine(begin,end,tokens,4)!=4)
+        {
+            throw "wrong region line, UAVRouteDecoder::DecodeRouteDesignFromText";
+        }
+        header.min_latitude  = ParseDouble(tokens[0][0],tokens[0][1]);
+        header.max_latitude  = ParseDouble(tokens[1][0],tokens[1][1]);
+        header.min_longitude = ParseDouble(tokens[2][0],tokens[2][1]);
+        header.max_longitude = ParseDouble(tokens[3][0],tokens[3][1]);
+
+        // the name may be empty, the 3 numbers are the last fields
+        lines.NextLine(begin,end);
+        const char * fields_begin = end;
+        for(int i=0; i<3; i++)
+        {
+            const char * space = fields_begin;
+            while(space>begin && space[-1]!=' ')
+            {
+                space--;
+            }
+            if(space==begin)
+            {
+                throw "wrong airport line, UAVRouteDecoder::DecodeRouteDesignFromText";
+            }
+            fields_begin = space-1;
+        }
+
+        header.airport_name.assign(begin,fields_begin);
+        if(SplitLine(fields_begin+1,end,tokens,3)!=3)
+        {
+            throw "wrong airport line, UAVRouteDecoder::DecodeRouteDesignFromText";
+        }
+        header.airport_latitude  = ParseDouble(tokens[0][0],tokens[0][1]);
+        header.airport_longitude = ParseDouble(tokens[1][0],tokens[1][1]);
+        // written truncated
+        header.airport_height    = (double)ParseInteger(tokens[2][0],tokens[2][1]);
+    }
+
+    // the line of UAVROUTE_FLIGHT_POINT::Output: strip-id, the coordinates, the height and the point class
+    void DecodePointLine(const char * begin, const char * end, bool encrypted, UAVFlightPoint & pt)
+    {
+        const char * tokens[5][2];
+        size_t count_tokens = SplitLine(begin,end,tokens,5);
+        if(count_tokens != (encrypted ? 4 : 5))
+        {
+            throw "wrong flight point line, UAVRouteDecoder::DecodeRouteDesignFromText";
+        }
+
+        const char * dash = (const char *)memchr(tokens[0][0],'-',tokens[0][1]-tokens[0][0]);
+        if(dash==NULL)
+        {
+            throw "wrong flight point id, UAVRouteDecoder::DecodeRouteDesignFromText";
+        }
+        const char * id_begin = dash+1;
+        const char * id_end = tokens[0][1];
+
+        pt.__strip_id = (unsigned char)ParseInteger(tokens[0][0],dash);
+        pt.__id_in_strip = 0;
+
+        size_t height_field = encrypted ? 2 : 3;
+        pt.__height = UnpackRounded(ParseInteger(tokens[height_field][0],tokens[height_field][1]));
+        long long pt_class = ParseInteger(tokens[height_field+1][0],tokens[height_field+1][1]);
+
+        // the point id: the id of an exposure, or 0A, 0B or nothing then the class
+        if(pt_class==FLIGTH_POINT_TYPE_EXPOSURE)
+        {
+            pt.__id_in_strip = (unsigned int)ParseInteger(id_begin,id_end);
+            pt.__flight_point_type = FLIGTH_POINT_TYPE_EXPOSURE;
+        }
+        else if( (pt_class==FLIGTH_POINT_TYPE_GUIDE || pt_class==FLIGTH_POINT_TYPE_ETRANCE_EXIT)
+                 && id_end>id_begin && id_end[-1]=='0'+pt_class )
+        {
+            int type = (int)pt_class;
+            size_t length_flag = id_end-id_begin-1;
+            if(length_flag==2 && id_begin[0]=='0' && id_begin[1]=='A')
+            {
+                type |= FLIGTH_POINT_TYPE_A_POINT_MASK;
+            }
+            else if(length_flag==2 && id_begin[0]=='0' && id_begin[1]=='B')
+            {
+                type |= FLIGTH_POINT_TYPE_B_POINT_MASK;
+            }
+            else if(length_flag!=0)
+            {
+                throw "wrong flight point id, UAVRouteDecoder::DecodeRouteDesignFromText";
+            }
+            pt.__flight_point_type = (enumFlightPointType)type;
+        }
+        else
+        {
+            throw "wrong flight point id, UAVRouteDecoder::DecodeRouteDesignFromText";
+        }
+
+        if(encrypted)
+        {
+            if(tokens[1][1]-tokens[1][0] != 16)
+            {
+                throw "wrong encrypted coordinate, UAVRouteDecoder::DecodeRouteDesignFromText";
+            }
+
+            // the key of the last two chars of the point id, as UAVFlightPoint::EncryptionKey
+            size_t length_id = id_end-id_begin;
+            size_t length_key = length_id<2 ? length_id : 2;
+            unsigned char key = CoordinateOutput::PointIdKey(id_end-length_key,length_key);
+
+            CoordinateOutput::DecryptCoordinate(tokens[1][0],key,pt.__latitude,pt.__longitude);
+        }
+        else
+        {
+            pt.__latitude  = ParseDouble(tokens[1][0],tokens[1][1]);
+            pt.__longitude = ParseDouble(tokens[2][0],tokens[2][1]);
+        }
+    }
+
+    // the 5 lines of UAVFLIGHT_STATISTIC_INFO::Output
+    void DecodeStatisticLines(TextLines & lines, UAVFlightStatisticInfo & statistic)
+    {
+        double values[5];
+
+        for(int i=0; i<5; i++)
+        {
+            const char * begin, * end;
+            lines.NextLine(begin,end);
+
+            size_t length_label = strlen(STATISTIC_LABELS[i]);
+            if((size_t)(end-begin)<length_label || memcmp(begin,STATISTIC_LABELS[i],length_label)!=0)
+            {
+                throw "wrong statistic line, UAVRouteDecoder::DecodeRouteDesignFromText";
+            }
+            values[i] = ParseDouble(begin+length_label,end);
+        }
+
+        statistic.__MBR_Area = (float)values[0];
+        statistic.__flight_region_area = (float)values[1];
+        statistic.__count_exposures = (unsigned int)values[2];
+        statistic.__count_strips = (unsigned char)values[3];
+        statistic.__photo_flight_course_chainage = (float)values[4];
+    }
+}
+
+
+void UAVRouteDecoder::DecodeRouteDesignFromBinary(const BYTE8 * buffer, size_t size
+                                                  ,UAVRouteDesign & route_design)
+{
+    const size_t frame_size = UAVRouteDataFrame::FRAME_SIZE_IN_BYTE8;
+
+    // 2 header frames, 1 frame per point, 1 statistic frame
+    if(size%frame_size!=0 || size<3*frame_size)
+    {
+        throw "not a .bht route file, UAVRouteDecoder::DecodeRouteDesignFromBinary";
+    }
+    const size_t count_points = size/frame_size - 3;
+
+    UAVRouteDataFrame frames_header[2];
+    frames_header[0].DecodeFrame(buffer);
+    frames_header[1].DecodeFrame(buffer+frame_size);
+    route_design.__header.FromFrames(frames_header[0],frames_header[1]);
+
+    route_design.__flight_point.resize(count_points);
+    UAVFlightPoint * points = count_points>0 ? &route_design.__flight_point[0] : NULL;
+
+    const BYTE8 * input_points = buffer + 2*frame_size;
+    DecodeFlightPointsFromBinary(input_points,count_points,points);
+
+    UAVRouteDataFrame frame_statis;
+    frame_statis.DecodeFrame(input_points+count_points*frame_size);
+    route_design.__flight_statistic.FromFrame(frame_statis);
+}
+
+void UAVRouteDecoder::DecodeFlightPointsFromBinary(const BYTE8 * input, size_t count_points
+                                                   ,UAVFlightPoint * points)
+{
+    const size_t frame_size = UAVRouteDataFrame::FRAME_SIZE_IN_BYTE8;
+
+    if(count_points <= POINTS_PER_DECODING_TASK)
+    {
+        for(size_t i=0; i<count_points; i++ )
+        {
+            UAVRouteDataFrame frame_point;
+            frame_point.DecodeFrame(input+i*frame_size);
+            points[i].FromFrame(frame_point);
+        }
+        return;
+    }
+
+    // the frames do not depend on each other: each chunk is decoded in place
+    TaskGroup decode_group;
+    for(size_t begin=0; begin<count_points; begin+=POINTS_PER_DECODING_TASK )
+    {
+        size_t end = std::min(begin+POINTS_PER_DECODING_TASK,count_points);
+        decode_group.Run([input,points,begin,end,frame_size]{
+            for(size_t i=begin; i<end; i++ )
+            {
+                UAVRouteDataFrame frame_point;
+                frame_point.DecodeFrame(input+i*frame_size);
+                points[i].FromFrame(frame_point);
+            }
+        });
+    }
+
+    decode_group.Wait();
+}
+
+void UAVRouteDecoder::DecodeRouteDesignFromText(const std::string & text
+                                                ,UAVRouteDesign & route_design, bool encrypted)
+{
+    TextLines lines(text);
+    const char * begin, * end;
+
+    lines.NextLine(begin,end);
+    if(!IsLine(begin,end,"BEGIN"))
+    {
+        throw "no BEGIN in the route file, UAVRouteDecoder::DecodeRouteDesignFromText";
+    }
+
+    // the header of .gst is not written
+    route_design.__header = UAVRouteHEADER();
+    if(!encrypted)
+    {
+        DecodeHeaderLines(lines,route_design.__header);
+    }
+
+    std::vector<UAVFlightPoint> & points = route_design.__flight_point;
+    points.clear();
+
+    for(;;)
+    {
+        lines.NextLine(begin,end);
+        if(IsLine(begin,end,"END"))
+        {
+            break;
+        }
+
+        UAVFlightPoint pt;
+        DecodePointLine(begin,end,encrypted,pt);
+        points.push_back(pt);
+    }
+
+    DecodeStatisticLines(lines,route_design.__flight_statistic);
+}
+
+void UAVRouteDecoder::ReadFileContents(const std::string & input_file, std::string & contents, bool binary)
+{
+    std::ifstream input(input_file.c_str(), binary ? (ios::in | ios::binary) : ios::in);
+    if(!input)
+    {
+        throw "can not open the route file, UAVRouteDecoder::ReadFileContents";
+    }
+
+    input.seekg(0,ios::end);
+    std::streamoff size = input.tellg();
+    input.seekg(0,ios::beg);
+
+    // a text file may be shorter than its size once the ends of line are converted
+    contents.resize((size_t)size);
+    if(size>0)
+    {
+        input.read(&contents[0],size);
+        contents.resize((size_t)input.gcount());
+    }
+}
+
+void UAVRouteDecoder::ReadRouteDesignFile(const std::string & input_file
+                                          ,UAVRouteDesign & route_design)
+{
+    QFileInfo fi(QString(input_file.c_str()));
+    QString suffix=fi.suffix();
+
+    std::string contents;
+
+    if (suffix.compare(QString("bht"), Qt::CaseInsensitive) ==0)
+    {
+        ReadFileContents(input_file,contents,true);
+        DecodeRouteDesignFromBinary((const BYTE8 *)contents.data(),contents.size(),route_design);
+        return;
+    }
+
+    if (suffix.compare(QString("ght"), Qt::CaseInsensitive) ==0)
+    {
+        ReadFileContents(input_file,contents,false);
+        DecodeRouteDesignFromText(contents,route_design,false);
+        return;
+    }
+
+    if (suffix.compare(QString("gst"), Qt::CaseInsensitive) ==0)
+    {
+        ReadFileContents(input_file,contents,false);
+        DecodeRouteDesignFromText(contents,route_design,true);
+        return;
+    }
+
+    if (suffix.compare(QString("grc"), Qt::CaseInsensitive) ==0)
+    {
+        ColumnarRouteReader reader;
+        reader.Open(input_file);
+        reader.ReadRouteDesign(route_design);
+        return;
+    }
+
+    throw "unknown route file suffix, UAVRouteDecoder::ReadRouteDesignFile";
+}
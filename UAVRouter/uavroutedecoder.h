@@ -0,0 +1,43 @@
+#ifndef UAVROUTEDECODER_H
+#define UAVROUTEDECODER_H
+
+/// UAVRouteDecoder: the route files of UAVRouteOutputer back to a UAVRouteDesign
+///
+///     .bht  every frame decrypted (inverse of SequentialXor and encryptWORD) and its checksum checked
+///     .ght  the lines parsed
+///     .gst  the lines parsed and the coordinates decrypted; the file has no header
+///     .grc  by ColumnarRouteReader
+///
+/// the packed numbers are decoded to values which UAVRouteOutputer packs to the same numbers,
+/// so a decoded route written again gives the same file; a wrong file throws
+
+#include <string>
+#include <vector>
+
+#include "UAVRoute.h"
+using namespace Gomo::FlightRoute;
+
+
+class UAVRouteDecoder
+{
+public:
+    // the inverse of UAVRouteOutputer::EncodeRouteDesignAsBinary
+    static void DecodeRouteDesignFromBinary(const BYTE8 * buffer, size_t size
+                                            ,UAVRouteDesign & route_design );
+    // the inverse of UAVRouteOutputer::EncodeFlightPointsAsBinary, in parallel chunks for a large count
+    static void DecodeFlightPointsFromBinary(const BYTE8 * input, size_t count_points
+                                             ,UAVFlightPoint * points );
+
+    // the inverse of UAVRouteOutputer::EncodeRouteDesignAsText, .gst if encrypted
+    static void DecodeRouteDesignFromText(const std::string & text
+                                          ,UAVRouteDesign & route_design, bool encrypted );
+
+    // the whole file, binary or as text
+    static void ReadFileContents(const std::string & input_file, std::string & contents, bool binary);
+
+    // the route file by its suffix (bht, ght, gst, grc), throw for any other suffix
+    static void ReadRouteDesignFile(const std::string & input_file
+                                    ,UAVRouteDesign & route_design );
+};
+
+#endif // UAVROUTEDECODER_H
@@ -1,8 +1,48 @@
 #include "uavrouteoutputer.h"
+#include "ogrdriverregistration.h"
 
 #include <fstream>
 using std::ofstream;
 
+#include "threadpool.h"
+
+namespace {
+
+    // the points encoded by a task of OutputRouteDesignFileAsBinary
+    const size_t POINTS_PER_ENCODING_TASK = 16384;
+
+    // the text formatted before a write to the file
+    const size_t TEXT_BUFFER_SIZE = 1<<16;
+
+    // the points whose coordinates are encrypted together for the .gst file
+    const size_t POINTS_PER_ENCRYPTION_BATCH = 256;
+
+    // the header, the lines of the points and END, as the Output of each, through one reused buffer
+    void OutputRouteLinesText(const UAVRouteDesign & route_design, std::ostream & out_stream, bool encrypt)
+    {
+        TextLineFormatter lines;
+
+        route_design.__header.Output(lines,encrypt);
+
+        const std::vector< UAVFlightPoint > & points = route_design.__flight_point;
+
+        for(size_t begin=0; begin<points.size(); begin+=POINTS_PER_ENCRYPTION_BATCH)
+        {
+            size_t count = std::min(POINTS_PER_ENCRYPTION_BATCH, points.size()-begin);
+
+            UAVRouteOutputer::AppendFlightPointsText(&points[begin],count,lines,encrypt);
+
+            if(lines.Size() >= TEXT_BUFFER_SIZE)
+            {
+                lines.WriteTo(out_stream);
+            }
+        }
+
+        lines.Append("END");
+        lines.Append("\n");
+        lines.WriteTo(out_stream);
+    }
+}
 
 
 
@@ -21,18 +61,7 @@ UAVRouteOutputer::UAVRouteOutputer()
             output_route_file.open(output_file);
 
             //output_route_file<< route_design.__header.ToStdString();
-            route_design.__header.Output(output_route_file);
-
-            std::vector< UAVFlightPoint >::const_iterator it_pt= route_design.__flight_point.begin();
-
-            for( ; it_pt!= route_design.__flight_point.end(); it_pt++ )
-            {
-                (*it_pt).Output(output_route_file);
-            }
-
-            output_route_file<<"END"<<"\n";
-
-            route_design.__flight_statistic.Output(output_route_file);
+            EncodeRouteDesignAsText(route_design,output_route_file,false);
 
             output_route_file.close();
         }
@@ -53,51 +82,136 @@ UAVRouteOutputer::UAVRouteOutputer()
             streamdebug<< "UAVRouteOutputer::OutputRouteDesignFileAsBinary here! "<<std::endl;
             qDebug(streamdebug.str().c_str());
 
+            std::vector<BYTE8> buffer;
+            EncodeRouteDesignAsBinary(route_design,buffer);
+
+            // a single write of the whole file
             std::ofstream output_route_file;
             output_route_file.open(output_file,ios::binary | ios::out);
+            output_route_file.write((const char *)&buffer[0],buffer.size());
+            output_route_file.close();
+        }
+        catch(std::string& e)
+        {
+            throw e+"Exception in PolygonAreaFlightRouteDesign::OutputRouteFile() ";
+        }
 
-            route_design.__header.OutputBinary(output_route_file);
 
-            std::vector< UAVFlightPoint >::const_iterator it_pt= route_design.__flight_point.begin();
+    }
 
-            for( ; it_pt!= route_design.__flight_point.end(); it_pt++ )
-            {
-                (*it_pt).OutputBinary(output_route_file);
-            }
+    void UAVRouteOutputer::EncodeRouteDesignAsBinary(const UAVRouteDesign & route_design
+                                                     ,std::vector<BYTE8> & buffer)
+    {
+        const size_t frame_size = UAVRouteDataFrame::FRAME_SIZE_IN_BYTE8;
+        const size_t count_points = route_design.__flight_point.size();
 
-            route_design.__flight_statistic.OutputBinary(output_route_file);
+        // 2 header frames, 1 frame per point, 1 statistic frame
+        buffer.resize((2+count_points+1)*frame_size);
+        BYTE8 * output = &buffer[0];
 
-            output_route_file.close();
-        }
-        catch(std::string& e)
+        UAVRouteDataFrame frames_header[2];
+        route_design.__header.ToFrames(frames_header[0],frames_header[1]);
+        UAVRouteDataFrame::EncodeFrames(frames_header,2,output);
+
+        BYTE8 * output_points = output + 2*frame_size;
+        const UAVFlightPoint * points = count_points>0 ? &route_design.__flight_point[0] : NULL;
+
+        EncodeFlightPointsAsBinary(points,count_points,output_points);
+
+        UAVRouteDataFrame frame_statis;
+        route_design.__flight_statistic.ToFrame(frame_statis);
+        frame_statis.EncodeFrame(output_points+count_points*frame_size);
+    }
+
+    void UAVRouteOutputer::EncodeFlightPointsAsBinary(const UAVFlightPoint * points, size_t count_points
+                                                      ,BYTE8 * output)
+    {
+        const size_t frame_size = UAVRouteDataFrame::FRAME_SIZE_IN_BYTE8;
+
+        if(count_points <= POINTS_PER_ENCODING_TASK)
         {
-            throw e+"Exception in PolygonAreaFlightRouteDesign::OutputRouteFile() ";
+            for(size_t i=0; i<count_points; i++ )
+            {
+                UAVRouteDataFrame frame_point;
+                points[i].ToFrame(frame_point);
+                frame_point.EncodeFrame(output+i*frame_size);
+            }
+            return;
         }
 
+        // the frames do not depend on each other: each chunk is encoded in place
+        TaskGroup encode_group;
+        for(size_t begin=0; begin<count_points; begin+=POINTS_PER_ENCODING_TASK )
+        {
+            size_t end = std::min(begin+POINTS_PER_ENCODING_TASK,count_points);
+            encode_group.Run([points,output,begin,end,frame_size]{
+                for(size_t i=begin; i<end; i++ )
+                {
+                    UAVRouteDataFrame frame_point;
+                    points[i].ToFrame(frame_point);
+                    frame_point.EncodeFrame(output+i*frame_size);
+                }
+            });
+        }
 
+        encode_group.Wait();
     }
 
 
-    void UAVRouteOutputer::OutputRouteDesignFileAsTextEncrypted(const UAVRouteDesign & route_design
-                                            ,const std::string & output_file)
+    void UAVRouteOutputer::EncodeRouteDesignAsText(const UAVRouteDesign & route_design
+                                                   ,std::ostream & out_stream, bool encrypt)
     {
-        try
+        OutputRouteLinesText(route_design,out_stream,encrypt);
+
+        route_design.__flight_statistic.Output(out_stream);
+    }
+
+    void UAVRouteOutputer::AppendFlightPointsText(const UAVFlightPoint * points, size_t count
+                                                  ,TextLineFormatter & lines, bool encrypt)
+    {
+        if(encrypt==false)
         {
-            std::ofstream output_route_file;
-            output_route_file.open(output_file);
+            for(size_t i=0; i<count; i++)
+            {
+                points[i].Output(lines);
+            }
+            return;
+        }
 
-            route_design.__header.Output(output_route_file,true);
+        double latitudes[POINTS_PER_ENCRYPTION_BATCH];
+        double longitudes[POINTS_PER_ENCRYPTION_BATCH];
+        unsigned char point_id_keys[POINTS_PER_ENCRYPTION_BATCH];
+        char encrypted[16*POINTS_PER_ENCRYPTION_BATCH];
 
-            std::vector< UAVFlightPoint >::const_iterator it_pt= route_design.__flight_point.begin();
+        for(size_t begin=0; begin<count; begin+=POINTS_PER_ENCRYPTION_BATCH)
+        {
+            size_t count_batch = std::min(POINTS_PER_ENCRYPTION_BATCH, count-begin);
 
-            for( ; it_pt!= route_design.__flight_point.end(); it_pt++ )
+            for(size_t i=0; i<count_batch; i++)
             {
-                (*it_pt).Output(output_route_file,true);
+                latitudes[i]     = points[begin+i].__latitude;
+                longitudes[i]    = points[begin+i].__longitude;
+                point_id_keys[i] = points[begin+i].EncryptionKey();
             }
 
-            output_route_file<<"END"<<"\n";
+            CoordinateOutput::EncryptCoordinates(latitudes, longitudes, point_id_keys, count_batch, encrypted);
+
+            for(size_t i=0; i<count_batch; i++)
+            {
+                points[begin+i].OutputEncrypted(lines, encrypted+16*i);
+            }
+        }
+    }
+
+    void UAVRouteOutputer::OutputRouteDesignFileAsTextEncrypted(const UAVRouteDesign & route_design
+                                            ,const std::string & output_file)
+    {
+        try
+        {
+            std::ofstream output_route_file;
+            output_route_file.open(output_file);
 
-            route_design.__flight_statistic.Output(output_route_file);
+            EncodeRouteDesignAsText(route_design,output_route_file,true);
 
             output_route_file.close();
         }
@@ -120,7 +234,7 @@ UAVRouteOutputer::UAVRouteOutputer()
         const char *pszDriverName = "KML";
         OGRSFDriver *poDriver;
 
-        OGRRegisterAll();
+        OGRDriverRegistration::RegisterAllOnce();
 
         poDriver = OGRSFDriverRegistrar::GetRegistrar()->GetDriverByName(
                     pszDriverName );
@@ -170,7 +284,7 @@ UAVRouteOutputer::UAVRouteOutputer()
 
         // 2. create the strip feature
         OGRLayer *poFlightStripLayer;
-        poFlightStripLayer = poDS->CreateLayer( "flight_points", NULL, wkbLineString25D, NULL );
+        poFlightStripLayer = poDS->CreateLayer( "flight_strips", NULL, wkbLineString25D, NULL );
 
         if( poFlightStripLayer->CreateField( &oField ) != OGRERR_NONE )
         {
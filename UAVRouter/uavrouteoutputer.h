@@ -14,6 +14,25 @@ public:
                                             ,const std::string & output_file);
     static void OutputRouteDesignFileAsBinary(const UAVRouteDesign & route_design
                                               ,const std::string & output_file );
+
+    // the whole binary file in one buffer: the header frames, the frames of the points
+    // encoded in parallel chunks, and the statistic frame; the frames have a fixed length
+    static void EncodeRouteDesignAsBinary(const UAVRouteDesign & route_design
+                                          ,std::vector<BYTE8> & buffer );
+    // the frames of count_points points to output, count_points*FRAME_SIZE_IN_BYTE8 bytes,
+    // in parallel chunks for a large count
+    static void EncodeFlightPointsAsBinary(const UAVFlightPoint * points, size_t count_points
+                                           ,BYTE8 * output );
+
+    // the whole text file (.ght, or .gst if encrypt) to out_stream
+    static void EncodeRouteDesignAsText(const UAVRouteDesign & route_design
+                                        ,std::ostream & out_stream, bool encrypt );
+
+    // the text lines of the points, as UAVFlightPoint::Output, the coordinates of .gst encrypted in batches
+    static void AppendFlightPointsText(const UAVFlightPoint * points, size_t count
+                                       ,TextLineFormatter & lines, bool encrypt );
+
+    // by the OGR KML driver, KMLRouteFileSink writes the .kml of OutputRouteFile directly
     static void OutputRouteDesignFileAsKML(const UAVRouteDesign & route_design
                                               ,const std::string & output_file );
 
@@ -0,0 +1,598 @@
+#include "uavroutesink.h"
+#include "uavrouteoutputer.h"
+#include "routecolumnfile.h"
+#include "ogrdriverregistration.h"
+#include "threadpool.h"
+
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include <QFileInfo>
+#include <QDebug>
+
+
+namespace {
+
+    // the text formatted before a write to the file, as UAVRouteOutputer
+    const size_t TEXT_BUFFER_SIZE = 1<<16;
+}
+
+
+UAVRouteSink::~UAVRouteSink()
+{
+}
+
+UAVRouteSink * UAVRouteSink::CreateFileSink(const std::string & output_file)
+{
+    QFileInfo fi(QString(output_file.c_str()));
+    QString suffix=fi.suffix();
+
+    if (suffix.compare(QString("ght"), Qt::CaseInsensitive) ==0)
+    {
+        return new TextRouteFileSink(output_file,false);
+    }
+
+    if (suffix.compare(QString("bht"), Qt::CaseInsensitive) ==0)
+    {
+        return new BinaryRouteFileSink(output_file);
+    }
+
+    if (suffix.compare(QString("kml"), Qt::CaseInsensitive) ==0)
+    {
+        if(fi.completeSuffix().endsWith(QString("ogr.kml"), Qt::CaseInsensitive))
+        {
+            return new OGRKMLRouteFileSink(output_file);
+        }
+        return new KMLRouteFileSink(output_file);
+    }
+
+    if (suffix.compare(QString("gst"), Qt::CaseInsensitive) ==0)
+    {
+        return new TextRouteFileSink(output_file,true);
+    }
+
+    if (suffix.compare(QString("grc"), Qt::CaseInsensitive) ==0)
+    {
+        return new ColumnarRouteFileSink(output_file);
+    }
+
+    return NULL;
+}
+
+void UAVRouteSink::WriteRouteDesign(const UAVRouteDesign & route_design, UAVRouteSink & sink)
+{
+    sink.BeginRoute(route_design.__header);
+
+    const std::vector< UAVFlightPoint > & points = route_design.__flight_point;
+
+    size_t begin = 0;
+    for(size_t i=1; i<=points.size(); i++)
+    {
+        if(i==points.size() || points[i].__strip_id != points[begin].__strip_id)
+        {
+            sink.AddStrip(&points[begin],i-begin);
+            begin = i;
+        }
+    }
+
+    sink.EndRoute(route_design.__flight_statistic);
+}
+
+
+TextRouteFileSink::TextRouteFileSink(const std::string & output_file, bool encrypt)
+    :m_encrypt(encrypt)
+{
+    m_output_file.open(output_file);
+}
+
+void TextRouteFileSink::BeginRoute(const UAVRouteHEADER & header)
+{
+    header.Output(m_lines,m_encrypt);
+}
+
+void TextRouteFileSink::AddStrip(const UAVFlightPoint * points, size_t count)
+{
+    UAVRouteOutputer::AppendFlightPointsText(points,count,m_lines,m_encrypt);
+
+    if(m_lines.Size() >= TEXT_BUFFER_SIZE)
+    {
+        m_lines.WriteTo(m_output_file);
+    }
+}
+
+void TextRouteFileSink::EndRoute(const UAVFlightStatisticInfo & statistic)
+{
+    m_lines.Append("END");
+    m_lines.Append("\n");
+    m_lines.WriteTo(m_output_file);
+
+    statistic.Output(m_output_file);
+
+    m_output_file.close();
+}
+
+
+BinaryRouteFileSink::BinaryRouteFileSink(const std::string & output_file)
+{
+    m_output_file.open(output_file,ios::binary | ios::out);
+}
+
+void BinaryRouteFileSink::BeginRoute(const UAVRouteHEADER & header)
+{
+    UAVRouteDataFrame frames_header[2];
+    header.ToFrames(frames_header[0],frames_header[1]);
+
+    m_frames.resize(2*UAVRouteDataFrame::FRAME_SIZE_IN_BYTE8);
+    UAVRouteDataFrame::EncodeFrames(frames_header,2,&m_frames[0]);
+
+    m_output_file.write((const char *)&m_frames[0],m_frames.size());
+}
+
+void BinaryRouteFileSink::AddStrip(const UAVFlightPoint * points, size_t count)
+{
+    if(count==0)
+    {
+        return;
+    }
+
+    m_frames.resize(count*UAVRouteDataFrame::FRAME_SIZE_IN_BYTE8);
+    UAVRouteOutputer::EncodeFlightPointsAsBinary(points,count,&m_frames[0]);
+
+    m_output_file.write((const char *)&m_frames[0],m_frames.size());
+}
+
+void BinaryRouteFileSink::EndRoute(const UAVFlightStatisticInfo & statistic)
+{
+    UAVRouteDataFrame frame_statis;
+    statistic.ToFrame(frame_statis);
+
+    m_frames.resize(UAVRouteDataFrame::FRAME_SIZE_IN_BYTE8);
+    frame_statis.EncodeFrame(&m_frames[0]);
+
+    m_output_file.write((const char *)&m_frames[0],m_frames.size());
+    m_output_file.close();
+}
+
+
+KMLRouteFileSink::KMLRouteFileSink(const std::string & output_file)
+{
+    m_output_file.open(output_file);
+}
+
+// the schema of the Id of the points, as the OGR KML driver writes it
+void KMLRouteFileSink::BeginRoute(const UAVRouteHEADER & header)
+{
+    m_lines.Append("<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n");
+    m_lines.Append("<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n");
+    m_lines.Append("<Document id=\"root_doc\">\n");
+    m_lines.Append("<Schema name=\"flight_points\" id=\"flight_points\">\n");
+    m_lines.Append("\t<SimpleField name=\"Id\" type=\"string\"></SimpleField>\n");
+    m_lines.Append("</Schema>\n");
+}
+
+void KMLRouteFileSink::AddStrip(const UAVFlightPoint * points, size_t count)
+{
+    if(count==0)
+    {
+        return;
+    }
+
+    unsigned int strip_id = points[0].__strip_id;
+
+    m_lines.Append("<Folder><name>strip ");
+    m_lines.AppendInteger(strip_id);
+    m_lines.Append("</name>\n");
+
+    // the flight points, Id as strip.point
+    for(size_t i=0; i<count; i++)
+    {
+        unsigned int point_strip_id = points[i].__strip_id;
+
+        m_lines.Append("  <Placemark>\n");
+        m_lines.Append("\t<ExtendedData><SchemaData schemaUrl=\"#flight_points\">\n");
+        m_lines.Append("\t\t<SimpleData name=\"Id\">");
+        m_lines.AppendInteger(point_strip_id);
+        m_lines.Append('.');
+        m_lines.AppendInteger(points[i].__id_in_strip);
+        m_lines.Append("</SimpleData>\n");
+        m_lines.Append("\t</SchemaData></ExtendedData>\n");
+        m_lines.Append("      <Point><coordinates>");
+        AppendCoordinates(points[i]);
+        m_lines.Append("</coordinates></Point>\n");
+        m_lines.Append("  </Placemark>\n");
+
+        if(m_lines.Size() >= TEXT_BUFFER_SIZE)
+        {
+            m_lines.WriteTo(m_output_file);
+        }
+    }
+
+    // the line of the strip
+    m_lines.Append("  <Placemark>\n");
+    m_lines.Append("\t<name>flight_strip ");
+    m_lines.AppendInteger(strip_id);
+    m_lines.Append("</name>\n");
+    m_lines.Append("      <LineString><coordinates>");
+    for(size_t i=0; i<count; i++)
+    {
+        if(i>0)
+        {
+            m_lines.Append(' ');
+        }
+        AppendCoordinates(points[i]);
+
+        if(m_lines.Size() >= TEXT_BUFFER_SIZE)
+        {
+            m_lines.WriteTo(m_output_file);
+        }
+    }
+    m_lines.Append("</coordinates></LineString>\n");
+    m_lines.Append("  </Placemark>\n");
+
+    m_lines.Append("</Folder>\n");
+
+    if(m_lines.Size() >= TEXT_BUFFER_SIZE)
+    {
+        m_lines.WriteTo(m_output_file);
+    }
+}
+
+void KMLRouteFileSink::EndRoute(const UAVFlightStatisticInfo & statistic)
+{
+    m_lines.Append("</Document></kml>\n");
+    m_lines.WriteTo(m_output_file);
+
+    m_output_file.close();
+}
+
+// longitude,latitude,height: 1e-8 degree is about 1 mm
+void KMLRouteFileSink::AppendCoordinates(const UAVFlightPoint & pt)
+{
+    m_lines.AppendFixed(pt.__longitude,8);
+    m_lines.Append(',');
+    m_lines.AppendFixed(pt.__latitude,8);
+    m_lines.Append(',');
+    m_lines.AppendFixed(pt.__height,2);
+}
+
+
+OGRKMLRouteFileSink::OGRKMLRouteFileSink(const std::string & output_file)
+    :m_output_file(output_file),
+    m_data_source(NULL),
+    m_point_layer(NULL)
+{
+}
+
+OGRKMLRouteFileSink::~OGRKMLRouteFileSink()
+{
+    if(m_data_source!=NULL)
+    {
+        OGRDataSource::DestroyDataSource( m_data_source );
+    }
+}
+
+// the same layers as UAVRouteOutputer::OutputRouteDesignFileAsKML, nothing is written if any of them fails
+void OGRKMLRouteFileSink::BeginRoute(const UAVRouteHEADER & header)
+{
+    qDebug("OGRKMLRouteFileSink::BeginRoute");
+
+    OGRDriverRegistration::RegisterAllOnce();
+
+    OGRSFDriver *poDriver = OGRSFDriverRegistrar::GetRegistrar()->GetDriverByName( "KML" );
+    if( poDriver == NULL )
+    {
+        return;
+    }
+
+    m_data_source = poDriver->CreateDataSource( m_output_file.c_str(), NULL );
+    if( m_data_source == NULL )
+    {
+        return;
+    }
+
+    m_point_layer = m_data_source->CreateLayer( "flight_points", NULL, wkbPoint25D, NULL );
+
+    OGRFieldDefn oField( "Id", OFTString );
+    oField.SetWidth(10);
+
+    if( m_point_layer->CreateField( &oField ) != OGRERR_NONE )
+    {
+        m_point_layer = NULL;
+    }
+}
+
+void OGRKMLRouteFileSink::AddStrip(const UAVFlightPoint * points, size_t count)
+{
+    if( m_point_layer == NULL )
+    {
+        return;
+    }
+
+    for(size_t i=0; i<count; i++)
+    {
+        OGRFeature * pOFeature;
+        points[i].ToOGRFeature(m_point_layer,&pOFeature);
+
+        if( m_point_layer->CreateFeature( pOFeature ) != OGRERR_NONE )
+        {
+            OGRFeature::DestroyFeature( pOFeature );
+            m_point_layer = NULL;
+            return;
+        }
+
+        OGRFeature::DestroyFeature( pOFeature );
+
+        OGRPoint ptLine= points[i].ToOGRPoint();
+        m_strip_lines.addPoint(&ptLine);
+    }
+}
+
+void OGRKMLRouteFileSink::EndRoute(const UAVFlightStatisticInfo & statistic)
+{
+    if( m_point_layer == NULL )
+    {
+        return;
+    }
+
+    OGRLayer *poFlightStripLayer = m_data_source->CreateLayer( "flight_strips", NULL, wkbLineString25D, NULL );
+
+    OGRFieldDefn oField( "Id", OFTString );
+    oField.SetWidth(10);
+
+    if( poFlightStripLayer->CreateField( &oField ) != OGRERR_NONE )
+    {
+        return;
+    }
+
+    OGRFeature * pStripFeature = OGRFeature::CreateFeature( poFlightStripLayer->GetLayerDefn() );
+    pStripFeature->SetField( "Id", "1" );
+
+    pStripFeature->SetGeometry( &m_strip_lines );
+    poFlightStripLayer->CreateFeature( pStripFeature );
+    OGRFeature::DestroyFeature( pStripFeature );
+
+    OGRDataSource::DestroyDataSource( m_data_source );
+    m_data_source = NULL;
+    m_point_layer = NULL;
+}
+
+
+// BeginRoute, a block of whole strips, or EndRoute
+struct FanOutRouteSink::RouteMessage
+{
+    enum MessageType { BEGIN_ROUTE, STRIPS, END_ROUTE };
+
+    MessageType type;
+    UAVRouteHEADER header;
+    std::vector<UAVFlightPoint> points;
+    std::vector<size_t> strip_ends;         // the end of each strip in points
+    UAVFlightStatisticInfo statistic;
+};
+
+// a sink and the thread writing it, NULL message to stop;
+// without thread the messages are written in the calling thread as they are pushed
+class FanOutRouteSink::SinkWorker
+{
+public:
+    SinkWorker(UAVRouteSink * sink, bool threaded)
+        :m_sink(sink),
+        m_failed(false)
+    {
+        if(threaded)
+        {
+            m_thread = std::thread(&SinkWorker::Run,this);
+        }
+    }
+
+    // wait for room in the queue, a failed sink drops the messages
+    void Push(const std::shared_ptr<const RouteMessage> & message)
+    {
+        if(!m_thread.joinable())
+        {
+            WriteMessage(*message);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_space.wait(lock,[this]{ return m_queue.size() < BLOCKS_IN_FLIGHT; });
+        m_queue.push_back(message);
+        m_wake.notify_one();
+    }
+
+    // stop the thread after the messages already pushed, return the exception of the sink if any
+    std::exception_ptr Join()
+    {
+        if(m_thread.joinable())
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_queue.push_back(std::shared_ptr<const RouteMessage>());
+                m_wake.notify_one();
+            }
+            m_thread.join();
+        }
+        return m_error;
+    }
+
+protected:
+    void Run()
+    {
+        for(;;)
+        {
+            std::shared_ptr<const RouteMessage> message;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock,[this]{ return !m_queue.empty(); });
+                message = m_queue.front();
+                m_queue.pop_front();
+                m_space.notify_one();
+            }
+
+            if(!message)
+            {
+                return;
+            }
+
+            WriteMessage(*message);
+        }
+    }
+
+    // a failed sink drops the messages
+    void WriteMessage(const RouteMessage & message)
+    {
+        if(m_failed)
+        {
+            return;
+        }
+
+        try
+        {
+            Write(message);
+        }
+        catch(...)
+        {
+            m_error = std::current_exception();
+            m_failed = true;
+        }
+    }
+
+    void Write(const RouteMessage & message)
+    {
+        switch(message.type)
+        {
+        case RouteMessage::BEGIN_ROUTE:
+            m_sink->BeginRoute(message.header);
+            break;
+        case RouteMessage::STRIPS:
+            {
+                size_t begin = 0;
+                for(size_t i=0; i<message.strip_ends.size(); i++)
+                {
+                    m_sink->AddStrip(&message.points[begin],message.strip_ends[i]-begin);
+                    begin = message.strip_ends[i];
+                }
+            }
+            break;
+        case RouteMessage::END_ROUTE:
+            m_sink->EndRoute(message.statistic);
+            break;
+        }
+    }
+
+protected:
+    std::unique_ptr<UAVRouteSink> m_sink;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;     // the thread waits for messages
+    std::condition_variable m_space;    // Push waits for room in the queue
+    std::deque< std::shared_ptr<const RouteMessage> > m_queue;
+
+    bool m_failed;                      // only used by the writing thread, until joined
+    std::exception_ptr m_error;
+};
+
+
+FanOutRouteSink::FanOutRouteSink()
+{
+}
+
+FanOutRouteSink::~FanOutRouteSink()
+{
+    StopWorkers();
+}
+
+// within a task or a scope of a pool the sinks are written in the calling thread,
+// no thread is started beyond the ones of the pool
+void FanOutRouteSink::AddSink(UAVRouteSink * sink)
+{
+    bool threaded = !WorkStealingThreadPool::IsInPoolScope();
+    m_workers.push_back(std::unique_ptr<SinkWorker>(new SinkWorker(sink,threaded)));
+}
+
+void FanOutRouteSink::BeginRoute(const UAVRouteHEADER & header)
+{
+    std::shared_ptr<RouteMessage> message(new RouteMessage);
+    message->type = RouteMessage::BEGIN_ROUTE;
+    message->header = header;
+
+    Publish(message);
+}
+
+// the strip is copied into the current block, a full block goes to all the sinks at once
+void FanOutRouteSink::AddStrip(const UAVFlightPoint * points, size_t count)
+{
+    if(!m_block)
+    {
+        m_block.reset(new RouteMessage);
+        m_block->type = RouteMessage::STRIPS;
+        m_block->points.reserve(POINTS_PER_BLOCK);
+    }
+
+    m_block->points.insert(m_block->points.end(),points,points+count);
+    m_block->strip_ends.push_back(m_block->points.size());
+
+    if(m_block->points.size() >= POINTS_PER_BLOCK)
+    {
+        PublishBlock();
+    }
+}
+
+void FanOutRouteSink::EndRoute(const UAVFlightStatisticInfo & statistic)
+{
+    PublishBlock();
+
+    std::shared_ptr<RouteMessage> message(new RouteMessage);
+    message->type = RouteMessage::END_ROUTE;
+    message->statistic = statistic;
+
+    Publish(message);
+
+    // all the sinks finish their files, then the first error is thrown
+    std::exception_ptr error;
+    for(size_t i=0; i<m_workers.size(); i++)
+    {
+        std::exception_ptr error_sink = m_workers[i]->Join();
+        if(!error && error_sink)
+        {
+            error = error_sink;
+        }
+    }
+    m_workers.clear();
+
+    if(error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void FanOutRouteSink::Publish(const std::shared_ptr<const RouteMessage> & message)
+{
+    for(size_t i=0; i<m_workers.size(); i++)
+    {
+        m_workers[i]->Push(message);
+    }
+}
+
+void FanOutRouteSink::PublishBlock()
+{
+    if(m_block)
+    {
+        Publish(m_block);
+        m_block.reset();
+    }
+}
+
+// the route was not ended: the sinks are stopped without their EndRoute
+void FanOutRouteSink::StopWorkers()
+{
+    for(size_t i=0; i<m_workers.size(); i++)
+    {
+        m_workers[i]->Join();
+    }
+    m_workers.clear();
+}
@@ -0,0 +1,145 @@
+#ifndef UAVROUTESINK_H
+#define UAVROUTESINK_H
+
+/// UAVRouteSink: receives a route design strip by strip instead of as a whole UAVRouteDesign,
+/// BeginRoute with the header, AddStrip for each strip in the flight order, EndRoute with the statistic;
+/// the file sinks write the same files as UAVRouteOutputer, keeping only the current strip in memory
+/// (but the OGR .kml, whose strip line is one line of all the points)
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+
+#include "UAVRoute.h"
+using namespace Gomo::FlightRoute;
+
+
+class UAVRouteSink
+{
+public:
+    virtual ~UAVRouteSink();
+
+    virtual void BeginRoute(const UAVRouteHEADER & header)=0;
+    virtual void AddStrip(const UAVFlightPoint * points, size_t count)=0;
+    virtual void EndRoute(const UAVFlightStatisticInfo & statistic)=0;
+
+    // the sink of the output file by its suffix (ght, bht, kml, gst, grc), NULL for any other suffix;
+    // a file *.ogr.kml is written by the OGR KML driver instead of KMLRouteFileSink
+    static UAVRouteSink * CreateFileSink(const std::string & output_file);
+
+    // a designed route through the sink, one strip after the other
+    static void WriteRouteDesign(const UAVRouteDesign & route_design, UAVRouteSink & sink);
+};
+
+
+// .ght, or .gst if encrypt
+class TextRouteFileSink : public UAVRouteSink
+{
+public:
+    TextRouteFileSink(const std::string & output_file, bool encrypt);
+
+    virtual void BeginRoute(const UAVRouteHEADER & header);
+    virtual void AddStrip(const UAVFlightPoint * points, size_t count);
+    virtual void EndRoute(const UAVFlightStatisticInfo & statistic);
+
+protected:
+    std::ofstream m_output_file;
+    TextLineFormatter m_lines;
+    bool m_encrypt;
+};
+
+
+// .bht
+class BinaryRouteFileSink : public UAVRouteSink
+{
+public:
+    explicit BinaryRouteFileSink(const std::string & output_file);
+
+    virtual void BeginRoute(const UAVRouteHEADER & header);
+    virtual void AddStrip(const UAVFlightPoint * points, size_t count);
+    virtual void EndRoute(const UAVFlightStatisticInfo & statistic);
+
+protected:
+    std::ofstream m_output_file;
+    std::vector<BYTE8> m_frames;
+};
+
+
+// .kml written directly: one folder per strip with a placemark per flight point and the line of the strip,
+// through a buffer flushed every 64 KB
+class KMLRouteFileSink : public UAVRouteSink
+{
+public:
+    explicit KMLRouteFileSink(const std::string & output_file);
+
+    virtual void BeginRoute(const UAVRouteHEADER & header);
+    virtual void AddStrip(const UAVFlightPoint * points, size_t count);
+    virtual void EndRoute(const UAVFlightStatisticInfo & statistic);
+
+protected:
+    void AppendCoordinates(const UAVFlightPoint & pt);
+
+protected:
+    std::ofstream m_output_file;
+    TextLineFormatter m_lines;
+};
+
+
+// .kml by the OGR KML driver, as UAVRouteOutputer::OutputRouteDesignFileAsKML:
+// a layer of the flight points and a layer of one line through all of them
+class OGRKMLRouteFileSink : public UAVRouteSink
+{
+public:
+    explicit OGRKMLRouteFileSink(const std::string & output_file);
+    virtual ~OGRKMLRouteFileSink();
+
+    virtual void BeginRoute(const UAVRouteHEADER & header);
+    virtual void AddStrip(const UAVFlightPoint * points, size_t count);
+    virtual void EndRoute(const UAVFlightStatisticInfo & statistic);
+
+protected:
+    std::string m_output_file;
+
+    OGRDataSource * m_data_source;
+    OGRLayer * m_point_layer;
+    OGRLineString m_strip_lines;
+};
+
+// FanOutRouteSink: one pass over the route for several sinks, each sink written by its own thread
+// (by the calling thread within a task or a scope of a WorkStealingThreadPool);
+// the strips are gathered into blocks of POINTS_PER_BLOCK points, and a sink has at most
+// BLOCKS_IN_FLIGHT blocks waiting (double buffering) so that the slowest sink paces the route;
+// an exception of a sink stops that sink only and is thrown again by EndRoute
+class FanOutRouteSink : public UAVRouteSink
+{
+public:
+    static const size_t POINTS_PER_BLOCK = 16384;
+    static const size_t BLOCKS_IN_FLIGHT = 2;
+
+    FanOutRouteSink();
+    virtual ~FanOutRouteSink();
+
+    // the sink is owned by the fan-out and its thread, if any, starts at once; add all of them before BeginRoute
+    void AddSink(UAVRouteSink * sink);
+    inline size_t GetSinkCount() const { return m_workers.size(); };
+
+    virtual void BeginRoute(const UAVRouteHEADER & header);
+    virtual void AddStrip(const UAVFlightPoint * points, size_t count);
+    // wait for all the sinks
+    virtual void EndRoute(const UAVFlightStatisticInfo & statistic);
+
+protected:
+    struct RouteMessage;
+    class SinkWorker;
+
+    void Publish(const std::shared_ptr<const RouteMessage> & message);
+    void PublishBlock();
+    void StopWorkers();
+
+protected:
+    std::vector< std::unique_ptr<SinkWorker> > m_workers;
+    std::shared_ptr<RouteMessage> m_block;
+};
+
+#endif // UAVROUTESINK_H
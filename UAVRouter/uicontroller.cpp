@@ -1,6 +1,7 @@
 #include "uicontroller.h"
 
 UIController::UIController()
+    :m_ui_main_window(NULL)
 {
 
 }
@@ -15,6 +16,13 @@ UIController::~UIController()
 
 void UIController::LoadDefaultDesignParameters2UI()
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if(m_ui_main_window == NULL)
+    {
+        return;
+    }
+
     //camera
     QString focus("55");
     QString h("10328");
@@ -58,6 +66,8 @@ void UIController::LoadDefaultDesignParameters2UI()
 
 void UIController::AddMainWindow(Ui::MainWindow * main_win)
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
     if (main_win!=NULL)
     {
         m_ui_main_window = main_win;
@@ -67,7 +77,7 @@ void UIController::AddMainWindow(Ui::MainWindow * main_win)
 
 UIController* UIController::GetUIControllerPtr()
 {
-
+    // the initialization of a local static is thread safe (C++11)
     static UIController controllerInstance;
 
     return &controllerInstance;
@@ -3,6 +3,8 @@
 
 #include "ui_mainwindow.h"
 
+#include <mutex>
+
 
 namespace Ui {
 class MainWindow;
@@ -27,6 +29,7 @@ public:
 
 protected:
     Ui::MainWindow * m_ui_main_window;
+    std::mutex m_mutex;
 
 
 };